@@ -144,6 +144,7 @@ bool Application::Start()
         if (scene->LoadScene(scenePath))
         {
             LOG_CONSOLE("[Game] Loaded scene: %s", scenePath.c_str());
+            scene->BuildStaticBatches();
         }
         else
         {
@@ -268,6 +269,7 @@ void Application::Play()
     if (playState == PlayState::EDITING) {
         LOG_CONSOLE("Saving scene state to memory...");
         savedSceneState = scene->SerializeSceneToString();
+        scene->BuildStaticBatches();
     }
 
     playState = PlayState::PLAYING;
@@ -314,6 +316,8 @@ void Application::Stop()
         scene->CleanupMarkedObjects(scene->GetRoot());
     }
 
+    scene->ClearStaticBatches();
+
     // Restore from memory
     if (playState != PlayState::EDITING && !savedSceneState.empty()) {
         LOG_CONSOLE("Restoring scene from memory...");
@@ -6,6 +6,7 @@
 #include "ModuleResources.h"
 #include "ResourceTexture.h"
 #include "ResourceMesh.h"
+#include "GLState.h"
 #include "Log.h"
 #include <glad/glad.h>
 #include <glm/glm.hpp>
@@ -1938,7 +1939,7 @@ void AssetsWindow::LoadPreviewForAsset(AssetEntry& asset)
             // Crear textura OpenGL
             GLuint textureID;
             glGenTextures(1, &textureID);
-            glBindTexture(GL_TEXTURE_2D, textureID);
+            GLState::BindTexture(GL_TEXTURE_2D, textureID);
 
             // Configure parameters
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -1958,7 +1959,7 @@ void AssetsWindow::LoadPreviewForAsset(AssetEntry& asset)
             // Upload data
             glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
 
-            glBindTexture(GL_TEXTURE_2D, 0);
+            GLState::BindTexture(GL_TEXTURE_2D, 0);
 
             // unload dat
             stbi_image_free(data);
@@ -2091,7 +2092,7 @@ void AssetsWindow::UnloadPreviewForAsset(AssetEntry& asset)
         // We only release it if it is not a DDS texture from the resource system.
         if (asset.extension != ".dds")
         {
-            glDeleteTextures(1, &asset.previewTextureID);
+            GLState::DeleteTextures(1, &asset.previewTextureID);
         }
         asset.previewTextureID = 0;
     }
@@ -2114,7 +2115,7 @@ unsigned int AssetsWindow::RenderMeshToTexture(const Mesh& mesh, int width, int
 
     // Create texture for colour
     glGenTextures(1, &colorTexture);
-    glBindTexture(GL_TEXTURE_2D, colorTexture);
+    GLState::BindTexture(GL_TEXTURE_2D, colorTexture);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -2135,7 +2136,7 @@ unsigned int AssetsWindow::RenderMeshToTexture(const Mesh& mesh, int width, int
         glBindFramebuffer(GL_FRAMEBUFFER, oldFBO);
         glDeleteFramebuffers(1, &fbo);
         glDeleteRenderbuffers(1, &depthRBO);
-        glDeleteTextures(1, &colorTexture);
+        GLState::DeleteTextures(1, &colorTexture);
         return 0;
     }
 
@@ -2144,17 +2145,12 @@ unsigned int AssetsWindow::RenderMeshToTexture(const Mesh& mesh, int width, int
     glClearColor(0.2f, 0.2f, 0.25f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LESS);
+    GLState::Enable(GL_DEPTH_TEST);
+    GLState::DepthFunc(GL_LESS);
 
-    glm::vec3 minBounds(FLT_MAX);
-    glm::vec3 maxBounds(-FLT_MAX);
-
-    for (const auto& vertex : mesh.vertices)
-    {
-        minBounds = glm::min(minBounds, vertex.position);
-        maxBounds = glm::max(maxBounds, vertex.position);
-    }
+    // Bounds from upload, the vertices may no longer be on the CPU
+    glm::vec3 minBounds = mesh.boundsMin;
+    glm::vec3 maxBounds = mesh.boundsMax;
 
     glm::vec3 center = (minBounds + maxBounds) * 0.5f;
     glm::vec3 size = maxBounds - minBounds;
@@ -2219,7 +2215,7 @@ unsigned int AssetsWindow::RenderMeshToTexture(const Mesh& mesh, int width, int
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
 
-    glUseProgram(shaderProgram);
+    GLState::UseProgram(shaderProgram);
 
     GLint mvpLoc = glGetUniformLocation(shaderProgram, "mvp");
     if (mvpLoc != -1)
@@ -2227,11 +2223,11 @@ unsigned int AssetsWindow::RenderMeshToTexture(const Mesh& mesh, int width, int
         glUniformMatrix4fv(mvpLoc, 1, GL_FALSE, glm::value_ptr(mvp));
     }
 
-    if (mesh.VAO != 0 && !mesh.indices.empty())
+    if (mesh.VAO != 0 && mesh.GetIndexCount() > 0)
     {
-        glBindVertexArray(mesh.VAO);
-        glDrawElements(GL_TRIANGLES, mesh.indices.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+        GLState::BindVertexArray(mesh.VAO);
+        glDrawElements(GL_TRIANGLES, mesh.GetIndexCount(), GL_UNSIGNED_INT, 0);
+        GLState::BindVertexArray(0);
     }
 
     glDeleteProgram(shaderProgram);
@@ -2263,7 +2259,7 @@ unsigned int AssetsWindow::RenderMultipleMeshesToTexture(const std::vector<const
 
     // Create texture for colour
     glGenTextures(1, &colorTexture);
-    glBindTexture(GL_TEXTURE_2D, colorTexture);
+    GLState::BindTexture(GL_TEXTURE_2D, colorTexture);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -2284,7 +2280,7 @@ unsigned int AssetsWindow::RenderMultipleMeshesToTexture(const std::vector<const
         glBindFramebuffer(GL_FRAMEBUFFER, oldFBO);
         glDeleteFramebuffers(1, &fbo);
         glDeleteRenderbuffers(1, &depthRBO);
-        glDeleteTextures(1, &colorTexture);
+        GLState::DeleteTextures(1, &colorTexture);
         return 0;
     }
 
@@ -2295,8 +2291,8 @@ unsigned int AssetsWindow::RenderMultipleMeshesToTexture(const std::vector<const
     glClearColor(0.2f, 0.2f, 0.25f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LESS);
+    GLState::Enable(GL_DEPTH_TEST);
+    GLState::DepthFunc(GL_LESS);
 
     // Calculate global AABB of all combined meshes
     glm::vec3 globalMinBounds(FLT_MAX);
@@ -2304,11 +2300,8 @@ unsigned int AssetsWindow::RenderMultipleMeshesToTexture(const std::vector<const
 
     for (const Mesh* mesh : meshes)
     {
-        for (const auto& vertex : mesh->vertices)
-        {
-            globalMinBounds = glm::min(globalMinBounds, vertex.position);
-            globalMaxBounds = glm::max(globalMaxBounds, vertex.position);
-        }
+        globalMinBounds = glm::min(globalMinBounds, mesh->boundsMin);
+        globalMaxBounds = glm::max(globalMaxBounds, mesh->boundsMax);
     }
 
     glm::vec3 center = (globalMinBounds + globalMaxBounds) * 0.5f;
@@ -2375,7 +2368,7 @@ unsigned int AssetsWindow::RenderMultipleMeshesToTexture(const std::vector<const
     glDeleteShader(fragmentShader);
 
     // Usar shader
-    glUseProgram(shaderProgram);
+    GLState::UseProgram(shaderProgram);
 
     GLint mvpLoc = glGetUniformLocation(shaderProgram, "mvp");
     if (mvpLoc != -1)
@@ -2385,11 +2378,11 @@ unsigned int AssetsWindow::RenderMultipleMeshesToTexture(const std::vector<const
 
     for (const Mesh* mesh : meshes)
     {
-        if (mesh->VAO != 0 && !mesh->indices.empty())
+        if (mesh->VAO != 0 && mesh->GetIndexCount() > 0)
         {
-            glBindVertexArray(mesh->VAO);
-            glDrawElements(GL_TRIANGLES, mesh->indices.size(), GL_UNSIGNED_INT, 0);
-            glBindVertexArray(0);
+            GLState::BindVertexArray(mesh->VAO);
+            glDrawElements(GL_TRIANGLES, mesh->GetIndexCount(), GL_UNSIGNED_INT, 0);
+            GLState::BindVertexArray(0);
         }
     }
 
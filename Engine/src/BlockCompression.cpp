@@ -0,0 +1,505 @@
+#include "BlockCompression.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    // Mean and dominant direction of the points, by power iteration on the covariance
+    void PrincipalAxis(const float (*points)[4], int dims, float* mean, float* axis)
+    {
+        for (int c = 0; c < dims; ++c)
+        {
+            mean[c] = 0.0f;
+            for (int i = 0; i < 16; ++i) mean[c] += points[i][c];
+            mean[c] /= 16.0f;
+        }
+
+        float covariance[4][4] = {};
+        for (int i = 0; i < 16; ++i)
+        {
+            for (int a = 0; a < dims; ++a)
+            {
+                for (int b = 0; b < dims; ++b)
+                    covariance[a][b] += (points[i][a] - mean[a]) * (points[i][b] - mean[b]);
+            }
+        }
+
+        for (int c = 0; c < dims; ++c) axis[c] = 1.0f;
+        for (int iteration = 0; iteration < 8; ++iteration)
+        {
+            float next[4] = {};
+            float length = 0.0f;
+            for (int a = 0; a < dims; ++a)
+            {
+                for (int b = 0; b < dims; ++b) next[a] += covariance[a][b] * axis[b];
+                length = std::max(length, std::fabs(next[a]));
+            }
+
+            // Flat block, any direction works
+            if (length < 1e-6f) break;
+            for (int c = 0; c < dims; ++c) axis[c] = next[c] / length;
+        }
+    }
+
+    // Endpoints at the extremes of the points projected on the principal axis
+    void FitEndpoints(const float (*points)[4], int dims, float* endpoint0, float* endpoint1)
+    {
+        float mean[4], axis[4];
+        PrincipalAxis(points, dims, mean, axis);
+
+        float minT = FLT_MAX, maxT = -FLT_MAX;
+        for (int i = 0; i < 16; ++i)
+        {
+            float t = 0.0f;
+            for (int c = 0; c < dims; ++c) t += (points[i][c] - mean[c]) * axis[c];
+            minT = std::min(minT, t);
+            maxT = std::max(maxT, t);
+        }
+
+        for (int c = 0; c < dims; ++c)
+        {
+            endpoint0[c] = std::clamp(mean[c] + axis[c] * maxT, 0.0f, 255.0f);
+            endpoint1[c] = std::clamp(mean[c] + axis[c] * minT, 0.0f, 255.0f);
+        }
+    }
+
+    // Least squares endpoints for fixed interpolation weights (weight of endpoint0 per pixel)
+    bool RefineEndpoints(const float (*points)[4], int dims, const float* weights, float* endpoint0, float* endpoint1)
+    {
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+        float ax[4] = {}, bx[4] = {};
+        for (int i = 0; i < 16; ++i)
+        {
+            float a = weights[i];
+            float b = 1.0f - a;
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+            for (int c = 0; c < dims; ++c)
+            {
+                ax[c] += a * points[i][c];
+                bx[c] += b * points[i][c];
+            }
+        }
+
+        float determinant = aa * bb - ab * ab;
+        if (std::fabs(determinant) < 1e-6f) return false;
+
+        for (int c = 0; c < dims; ++c)
+        {
+            endpoint0[c] = std::clamp((ax[c] * bb - bx[c] * ab) / determinant, 0.0f, 255.0f);
+            endpoint1[c] = std::clamp((bx[c] * aa - ax[c] * ab) / determinant, 0.0f, 255.0f);
+        }
+        return true;
+    }
+
+    void LoadBlock(const uint8_t* block, float (*points)[4])
+    {
+        for (int i = 0; i < 16; ++i)
+        {
+            for (int c = 0; c < 4; ++c) points[i][c] = block[i * 4 + c];
+        }
+    }
+
+    // Little endian bit packing for the 128 bit BC7 block
+    void WriteBits(uint8_t* out, int& position, uint32_t value, int count)
+    {
+        for (int i = 0; i < count; ++i, ++position)
+        {
+            if (value & (1u << i)) out[position >> 3] |= (uint8_t)(1u << (position & 7));
+        }
+    }
+
+    // BC1
+
+    uint16_t To565(const float* color)
+    {
+        uint32_t r = (uint32_t)(color[0] * 31.0f / 255.0f + 0.5f);
+        uint32_t g = (uint32_t)(color[1] * 63.0f / 255.0f + 0.5f);
+        uint32_t b = (uint32_t)(color[2] * 31.0f / 255.0f + 0.5f);
+        return (uint16_t)((r << 11) | (g << 5) | b);
+    }
+
+    void From565(uint16_t packed, float* color)
+    {
+        uint32_t r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+        color[0] = (float)((r << 3) | (r >> 2));
+        color[1] = (float)((g << 2) | (g >> 4));
+        color[2] = (float)((b << 3) | (b >> 2));
+    }
+
+    // Four color mode palette, weights of color0 per index
+    const float kBC1Weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+    float AssignBC1Indices(const float (*points)[4], uint16_t color0, uint16_t color1, uint32_t& indices, float* weights)
+    {
+        float c0[3], c1[3], palette[4][3];
+        From565(color0, c0);
+        From565(color1, c1);
+        for (int p = 0; p < 4; ++p)
+        {
+            for (int c = 0; c < 3; ++c) palette[p][c] = c0[c] * kBC1Weights[p] + c1[c] * (1.0f - kBC1Weights[p]);
+        }
+
+        float error = 0.0f;
+        indices = 0;
+        for (int i = 0; i < 16; ++i)
+        {
+            int best = 0;
+            float bestDistance = FLT_MAX;
+            for (int p = 0; p < 4; ++p)
+            {
+                float distance = 0.0f;
+                for (int c = 0; c < 3; ++c)
+                {
+                    float d = points[i][c] - palette[p][c];
+                    distance += d * d;
+                }
+                if (distance < bestDistance)
+                {
+                    bestDistance = distance;
+                    best = p;
+                }
+            }
+            indices |= (uint32_t)best << (i * 2);
+            weights[i] = kBC1Weights[best];
+            error += bestDistance;
+        }
+        return error;
+    }
+
+    void EncodeColorBlock(const float (*points)[4], uint8_t* out)
+    {
+        float endpoint0[4], endpoint1[4];
+        FitEndpoints(points, 3, endpoint0, endpoint1);
+
+        uint16_t bestColor0 = 0, bestColor1 = 0;
+        uint32_t bestIndices = 0;
+        float bestError = FLT_MAX;
+
+        // The PCA fit, then one least squares pass on the indices it produced
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            uint16_t color0 = To565(endpoint0);
+            uint16_t color1 = To565(endpoint1);
+
+            // color0 > color1 selects the four color mode, equal colors leave a flat block
+            if (color0 < color1) std::swap(color0, color1);
+
+            uint32_t indices = 0;
+            float weights[16];
+            float error = color0 == color1 ? 0.0f : AssignBC1Indices(points, color0, color1, indices, weights);
+            if (color0 == color1)
+            {
+                float flat[3];
+                From565(color0, flat);
+                for (int i = 0; i < 16; ++i)
+                {
+                    weights[i] = 1.0f;
+                    for (int c = 0; c < 3; ++c) error += (points[i][c] - flat[c]) * (points[i][c] - flat[c]);
+                }
+            }
+
+            if (error < bestError)
+            {
+                bestError = error;
+                bestColor0 = color0;
+                bestColor1 = color1;
+                bestIndices = indices;
+            }
+
+            if (!RefineEndpoints(points, 3, weights, endpoint0, endpoint1)) break;
+        }
+
+        memcpy(out, &bestColor0, 2);
+        memcpy(out + 2, &bestColor1, 2);
+        memcpy(out + 4, &bestIndices, 4);
+    }
+
+    // BC4, one channel with eight interpolated values
+
+    void EncodeChannelBlock(const uint8_t* block, int channel, uint8_t* out)
+    {
+        uint8_t minValue = 255, maxValue = 0;
+        for (int i = 0; i < 16; ++i)
+        {
+            minValue = std::min(minValue, block[i * 4 + channel]);
+            maxValue = std::max(maxValue, block[i * 4 + channel]);
+        }
+
+        memset(out, 0, 8);
+        out[0] = maxValue;
+        out[1] = minValue;
+        if (maxValue == minValue) return;
+
+        int palette[8] = { maxValue, minValue };
+        for (int p = 2; p < 8; ++p) palette[p] = ((8 - p) * maxValue + (p - 1) * minValue) / 7;
+
+        uint64_t indices = 0;
+        for (int i = 0; i < 16; ++i)
+        {
+            int value = block[i * 4 + channel];
+            int best = 0;
+            int bestDistance = 256;
+            for (int p = 0; p < 8; ++p)
+            {
+                int distance = std::abs(value - palette[p]);
+                if (distance < bestDistance)
+                {
+                    bestDistance = distance;
+                    best = p;
+                }
+            }
+            indices |= (uint64_t)best << (i * 3);
+        }
+
+        for (int b = 0; b < 6; ++b) out[2 + b] = (uint8_t)(indices >> (b * 8));
+    }
+
+    // BC7 mode 6: one subset, RGBA endpoints of 7 bits plus a shared p-bit each, 4 bit indices
+
+    const int kBC7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    int QuantizeBC7(float value, int pbit)
+    {
+        return std::clamp((int)((value - pbit) * 0.5f + 0.5f), 0, 127);
+    }
+
+    float AssignBC7Indices(const float (*points)[4], const int* endpoint0, const int* endpoint1, uint8_t* indices)
+    {
+        float palette[16][4];
+        for (int p = 0; p < 16; ++p)
+        {
+            for (int c = 0; c < 4; ++c)
+                palette[p][c] = (float)(((64 - kBC7Weights[p]) * endpoint0[c] + kBC7Weights[p] * endpoint1[c] + 32) >> 6);
+        }
+
+        float error = 0.0f;
+        for (int i = 0; i < 16; ++i)
+        {
+            int best = 0;
+            float bestDistance = FLT_MAX;
+            for (int p = 0; p < 16; ++p)
+            {
+                float distance = 0.0f;
+                for (int c = 0; c < 4; ++c)
+                {
+                    float d = points[i][c] - palette[p][c];
+                    distance += d * d;
+                }
+                if (distance < bestDistance)
+                {
+                    bestDistance = distance;
+                    best = p;
+                }
+            }
+            indices[i] = (uint8_t)best;
+            error += bestDistance;
+        }
+        return error;
+    }
+}
+
+namespace BlockCompression
+{
+    bool IsCompressed(TextureFormat format)
+    {
+        return format != TextureFormat::RGBA8;
+    }
+
+    unsigned int GetGLFormat(TextureFormat format)
+    {
+        switch (format)
+        {
+        case TextureFormat::BC1: return 0x83F0;  // GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+        case TextureFormat::BC3: return 0x83F3;  // GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+        case TextureFormat::BC5: return 0x8DBD;  // GL_COMPRESSED_RG_RGTC2
+        case TextureFormat::BC7: return 0x8E8C;  // GL_COMPRESSED_RGBA_BPTC_UNORM
+        default: return 0x8058;                  // GL_RGBA8
+        }
+    }
+
+    const char* GetFormatName(TextureFormat format)
+    {
+        switch (format)
+        {
+        case TextureFormat::BC1: return "BC1";
+        case TextureFormat::BC3: return "BC3";
+        case TextureFormat::BC5: return "BC5";
+        case TextureFormat::BC7: return "BC7";
+        default: return "RGBA8";
+        }
+    }
+
+    size_t GetLevelSize(TextureFormat format, unsigned int width, unsigned int height)
+    {
+        if (!IsCompressed(format)) return (size_t)width * height * 4;
+
+        size_t blocks = (size_t)((width + 3) / 4) * ((height + 3) / 4);
+        return blocks * (format == TextureFormat::BC1 ? 8 : 16);
+    }
+
+    void Compress(const uint8_t* rgba, unsigned int width, unsigned int height, TextureFormat format, uint8_t* out)
+    {
+        if (!IsCompressed(format))
+        {
+            memcpy(out, rgba, GetLevelSize(format, width, height));
+            return;
+        }
+
+        int blocksX = (int)(width + 3) / 4;
+        int blocksY = (int)(height + 3) / 4;
+        size_t blockSize = format == TextureFormat::BC1 ? 8 : 16;
+
+        JobSystem::GetInstance().ParallelFor(blocksY, 4, [&](int begin, int end)
+        {
+            uint8_t block[64];
+            for (int by = begin; by < end; ++by)
+            {
+                for (int bx = 0; bx < blocksX; ++bx)
+                {
+                    for (int y = 0; y < 4; ++y)
+                    {
+                        unsigned int sy = std::min((unsigned int)(by * 4 + y), height - 1);
+                        for (int x = 0; x < 4; ++x)
+                        {
+                            unsigned int sx = std::min((unsigned int)(bx * 4 + x), width - 1);
+                            memcpy(block + (y * 4 + x) * 4, rgba + ((size_t)sy * width + sx) * 4, 4);
+                        }
+                    }
+
+                    uint8_t* target = out + ((size_t)by * blocksX + bx) * blockSize;
+                    switch (format)
+                    {
+                    case TextureFormat::BC1: EncodeBC1(block, target); break;
+                    case TextureFormat::BC3: EncodeBC3(block, target); break;
+                    case TextureFormat::BC5: EncodeBC5(block, target); break;
+                    case TextureFormat::BC7: EncodeBC7(block, target); break;
+                    default: break;
+                    }
+                }
+            }
+        });
+    }
+
+    void Downsample(const uint8_t* rgba, unsigned int width, unsigned int height, uint8_t* out)
+    {
+        unsigned int outWidth = std::max(1u, width / 2);
+        unsigned int outHeight = std::max(1u, height / 2);
+
+        for (unsigned int y = 0; y < outHeight; ++y)
+        {
+            const uint8_t* row0 = rgba + (size_t)std::min(y * 2, height - 1) * width * 4;
+            const uint8_t* row1 = rgba + (size_t)std::min(y * 2 + 1, height - 1) * width * 4;
+
+            for (unsigned int x = 0; x < outWidth; ++x)
+            {
+                size_t x0 = (size_t)std::min(x * 2, width - 1) * 4;
+                size_t x1 = (size_t)std::min(x * 2 + 1, width - 1) * 4;
+                uint8_t* pixel = out + ((size_t)y * outWidth + x) * 4;
+
+                for (int c = 0; c < 4; ++c)
+                    pixel[c] = (uint8_t)((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) >> 2);
+            }
+        }
+    }
+
+    void EncodeBC1(const uint8_t* block, uint8_t* out)
+    {
+        float points[16][4];
+        LoadBlock(block, points);
+        EncodeColorBlock(points, out);
+    }
+
+    void EncodeBC3(const uint8_t* block, uint8_t* out)
+    {
+        float points[16][4];
+        LoadBlock(block, points);
+        EncodeChannelBlock(block, 3, out);
+        EncodeColorBlock(points, out + 8);
+    }
+
+    void EncodeBC5(const uint8_t* block, uint8_t* out)
+    {
+        EncodeChannelBlock(block, 0, out);
+        EncodeChannelBlock(block, 1, out + 8);
+    }
+
+    void EncodeBC7(const uint8_t* block, uint8_t* out)
+    {
+        float points[16][4];
+        LoadBlock(block, points);
+
+        float endpoint0[4], endpoint1[4];
+        FitEndpoints(points, 4, endpoint0, endpoint1);
+
+        int bestQuantized[2][4] = {};
+        int bestPBits[2] = {};
+        uint8_t bestIndices[16] = {};
+        float bestError = FLT_MAX;
+
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            uint8_t passIndices[16] = {};
+            float passError = FLT_MAX;
+
+            // Every p-bit pair, the shared bit moves the whole endpoint by one step
+            for (int pbits = 0; pbits < 4; ++pbits)
+            {
+                int p0 = pbits & 1, p1 = pbits >> 1;
+                int quantized[2][4], expanded[2][4];
+                for (int c = 0; c < 4; ++c)
+                {
+                    quantized[0][c] = QuantizeBC7(endpoint0[c], p0);
+                    quantized[1][c] = QuantizeBC7(endpoint1[c], p1);
+                    expanded[0][c] = (quantized[0][c] << 1) | p0;
+                    expanded[1][c] = (quantized[1][c] << 1) | p1;
+                }
+
+                uint8_t indices[16];
+                float error = AssignBC7Indices(points, expanded[0], expanded[1], indices);
+                if (error < passError)
+                {
+                    passError = error;
+                    memcpy(passIndices, indices, sizeof(indices));
+                }
+                if (error < bestError)
+                {
+                    bestError = error;
+                    memcpy(bestQuantized, quantized, sizeof(quantized));
+                    bestPBits[0] = p0;
+                    bestPBits[1] = p1;
+                    memcpy(bestIndices, indices, sizeof(indices));
+                }
+            }
+
+            float weights[16];
+            for (int i = 0; i < 16; ++i) weights[i] = (64 - kBC7Weights[passIndices[i]]) / 64.0f;
+            if (!RefineEndpoints(points, 4, weights, endpoint0, endpoint1)) break;
+        }
+
+        // The first index is stored with 3 bits, its top bit must be 0
+        if (bestIndices[0] & 8)
+        {
+            std::swap(bestQuantized[0], bestQuantized[1]);
+            std::swap(bestPBits[0], bestPBits[1]);
+            for (uint8_t& index : bestIndices) index = (uint8_t)(15 - index);
+        }
+
+        memset(out, 0, 16);
+        int position = 0;
+        WriteBits(out, position, 1u << 6, 7);
+        for (int c = 0; c < 4; ++c)
+        {
+            WriteBits(out, position, (uint32_t)bestQuantized[0][c], 7);
+            WriteBits(out, position, (uint32_t)bestQuantized[1][c], 7);
+        }
+        WriteBits(out, position, (uint32_t)bestPBits[0], 1);
+        WriteBits(out, position, (uint32_t)bestPBits[1], 1);
+        WriteBits(out, position, bestIndices[0], 3);
+        for (int i = 1; i < 16; ++i) WriteBits(out, position, bestIndices[i], 4);
+    }
+}
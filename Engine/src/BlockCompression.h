@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Pixel format of a texture in Library files and on the GPU. Values match
+// ImportSettings::compression, 0 keeps the uncompressed RGBA8 pixels.
+enum class TextureFormat : uint32_t
+{
+    RGBA8 = 0,
+    BC1 = 1,    // RGB, 4 bits per pixel
+    BC3 = 2,    // RGBA, 8 bits per pixel (BC1 color plus BC4 alpha)
+    BC5 = 3,    // RG, 8 bits per pixel (two BC4 channels), for normal maps
+    BC7 = 4     // RGBA, 8 bits per pixel, highest quality
+};
+
+// Portable CPU encoders for the BCn formats plus the mip chain filter used at import.
+// Blocks cover 4x4 pixels, edges of sizes that are not a multiple of 4 are clamped.
+namespace BlockCompression
+{
+    bool IsCompressed(TextureFormat format);
+    unsigned int GetGLFormat(TextureFormat format);
+    const char* GetFormatName(TextureFormat format);
+
+    // Bytes of one mip level of the given size
+    size_t GetLevelSize(TextureFormat format, unsigned int width, unsigned int height);
+
+    // Encodes a whole RGBA8 level into out (GetLevelSize bytes), block rows run on the job system
+    void Compress(const uint8_t* rgba, unsigned int width, unsigned int height, TextureFormat format, uint8_t* out);
+
+    // 2x2 box filter into a level of half the size, rounded down and never below 1
+    void Downsample(const uint8_t* rgba, unsigned int width, unsigned int height, uint8_t* out);
+
+    // Single block encoders, block is 16 RGBA8 pixels in row order
+    void EncodeBC1(const uint8_t* block, uint8_t* out);
+    void EncodeBC3(const uint8_t* block, uint8_t* out);
+    void EncodeBC5(const uint8_t* block, uint8_t* out);
+    void EncodeBC7(const uint8_t* block, uint8_t* out);
+}
@@ -4,6 +4,7 @@
 #include "Window.h"
 #include "Frustum.h"
 #include "Log.h"
+#include "GLState.h"
 
 #include "glad/glad.h"
 
@@ -139,17 +140,23 @@ bool CameraLens::CleanUp()
 
 void CameraLens::SetRenderTarget(int width, int height)
 {
-    if (this->textureWidth == width && this->textureHeight == height && fboID != 0 && msaaFBO != 0)
+    if (this->textureWidth == width && this->textureHeight == height && fboID != 0 && msaaFBO != 0 &&
+        (idTextureID != 0) == debugCamera)
         return;
 
     if (fboID != 0) glDeleteFramebuffers(1, &fboID);
-    if (textureID != 0) glDeleteTextures(1, &textureID);
+    if (textureID != 0) GLState::DeleteTextures(1, &textureID);
     if (rboID != 0) glDeleteRenderbuffers(1, &rboID);
 
     if (msaaFBO != 0) glDeleteFramebuffers(1, &msaaFBO);
-    if (msaaColorBuffer != 0) glDeleteTextures(1, &msaaColorBuffer);
+    if (msaaColorBuffer != 0) GLState::DeleteTextures(1, &msaaColorBuffer);
     if (msaaDepthRBO != 0) glDeleteRenderbuffers(1, &msaaDepthRBO);
 
+    if (idTextureID != 0) GLState::DeleteTextures(1, &idTextureID);
+    if (msaaIdBuffer != 0) glDeleteRenderbuffers(1, &msaaIdBuffer);
+    idTextureID = 0;
+    msaaIdBuffer = 0;
+
     this->textureWidth = width;
     this->textureHeight = height;
     int samples = 4;
@@ -158,7 +165,7 @@ void CameraLens::SetRenderTarget(int width, int height)
     glBindFramebuffer(GL_FRAMEBUFFER, msaaFBO);
 
     glGenTextures(1, &msaaColorBuffer);
-    glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, msaaColorBuffer);
+    GLState::BindTexture(GL_TEXTURE_2D_MULTISAMPLE, msaaColorBuffer);
     glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, samples, GL_RGBA, width, height, GL_TRUE);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D_MULTISAMPLE, msaaColorBuffer, 0);
 
@@ -167,6 +174,14 @@ void CameraLens::SetRenderTarget(int width, int height)
     glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH24_STENCIL8, width, height);
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, msaaDepthRBO);
 
+    if (debugCamera)
+    {
+        glGenRenderbuffers(1, &msaaIdBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, msaaIdBuffer);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_R32UI, width, height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_RENDERBUFFER, msaaIdBuffer);
+    }
+
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
         LOG_DEBUG("ERROR: Framebuffer MSAA isn't complete");
 
@@ -174,7 +189,7 @@ void CameraLens::SetRenderTarget(int width, int height)
     glBindFramebuffer(GL_FRAMEBUFFER, fboID);
 
     glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
+    GLState::BindTexture(GL_TEXTURE_2D, textureID);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -185,11 +200,21 @@ void CameraLens::SetRenderTarget(int width, int height)
     glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rboID);
 
+    if (debugCamera)
+    {
+        glGenTextures(1, &idTextureID);
+        GLState::BindTexture(GL_TEXTURE_2D, idTextureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, width, height, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, idTextureID, 0);
+    }
+
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
         LOG_DEBUG("ERROR: Framebuffer de salida no est completo.");
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::BindTexture(GL_TEXTURE_2D, 0);
     glBindRenderbuffer(GL_RENDERBUFFER, 0);
 }
 
@@ -21,7 +21,7 @@ public:
     float GetFov() { return fov; }
     float GetAspectRatio() { return aspectRatio; }
     float GetNearPlane() { return zNear; }
-    float GetFarPlane() { return zFar; }
+    float GetFarPlane() const { return zFar; }
 
     void SetUsesPostProcessing(bool uses) { usesPostProcessing = uses; }
     bool IsUsingPostProcessing() const { return usesPostProcessing; }
@@ -60,6 +60,10 @@ public:
     unsigned int msaaColorBuffer = 0;
     unsigned int msaaDepthRBO = 0;
 
+    // Per-pixel draw IDs (GL_R32UI, attachment 1) for picking, debug camera only
+    unsigned int idTextureID = 0;
+    unsigned int msaaIdBuffer = 0;
+
     int textureWidth = 0;
     int textureHeight = 0;
     int depth;
@@ -29,6 +29,7 @@ Component::Component(GameObject* owner, ComponentType type) : owner(owner), type
     case ComponentType::PRISMATIC_JOINT:         name = "Prismatic Joint";          break;
     case ComponentType::SPHERICAL_JOINT:         name = "Spherical Joint";          break;
     case ComponentType::CANVAS:                  name = "Canvas";                   break;
+    case ComponentType::LIGHT:                   name = "Light";                    break;
     case ComponentType::LISTENER:                name = "Audio Listener";           break;
     case ComponentType::AUDIOSOURCE:             name = "Audio Source";             break;
     case ComponentType::REVERBZONE:              name = "Reverb Zone";              break;
@@ -2,6 +2,7 @@
 #include <glad/glad.h>
 #include "GLRenderDevice.h"
 #include "Application.h"
+#include "GLState.h"
 #include "Time.h"
 #include "NoesisPCH.h"
 #include "NsCore/Noesis.h"
@@ -40,7 +41,7 @@ ComponentCanvas::~ComponentCanvas()
     device.Reset();
 
     if (fbo)       glDeleteFramebuffers(1, &fbo);
-    if (textureID) glDeleteTextures(1, &textureID);
+    if (textureID) GLState::DeleteTextures(1, &textureID);
     if (rbo)       glDeleteRenderbuffers(1, &rbo);
 }
 
@@ -117,6 +118,7 @@ bool ComponentCanvas::LoadXAML(const char* filename)
     currentXAML = filename;
     view->Activate();
     needsHookEvents = true;
+    textureStale = true;
     return true;
 }
 
@@ -124,7 +126,8 @@ void ComponentCanvas::Update()
 {
     if (!view) return;
     double dt = Application::GetInstance().time->GetRealDeltaTime();
-    view->Update(Application::GetInstance().time->GetTotalTime());
+    // False when animation, layout, bindings and input left the view as it was
+    if (view->Update(Application::GetInstance().time->GetTotalTime())) viewDirty = true;
 
     if (needsHookEvents)
     {
@@ -166,13 +169,30 @@ void ComponentCanvas::Update()
     }
 }
 
-void ComponentCanvas::RenderToTexture()
+bool ComponentCanvas::PrepareRender()
 {
-    if (!view) return;
+    if (!view) return false;
+    if (!viewDirty && !textureStale) return false;
 
-    glPushAttrib(GL_ALL_ATTRIB_BITS);
+    // A texture that still shows the view is kept until the update rate allows the next render
+    float now = Application::GetInstance().time->GetTotalTime();
+    if (!textureStale && updateRate > 0.0f && now - lastRenderTime < 1.0f / updateRate) return false;
 
     view->GetRenderer()->UpdateRenderTree();
+
+    viewDirty = false;
+    textureStale = false;
+    lastRenderTime = now;
+    return true;
+}
+
+void ComponentCanvas::RenderToTexture(int renderWidth, int renderHeight, bool render)
+{
+    if (renderWidth != fboWidth || renderHeight != fboHeight) GenerateFramebuffer(renderWidth, renderHeight);
+    if (!render || !view) return;
+
+    glPushAttrib(GL_ALL_ATTRIB_BITS);
+
     view->GetRenderer()->RenderOffscreen();
 
     GLint prevFBO = 0;
@@ -181,8 +201,8 @@ void ComponentCanvas::RenderToTexture()
     glGetIntegerv(GL_VIEWPORT, prevViewport);
 
     glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-    glViewport(0, 0, width, height);
-    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glViewport(0, 0, renderWidth, renderHeight);
+    GLState::ColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
     glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
@@ -192,6 +212,9 @@ void ComponentCanvas::RenderToTexture()
     glViewport(prevViewport[0], prevViewport[1], prevViewport[2], prevViewport[3]);
 
     glPopAttrib();
+
+    // Noesis binds its own programs, buffers and textures
+    GLState::Invalidate();
 }
 
 void ComponentCanvas::Resize(int newWidth, int newHeight)
@@ -201,21 +224,22 @@ void ComponentCanvas::Resize(int newWidth, int newHeight)
     width = newWidth;
     height = newHeight;
 
+    // The framebuffer is created again by the next RenderToTexture
     if (view) view->SetSize(width, height);
-    GenerateFramebuffer(width, height);
+    textureStale = true;
 }
 
 void ComponentCanvas::GenerateFramebuffer(int w, int h)
 {
     if (fbo)       glDeleteFramebuffers(1, &fbo);
-    if (textureID) glDeleteTextures(1, &textureID);
+    if (textureID) GLState::DeleteTextures(1, &textureID);
     if (rbo)       glDeleteRenderbuffers(1, &rbo);
 
     glGenFramebuffers(1, &fbo);
     glBindFramebuffer(GL_FRAMEBUFFER, fbo);
 
     glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
+    GLState::BindTexture(GL_TEXTURE_2D, textureID);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -227,6 +251,8 @@ void ComponentCanvas::GenerateFramebuffer(int w, int h)
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rbo);
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    fboWidth = w;
+    fboHeight = h;
 }
 
 void ComponentCanvas::OnMouseMove(int x, int y)
@@ -340,6 +366,7 @@ void ComponentCanvas::Serialize(nlohmann::json& componentObj) const
     componentObj["xamlPath"] = currentXAML;
     componentObj["opacity"] = opacity;
     componentObj["uiLayer"] = uiLayer;
+    componentObj["updateRate"] = updateRate;
 
 }
 
@@ -356,6 +383,7 @@ void ComponentCanvas::Deserialize(const nlohmann::json& componentObj)
     }
 
     uiLayer = componentObj.value("uiLayer", 0);
+    SetUpdateRate(componentObj.value("updateRate", 0.0f));
 }
 
 void ComponentCanvas::UnloadXAML()
@@ -15,7 +15,13 @@ public:
     void Update() override;
     void ShutdownView();
     void CleanUp();
-    void RenderToTexture();
+    // Decides if the view is rendered this frame and takes its render tree, on the thread that
+    // updates the view. False when the cached texture is kept
+    bool PrepareRender();
+    // On the thread holding the context: sizes the framebuffer, then renders the taken tree
+    // into the texture when PrepareRender asked for it
+    void RenderToTexture(int renderWidth, int renderHeight, bool render);
+    bool IsLoaded() const { return view != nullptr; }
 
     bool LoadXAML(const char* filename);
     void UnloadXAML();
@@ -51,6 +57,10 @@ public:
     void SetUILayer(int layer) { uiLayer = layer; }
     int GetUILayer() const { return uiLayer; }
 
+    // Most re-renders per second of a changing view, 0 renders every change
+    void SetUpdateRate(float rate) { updateRate = rate > 0.0f ? rate : 0.0f; }
+    float GetUpdateRate() const { return updateRate; }
+
     float opacity = 1.0f;
 
 private:
@@ -67,6 +77,8 @@ private:
     unsigned int rbo = 0;
     int width = 1280;
     int height = 720;
+    int fboWidth = 0;           // size the framebuffer was created with
+    int fboHeight = 0;
 
     float stickX = 0.0f;
     float stickY = 0.0f;
@@ -78,4 +90,9 @@ private:
     static constexpr double STICK_REPEAT_RATE = 0.15;
     bool needsHookEvents = false;
     int uiLayer = 0;
+
+    bool viewDirty = true;      // Noesis reported a change not rendered yet
+    bool textureStale = true;   // the texture doesn't hold the view (new framebuffer or view)
+    float updateRate = 0.0f;
+    float lastRenderTime = 0.0f;
 };
\ No newline at end of file
@@ -0,0 +1,59 @@
+#include "ComponentLight.h"
+#include <nlohmann/json.hpp>
+#include "Application.h"
+#include "Renderer.h"
+#include <algorithm>
+#ifndef WAVE_GAME
+#include <imgui.h>
+#endif
+
+ComponentLight::ComponentLight(GameObject* owner)
+    : Component(owner, ComponentType::LIGHT)
+{
+    name = "Light";
+    Application::GetInstance().renderer->AddLight(this);
+}
+
+ComponentLight::~ComponentLight()
+{
+    Application::GetInstance().renderer->RemoveLight(this);
+}
+
+void ComponentLight::OnEditor()
+{
+#ifndef WAVE_GAME
+    const char* types[] = { "Point", "Spot" };
+    int type = (int)lightType;
+    if (ImGui::Combo("Type", &type, types, IM_ARRAYSIZE(types))) lightType = (LightType)type;
+
+    ImGui::ColorEdit3("Color", &color.x);
+    ImGui::DragFloat("Intensity", &intensity, 0.05f, 0.0f, 100.0f);
+    ImGui::DragFloat("Range", &range, 0.1f, 0.01f, 1000.0f);
+
+    if (lightType == LightType::SPOT)
+    {
+        ImGui::SliderFloat("Spot Angle", &spotAngle, 1.0f, 179.0f);
+        ImGui::SliderFloat("Spot Blend", &spotBlend, 0.0f, 1.0f);
+    }
+#endif
+}
+
+void ComponentLight::Serialize(nlohmann::json& o) const
+{
+    o["lightType"] = (int)lightType;
+    o["color"] = { color.x, color.y, color.z };
+    o["intensity"] = intensity;
+    o["range"] = range;
+    o["spotAngle"] = spotAngle;
+    o["spotBlend"] = spotBlend;
+}
+
+void ComponentLight::Deserialize(const nlohmann::json& o)
+{
+    lightType = (LightType)std::clamp(o.value("lightType", 0), 0, 1);
+    if (o.contains("color")) color = glm::vec3(o["color"][0], o["color"][1], o["color"][2]);
+    intensity = o.value("intensity", 1.0f);
+    range = o.value("range", 10.0f);
+    spotAngle = o.value("spotAngle", 45.0f);
+    spotBlend = o.value("spotBlend", 0.2f);
+}
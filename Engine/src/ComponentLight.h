@@ -0,0 +1,31 @@
+#pragma once
+#include "Component.h"
+#include <nlohmann/json_fwd.hpp>
+#include <glm/glm.hpp>
+
+enum class LightType {
+    POINT,
+    SPOT, // shines along the transform's forward
+};
+
+class ComponentLight : public Component {
+public:
+    ComponentLight(GameObject* owner);
+    ~ComponentLight();
+
+    void OnEditor() override;
+
+    void Serialize(nlohmann::json& componentObj) const override;
+    void Deserialize(const nlohmann::json& componentObj) override;
+
+    bool IsType(ComponentType type) override { return type == ComponentType::LIGHT; }
+    bool IsIncompatible(ComponentType type) override { return type == ComponentType::LIGHT; }
+
+public:
+    LightType lightType = LightType::POINT;
+    glm::vec3 color = glm::vec3(1.0f);
+    float intensity = 1.0f;
+    float range = 10.0f;        // no light past this distance
+    float spotAngle = 45.0f;    // full cone, degrees
+    float spotBlend = 0.2f;     // fraction of the cone that fades out
+};
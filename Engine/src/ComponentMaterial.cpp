@@ -6,6 +6,8 @@
 #include "Renderer.h"
 #include "Texture.h"
 #include "ResourceShader.h"
+#include "Shader.h"
+#include "GLState.h"
 #include "Log.h"
 #include <glad/glad.h>
 #include <SDL3/SDL_timer.h>
@@ -30,6 +32,11 @@ ComponentMaterial::~ComponentMaterial()
 {
     ReleaseCurrentTexture();
     ReleaseCurrentShader();
+
+    if (uniformSlot >= 0) {
+        Application::GetInstance().renderer->ReleaseMaterialSlot((unsigned int)uniformSlot);
+        uniformSlot = -1;
+    }
 }
 
 void ComponentMaterial::Update()
@@ -471,43 +478,70 @@ void ComponentMaterial::CreateCheckerboardTexture()
     LOG_DEBUG("[ComponentMaterial] Checkerboard texture activated");
 }
 
-void ComponentMaterial::Use()
+unsigned int ComponentMaterial::GetTextureID() const
 {
     if (useCheckerboard) {
         Renderer* renderer = Application::GetInstance().renderer.get();
         if (renderer && renderer->GetDefaultTexture()) {
-            renderer->GetDefaultTexture()->Bind();
-        }
-        else {
-            glBindTexture(GL_TEXTURE_2D, 0);
+            return renderer->GetDefaultTexture()->GetID();
         }
-        return;
+        return 0;
     }
 
     if (textureUID == 0) {
-        glBindTexture(GL_TEXTURE_2D, 0);
-        return;
+        return 0;
     }
 
     const Resource* resource = Application::GetInstance().resources->GetResource(textureUID);
 
     if (!resource || !resource->IsLoadedToMemory()) {
-        glBindTexture(GL_TEXTURE_2D, 0);
-        return;
+        return 0;
     }
 
     const ResourceTexture* texResource = dynamic_cast<const ResourceTexture*>(resource);
-    if (texResource) {
-        glBindTexture(GL_TEXTURE_2D, texResource->GetGPU_ID());
+    return texResource ? texResource->GetGPU_ID() : 0;
+}
+
+bool ComponentMaterial::HasCutout() const
+{
+    if (useCheckerboard || textureUID == 0) {
+        return false;
     }
-    else {
-        glBindTexture(GL_TEXTURE_2D, 0);
+
+    const Resource* resource = Application::GetInstance().resources->GetResource(textureUID);
+
+    if (!resource || !resource->IsLoadedToMemory()) {
+        return false;
     }
+
+    const ResourceTexture* texResource = dynamic_cast<const ResourceTexture*>(resource);
+    return texResource && !texResource->IsOpaque();
+}
+
+void ComponentMaterial::Use()
+{
+    GLState::BindTexture(GL_TEXTURE_2D, GetTextureID());
 }
 
 void ComponentMaterial::Unbind()
 {
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::BindTexture(GL_TEXTURE_2D, 0);
+}
+
+MaterialUniformData ComponentMaterial::GetUniformData() const
+{
+    MaterialUniformData data;
+    data.materialDiffuse = glm::vec3(diffuseColor);
+    data.opacity = opacity;
+    return data;
+}
+
+unsigned int ComponentMaterial::GetUniformSlot()
+{
+    if (uniformSlot < 0) {
+        uniformSlot = (int)Application::GetInstance().renderer->AcquireMaterialSlot();
+    }
+    return (unsigned int)uniformSlot;
 }
 
 int ComponentMaterial::GetTextureWidth() const
@@ -4,6 +4,8 @@
 #include <string>
 #include <glm/glm.hpp> 
 
+struct MaterialUniformData;
+
 enum class MaterialType {
     STANDARD,
     WATER
@@ -35,6 +37,15 @@ public:
 
     void Use();
     void Unbind();
+    // GL texture Use binds, 0 when there is none or it isn't loaded
+    unsigned int GetTextureID() const;
+    // The texture may have texels the mesh shader's alpha cutout discards
+    bool HasCutout() const;
+
+    // Values of the MaterialData block, no GL calls
+    MaterialUniformData GetUniformData() const;
+    // Slot of the renderer's MaterialData buffer, taken on first use. No GL calls
+    unsigned int GetUniformSlot();
 
     bool HasTexture() const { return textureUID != 0 || useCheckerboard; }
     bool HasOriginalTexture() const { return originalTextureUID != 0; }
@@ -124,4 +135,6 @@ private:
     MaterialType materialType = MaterialType::STANDARD;
 
     bool hasMaterialProperties = false;
+
+    int uniformSlot = -1;
 };
\ No newline at end of file
@@ -5,9 +5,12 @@
 #include "Application.h"
 #include "ModuleResources.h"
 #include "ResourceMesh.h"
+#include "VertexFormat.h"
+#include "GLState.h"
 #include "Transform.h"
 #include "Log.h"
 #include <glad/glad.h>
+#include <algorithm>
 #include "Application.h"
 ComponentMesh::ComponentMesh(GameObject* owner, ComponentType type)
     : Component(owner, type),
@@ -25,21 +28,29 @@ ComponentMesh::~ComponentMesh()
     ReleaseCurrentMesh();
     Application::GetInstance().renderer->RemoveMesh(this);
 
-    // Clean up direct mesh GPU resources if present
-    if (hasDirectMesh && directMesh.VAO != 0) {
-        glDeleteVertexArrays(1, &directMesh.VAO);
-        glDeleteBuffers(1, &directMesh.VBO);
-        glDeleteBuffers(1, &directMesh.EBO);
-    }
+    if (ModuleScene* scene = Application::GetInstance().scene.get())
+        scene->ForgetObject(owner);
 }
 
 void ComponentMesh::ReleaseCurrentMesh()
 {
+    if (holdsCPUData) {
+        ReleaseCPUData();
+        holdsCPUData = false;
+    }
+
     if (meshUID != 0) {
         Application::GetInstance().resources->ReleaseResource(meshUID);
         meshUID = 0;
     }
 
+    // Clean up direct mesh GPU resources if present
+    if (hasDirectMesh) {
+        GeometryArena::GetInstance().Free(directMesh);
+        VertexFormat::Release(directMesh);
+        directMesh = Mesh();
+    }
+
     hasDirectMesh = false;
 }
 
@@ -76,77 +87,84 @@ bool ComponentMesh::LoadMeshByUID(UID meshUID)
 
     const Mesh& loadedMesh = meshResource->GetMesh();
 
-    if (loadedMesh.vertices.empty() || loadedMesh.indices.empty())
+    if (!loadedMesh.IsValid() || loadedMesh.GetIndexCount() == 0)
     {
         LOG_CONSOLE("ERROR: Loaded mesh is empty (UID: %llu)", meshUID);
+        Application::GetInstance().resources->ReleaseResource(meshUID);
         return false;
     }
 
-    // Assign mesh to component
-    SetMesh(loadedMesh);
-
-    // Store UID for reference
+    // The resource is shared, only the previous mesh is released
+    ReleaseCurrentMesh();
     this->meshUID = meshUID;
 
+    OnMeshChanged();
+
     return true;
 }
 
 void ComponentMesh::SetMesh(const Mesh& mesh)
 {
+    // mesh can belong to what is released below
+    Mesh newMesh = mesh;
+
     // Release resource system mesh if any
     ReleaseCurrentMesh();
 
-    // Copy mesh data for direct storage
-    directMesh = mesh;
+    // Copy mesh data for direct storage. The arena range belongs to the source mesh
+    directMesh = std::move(newMesh);
+    directMesh.arenaRange = ArenaRange();
     hasDirectMesh = true;
 
-    // Upload mesh to GPU if data is available
-    if (!directMesh.vertices.empty() && !directMesh.indices.empty())
-    {
-        // Generate OpenGL buffers
-        glGenVertexArrays(1, &directMesh.VAO);
-        glGenBuffers(1, &directMesh.VBO);
-        glGenBuffers(1, &directMesh.EBO);
-
-        glBindVertexArray(directMesh.VAO);
-
-        // Upload vertex data
-        glBindBuffer(GL_ARRAY_BUFFER, directMesh.VBO);
-        glBufferData(GL_ARRAY_BUFFER,
-            directMesh.vertices.size() * sizeof(Vertex),
-            directMesh.vertices.data(),
-            GL_STATIC_DRAW);
-
-        // Upload index data
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, directMesh.EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-            directMesh.indices.size() * sizeof(unsigned int),
-            directMesh.indices.data(),
-            GL_STATIC_DRAW);
-
-        // Configure vertex attributes
-        // Position
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-
-        // Normal
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-            (void*)offsetof(Vertex, normal));
-
-        // TexCoords
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-            (void*)offsetof(Vertex, texCoords));
-
-        glBindVertexArray(0);
-    }
+    // Upload mesh to GPU
+    VertexFormat::Upload(directMesh);
+
+    OnMeshChanged();
+}
+
+void ComponentMesh::OnMeshChanged()
+{
+    // Occluders are rasterized from the CPU copy
+    if (occluder && !holdsCPUData) holdsCPUData = AcquireCPUData();
 
     UpdateStaticAABB();
 
     owner->PublishGameObjectEvent(GameObjectEvent::MESH_CHANGED, this);
 }
 
+void ComponentMesh::SetOccluder(bool b)
+{
+    occluder = b;
+
+    if (occluder && !holdsCPUData) {
+        holdsCPUData = AcquireCPUData();
+    }
+    else if (!occluder && holdsCPUData) {
+        ReleaseCPUData();
+        holdsCPUData = false;
+    }
+}
+
+bool ComponentMesh::AcquireCPUData()
+{
+    if (meshUID == 0) return hasDirectMesh && directMesh.HasCPUData();
+
+    Resource* resource = Application::GetInstance().resources->GetResourceDirect(meshUID);
+    if (!resource || resource->GetType() != Resource::MESH) return false;
+
+    return static_cast<ResourceMesh*>(resource)->AcquireCPUData();
+}
+
+void ComponentMesh::ReleaseCPUData()
+{
+    if (meshUID == 0) return;
+
+    Resource* resource = Application::GetInstance().resources->GetResourceDirect(meshUID);
+    if (resource && resource->GetType() == Resource::MESH) {
+        static_cast<ResourceMesh*>(resource)->ReleaseCPUData();
+    }
+}
+
 const Mesh& ComponentMesh::GetMesh() const
 {
     // Return resource mesh if loaded
@@ -187,14 +205,14 @@ bool ComponentMesh::HasMesh() const
             const ResourceMesh* meshResource = dynamic_cast<const ResourceMesh*>(resource);
             if (meshResource) {
                 const Mesh& mesh = meshResource->GetMesh();
-                return !mesh.vertices.empty() && !mesh.indices.empty();
+                return mesh.GetVertexCount() > 0 && mesh.GetIndexCount() > 0;
             }
         }
     }
 
     // Verify direct mesh availability
     if (hasDirectMesh) {
-        return !directMesh.vertices.empty() && !directMesh.indices.empty();
+        return directMesh.GetVertexCount() > 0 && directMesh.GetIndexCount() > 0;
     }
 
     return false;
@@ -224,14 +242,14 @@ void ComponentMesh::Draw()
     }
 
     // Render mesh if valid
-    if (meshToDraw && meshToDraw->VAO != 0 && !meshToDraw->indices.empty()) {
-        glBindVertexArray(meshToDraw->VAO);
-        glDrawElements(GL_TRIANGLES, meshToDraw->indices.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+    if (meshToDraw && meshToDraw->VAO != 0 && meshToDraw->GetIndexCount() > 0) {
+        GLState::BindVertexArray(meshToDraw->VAO);
+        glDrawElements(GL_TRIANGLES, meshToDraw->GetIndexCount(), GL_UNSIGNED_INT, 0);
+        GLState::BindVertexArray(0);
     }
 }
 
-const AABB& ComponentMesh::GetGlobalAABB() const
+AABB ComponentMesh::GetGlobalAABB() const
 {
     return staticAABB.GetGlobalAABB(owner->transform->GetGlobalMatrix());
 }
@@ -246,12 +264,12 @@ void ComponentMesh::UpdateStaticAABB()
 {
     staticAABB.SetNegativeInfinity();
     
+    // Bounds are computed on upload, the vertices may no longer be on the CPU
     const Mesh& mesh = GetMesh();
-    if (!mesh.IsValid() || mesh.vertices.empty()) return;
+    if (!mesh.IsValid() || mesh.GetVertexCount() == 0) return;
 
-    for (const auto& vertex : mesh.vertices) {
-        staticAABB.Enclose(vertex.position);
-    }
+    staticAABB.Enclose(mesh.boundsMin);
+    staticAABB.Enclose(mesh.boundsMax);
 }
 
 void ComponentMesh::Serialize(nlohmann::json& componentObj) const
@@ -265,10 +283,26 @@ void ComponentMesh::Serialize(nlohmann::json& componentObj) const
     if (hasDirectMesh && !primitiveType.empty()) {
         componentObj["primitiveType"] = primitiveType;
     }
+
+    // Occlusion
+    if (occluder) {
+        componentObj["occluder"] = occluder;
+    }
+
+    // LOD
+    if (forcedLOD >= 0) {
+        componentObj["forcedLOD"] = forcedLOD;
+    }
 }
 
 void ComponentMesh::Deserialize(const nlohmann::json& componentObj)
 {
+    // Occlusion, the CPU copy is acquired once the mesh is set
+    occluder = componentObj.value("occluder", false);
+
+    // LOD
+    forcedLOD = componentObj.value("forcedLOD", -1);
+
     // UID
     if (componentObj.contains("meshUID")) {
         UID uid = componentObj["meshUID"].get<UID>();
@@ -300,17 +334,49 @@ void ComponentMesh::Deserialize(const nlohmann::json& componentObj)
     }
 }
 
+// Below each size the next level is used
+const float ComponentMesh::kLODScreenSizes[kMaxMeshLODs - 1] = { 0.25f, 0.1f, 0.04f };
+const float ComponentMesh::kLODHysteresis = 0.15f;
+
+int ComponentMesh::SelectLOD(float screenSize, int previousLOD) const
+{
+    int lodCount = GetMesh().GetLODCount();
+
+    if (forcedLOD >= 0) return std::min(forcedLOD, lodCount - 1);
+
+    int lod = std::clamp(previousLOD, 0, lodCount - 1);
+
+    while (lod < lodCount - 1 && screenSize < kLODScreenSizes[lod] * (1.0f - kLODHysteresis))
+        lod++;
+    while (lod > 0 && screenSize > kLODScreenSizes[lod - 1] * (1.0f + kLODHysteresis))
+        lod--;
+
+    return lod;
+}
+
 void ComponentMesh::OnGameObjectEvent(GameObjectEvent event, Component* component)
 {
     switch (event)
     {
     case GameObjectEvent::COMPONENT_ADDED:
         if (component->IsType(ComponentType::MATERIAL))
+        {
             attachedMaterial = (ComponentMaterial*)component;
+            Application::GetInstance().renderer->MarkMeshDirty(this);
+        }
         break;
     case GameObjectEvent::COMPONENT_REMOVED:
         if (component->IsType(ComponentType::MATERIAL))
+        {
             attachedMaterial = nullptr;
+            Application::GetInstance().renderer->MarkMeshDirty(this);
+        }
+        break;
+    case GameObjectEvent::TRANSFORM_CHANGED:
+    case GameObjectEvent::TRANSFORM_SCALED:
+    case GameObjectEvent::MESH_CHANGED:
+        Application::GetInstance().scene->NotifyObjectMoved(owner);
+        Application::GetInstance().renderer->MarkMeshDirty(this);
         break;
     }
 }
\ No newline at end of file
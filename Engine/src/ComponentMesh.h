@@ -45,9 +45,10 @@ public:
 
     unsigned int GetNumVertices() const {
         const Mesh& m = GetMesh();
-        return static_cast<unsigned int>(m.vertices.size());
+        return m.GetVertexCount();
     }
     
+    // Empty unless the CPU data is held, see AcquireCPUData
     std::vector<Vertex> GetVertices() const {
         const Mesh& m = GetMesh();
         return m.vertices;
@@ -55,7 +56,7 @@ public:
 
     unsigned int GetNumIndices() const {
         const Mesh& m = GetMesh();
-        return static_cast<unsigned int>(m.indices.size());
+        return m.GetIndexCount();
     }
 
     std::vector<unsigned int> GetIndices() const {
@@ -73,10 +74,15 @@ public:
         return static_cast<unsigned int>(m.textures.size());
     }
 
+    // Resource meshes may drop their vertices and indices after upload. Hold them while
+    // reading them on the CPU. Returns false if they can't be loaded
+    bool AcquireCPUData();
+    void ReleaseCPUData();
+
     ComponentMaterial* GetAttachedMaterial() { return attachedMaterial; }
 
     const AABB& GetAABB() const;
-    const AABB& GetGlobalAABB() const;
+    AABB GetGlobalAABB() const;
     void UpdateStaticAABB();
     virtual void UpdateDynamicAABB() {}
 
@@ -92,14 +98,36 @@ public:
     void SetDrawNormals(bool b) { drawNormals = b; };
     bool GetDrawNormals() { return drawNormals; }
 
+    //OCCLUSION
+    // Occluders keep the CPU copy of their mesh
+    void SetOccluder(bool b);
+    bool IsOccluder() const { return occluder; }
+
+    //LOD
+    // Picks a level from the projected size (bounding radius over half the screen height), starting
+    // from the level the same camera drew last. A level only changes once the size is clearly past
+    // its threshold, so it doesn't flicker
+    int SelectLOD(float screenSize, int previousLOD) const;
+    int GetLODCount() const { return GetMesh().GetLODCount(); }
+    void SetForcedLOD(int lod) { forcedLOD = lod; }
+    int GetForcedLOD() const { return forcedLOD; }
+
+    static const float kLODScreenSizes[kMaxMeshLODs - 1];
+    static const float kLODHysteresis;
+
+    //STATIC BATCHING
+    void SetStaticBatched(bool b) { staticBatched = b; }
+    bool IsStaticBatched() const { return staticBatched; }
+
 private:
-    void OnGameObjectEvent(GameObjectEvent event, Component* component);
+    void OnGameObjectEvent(GameObjectEvent event, Component* component) override;
 
 
 protected:
 
     UID meshUID = 0;
     void ReleaseCurrentMesh();
+    virtual void OnMeshChanged();
 
     Mesh directMesh;
     bool hasDirectMesh;
@@ -117,4 +145,14 @@ protected:
     //DEBUG
     bool drawMesh = false;
     bool drawNormals = false;
+
+    //OCCLUSION
+    bool occluder = false;
+    bool holdsCPUData = false;
+
+    //LOD
+    int forcedLOD = -1;           // -1 selects by screen size
+
+    //STATIC BATCHING
+    bool staticBatched = false;   // drawn as part of a static batch instead
 };
\ No newline at end of file
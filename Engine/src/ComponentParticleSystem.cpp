@@ -27,6 +27,8 @@ ComponentParticleSystem::ComponentParticleSystem(GameObject* owner)
 ComponentParticleSystem::~ComponentParticleSystem() {
     
     Application::GetInstance().renderer.get()->RemoveParticle(this);
+    if (ModuleScene* scene = Application::GetInstance().scene.get())
+        scene->CancelEmitterUpdate(emitter);
     // Release texture resource reference
     if (textureResourceUID != 0) {
         Application::GetInstance().resources->ReleaseResource(textureResourceUID);
@@ -64,47 +66,9 @@ void ComponentParticleSystem::Update() {
     // Only update simulation on PLAY mode
     if (Application::GetInstance().GetPlayState() != Application::PlayState::PLAYING) return;
 
-    // Prewarm logic, instant simulation at start
-    if (emitter->prewarm && emitter->systemTime == 0.0f) {
-        float simStep = 0.1f;
-        float simTime = 2.0f; // Simulate 2 seconds instantly
-        for (float t = 0; t < simTime; t += simStep) {
-            emitter->Update(simStep);
-        }
-    }
-
+    // Simulated with the other emitters once every GameObject updated
     float dt = Application::GetInstance().time->GetDeltaTime();
-    emitter->Update(dt);
-}
-
-void ComponentParticleSystem::Draw(ComponentCamera* camera) {
-    
-    if (!active || !emitter) return;
-
-    glUseProgram(0);
-    glBindVertexArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
-    // Setup Legacy Matrices
-    glMatrixMode(GL_PROJECTION);
-    glLoadMatrixf(glm::value_ptr(camera->GetProjectionMatrix()));
-
-    glMatrixMode(GL_MODELVIEW);
-    glm::mat4 viewMatrix = camera->GetViewMatrix();
-    glLoadMatrixf(glm::value_ptr(viewMatrix));
-
-    // Simulation space logic in render
-    if (emitter->simulationSpace == SimulationSpace::LOCAL) {
-        // In LOCAL, we apply the object's matrix. Particles move with it
-        Transform* trans = dynamic_cast<Transform*>(owner->GetComponent(ComponentType::TRANSFORM));
-        if (trans) {
-            glMultMatrixf(glm::value_ptr(trans->GetGlobalMatrix()));
-        }
-    }
-    // In WORLD, we don't apply the object's matrix Identity, because particles already have absolute world positions calculated in Update()
-    // Draw particles
-    emitter->Draw(camera->owner->transform->GetGlobalPosition());
+    Application::GetInstance().scene->ScheduleEmitterUpdate(emitter, dt);
 }
 
 void ComponentParticleSystem::OnEditor() {
@@ -191,6 +155,11 @@ void ComponentParticleSystem::OnEditor() {
         }
 
         ImGui::Checkbox("Additive Blending (Glow)", &emitter->additiveBlending);
+        ImGui::BeginDisabled(emitter->additiveBlending);
+        ImGui::Checkbox("Sort Particles", &emitter->sortParticles);
+        ImGui::EndDisabled();
+        if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled))
+            ImGui::SetTooltip("Draw back to front, additive blending doesn't need it");
 
         // Module settings
         ModuleEmitterSpawn* spawner = nullptr;
@@ -326,7 +295,7 @@ void ComponentParticleSystem::OnEditor() {
             ImGui::TextColored(color, "%s", feedbackMessage.c_str());
         }
         ImGui::Separator();
-        ImGui::TextColored(ImVec4(0, 1, 1, 1), "Particles Alive: %d", (int)emitter->particles.size());
+        ImGui::TextColored(ImVec4(0, 1, 1, 1), "Particles Alive: %d", emitter->particles.Count());
     #endif 
 }
 
@@ -371,6 +340,7 @@ void ComponentParticleSystem::Serialize(nlohmann::json& componentObj) const {
     componentObj["texturePath"] = emitter->texturePath;
     if (textureResourceUID != 0) componentObj["textureUID"] = textureResourceUID;
     componentObj["additive"] = emitter->additiveBlending;
+    componentObj["sortParticles"] = emitter->sortParticles;
     componentObj["textureRows"] = emitter->textureRows;
     componentObj["textureCols"] = emitter->textureCols;
     componentObj["animSpeed"] = emitter->animationSpeed;
@@ -450,6 +420,7 @@ void ComponentParticleSystem::Deserialize(const nlohmann::json& componentObj) {
     }
     if (emitter->textureID == 0 && componentObj.contains("texturePath")) SetTexture(componentObj["texturePath"]);
     if (componentObj.contains("additive")) emitter->additiveBlending = componentObj["additive"];
+    if (componentObj.contains("sortParticles")) emitter->sortParticles = componentObj["sortParticles"];
     if (componentObj.contains("textureRows")) emitter->textureRows = componentObj["textureRows"];
     if (componentObj.contains("textureCols")) emitter->textureCols = componentObj["textureCols"];
     if (componentObj.contains("animSpeed")) emitter->animationSpeed = componentObj["animSpeed"];
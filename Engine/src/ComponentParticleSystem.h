@@ -12,7 +12,6 @@ public:
     virtual ~ComponentParticleSystem();
 
     void Update() override;
-    void Draw(ComponentCamera* camera);
 
     bool IsType(ComponentType type) override { return type == ComponentType::PARTICLE; };
     bool IsIncompatible(ComponentType type) override { return false; };
@@ -26,11 +26,11 @@ ComponentSkinnedMesh::~ComponentSkinnedMesh()
 }
 
 
-void ComponentSkinnedMesh::SetMesh(const Mesh& meshData)
+void ComponentSkinnedMesh::OnMeshChanged()
 {
-    ComponentMesh::SetMesh(meshData);
     bonesLinked = false;
     boneGameObjects.clear();
+    ComponentMesh::OnMeshChanged();
 }
 
 void ComponentSkinnedMesh::LinkBones() {
@@ -91,8 +91,6 @@ void ComponentSkinnedMesh::UpdateSkinningMatrices()
             boneGlobalMatrices[i] = glm::mat4(1.0f);
     }
 
-    Application::GetInstance().renderer->UploadGlobalMatricesToGPU(ssboGlobalMatrices, boneGlobalMatrices);
-
     hasSkinningData = true;
 }
 
@@ -19,14 +19,14 @@ public:
     void Update() override;
 
     void LinkBones();
+    // Computes the bone palette on the CPU, the draws that record it upload it
     void UpdateSkinningMatrices();
     bool HasSkinning() const override { return hasSkinningData; }
 
-    void SetMesh(const Mesh& meshData) override;
-
     const glm::mat4& GetMeshInverse() const { return meshInverseTransform; }
     unsigned int GetSSBOGlobal() const { return ssboGlobalMatrices; }
     unsigned int GetSSBOOffset() const { return ssboOffsetMatrices; }
+    const std::vector<glm::mat4>& GetBoneMatrices() const { return boneGlobalMatrices; }
     int GetLinkedBonesNum() const { return boneGameObjects.size(); }
 
     void OnEvent(const Event& event);
@@ -35,6 +35,7 @@ protected:
 
     UID meshUID = 0;
     void ReleaseCurrentMesh();
+    void OnMeshChanged() override;
 
 private:
 
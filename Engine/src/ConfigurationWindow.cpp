@@ -7,6 +7,16 @@
 #include <psapi.h>
 #include "Application.h"
 #include "ModuleCamera.h"
+#include "GeometryArena.h"
+#include "VertexFormat.h"
+#include "ResourceMesh.h"
+#include "ResourceTexture.h"
+#include "ParticleSystem.h"
+#include "ShaderCache.h"
+#include "TextureStreamer.h"
+#include "UploadManager.h"
+#include "GLState.h"
+#include "GpuProfiler.h"
 #include "Log.h"
 
 ConfigurationWindow::ConfigurationWindow()
@@ -243,6 +253,16 @@ void ConfigurationWindow::DrawRendererSettings()
     {
         ImGui::SetTooltip("Visualize depth buffer as grayscale\nWhite = Near, Black = Far");
     }
+
+    bool showOverdraw = renderer->IsShowingOverdraw();
+    if (ImGui::Checkbox("Show Overdraw", &showOverdraw))
+    {
+        renderer->SetShowOverdraw(showOverdraw);
+    }
+    if (ImGui::IsItemHovered())
+    {
+        ImGui::SetTooltip("Every shaded fragment brightens its pixel\nThe scene camera's opaque overdraw is shown in the stats");
+    }
 	ImGui::Spacing();
 
     bool faceCulling = renderer->IsFaceCullingEnabled();
@@ -283,6 +303,220 @@ void ConfigurationWindow::DrawRendererSettings()
     }
     if (ImGui::IsItemHovered()) ImGui::SetTooltip("Render meshes as wireframes");
 
+    bool instancing = renderer->IsInstancingEnabled();
+    if (ImGui::Checkbox("GPU Instancing", &instancing))
+    {
+        renderer->SetInstancing(instancing);
+    }
+    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Merge opaque meshes sharing mesh and material into instanced draws");
+
+    bool renderThread = renderer->IsRenderThreadEnabled();
+    if (ImGui::Checkbox("Render Thread", &renderThread))
+    {
+        renderer->SetRenderThreadEnabled(renderThread);
+    }
+    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Replay each camera on a thread holding the GL context while the next camera is recorded (needs more than one camera)");
+
+    bool meshLOD = renderer->IsMeshLODEnabled();
+    if (ImGui::Checkbox("Mesh LOD", &meshLOD))
+    {
+        renderer->SetMeshLOD(meshLOD);
+    }
+    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Draw simplified levels of imported meshes as they get smaller on screen");
+
+    bool multiDraw = renderer->IsMultiDrawIndirectEnabled();
+    if (ImGui::Checkbox("Multi-Draw Indirect", &multiDraw))
+    {
+        renderer->SetMultiDrawIndirect(multiDraw);
+    }
+    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Submit opaque meshes from a shared vertex/index arena with one indirect draw per material (needs GPU Instancing)");
+
+    bool depthPrepass = renderer->IsDepthPrepassEnabled();
+    if (ImGui::Checkbox("Depth Pre-Pass", &depthPrepass))
+    {
+        renderer->SetDepthPrepass(depthPrepass);
+    }
+    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Draw opaque depth front to back from positions only, then shade each pixel once with an equal depth test (skinned and cutout meshes are shaded after it)");
+
+    bool compactVertices = VertexFormat::GetDefaultLayout() == VertexLayout::COMPACT;
+    if (ImGui::Checkbox("Compact Vertex Format", &compactVertices))
+    {
+        VertexFormat::SetDefaultLayout(compactVertices ? VertexLayout::COMPACT : VertexLayout::FULL);
+    }
+    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Upload and save meshes as 20 byte vertices plus an 8 byte skinning stream instead of 80 bytes (applies to meshes loaded or imported afterwards)");
+
+    bool releaseMeshData = ResourceMesh::GetDefaultResidency() == MeshResidency::RELEASE_AFTER_UPLOAD;
+    if (ImGui::Checkbox("Release Mesh CPU Data", &releaseMeshData))
+    {
+        MeshResidency residency = releaseMeshData ? MeshResidency::RELEASE_AFTER_UPLOAD : MeshResidency::KEEP_CPU;
+        ResourceMesh::SetDefaultResidency(residency);
+
+        for (const auto& pair : Application::GetInstance().resources->GetAllResources())
+        {
+            if (pair.second->GetType() == Resource::MESH)
+                static_cast<ResourceMesh*>(pair.second)->SetResidency(residency);
+        }
+    }
+    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Drop vertices and indices of mesh resources once uploaded, unless colliders, navmesh or occluders need them");
+
+    ShaderCache& shaderCache = ShaderCache::GetInstance();
+    bool shaderBinaries = shaderCache.IsEnabled();
+    if (ImGui::Checkbox("Shader Binary Cache", &shaderBinaries))
+    {
+        shaderCache.SetEnabled(shaderBinaries);
+    }
+    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Load linked shader programs from the Library instead of compiling them (applies to shaders loaded afterwards)");
+
+    const Renderer::RenderStats& renderStats = renderer->GetRenderStats();
+    ImGui::Text("Draw Calls: %d (%d instanced, %d objects)", renderStats.drawCalls,
+        renderStats.instancedDrawCalls, renderStats.instancedObjects);
+    ImGui::Text("Particles: %d in %d draws", renderStats.particles, renderStats.particleDrawCalls);
+    ImGui::Text("Render Commands: %d", renderStats.renderCommands);
+    ImGui::Text("Canvas Renders: %d rendered, %d reused", renderStats.canvasRenders, renderStats.canvasRendersSkipped);
+    ImGui::Text("Lights: %d in %d cluster entries, binned in %.3f ms", renderStats.lights, renderStats.lightIndices,
+        renderStats.lightBinTimeMs);
+    if (renderer->IsDepthPrepassEnabled())
+        ImGui::Text("Depth Pre-Pass Draws: %d", renderStats.prepassDrawCalls);
+    if (renderer->IsShowingOverdraw())
+        ImGui::Text("Opaque Overdraw: %.2f shaded samples per sample", renderer->GetOpaqueOverdraw());
+    const GLState::Stats& stateStats = GLState::GetStats();
+    ImGui::Text("GL State Calls: %d issued, %d skipped as redundant", stateStats.calls, stateStats.skipped);
+    if (renderer->IsMultiDrawIndirectEnabled())
+    {
+        const GeometryArena& arena = GeometryArena::GetInstance();
+        ImGui::Text("Indirect Commands: %d", renderStats.indirectCommands);
+        ImGui::Text("Geometry Arena: %u / %u vertices, %u / %u indices", arena.GetUsedVertices(),
+            arena.GetVertexCapacity(), arena.GetUsedIndices(), arena.GetIndexCapacity());
+    }
+    ImGui::Text("Vertex Memory: %.2f MB (%.2f MB as full vertices)", VertexFormat::GetUploadedBytes() / (1024.0f * 1024.0f),
+        VertexFormat::GetUploadedFullBytes() / (1024.0f * 1024.0f));
+    ImGui::Text("Mesh Resources: %.2f MB CPU, %.2f MB GPU", ResourceMesh::GetTotalCPUBytes() / (1024.0f * 1024.0f),
+        ResourceMesh::GetTotalGPUBytes() / (1024.0f * 1024.0f));
+    ImGui::Text("Texture Memory: %.2f MB (%.2f MB as RGBA8)", ResourceTexture::GetTotalGPUBytes() / (1024.0f * 1024.0f),
+        ResourceTexture::GetTotalUncompressedBytes() / (1024.0f * 1024.0f));
+
+    TextureStreamer& textureStreamer = TextureStreamer::GetInstance();
+    bool textureStreaming = textureStreamer.IsEnabled();
+    if (ImGui::Checkbox("Texture Streaming", &textureStreaming))
+    {
+        textureStreamer.SetEnabled(textureStreaming);
+    }
+    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Load textures with their small mips only and stream larger ones by screen coverage (applies to textures loaded afterwards)");
+
+    int textureBudgetMB = (int)(textureStreamer.GetBudget() / (1024 * 1024));
+    if (ImGui::SliderInt("Texture Budget (MB)", &textureBudgetMB, 32, 4096))
+    {
+        textureStreamer.SetBudget((size_t)textureBudgetMB * 1024 * 1024);
+    }
+
+    const TextureStreamer::Stats& streamStats = textureStreamer.GetStats();
+    ImGui::Text("Streaming: %d textures, %d pending (%.2f MB reserved), %d over budget, %d loaded / %d evicted levels",
+        streamStats.streamedTextures, streamStats.pendingRequests, streamStats.reservedBytes / (1024.0f * 1024.0f),
+        streamStats.deferredRequests, streamStats.loadedLevels, streamStats.evictedLevels);
+
+    UploadManager& uploadManager = UploadManager::GetInstance();
+    int uploadBudgetMB = (int)(uploadManager.GetFrameBudget() / (1024 * 1024));
+    if (ImGui::SliderInt("Upload Budget (MB/frame)", &uploadBudgetMB, 1, 64))
+    {
+        uploadManager.SetFrameBudget((size_t)uploadBudgetMB * 1024 * 1024);
+    }
+    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Bytes of texture and mesh data staged to the GPU per frame, larger uploads wait for the next frames");
+
+    const UploadManager::Stats& uploadStats = uploadManager.GetStats();
+    ImGui::Text("Uploads: %d queued (%.2f MB), %.2f MB last frame, %d batches in flight, ring %.1f / %.1f MB",
+        uploadStats.queuedUploads, uploadStats.queuedBytes / (1024.0f * 1024.0f),
+        uploadStats.uploadedBytes / (1024.0f * 1024.0f), uploadStats.batchesInFlight,
+        uploadStats.ringUsed / (1024.0f * 1024.0f), uploadStats.ringSize / (1024.0f * 1024.0f));
+    ImGui::Text("Triangles per LOD: %d / %d / %d / %d", renderStats.lodTriangles[0],
+        renderStats.lodTriangles[1], renderStats.lodTriangles[2], renderStats.lodTriangles[3]);
+    ImGui::Text("Submit Time: %.3f ms", renderStats.submitTimeMs);
+    const ShaderCache::Stats& shaderStats = shaderCache.GetStats();
+    ImGui::Text("Shaders: %d cached (%.2f ms), %d compiled (%.2f ms), %d rejected", shaderStats.hits,
+        shaderStats.loadTimeMs, shaderStats.compiled, shaderStats.compileTimeMs, shaderStats.rejected);
+    ImGui::Text("Render Lists: %.3f ms (%d static, %d dynamic, %d static re-sorts)", renderer->GetBuildListsTimeMs(),
+        renderer->GetStaticRenderObjectCount(), renderer->GetDynamicRenderObjectCount(), renderStats.staticPacketRebuilds);
+
+    GpuProfiler& gpuProfiler = GpuProfiler::GetInstance();
+    bool gpuTimers = gpuProfiler.IsEnabled();
+    if (ImGui::Checkbox("GPU Pass Timers", &gpuTimers))
+    {
+        gpuProfiler.SetEnabled(gpuTimers);
+    }
+    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Time each render pass on the GPU with timer queries read two frames later, also sent to Tracy as plots");
+    if (gpuTimers)
+    {
+        ImGui::Text("GPU Passes (last / min / avg / max ms over %d frames, %d dropped):",
+            GpuProfiler::kHistory, gpuProfiler.GetDroppedFrames());
+        for (const GpuProfiler::PassStats& pass : gpuProfiler.GetStats())
+        {
+            ImGui::Text("  %s: %.3f / %.3f / %.3f / %.3f", pass.name, pass.lastMs, pass.minMs, pass.avgMs, pass.maxMs);
+        }
+    }
+
+    ModuleScene* scene = Application::GetInstance().scene.get();
+    bool staticBatching = scene->IsStaticBatchingEnabled();
+    if (ImGui::Checkbox("Static Batching", &staticBatching))
+    {
+        scene->SetStaticBatchingEnabled(staticBatching);
+    }
+    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Merge static meshes by material and chunk when entering play mode");
+
+    const StaticBatcher::Stats& batchStats = scene->GetStaticBatcher().GetStats();
+    if (batchStats.batches > 0)
+    {
+        ImGui::Text("Static Batches: %d from %d meshes, %d vertices (%s, %.2f ms)", batchStats.batches,
+            batchStats.sourceMeshes, batchStats.vertices, batchStats.fromCache ? "cached" : "built", batchStats.buildTimeMs);
+    }
+    if (ImGui::Button("Benchmark Render Queue"))
+    {
+        renderer->BenchmarkRenderQueue();
+    }
+    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Log radix sort vs std::multimap timings for 10k-50k draws");
+    if (ImGui::Button("Benchmark Light Clustering"))
+    {
+        renderer->BenchmarkLightClustering();
+    }
+    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Log the CPU time of binning 64-1024 random point lights into the cluster grid");
+    if (ImGui::Button("Benchmark Particles"))
+    {
+        EmitterInstance::Benchmark();
+    }
+    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Log particles updated per millisecond for 100k and 1M particles");
+
+    ImGui::Spacing();
+
+    bool occlusion = renderer->IsOcclusionCullingEnabled();
+    if (ImGui::Checkbox("Occlusion Culling", &occlusion))
+    {
+        renderer->SetOcclusionCulling(occlusion);
+    }
+    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Skip meshes hidden behind occluders (CPU depth buffer)");
+
+    if (occlusion)
+    {
+        ImGui::Indent();
+
+        bool autoOccluders = renderer->IsAutoOccludersEnabled();
+        if (ImGui::Checkbox("Auto Occluders", &autoOccluders))
+        {
+            renderer->SetAutoOccluders(autoOccluders);
+        }
+        if (ImGui::IsItemHovered()) ImGui::SetTooltip("Also use large opaque meshes, not only the ones marked as Occluder");
+
+        int budget = renderer->GetOccluderTriangleBudget();
+        if (ImGui::DragInt("Triangle Budget", &budget, 100.0f, 0, 500000))
+        {
+            renderer->SetOccluderTriangleBudget(budget);
+        }
+
+        const OcclusionCuller::Stats& stats = renderer->GetOcclusionStats();
+        ImGui::Text("Occluders: %d (%d / %d triangles)", stats.occluders, stats.trianglesRasterized, stats.trianglesSubmitted);
+        ImGui::Text("Culled: %d / %d tested", stats.occludeesCulled, stats.occludeesTested);
+        ImGui::Text("Occlusion Time: %.3f ms", renderer->GetOcclusionTimeMs());
+
+        ImGui::Unindent();
+    }
+
     ImGui::Spacing();
     ImGui::Separator();
 
@@ -381,6 +615,22 @@ void ConfigurationWindow::DrawRendererSettings()
     }
     if (ImGui::IsItemHovered()) ImGui::SetTooltip("Show octree spatial partitioning structure");
 
+    ModuleScene* scene = Application::GetInstance().scene.get();
+    int octreeType = static_cast<int>(scene->GetOctreeType());
+    const char* octreeTypes[] = { "Strict", "Loose" };
+    if (ImGui::Combo("Octree Type", &octreeType, octreeTypes, 2))
+    {
+        scene->SetOctreeType(static_cast<OctreeType>(octreeType));
+    }
+    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Strict: objects are stored in every node they overlap\nLoose: nodes overlap, each object lives in one node");
+
+    ImGui::SameLine();
+    if (ImGui::Button("Benchmark"))
+    {
+        scene->BenchmarkOctree();
+    }
+    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Compare both octree types on the current scene (results in console)");
+
     if (ImGui::Checkbox("Show Raycast", &showRaycast))
     {
         LOG_DEBUG("Raycast visualization: %s", showRaycast ? "ON" : "OFF");
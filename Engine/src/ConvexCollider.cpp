@@ -54,15 +54,20 @@ void ConvexCollider::CookMesh() {
     {
         /*if (!meshRenderer) LOG(LogType::LOG_WARNING, "Convex Collider on '%s' ignored: No MeshRenderer component found.", owner->name.c_str());*/
     }
-    else
+    else if (meshRenderer->AcquireCPUData())
     {
-        int size = meshRenderer->GetNumVertices();
+        // Read straight from the mesh, GetVertices copies
+        const Mesh& mesh = meshRenderer->GetMesh();
+
+        int size = (int)mesh.vertices.size();
         std::vector<glm::vec3> vertices(size);
 
         for (int i = 0; i < size; i++) {
-            vertices[i] = meshRenderer->GetVertices()[i].position;
+            vertices[i] = mesh.vertices[i].position;
         }
 
+        meshRenderer->ReleaseCPUData();
+
         cookedMesh = PhysicsCooker::CookConvex((const float*)vertices.data(), (uint32_t)size, sizeof(glm::vec3));
     }
 
@@ -0,0 +1,298 @@
+#include "GLState.h"
+#include <array>
+
+namespace
+{
+    GLFunctions gl = GLState::GetDefaultFunctions();
+    GLState::Stats frameStats;
+    GLState::Stats lastFrameStats;
+
+    template <typename T>
+    struct Cached
+    {
+        T value = T();
+        bool valid = false;
+
+        // False when the value is already set and the call can be dropped
+        bool Set(const T& newValue)
+        {
+            if (valid && value == newValue)
+            {
+                frameStats.skipped++;
+                return false;
+            }
+
+            value = newValue;
+            valid = true;
+            frameStats.calls++;
+            return true;
+        }
+    };
+
+    // Capabilities the engine toggles per draw, anything else passes through
+    const GLenum kTrackedCaps[] = {
+        GL_DEPTH_TEST, GL_CULL_FACE, GL_BLEND, GL_STENCIL_TEST, GL_SCISSOR_TEST, GL_MULTISAMPLE, GL_POLYGON_OFFSET_LINE
+    };
+    const int kTrackedCapCount = sizeof(kTrackedCaps) / sizeof(kTrackedCaps[0]);
+
+    Cached<bool> caps[kTrackedCapCount];
+    Cached<GLuint> program;
+    Cached<GLuint> activeUnit;
+    Cached<GLuint> textures[GLState::kMaxTextureUnits];
+    Cached<GLuint> vertexArray;
+    Cached<GLboolean> depthMask;
+    Cached<GLenum> depthFunc;
+    Cached<std::array<GLenum, 2>> blendFunc;
+    Cached<GLenum> cullFace;
+    Cached<std::array<GLboolean, 4>> colorMask;
+    Cached<std::array<GLuint, 3>> stencilFunc;
+    Cached<GLuint> stencilMask;
+    Cached<std::array<GLenum, 3>> stencilOp;
+    Cached<GLenum> polygonMode;
+
+    int FindCap(GLenum cap)
+    {
+        for (int i = 0; i < kTrackedCapCount; ++i)
+        {
+            if (kTrackedCaps[i] == cap) return i;
+        }
+        return -1;
+    }
+}
+
+GLFunctions GLState::GetDefaultFunctions()
+{
+    GLFunctions functions;
+    functions.enable = [](GLenum cap) { glEnable(cap); };
+    functions.disable = [](GLenum cap) { glDisable(cap); };
+    functions.useProgram = [](GLuint id) { glUseProgram(id); };
+    functions.activeTexture = [](GLenum unit) { glActiveTexture(unit); };
+    functions.bindTexture = [](GLenum target, GLuint texture) { glBindTexture(target, texture); };
+    functions.bindTextureUnit = [](GLuint unit, GLuint texture) { glBindTextureUnit(unit, texture); };
+    functions.bindTextures = [](GLuint first, GLsizei count, const GLuint* ids) { glBindTextures(first, count, ids); };
+    functions.bindVertexArray = [](GLuint vao) { glBindVertexArray(vao); };
+    functions.depthMask = [](GLboolean flag) { glDepthMask(flag); };
+    functions.depthFunc = [](GLenum func) { glDepthFunc(func); };
+    functions.blendFunc = [](GLenum source, GLenum destination) { glBlendFunc(source, destination); };
+    functions.cullFace = [](GLenum mode) { glCullFace(mode); };
+    functions.colorMask = [](GLboolean r, GLboolean g, GLboolean b, GLboolean a) { glColorMask(r, g, b, a); };
+    functions.stencilFunc = [](GLenum func, GLint ref, GLuint mask) { glStencilFunc(func, ref, mask); };
+    functions.stencilMask = [](GLuint mask) { glStencilMask(mask); };
+    functions.stencilOp = [](GLenum sfail, GLenum dpfail, GLenum dppass) { glStencilOp(sfail, dpfail, dppass); };
+    functions.polygonMode = [](GLenum face, GLenum mode) { glPolygonMode(face, mode); };
+    functions.deleteTextures = [](GLsizei count, const GLuint* ids) { glDeleteTextures(count, ids); };
+    functions.deleteVertexArrays = [](GLsizei count, const GLuint* ids) { glDeleteVertexArrays(count, ids); };
+    return functions;
+}
+
+void GLState::SetFunctions(const GLFunctions& functions)
+{
+    gl = functions;
+    Invalidate();
+}
+
+void GLState::Invalidate()
+{
+    for (Cached<bool>& cap : caps) cap.valid = false;
+    for (Cached<GLuint>& texture : textures) texture.valid = false;
+    program.valid = false;
+    activeUnit.valid = false;
+    vertexArray.valid = false;
+    depthMask.valid = false;
+    depthFunc.valid = false;
+    blendFunc.valid = false;
+    cullFace.valid = false;
+    colorMask.valid = false;
+    stencilFunc.valid = false;
+    stencilMask.valid = false;
+    stencilOp.valid = false;
+    polygonMode.valid = false;
+
+    // Texture binds are only tracked on a known unit
+    activeUnit.Set(0);
+    gl.activeTexture(GL_TEXTURE0);
+}
+
+void GLState::BeginFrame()
+{
+    lastFrameStats = frameStats;
+    frameStats = Stats();
+    Invalidate();
+}
+
+const GLState::Stats& GLState::GetStats()
+{
+    return lastFrameStats;
+}
+
+void GLState::Enable(GLenum cap)
+{
+    SetEnabled(cap, true);
+}
+
+void GLState::Disable(GLenum cap)
+{
+    SetEnabled(cap, false);
+}
+
+void GLState::SetEnabled(GLenum cap, bool enabled)
+{
+    int index = FindCap(cap);
+    if (index >= 0 && !caps[index].Set(enabled)) return;
+    if (index < 0) frameStats.calls++;
+
+    if (enabled) gl.enable(cap);
+    else gl.disable(cap);
+}
+
+void GLState::UseProgram(GLuint id)
+{
+    if (program.Set(id)) gl.useProgram(id);
+}
+
+void GLState::ActiveTexture(GLenum unit)
+{
+    if (activeUnit.Set(unit - GL_TEXTURE0)) gl.activeTexture(unit);
+}
+
+void GLState::BindTexture(GLenum target, GLuint texture)
+{
+    // Other targets and units past the tracked ones go through as they are
+    bool tracked = target == GL_TEXTURE_2D && activeUnit.valid && activeUnit.value < (GLuint)kMaxTextureUnits;
+    if (!tracked)
+    {
+        frameStats.calls++;
+        gl.bindTexture(target, texture);
+        return;
+    }
+
+    if (textures[activeUnit.value].Set(texture)) gl.bindTexture(target, texture);
+}
+
+void GLState::BindTextureUnit(unsigned int unit, GLuint texture)
+{
+    if (unit >= (unsigned int)kMaxTextureUnits)
+    {
+        frameStats.calls++;
+        gl.bindTextureUnit(unit, texture);
+        return;
+    }
+
+    if (textures[unit].Set(texture)) gl.bindTextureUnit(unit, texture);
+}
+
+void GLState::BindTextures(unsigned int firstUnit, unsigned int count, const GLuint* ids)
+{
+    if (firstUnit + count > (unsigned int)kMaxTextureUnits)
+    {
+        frameStats.calls++;
+        gl.bindTextures(firstUnit, (GLsizei)count, ids);
+        return;
+    }
+
+    // Only the span between the first and last changed unit is rebound
+    int first = -1, last = -1;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        const Cached<GLuint>& slot = textures[firstUnit + i];
+        if (slot.valid && slot.value == ids[i]) continue;
+        if (first < 0) first = (int)i;
+        last = (int)i;
+    }
+
+    if (first < 0)
+    {
+        frameStats.skipped += (int)count;
+        return;
+    }
+
+    for (int i = first; i <= last; ++i)
+    {
+        textures[firstUnit + i].value = ids[i];
+        textures[firstUnit + i].valid = true;
+    }
+
+    frameStats.calls++;
+    frameStats.skipped += (int)count - (last - first + 1);
+    gl.bindTextures(firstUnit + first, last - first + 1, ids + first);
+}
+
+void GLState::BindVertexArray(GLuint vao)
+{
+    if (vertexArray.Set(vao)) gl.bindVertexArray(vao);
+}
+
+void GLState::DepthMask(GLboolean flag)
+{
+    if (depthMask.Set(flag)) gl.depthMask(flag);
+}
+
+void GLState::DepthFunc(GLenum func)
+{
+    if (depthFunc.Set(func)) gl.depthFunc(func);
+}
+
+void GLState::BlendFunc(GLenum source, GLenum destination)
+{
+    if (blendFunc.Set({ source, destination })) gl.blendFunc(source, destination);
+}
+
+void GLState::CullFace(GLenum mode)
+{
+    if (cullFace.Set(mode)) gl.cullFace(mode);
+}
+
+void GLState::ColorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha)
+{
+    if (colorMask.Set({ red, green, blue, alpha })) gl.colorMask(red, green, blue, alpha);
+}
+
+void GLState::StencilFunc(GLenum func, GLint ref, GLuint mask)
+{
+    if (stencilFunc.Set({ func, (GLuint)ref, mask })) gl.stencilFunc(func, ref, mask);
+}
+
+void GLState::StencilMask(GLuint mask)
+{
+    if (stencilMask.Set(mask)) gl.stencilMask(mask);
+}
+
+void GLState::StencilOp(GLenum stencilFail, GLenum depthFail, GLenum depthPass)
+{
+    if (stencilOp.Set({ stencilFail, depthFail, depthPass })) gl.stencilOp(stencilFail, depthFail, depthPass);
+}
+
+void GLState::PolygonMode(GLenum face, GLenum mode)
+{
+    // The engine never sets the faces apart, only both at once is tracked
+    if (face != GL_FRONT_AND_BACK)
+    {
+        polygonMode.valid = false;
+        frameStats.calls++;
+        gl.polygonMode(face, mode);
+        return;
+    }
+
+    if (polygonMode.Set(mode)) gl.polygonMode(face, mode);
+}
+
+void GLState::DeleteTextures(GLsizei count, const GLuint* ids)
+{
+    for (GLsizei i = 0; i < count; ++i)
+    {
+        for (Cached<GLuint>& slot : textures)
+        {
+            if (slot.valid && slot.value == ids[i] && ids[i] != 0) slot.value = 0;
+        }
+    }
+    gl.deleteTextures(count, ids);
+}
+
+void GLState::DeleteVertexArrays(GLsizei count, const GLuint* ids)
+{
+    for (GLsizei i = 0; i < count; ++i)
+    {
+        if (vertexArray.valid && vertexArray.value == ids[i] && ids[i] != 0) vertexArray.value = 0;
+    }
+    gl.deleteVertexArrays(count, ids);
+}
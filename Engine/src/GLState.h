@@ -0,0 +1,83 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// GL entry points the state cache forwards to. Defaults to the loaded driver functions, a table
+// of recording functions checks the filtering without a context
+struct GLFunctions
+{
+    void (*enable)(GLenum cap) = nullptr;
+    void (*disable)(GLenum cap) = nullptr;
+    void (*useProgram)(GLuint program) = nullptr;
+    void (*activeTexture)(GLenum unit) = nullptr;
+    void (*bindTexture)(GLenum target, GLuint texture) = nullptr;
+    void (*bindTextureUnit)(GLuint unit, GLuint texture) = nullptr;
+    void (*bindTextures)(GLuint first, GLsizei count, const GLuint* textures) = nullptr;
+    void (*bindVertexArray)(GLuint vao) = nullptr;
+    void (*depthMask)(GLboolean flag) = nullptr;
+    void (*depthFunc)(GLenum func) = nullptr;
+    void (*blendFunc)(GLenum source, GLenum destination) = nullptr;
+    void (*cullFace)(GLenum mode) = nullptr;
+    void (*colorMask)(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha) = nullptr;
+    void (*stencilFunc)(GLenum func, GLint ref, GLuint mask) = nullptr;
+    void (*stencilMask)(GLuint mask) = nullptr;
+    void (*stencilOp)(GLenum stencilFail, GLenum depthFail, GLenum depthPass) = nullptr;
+    void (*polygonMode)(GLenum face, GLenum mode) = nullptr;
+    void (*deleteTextures)(GLsizei count, const GLuint* textures) = nullptr;
+    void (*deleteVertexArrays)(GLsizei count, const GLuint* arrays) = nullptr;
+};
+
+// Shadow copy of the GL state the engine changes. Every engine state change goes through here
+// and is dropped when it matches what is already set. State other libraries change behind our
+// back (Noesis) is forgotten with Invalidate, the next call of each kind then reaches the driver
+namespace GLState
+{
+    struct Stats
+    {
+        int calls = 0;      // forwarded to the driver
+        int skipped = 0;    // already set
+    };
+
+    // Texture units tracked for GL_TEXTURE_2D, other targets and units pass through
+    static const int kMaxTextureUnits = 16;
+
+    GLFunctions GetDefaultFunctions();
+    // Also invalidates, the new table has no known state
+    void SetFunctions(const GLFunctions& functions);
+
+    // Forgets every value and selects texture unit 0
+    void Invalidate();
+    // Keeps the counts of the frame that ends for GetStats and invalidates
+    void BeginFrame();
+    const Stats& GetStats();
+
+    void Enable(GLenum cap);
+    void Disable(GLenum cap);
+    void SetEnabled(GLenum cap, bool enabled);
+
+    void UseProgram(GLuint program);
+
+    void ActiveTexture(GLenum unit);
+    // Binds to the active unit
+    void BindTexture(GLenum target, GLuint texture);
+    // Binds a 2D texture to a unit without changing the active one
+    void BindTextureUnit(unsigned int unit, GLuint texture);
+    // Binds consecutive units, the changed range goes out as one multi-bind
+    void BindTextures(unsigned int firstUnit, unsigned int count, const GLuint* textures);
+
+    void BindVertexArray(GLuint vao);
+
+    void DepthMask(GLboolean flag);
+    void DepthFunc(GLenum func);
+    void BlendFunc(GLenum source, GLenum destination);
+    void CullFace(GLenum mode);
+    void ColorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha);
+    void StencilFunc(GLenum func, GLint ref, GLuint mask);
+    void StencilMask(GLuint mask);
+    void StencilOp(GLenum stencilFail, GLenum depthFail, GLenum depthPass);
+    void PolygonMode(GLenum face, GLenum mode);
+
+    // Deleting a bound object rebinds 0, the cache follows so a reused name is bound again
+    void DeleteTextures(GLsizei count, const GLuint* textures);
+    void DeleteVertexArrays(GLsizei count, const GLuint* arrays);
+}
@@ -34,6 +34,7 @@
 #include "AudioListener.h"
 #include "ReverbZone.h"
 #include "ComponentPostProcessing.h"
+#include "ComponentLight.h"
 #include <nlohmann/json.hpp>
 
 GameObject::GameObject(const std::string& name) : name(name), active(true), parent(nullptr) {
@@ -164,6 +165,9 @@ Component* GameObject::CreateComponent(ComponentType type) {
     case ComponentType::POSTPROCESSING:
         newComponent = new ComponentPostProcessing(this);
         break;
+    case ComponentType::LIGHT:
+        newComponent = new ComponentLight(this);
+        break;
     default:
         LOG_DEBUG("ERROR: Unknown component type requested for GameObject '%s'", name.c_str());
         LOG_CONSOLE("Failed to create component");
@@ -430,6 +434,7 @@ void GameObject::Serialize(nlohmann::json& gameObjectArray) const {
     gameObjectObj["name"] = name;
     gameObjectObj["uid"] = objectUID;
     gameObjectObj["active"] = active;
+    gameObjectObj["static"] = isStatic;
 
     // Components
     nlohmann::json componentsArray = nlohmann::json::array();
@@ -470,6 +475,10 @@ GameObject* GameObject::Deserialize(const nlohmann::json& gameObjectObj, GameObj
         newObject->SetActive(gameObjectObj["active"].get<bool>());
     }
 
+    if (gameObjectObj.contains("static")) {
+        newObject->SetStatic(gameObjectObj["static"].get<bool>());
+    }
+
     if (parent) {
         parent->AddChild(newObject);
     }
@@ -55,6 +55,9 @@ public:
     void SetName(const std::string& newName) { name = newName; }
     bool IsActive() const { return active; }
     void SetActive(bool state) { active = state; }
+    // Static objects never move in play mode and get merged by the static batcher
+    bool IsStatic() const { return isStatic; }
+    void SetStatic(bool state) { isStatic = state; }
     GameObject* GetParent() const { return parent; }
     const std::vector<GameObject*>& GetChildren() const { return children; }
     const std::vector<Component*>& GetComponents() const { return components; }
@@ -83,6 +86,7 @@ public:
     UID objectUID;
     std::string name;
     bool active = true;
+    bool isStatic = false;
     Transform* transform = nullptr;
 
 private:
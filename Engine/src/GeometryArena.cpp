@@ -0,0 +1,171 @@
+#include "GeometryArena.h"
+#include "ResourceMesh.h"
+#include "VertexFormat.h"
+#include "GLState.h"
+#include "Log.h"
+#include <glad/glad.h>
+#include <cstddef>
+
+GeometryArena& GeometryArena::GetInstance()
+{
+    static GeometryArena instance;
+    return instance;
+}
+
+bool GeometryArena::Init(uint32_t vertexCapacity, uint32_t indexCapacity)
+{
+    if (IsInitialized()) return true;
+
+    glCreateBuffers(1, &vertexBuffer);
+    glNamedBufferData(vertexBuffer, (GLsizeiptr)vertexCapacity * sizeof(PackedVertex), nullptr, GL_STATIC_DRAW);
+
+    glCreateBuffers(1, &indexBuffer);
+    glNamedBufferData(indexBuffer, (GLsizeiptr)indexCapacity * sizeof(unsigned int), nullptr, GL_STATIC_DRAW);
+
+    // Compact static stream, skinned meshes never go through the arena
+    glCreateVertexArrays(1, &vao);
+    glVertexArrayVertexBuffer(vao, 0, vertexBuffer, 0, sizeof(PackedVertex));
+    glVertexArrayElementBuffer(vao, indexBuffer);
+
+    glEnableVertexArrayAttrib(vao, 0);
+    glVertexArrayAttribFormat(vao, 0, 3, GL_FLOAT, GL_FALSE, offsetof(PackedVertex, position));
+    glEnableVertexArrayAttrib(vao, 1);
+    glVertexArrayAttribFormat(vao, 1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, offsetof(PackedVertex, normal));
+    glEnableVertexArrayAttrib(vao, 2);
+    glVertexArrayAttribFormat(vao, 2, 2, GL_HALF_FLOAT, GL_FALSE, offsetof(PackedVertex, texCoords));
+
+    for (GLuint attribute = 0; attribute < 3; ++attribute)
+    {
+        glVertexArrayAttribBinding(vao, attribute, 0);
+    }
+
+    vertexAllocator.Reset(vertexCapacity);
+    indexAllocator.Reset(indexCapacity);
+
+    LOG_DEBUG("Geometry arena created: %u vertices, %u indices", vertexCapacity, indexCapacity);
+    return true;
+}
+
+void GeometryArena::CleanUp()
+{
+    if (vao != 0) GLState::DeleteVertexArrays(1, &vao);
+    if (vertexBuffer != 0) glDeleteBuffers(1, &vertexBuffer);
+    if (indexBuffer != 0) glDeleteBuffers(1, &indexBuffer);
+
+    vao = 0;
+    vertexBuffer = 0;
+    indexBuffer = 0;
+
+    vertexAllocator.Reset(0);
+    indexAllocator.Reset(0);
+}
+
+bool GeometryArena::Upload(Mesh& mesh)
+{
+    if (!IsInitialized() || mesh.GetVertexCount() == 0 || mesh.GetIndexCount() == 0) return false;
+    if (mesh.arenaRange.IsValid()) return true;
+
+    // Without a CPU copy the mesh buffers are copied on the GPU, which needs them in the arena layout
+    bool fromCPU = mesh.HasCPUData();
+    if (!fromCPU && (mesh.gpuLayout != VertexLayout::COMPACT || mesh.skinVBO != 0 || mesh.VBO == 0)) return false;
+
+    // LODs come along so every level can be drawn from the arena
+    uint32_t vertexCount = mesh.GetVertexCount();
+    uint32_t indexCount = mesh.GetLODFirstIndex(mesh.GetLODCount());
+
+    uint32_t baseVertex = AllocateVertices(vertexCount);
+    if (baseVertex == RangeAllocator::kInvalidOffset) return false;
+
+    uint32_t firstIndex = AllocateIndices(indexCount);
+    if (firstIndex == RangeAllocator::kInvalidOffset)
+    {
+        vertexAllocator.Free(baseVertex, vertexCount);
+        return false;
+    }
+
+    if (fromCPU)
+    {
+        std::vector<PackedVertex> packed(vertexCount);
+        for (uint32_t i = 0; i < vertexCount; ++i)
+            packed[i] = VertexFormat::Pack(mesh.vertices[i]);
+
+        std::vector<unsigned int> gpuIndices = mesh.GetGPUIndices();
+
+        glNamedBufferSubData(vertexBuffer, (GLintptr)baseVertex * sizeof(PackedVertex),
+            (GLsizeiptr)vertexCount * sizeof(PackedVertex), packed.data());
+        glNamedBufferSubData(indexBuffer, (GLintptr)firstIndex * sizeof(unsigned int),
+            (GLsizeiptr)indexCount * sizeof(unsigned int), gpuIndices.data());
+    }
+    else
+    {
+        glCopyNamedBufferSubData(mesh.VBO, vertexBuffer, 0, (GLintptr)baseVertex * sizeof(PackedVertex),
+            (GLsizeiptr)vertexCount * sizeof(PackedVertex));
+        glCopyNamedBufferSubData(mesh.EBO, indexBuffer, 0, (GLintptr)firstIndex * sizeof(unsigned int),
+            (GLsizeiptr)indexCount * sizeof(unsigned int));
+    }
+
+    mesh.arenaRange.baseVertex = (int32_t)baseVertex;
+    mesh.arenaRange.vertexCount = vertexCount;
+    mesh.arenaRange.firstIndex = firstIndex;
+    mesh.arenaRange.indexCount = indexCount;
+    return true;
+}
+
+void GeometryArena::Free(Mesh& mesh)
+{
+    ArenaRange& range = mesh.arenaRange;
+
+    // Ranges handed out before a CleanUp are already gone
+    if (range.IsValid() && IsInitialized())
+    {
+        vertexAllocator.Free((uint32_t)range.baseVertex, range.vertexCount);
+        indexAllocator.Free(range.firstIndex, range.indexCount);
+    }
+
+    range = ArenaRange();
+}
+
+uint32_t GeometryArena::AllocateVertices(uint32_t count)
+{
+    uint32_t offset = vertexAllocator.Allocate(count);
+    if (offset != RangeAllocator::kInvalidOffset) return offset;
+
+    uint32_t oldCapacity = vertexAllocator.GetCapacity();
+    uint32_t newCapacity = oldCapacity * 2;
+    while (newCapacity - oldCapacity < count) newCapacity *= 2;
+
+    ResizeBuffer(vertexBuffer, (size_t)oldCapacity * sizeof(PackedVertex), (size_t)newCapacity * sizeof(PackedVertex));
+    glVertexArrayVertexBuffer(vao, 0, vertexBuffer, 0, sizeof(PackedVertex));
+    vertexAllocator.Grow(newCapacity);
+
+    return vertexAllocator.Allocate(count);
+}
+
+uint32_t GeometryArena::AllocateIndices(uint32_t count)
+{
+    uint32_t offset = indexAllocator.Allocate(count);
+    if (offset != RangeAllocator::kInvalidOffset) return offset;
+
+    uint32_t oldCapacity = indexAllocator.GetCapacity();
+    uint32_t newCapacity = oldCapacity * 2;
+    while (newCapacity - oldCapacity < count) newCapacity *= 2;
+
+    ResizeBuffer(indexBuffer, (size_t)oldCapacity * sizeof(unsigned int), (size_t)newCapacity * sizeof(unsigned int));
+    glVertexArrayElementBuffer(vao, indexBuffer);
+    indexAllocator.Grow(newCapacity);
+
+    return indexAllocator.Allocate(count);
+}
+
+void GeometryArena::ResizeBuffer(unsigned int& buffer, size_t oldSize, size_t newSize)
+{
+    unsigned int newBuffer = 0;
+    glCreateBuffers(1, &newBuffer);
+    glNamedBufferData(newBuffer, (GLsizeiptr)newSize, nullptr, GL_STATIC_DRAW);
+    glCopyNamedBufferSubData(buffer, newBuffer, 0, 0, (GLsizeiptr)oldSize);
+
+    glDeleteBuffers(1, &buffer);
+    buffer = newBuffer;
+
+    LOG_DEBUG("Geometry arena buffer grown to %zu bytes", newSize);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "RangeAllocator.h"
+
+struct Mesh;
+
+// Where a mesh lives inside the arena buffers
+struct ArenaRange
+{
+    int32_t baseVertex = -1;
+    uint32_t vertexCount = 0;
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+
+    bool IsValid() const { return baseVertex >= 0; }
+};
+
+// Shared vertex and index buffers for multi-draw indirect. Meshes are copied into
+// sub-ranges on first use and all of them are drawn through a single VAO.
+// The buffers double in size when they run out of space.
+class GeometryArena
+{
+public:
+    static GeometryArena& GetInstance();
+
+    bool Init(uint32_t vertexCapacity, uint32_t indexCapacity);
+    void CleanUp();
+    bool IsInitialized() const { return vao != 0; }
+
+    // Copies the mesh data into the arena and stores the range in the mesh
+    bool Upload(Mesh& mesh);
+    void Free(Mesh& mesh);
+
+    unsigned int GetVAO() const { return vao; }
+
+    uint32_t GetUsedVertices() const { return vertexAllocator.GetUsed(); }
+    uint32_t GetVertexCapacity() const { return vertexAllocator.GetCapacity(); }
+    uint32_t GetUsedIndices() const { return indexAllocator.GetUsed(); }
+    uint32_t GetIndexCapacity() const { return indexAllocator.GetCapacity(); }
+
+private:
+    GeometryArena() = default;
+
+    GeometryArena(const GeometryArena&) = delete;
+    GeometryArena& operator=(const GeometryArena&) = delete;
+
+    uint32_t AllocateVertices(uint32_t count);
+    uint32_t AllocateIndices(uint32_t count);
+    void ResizeBuffer(unsigned int& buffer, size_t oldSize, size_t newSize);
+
+private:
+    RangeAllocator vertexAllocator;
+    RangeAllocator indexAllocator;
+
+    unsigned int vao = 0;
+    unsigned int vertexBuffer = 0;
+    unsigned int indexBuffer = 0;
+};
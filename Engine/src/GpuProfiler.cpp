@@ -0,0 +1,170 @@
+#include "GpuProfiler.h"
+#include "Log.h"
+#include "tracy/Tracy.hpp"
+#include <algorithm>
+#include <cstring>
+
+GpuProfiler& GpuProfiler::GetInstance()
+{
+    static GpuProfiler instance;
+    return instance;
+}
+
+GpuProfiler::Scope::Scope(const char* name)
+{
+    active = GpuProfiler::GetInstance().BeginPass(name);
+}
+
+GpuProfiler::Scope::~Scope()
+{
+    if (active) GpuProfiler::GetInstance().EndPass();
+}
+
+void GpuProfiler::CleanUp()
+{
+    if (openPass != -1)
+    {
+        glEndQuery(GL_TIME_ELAPSED);
+        openPass = -1;
+    }
+
+    for (FrameSlot& slot : slots)
+    {
+        if (!slot.queries.empty()) glDeleteQueries((GLsizei)slot.queries.size(), slot.queries.data());
+        slot.queries.clear();
+        slot.timings.clear();
+    }
+
+    passes.clear();
+    stats.clear();
+    droppedFrames = 0;
+}
+
+void GpuProfiler::BeginFrame()
+{
+    if (openPass != -1)
+    {
+        LOG_DEBUG("[GpuProfiler] Pass %s was still open at the end of the frame", passes[openPass].name);
+        EndPass();
+    }
+
+    // The slot written two frames ago is the one this frame reuses
+    currentSlot = (currentSlot + 1) % kFrameSlots;
+    ReadSlot(slots[currentSlot]);
+}
+
+void GpuProfiler::ReadSlot(FrameSlot& slot)
+{
+    if (slot.timings.empty()) return;
+
+    // Queries finish in the order they were issued, the last one being ready means all are
+    GLuint available = 0;
+    glGetQueryObjectuiv(slot.timings.back().query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+    {
+        droppedFrames++;
+        slot.timings.clear();
+        return;
+    }
+
+    for (const Timing& timing : slot.timings)
+    {
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(timing.query, GL_QUERY_RESULT, &nanoseconds);
+
+        Pass& pass = passes[timing.pass];
+        pass.frameMs += (double)nanoseconds / 1000000.0;
+        pass.ranThisFrame = true;
+    }
+    slot.timings.clear();
+
+    for (int i = 0; i < (int)passes.size(); ++i)
+    {
+        Pass& pass = passes[i];
+        if (!pass.ranThisFrame) continue;
+
+        AddSample(i, (float)pass.frameMs);
+        TracyPlot(pass.plotName.c_str(), pass.frameMs);
+
+        pass.frameMs = 0.0;
+        pass.ranThisFrame = false;
+    }
+}
+
+void GpuProfiler::AddSample(int index, float ms)
+{
+    Pass& pass = passes[index];
+    pass.history[pass.head] = ms;
+    pass.head = (pass.head + 1) % kHistory;
+    if (pass.count < kHistory) pass.count++;
+
+    PassStats& passStats = stats[index];
+    passStats.lastMs = ms;
+    passStats.minMs = ms;
+    passStats.maxMs = ms;
+
+    float sum = 0.0f;
+    for (int i = 0; i < pass.count; ++i)
+    {
+        float sample = pass.history[i];
+        passStats.minMs = std::min(passStats.minMs, sample);
+        passStats.maxMs = std::max(passStats.maxMs, sample);
+        sum += sample;
+    }
+    passStats.avgMs = sum / pass.count;
+}
+
+int GpuProfiler::FindPass(const char* name)
+{
+    for (int i = 0; i < (int)passes.size(); ++i)
+    {
+        if (passes[i].name == name || strcmp(passes[i].name, name) == 0) return i;
+    }
+
+    Pass pass;
+    pass.name = name;
+    pass.plotName = std::string("GPU ") + name;
+    passes.push_back(std::move(pass));
+
+    PassStats passStats;
+    passStats.name = name;
+    stats.push_back(passStats);
+
+    return (int)passes.size() - 1;
+}
+
+bool GpuProfiler::BeginPass(const char* name)
+{
+    if (!enabled) return false;
+
+    if (openPass != -1)
+    {
+        LOG_DEBUG("[GpuProfiler] Pass %s opened inside %s, only the outer one is timed", name, passes[openPass].name);
+        return false;
+    }
+
+    FrameSlot& slot = slots[currentSlot];
+    if (slot.timings.size() == slot.queries.size())
+    {
+        GLuint query = 0;
+        glGenQueries(1, &query);
+        slot.queries.push_back(query);
+    }
+
+    Timing timing;
+    timing.pass = FindPass(name);
+    timing.query = slot.queries[slot.timings.size()];
+    slot.timings.push_back(timing);
+
+    glBeginQuery(GL_TIME_ELAPSED, timing.query);
+    openPass = timing.pass;
+    return true;
+}
+
+void GpuProfiler::EndPass()
+{
+    if (openPass == -1) return;
+
+    glEndQuery(GL_TIME_ELAPSED);
+    openPass = -1;
+}
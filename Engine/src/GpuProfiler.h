@@ -0,0 +1,95 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <deque>
+#include <string>
+#include <vector>
+
+// GPU time of named render passes from GL_TIME_ELAPSED queries. Queries are double buffered:
+// a frame's results are read two frames later if the driver has them, a frame that isn't ready
+// is dropped instead of waited on. Passes can't nest, GL runs one elapsed time query at a time.
+// Every pass is also sent to Tracy as a plot, next to the CPU zones.
+class GpuProfiler
+{
+public:
+    // Milliseconds over the last kHistory frames the pass ran in, summed within a frame
+    struct PassStats
+    {
+        const char* name = nullptr;
+        float lastMs = 0.0f;
+        float minMs = 0.0f;
+        float avgMs = 0.0f;
+        float maxMs = 0.0f;
+    };
+
+    // Times a pass for the lifetime of the scope
+    class Scope
+    {
+    public:
+        explicit Scope(const char* name);
+        ~Scope();
+
+    private:
+        bool active;
+    };
+
+    static const int kHistory = 120;
+
+    static GpuProfiler& GetInstance();
+
+    void CleanUp();
+
+    bool IsEnabled() const { return enabled; }
+    void SetEnabled(bool enable) { enabled = enable; }
+
+    // Reads back the frame issued two frames ago and starts recording a new one
+    void BeginFrame();
+
+    // Names must outlive the profiler (string literals), passes are found by name.
+    // False when disabled or another pass is open
+    bool BeginPass(const char* name);
+    void EndPass();
+
+    // In the order the passes first ran
+    const std::vector<PassStats>& GetStats() const { return stats; }
+    int GetDroppedFrames() const { return droppedFrames; }
+
+private:
+    static const int kFrameSlots = 2;
+
+    struct Pass
+    {
+        const char* name = nullptr;
+        std::string plotName;       // "GPU <name>", Tracy keeps the pointer
+        float history[kHistory] = {};
+        int count = 0;
+        int head = 0;
+        double frameMs = 0.0;       // sum of the frame being read
+        bool ranThisFrame = false;
+    };
+
+    struct Timing
+    {
+        int pass;
+        GLuint query;
+    };
+
+    struct FrameSlot
+    {
+        std::vector<GLuint> queries;    // grows to the most passes a frame has timed
+        std::vector<Timing> timings;
+    };
+
+    int FindPass(const char* name);
+    void ReadSlot(FrameSlot& slot);
+    void AddSample(int pass, float ms);
+
+    bool enabled = true;
+    FrameSlot slots[kFrameSlots];
+    int currentSlot = 0;
+    int openPass = -1;
+
+    std::deque<Pass> passes;            // stable addresses for the plot names
+    std::vector<PassStats> stats;
+    int droppedFrames = 0;
+};
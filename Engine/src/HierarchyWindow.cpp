@@ -64,6 +64,12 @@ void HierarchyWindow::DrawBackgroundContextMenu()
         postProcessing->CreateComponent(ComponentType::POSTPROCESSING);
     }
 
+    if (ImGui::MenuItem("Create Light"))
+    {
+        GameObject* light = CreateAndRegisterGameObject("Light");
+        light->CreateComponent(ComponentType::LIGHT);
+    }
+
     ImGui::EndPopup();
 }
 
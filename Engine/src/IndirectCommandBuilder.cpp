@@ -0,0 +1,49 @@
+#include "IndirectCommandBuilder.h"
+
+void IndirectCommandBuilder::Clear(uint32_t base)
+{
+    commands.clear();
+    batches.clear();
+    baseInstance = base;
+    instanceCount = 0;
+}
+
+void IndirectCommandBuilder::BeginBatch()
+{
+    IndirectBatch batch;
+    batch.firstCommand = (uint32_t)commands.size();
+    batch.firstInstance = baseInstance + instanceCount;
+    batches.push_back(batch);
+}
+
+uint32_t IndirectCommandBuilder::AddDraw(uint32_t firstIndex, uint32_t indexCount, int32_t baseVertex)
+{
+    if (batches.empty()) BeginBatch();
+
+    IndirectBatch& batch = batches.back();
+    uint32_t slot = instanceCount++;
+
+    // Instances of a command are consecutive slots, so a repeat of the last mesh just extends it
+    if (batch.commandCount > 0)
+    {
+        DrawElementsIndirectCommand& last = commands.back();
+        if (last.firstIndex == firstIndex && last.count == indexCount && last.baseVertex == baseVertex)
+        {
+            last.instanceCount++;
+            batch.instanceCount++;
+            return slot;
+        }
+    }
+
+    DrawElementsIndirectCommand command;
+    command.count = indexCount;
+    command.instanceCount = 1;
+    command.firstIndex = firstIndex;
+    command.baseVertex = baseVertex;
+    command.baseInstance = baseInstance + slot;
+    commands.push_back(command);
+
+    batch.commandCount++;
+    batch.instanceCount++;
+    return slot;
+}
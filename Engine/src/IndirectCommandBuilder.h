@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Same layout as the command glMultiDrawElementsIndirect reads
+struct DrawElementsIndirectCommand
+{
+    uint32_t count;
+    uint32_t instanceCount;
+    uint32_t firstIndex;
+    int32_t baseVertex;
+    uint32_t baseInstance;
+};
+
+// Commands that are submitted together with a single multi-draw call
+struct IndirectBatch
+{
+    uint32_t firstCommand = 0;
+    uint32_t commandCount = 0;
+    uint32_t firstInstance = 0; // absolute instance slot of the first draw
+    uint32_t instanceCount = 0;
+};
+
+// Turns a stream of draws into indirect commands, grouped in batches that share
+// render state. Each draw gets the next instance slot, so its per-instance data can be
+// written at baseInstance + slot. Back to back draws of the same mesh range are folded
+// into a single command with a larger instanceCount. No GL calls are made here.
+class IndirectCommandBuilder
+{
+public:
+    void Clear(uint32_t baseInstance);
+
+    // Following draws go into a new batch
+    void BeginBatch();
+
+    // Returns the instance slot of the draw, relative to baseInstance
+    uint32_t AddDraw(uint32_t firstIndex, uint32_t indexCount, int32_t baseVertex);
+
+    const std::vector<DrawElementsIndirectCommand>& GetCommands() const { return commands; }
+    const std::vector<IndirectBatch>& GetBatches() const { return batches; }
+    uint32_t GetInstanceCount() const { return instanceCount; }
+
+private:
+    std::vector<DrawElementsIndirectCommand> commands;
+    std::vector<IndirectBatch> batches;
+    uint32_t baseInstance = 0;
+    uint32_t instanceCount = 0;
+};
@@ -37,6 +37,7 @@
 #include "ReverbZone.h"
 #include "TransformCommand.h"
 #include "ModuleEditor.h"
+#include "EditorCamera.h"
 #include "ComponentCommand.h"
 #include "Joint.h"
 #include "FixedJoint.h"
@@ -54,6 +55,7 @@
 #include "ComponentNavigation.h"
 #include "NavMeshManager.h"
 #include "ComponentPostProcessing.h"
+#include "ComponentLight.h"
 #include <filesystem>
 #include <nlohmann/json.hpp>
 
@@ -256,6 +258,9 @@ void InspectorWindow::Draw()
         case ComponentType::POSTPROCESSING:
             DrawPostProcessingComponent(component);
             break;
+        case ComponentType::LIGHT:
+            DrawLightComponent(component);
+            break;
 
             // --- FÍSICAS ---
         case ComponentType::RIGIDBODY:
@@ -740,9 +745,22 @@ void InspectorWindow::DrawMeshComponent(Component* component)
             const Mesh& mesh = meshComp->GetMesh();
 
             ImGui::Text("Mesh Statistics:");
-            ImGui::Text("Vertices: %d", (int)mesh.vertices.size());
-            ImGui::Text("Indices: %d", (int)mesh.indices.size());
-            ImGui::Text("Triangles: %d", (int)mesh.indices.size() / 3);
+            ImGui::Text("Vertices: %d", (int)mesh.GetVertexCount());
+            ImGui::Text("Indices: %d", (int)mesh.GetIndexCount());
+            ImGui::Text("Triangles: %d", (int)mesh.GetIndexCount() / 3);
+            ImGui::Text("Memory: %.1f KB CPU, %.1f KB GPU", mesh.GetCPUBytes() / 1024.0f, mesh.GetGPUBytes() / 1024.0f);
+
+            Resource* meshResource = Application::GetInstance().resources->GetResourceDirect(meshComp->GetMeshUID());
+            if (meshResource && meshResource->GetType() == Resource::MESH)
+            {
+                ResourceMesh* resourceMesh = static_cast<ResourceMesh*>(meshResource);
+                bool keepCPU = resourceMesh->GetResidency() == MeshResidency::KEEP_CPU;
+                if (ImGui::Checkbox("Keep CPU Data", &keepCPU))
+                {
+                    resourceMesh->SetResidency(keepCPU ? MeshResidency::KEEP_CPU : MeshResidency::RELEASE_AFTER_UPLOAD);
+                }
+                if (ImGui::IsItemHovered()) ImGui::SetTooltip("Keep vertices and indices in RAM after upload instead of re-reading them from the Library when needed");
+            }
 
             ImGui::Spacing();
             ImGui::Separator();
@@ -762,6 +780,50 @@ void InspectorWindow::DrawMeshComponent(Component* component)
                 meshComp->SetDrawMesh(showNormals);
                 LOG_DEBUG("Face normals visualization: %s", showMesh ? "ON" : "OFF");
             }
+
+            ImGui::Spacing();
+            ImGui::Separator();
+            ImGui::Spacing();
+
+            bool occluder = meshComp->IsOccluder();
+            if (ImGui::Checkbox("Occluder", &occluder))
+            {
+                meshComp->SetOccluder(occluder);
+            }
+            if (ImGui::IsItemHovered())
+            {
+                ImGui::SetTooltip("Rasterized into the CPU occlusion buffer to hide meshes behind it");
+            }
+
+            int lodCount = meshComp->GetLODCount();
+            if (lodCount > 1)
+            {
+                ImGui::Spacing();
+                ImGui::Separator();
+                ImGui::Spacing();
+
+                // Marks the level the scene view draws
+                int drawnLOD = Application::GetInstance().renderer->GetDrawnLOD(meshComp,
+                    Application::GetInstance().editor->GetEditorCamera()->GetCameraLens());
+
+                ImGui::Text("LOD Levels:");
+                for (int lod = 0; lod < lodCount; ++lod)
+                {
+                    float error = lod > 0 ? mesh.lods[lod - 1].error : 0.0f;
+                    ImGui::Text("  LOD %d: %d triangles (error %.4f)%s", lod, (int)mesh.GetLODIndexCount(lod) / 3,
+                        error, lod == drawnLOD ? "  <" : "");
+                }
+
+                int forcedLOD = meshComp->GetForcedLOD();
+                if (ImGui::SliderInt("Force LOD", &forcedLOD, -1, lodCount - 1, forcedLOD < 0 ? "Auto" : "%d"))
+                {
+                    meshComp->SetForcedLOD(forcedLOD);
+                }
+                if (ImGui::IsItemHovered())
+                {
+                    ImGui::SetTooltip("Auto picks the level from the projected screen size");
+                }
+            }
         }
     }
 }
@@ -877,9 +939,22 @@ void InspectorWindow::DrawSkinnedMeshComponent(Component* component)
             const Mesh& mesh = meshComp->GetMesh();
 
             ImGui::Text("Mesh Statistics:");
-            ImGui::Text("Vertices: %d", (int)mesh.vertices.size());
-            ImGui::Text("Indices: %d", (int)mesh.indices.size());
-            ImGui::Text("Triangles: %d", (int)mesh.indices.size() / 3);
+            ImGui::Text("Vertices: %d", (int)mesh.GetVertexCount());
+            ImGui::Text("Indices: %d", (int)mesh.GetIndexCount());
+            ImGui::Text("Triangles: %d", (int)mesh.GetIndexCount() / 3);
+            ImGui::Text("Memory: %.1f KB CPU, %.1f KB GPU", mesh.GetCPUBytes() / 1024.0f, mesh.GetGPUBytes() / 1024.0f);
+
+            Resource* meshResource = Application::GetInstance().resources->GetResourceDirect(meshComp->GetMeshUID());
+            if (meshResource && meshResource->GetType() == Resource::MESH)
+            {
+                ResourceMesh* resourceMesh = static_cast<ResourceMesh*>(meshResource);
+                bool keepCPU = resourceMesh->GetResidency() == MeshResidency::KEEP_CPU;
+                if (ImGui::Checkbox("Keep CPU Data", &keepCPU))
+                {
+                    resourceMesh->SetResidency(keepCPU ? MeshResidency::KEEP_CPU : MeshResidency::RELEASE_AFTER_UPLOAD);
+                }
+                if (ImGui::IsItemHovered()) ImGui::SetTooltip("Keep vertices and indices in RAM after upload instead of re-reading them from the Library when needed");
+            }
             ImGui::Text("Linked bones: %d / %d", meshComp->GetLinkedBonesNum(), (int)mesh.bones.size());
 
             if (ImGui::Button("Link Bones"))
@@ -1210,6 +1285,13 @@ void InspectorWindow::DrawCanvasComponent(Component* component)
         canvasComp->SetUILayer(UILayer);
     }
 
+    float updateRate = canvasComp->GetUpdateRate();
+    if (ImGui::DragFloat("Update Rate", &updateRate, 1.0f, 0.0f, 240.0f, "%.0f /s"))
+    {
+        canvasComp->SetUpdateRate(updateRate);
+    }
+    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Most re-renders per second while the UI changes, 0 renders every change (a static UI is never re-rendered)");
+
     ImGui::Separator();
 
     unsigned int texID = canvasComp->GetTextureID();
@@ -1370,6 +1452,17 @@ bool InspectorWindow::DrawGameObjectSection(GameObject* selectedObject)
     bool objectDeleted = false;
     if (ImGui::CollapsingHeader("GameObject", ImGuiTreeNodeFlags_DefaultOpen))
     {
+        bool isStatic = selectedObject->IsStatic();
+        if (ImGui::Checkbox("Static", &isStatic))
+        {
+            selectedObject->SetStatic(isStatic);
+        }
+        if (ImGui::IsItemHovered())
+        {
+            ImGui::SetTooltip("Never moves in play mode. Its mesh is merged with other static meshes\nsharing the same material when play starts");
+        }
+        ImGui::Spacing();
+
         ImGui::Text("Actions:");
         ImGui::Spacing();
         // Delete button
@@ -2230,6 +2323,30 @@ void InspectorWindow::DrawAddComponentButton(GameObject* selectedObject)
             ImGui::EndTooltip();
         }
 
+        // Light Component
+        bool hasLight = (selectedObject->GetComponent(ComponentType::LIGHT) != nullptr);
+        if (hasLight) ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.5f, 0.5f, 0.5f, 1.0f));
+
+        if (ImGui::Selectable("Light", false, hasLight ? ImGuiSelectableFlags_Disabled : 0))
+        {
+            Component* newComp = selectedObject->CreateComponent(ComponentType::LIGHT);
+            if (newComp)
+                Application::GetInstance().editor->GetCommandHistory()->PushWithoutExecute(
+                    std::make_unique<AddComponentCommand>(selectedObject, newComp)
+                );
+            LOG_CONSOLE("[Inspector] Light component added to: %s", selectedObject->GetName().c_str());
+            ImGui::CloseCurrentPopup();
+        }
+
+        if (hasLight) ImGui::PopStyleColor();
+
+        if (ImGui::IsItemHovered() && !hasLight)
+        {
+            ImGui::BeginTooltip();
+            ImGui::Text("Add a point or spot light");
+            ImGui::EndTooltip();
+        }
+
         // Post Processing Component
         bool hasPostProcessing = (selectedObject->GetComponent(ComponentType::POSTPROCESSING) != nullptr);
         if (hasPostProcessing) ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.5f, 0.5f, 0.5f, 1.0f));
@@ -2349,4 +2466,17 @@ void InspectorWindow::DrawPostProcessingComponent(Component* component)
     {
         postProcessing->OnEditor();
     }
+}
+
+void InspectorWindow::DrawLightComponent(Component* component)
+{
+    ComponentLight* light = static_cast<ComponentLight*>(component);
+    if (!light) return;
+
+    bool open = ImGui::CollapsingHeader("Light", ImGuiTreeNodeFlags_DefaultOpen);
+    DrawComponentContextMenu(light, true);
+    if (open)
+    {
+        light->OnEditor();
+    }
 }
\ No newline at end of file
@@ -34,6 +34,7 @@ private:
     void DrawGizmoSettings();
     void DrawAddComponentButton(GameObject* selectedObject);
     void DrawPostProcessingComponent(Component* component);
+    void DrawLightComponent(Component* component);
     // Draw component functions
     void DrawTransformComponent(Component* component);
     void DrawCameraComponent(Component* component);
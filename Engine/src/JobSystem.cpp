@@ -0,0 +1,140 @@
+#include "JobSystem.h"
+#include <algorithm>
+
+// Set on workers and on a caller while it runs ranges, nested loops must not wait for the pool
+static thread_local bool runningJob = false;
+
+JobSystem& JobSystem::GetInstance()
+{
+    static JobSystem instance;
+    return instance;
+}
+
+JobSystem::JobSystem()
+{
+    unsigned int hardwareThreads = std::thread::hardware_concurrency();
+    int workerCount = std::max(1, static_cast<int>(hardwareThreads) - 1);
+
+    workers.reserve(workerCount);
+    for (int i = 0; i < workerCount; ++i)
+    {
+        workers.emplace_back(&JobSystem::WorkerLoop, this);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    wakeCondition.notify_all();
+
+    for (std::thread& worker : workers)
+    {
+        if (worker.joinable())
+            worker.join();
+    }
+}
+
+void JobSystem::ParallelFor(int count, int minRangeSize, const std::function<void(int, int)>& job)
+{
+    if (count <= 0)
+        return;
+
+    minRangeSize = std::max(1, minRangeSize);
+
+    // Not worth waking anyone up
+    if (count <= minRangeSize || workers.empty())
+    {
+        job(0, count);
+        return;
+    }
+
+    // Waiting for the pool from inside a job would never end, another thread's loop would be overwritten
+    bool runInline = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        runInline = runningJob || poolBusy;
+        if (!runInline) poolBusy = true;
+    }
+    if (runInline)
+    {
+        job(0, count);
+        return;
+    }
+
+    int ranges = std::min(GetWorkerCount() * 4, (count + minRangeSize - 1) / minRangeSize);
+
+    Batch batch;
+    batch.job = &job;
+    batch.count = count;
+    batch.rangeSize = (count + ranges - 1) / ranges;
+
+    // Hands the pool back even if the job throws on this thread. Workers that joined the batch may
+    // still be running their last range, and the batch lives on this stack
+    struct PoolRelease
+    {
+        JobSystem& jobs;
+        ~PoolRelease()
+        {
+            runningJob = false;
+            std::unique_lock<std::mutex> lock(jobs.mutex);
+            jobs.currentBatch = nullptr;
+            jobs.doneCondition.wait(lock, [this]() { return jobs.activeWorkers == 0; });
+            jobs.poolBusy = false;
+        }
+    } release{ *this };
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        currentBatch = &batch;
+        ++batchId;
+    }
+    wakeCondition.notify_all();
+
+    // The caller works too instead of sleeping
+    runningJob = true;
+    while (RunNextRange(batch)) {}
+}
+
+bool JobSystem::RunNextRange(Batch& batch)
+{
+    int begin = batch.nextIndex.fetch_add(batch.rangeSize);
+    if (begin >= batch.count)
+        return false;
+
+    int end = std::min(begin + batch.rangeSize, batch.count);
+    (*batch.job)(begin, end);
+    return true;
+}
+
+void JobSystem::WorkerLoop()
+{
+    unsigned int lastBatch = 0;
+    runningJob = true;
+
+    while (true)
+    {
+        Batch* batch = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeCondition.wait(lock, [this, lastBatch]() { return !running || (currentBatch != nullptr && batchId != lastBatch); });
+
+            if (!running)
+                return;
+
+            lastBatch = batchId;
+            batch = currentBatch;
+            ++activeWorkers;
+        }
+
+        while (RunNextRange(*batch)) {}
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --activeWorkers;
+        }
+        doneCondition.notify_all();
+    }
+}
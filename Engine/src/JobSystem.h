@@ -0,0 +1,56 @@
+#pragma once
+
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+
+// Small fixed-size worker pool for data-parallel loops (culling, particles, light binning).
+// ParallelFor blocks the calling thread, which also takes part in the work.
+// One loop runs on the pool at a time: a ParallelFor issued from inside a job, or while another
+// thread's loop is running, runs inline on the calling thread instead of waiting for the pool.
+class JobSystem
+{
+public:
+    static JobSystem& GetInstance();
+
+    // Calls job(begin, end) on contiguous ranges of [0, count) across the workers
+    void ParallelFor(int count, int minRangeSize, const std::function<void(int, int)>& job);
+
+    int GetWorkerCount() const { return static_cast<int>(workers.size()) + 1; }
+
+private:
+    struct Batch
+    {
+        const std::function<void(int, int)>* job = nullptr;
+        int count = 0;
+        int rangeSize = 1;
+        std::atomic<int> nextIndex{ 0 };
+    };
+
+    JobSystem();
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    void WorkerLoop();
+    static bool RunNextRange(Batch& batch);
+
+private:
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable wakeCondition;
+    std::condition_variable doneCondition;
+
+    // Batch being executed, only valid while ParallelFor is running
+    Batch* currentBatch = nullptr;
+    unsigned int batchId = 0;
+    bool poolBusy = false;  // a ParallelFor owns the workers until its last range is done
+    int activeWorkers = 0;
+
+    bool running = true;
+};
@@ -0,0 +1,191 @@
+#include "LightClusterer.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <emmintrin.h>
+
+static_assert(LightClusterer::kTilesX % 4 == 0, "Rows are tested four tiles at a time");
+
+// Slice entries pack the tile in the high bits and the light in the low ones
+static const int kEntryLightBits = 20;
+static const uint32_t kEntryLightMask = (1u << kEntryLightBits) - 1;
+
+void LightClusterer::SetProjection(const glm::mat4& projection, float near, float far)
+{
+    nearPlane = near;
+    farPlane = far;
+    projX = projection[0][0];
+    projY = projection[1][1];
+
+    float logRatio = std::log(farPlane / nearPlane);
+    sliceScale = kSlices / logRatio;
+    sliceBias = -kSlices * std::log(nearPlane) / logRatio;
+
+    for (int slice = 0; slice < kSlices; ++slice)
+    {
+        float sliceMin = nearPlane * std::pow(farPlane / nearPlane, (float)slice / kSlices);
+        float sliceMax = nearPlane * std::pow(farPlane / nearPlane, (float)(slice + 1) / kSlices);
+        sliceNear[slice] = sliceMin;
+        sliceFar[slice] = sliceMax;
+
+        // A tile edge at a given NDC moves outwards with depth, the box takes both ends
+        for (int x = 0; x < kTilesX; ++x)
+        {
+            float ndcMin = -1.0f + 2.0f * x / kTilesX;
+            float ndcMax = -1.0f + 2.0f * (x + 1) / kTilesX;
+            tileMinX[slice][x] = std::min(ndcMin * sliceMin, ndcMin * sliceMax) / projX;
+            tileMaxX[slice][x] = std::max(ndcMax * sliceMin, ndcMax * sliceMax) / projX;
+        }
+        for (int y = 0; y < kTilesY; ++y)
+        {
+            float ndcMin = -1.0f + 2.0f * y / kTilesY;
+            float ndcMax = -1.0f + 2.0f * (y + 1) / kTilesY;
+            tileMinY[slice][y] = std::min(ndcMin * sliceMin, ndcMin * sliceMax) / projY;
+            tileMaxY[slice][y] = std::max(ndcMax * sliceMin, ndcMax * sliceMax) / projY;
+        }
+    }
+}
+
+int LightClusterer::SliceOf(float depth) const
+{
+    int slice = (int)std::floor(std::log(depth) * sliceScale + sliceBias);
+    return std::clamp(slice, 0, kSlices - 1);
+}
+
+LightClusterer::LightBounds LightClusterer::ComputeBounds(const glm::vec4& sphere) const
+{
+    LightBounds result = { 0, -1, 0, -1, 0, -1 };
+
+    // The view looks down -Z
+    float depth = -sphere.z;
+    float radius = sphere.w;
+    float minDepth = std::max(depth - radius, nearPlane);
+    float maxDepth = std::min(depth + radius, farPlane);
+    if (minDepth > maxDepth) return result;
+
+    // NDC of the sphere's box is extreme at its corners, the depth range is positive
+    auto tileRange = [&](float center, float proj, int tiles, int& minTile, int& maxTile) {
+        float a = (center - radius) * proj;
+        float b = (center + radius) * proj;
+        float ndcMin = std::min(a / minDepth, a / maxDepth);
+        float ndcMax = std::max(b / minDepth, b / maxDepth);
+        if (ndcMin > 1.0f || ndcMax < -1.0f) return false;
+
+        minTile = std::clamp((int)std::floor((ndcMin + 1.0f) * 0.5f * tiles), 0, tiles - 1);
+        maxTile = std::clamp((int)std::floor((ndcMax + 1.0f) * 0.5f * tiles), 0, tiles - 1);
+        return true;
+        };
+
+    if (!tileRange(sphere.x, projX, kTilesX, result.minTileX, result.maxTileX)) return result;
+    if (!tileRange(sphere.y, projY, kTilesY, result.minTileY, result.maxTileY)) return result;
+
+    result.minSlice = SliceOf(minDepth);
+    result.maxSlice = SliceOf(maxDepth);
+    return result;
+}
+
+void LightClusterer::Build(const std::vector<glm::vec4>& viewSpheres)
+{
+    clusters.assign(kClusterCount, LightCluster{ 0, 0 });
+    lightIndices.clear();
+    occupiedClusters = 0;
+
+    size_t lightCount = std::min(viewSpheres.size(), (size_t)kEntryLightMask + 1);
+    bounds.resize(lightCount);
+
+    bool anyVisible = false;
+    for (size_t i = 0; i < lightCount; ++i)
+    {
+        bounds[i] = ComputeBounds(viewSpheres[i]);
+        anyVisible |= bounds[i].minSlice <= bounds[i].maxSlice;
+    }
+    if (!anyVisible) return;
+
+    JobSystem::GetInstance().ParallelFor(kSlices, 1, [&](int begin, int end) {
+        for (int slice = begin; slice < end; ++slice) BinSlice(slice, viewSpheres);
+        });
+
+    // Slices were grouped on their own, their offsets start after the previous slices
+    uint32_t base = 0;
+    for (int slice = 0; slice < kSlices; ++slice)
+    {
+        LightCluster* sliceClusters = clusters.data() + slice * kTilesX * kTilesY;
+        for (int tile = 0; tile < kTilesX * kTilesY; ++tile)
+        {
+            sliceClusters[tile].offset += base;
+            if (sliceClusters[tile].count > 0) occupiedClusters++;
+        }
+
+        lightIndices.insert(lightIndices.end(), sliceIndices[slice].begin(), sliceIndices[slice].end());
+        base += (uint32_t)sliceIndices[slice].size();
+    }
+}
+
+void LightClusterer::BinSlice(int slice, const std::vector<glm::vec4>& spheres)
+{
+    std::vector<uint32_t>& entries = sliceEntries[slice];
+    entries.clear();
+
+    const float nearDepth = sliceNear[slice];
+    const float farDepth = sliceFar[slice];
+    const __m128 zero = _mm_setzero_ps();
+
+    for (uint32_t light = 0; light < (uint32_t)bounds.size(); ++light)
+    {
+        const LightBounds& lightBounds = bounds[light];
+        if (slice < lightBounds.minSlice || slice > lightBounds.maxSlice) continue;
+
+        // Squared distance from the center to each froxel box, z and y are shared by a row
+        const glm::vec4& sphere = spheres[light];
+        float depth = -sphere.z;
+        float dz = std::max(nearDepth - depth, 0.0f) + std::max(depth - farDepth, 0.0f);
+        float radiusSq = sphere.w * sphere.w - dz * dz;
+        if (radiusSq < 0.0f) continue;
+
+        const __m128 centerX = _mm_set1_ps(sphere.x);
+        int firstGroup = lightBounds.minTileX & ~3;
+
+        for (int y = lightBounds.minTileY; y <= lightBounds.maxTileY; ++y)
+        {
+            float dy = std::max(tileMinY[slice][y] - sphere.y, 0.0f) + std::max(sphere.y - tileMaxY[slice][y], 0.0f);
+            float rowRadiusSq = radiusSq - dy * dy;
+            if (rowRadiusSq < 0.0f) continue;
+
+            const __m128 limit = _mm_set1_ps(rowRadiusSq);
+            for (int x = firstGroup; x <= lightBounds.maxTileX; x += 4)
+            {
+                __m128 below = _mm_max_ps(_mm_sub_ps(_mm_load_ps(&tileMinX[slice][x]), centerX), zero);
+                __m128 above = _mm_max_ps(_mm_sub_ps(centerX, _mm_load_ps(&tileMaxX[slice][x])), zero);
+                __m128 dx = _mm_add_ps(below, above);
+                int mask = _mm_movemask_ps(_mm_cmple_ps(_mm_mul_ps(dx, dx), limit));
+
+                for (int lane = 0; lane < 4; ++lane)
+                {
+                    int tileX = x + lane;
+                    if (!(mask & (1 << lane)) || tileX < lightBounds.minTileX || tileX > lightBounds.maxTileX) continue;
+
+                    uint32_t tile = (uint32_t)(y * kTilesX + tileX);
+                    entries.push_back((tile << kEntryLightBits) | light);
+                }
+            }
+        }
+    }
+
+    // Counting sort by tile keeps each tile's lights in light order
+    LightCluster* sliceClusters = clusters.data() + slice * kTilesX * kTilesY;
+    for (uint32_t entry : entries) sliceClusters[entry >> kEntryLightBits].count++;
+
+    uint32_t offset = 0;
+    for (int tile = 0; tile < kTilesX * kTilesY; ++tile)
+    {
+        sliceClusters[tile].offset = offset;
+        offset += sliceClusters[tile].count;
+    }
+
+    std::vector<uint32_t>& indices = sliceIndices[slice];
+    indices.resize(entries.size());
+
+    uint32_t cursor[kTilesX * kTilesY];
+    for (int tile = 0; tile < kTilesX * kTilesY; ++tile) cursor[tile] = sliceClusters[tile].offset;
+    for (uint32_t entry : entries) indices[cursor[entry >> kEntryLightBits]++] = entry & kEntryLightMask;
+}
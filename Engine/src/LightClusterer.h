@@ -0,0 +1,77 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+// Range of a cluster in the light index list, same layout as an entry of the LightGrid buffer
+struct LightCluster
+{
+    uint32_t offset;
+    uint32_t count;
+};
+
+// Bins lights into a froxel grid: kTilesX by kTilesY screen tiles, each split into kSlices depth
+// slices spaced exponentially between the near and far planes. A cluster lists the lights whose
+// bounding sphere touches it, so a fragment only evaluates the lights of its own cluster.
+// Slices are binned in parallel on the job system, four tiles of a row are tested at a time
+// with SSE. No GL calls are made here.
+class LightClusterer
+{
+public:
+    static const int kTilesX = 16;
+    static const int kTilesY = 9;
+    static const int kSlices = 24;
+    static const int kClusterCount = kTilesX * kTilesY * kSlices;
+
+    // Symmetric perspective projection, as glm::perspective builds it
+    void SetProjection(const glm::mat4& projection, float nearPlane, float farPlane);
+
+    // View space bounding spheres (xyz center, w radius), indices refer to this list
+    void Build(const std::vector<glm::vec4>& viewSpheres);
+
+    // Indexed by (slice * kTilesY + tileY) * kTilesX + tileX
+    const std::vector<LightCluster>& GetClusters() const { return clusters; }
+    const std::vector<uint32_t>& GetLightIndices() const { return lightIndices; }
+    int GetOccupiedClusters() const { return occupiedClusters; }
+
+    // Slice of a view depth: log(depth) * scale + bias
+    float GetSliceScale() const { return sliceScale; }
+    float GetSliceBias() const { return sliceBias; }
+
+private:
+    // Tiles and slices a light's sphere can reach, empty when minSlice > maxSlice
+    struct LightBounds
+    {
+        int minTileX, maxTileX;
+        int minTileY, maxTileY;
+        int minSlice, maxSlice;
+    };
+
+    int SliceOf(float depth) const;
+    LightBounds ComputeBounds(const glm::vec4& sphere) const;
+    void BinSlice(int slice, const std::vector<glm::vec4>& spheres);
+
+    float nearPlane = 0.1f;
+    float farPlane = 1000.0f;
+    float projX = 1.0f;
+    float projY = 1.0f;
+    float sliceScale = 0.0f;
+    float sliceBias = 0.0f;
+
+    // View space bounds of every froxel: x per slice and column, y per slice and row
+    alignas(16) float tileMinX[kSlices][kTilesX] = {};
+    alignas(16) float tileMaxX[kSlices][kTilesX] = {};
+    float tileMinY[kSlices][kTilesY] = {};
+    float tileMaxY[kSlices][kTilesY] = {};
+    float sliceNear[kSlices] = {};
+    float sliceFar[kSlices] = {};
+
+    std::vector<LightBounds> bounds;
+    std::vector<uint32_t> sliceEntries[kSlices];    // tile << 20 | light, in light order
+    std::vector<uint32_t> sliceIndices[kSlices];    // entries grouped by tile
+
+    std::vector<LightCluster> clusters;
+    std::vector<uint32_t> lightIndices;
+    int occupiedClusters = 0;
+};
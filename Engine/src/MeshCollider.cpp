@@ -52,19 +52,21 @@ void MeshCollider::CookMesh() {
     if (!hasValidMesh) {
         /*if (!meshRenderer) LOG(LogType::LOG_WARNING, "Mesh Collider on '%s' ignored: No MeshRenderer component found.", owner->name.c_str());*/
     }
-    else {
+    else if (meshRenderer->AcquireCPUData()) {
+
+        // Read straight from the mesh, GetVertices and GetIndices copy
+        const Mesh& mesh = meshRenderer->GetMesh();
 
-        int vertexSize = meshRenderer->GetNumVertices();
+        int vertexSize = (int)mesh.vertices.size();
         std::vector<glm::vec3> vertices(vertexSize);
         for (int i = 0; i < vertexSize; i++) {
-            vertices[i] = meshRenderer->GetVertices()[i].position;
+            vertices[i] = mesh.vertices[i].position;
         }
 
-        int indicesSize = meshRenderer->GetNumIndices();
-        std::vector<uint32_t> indices(indicesSize);
-        for (int i = 0; i < indicesSize; i++) {
-            indices[i] = meshRenderer->GetIndices()[i];
-        }
+        int indicesSize = (int)mesh.indices.size();
+        std::vector<uint32_t> indices(mesh.indices.begin(), mesh.indices.end());
+
+        meshRenderer->ReleaseCPUData();
 
         cookedMesh = PhysicsCooker::CookTriangleMesh(
             (const float*)vertices.data(),
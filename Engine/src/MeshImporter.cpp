@@ -2,6 +2,8 @@
 
 #include "MeshImporter.h"
 #include "LibraryManager.h"
+#include "MeshSimplifier.h"
+#include "VertexFormat.h"
 #include <filesystem>
 #include <assimp/mesh.h>
 #include <fstream>
@@ -10,6 +12,10 @@
 #include <algorithm>
 #include <limits>
 
+// Files written before the header start straight with the vertex count
+static const uint32_t kMeshFileMagic = 0x48534D57; // "WMSH"
+static const uint32_t kMeshFileVersion = 2;
+
 MeshImporter::MeshImporter() {}
 MeshImporter::~MeshImporter() {}
 
@@ -116,6 +122,45 @@ Mesh MeshImporter::ImportFromAssimp(const aiMesh* assimpMesh) {
     return mesh;
 }
 
+// LOD: Each level halves the triangles of the previous one, up to the error allowed for it
+static const float kLODTriangleRatios[kMaxMeshLODs - 1] = { 0.5f, 0.25f, 0.125f };
+static const float kLODMaxErrors[kMaxMeshLODs - 1] = { 0.01f, 0.03f, 0.08f };
+static const size_t kMinLODTriangles = 256;
+
+void MeshImporter::GenerateLODs(Mesh& mesh) {
+
+    mesh.lods.clear();
+
+    size_t triangleCount = mesh.indices.size() / 3;
+    if (triangleCount < kMinLODTriangles || mesh.vertices.empty()) return;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    const Vertex& first = mesh.vertices[0];
+    const std::vector<unsigned int>* source = &mesh.indices;
+    mesh.lods.reserve(kMaxMeshLODs - 1);
+
+    for (int level = 0; level < kMaxMeshLODs - 1; ++level) {
+        size_t target = (size_t)(triangleCount * kLODTriangleRatios[level]) * 3;
+
+        // Simplifying the previous level is much cheaper than starting from the full mesh
+        MeshLOD lod;
+        lod.error = MeshSimplifier::Simplify(&first.position.x, &first.normal.x, &first.texCoords.x, sizeof(Vertex),
+            mesh.vertices.size(), *source, target, kLODMaxErrors[level], lod.indices);
+
+        // Not worth a level if it barely removed anything (seams and borders are locked)
+        if (lod.indices.empty() || lod.indices.size() > source->size() * 0.85f) break;
+
+        mesh.lods.push_back(std::move(lod));
+        source = &mesh.lods.back().indices;
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    float ms = std::chrono::duration<float, std::milli>(end - start).count();
+
+    LOG_DEBUG("Generated %d LODs for %zu triangles in %.1f ms", (int)mesh.lods.size(), triangleCount, ms);
+}
+
 // SAVE: Our Mesh -> Custom Binary Format
 bool MeshImporter::SaveToCustomFormat(const Mesh& mesh, const UID& uid) {
     std::string fullPath = LibraryManager::GetLibraryPathFromUID(uid);
@@ -126,12 +171,40 @@ bool MeshImporter::SaveToCustomFormat(const Mesh& mesh, const UID& uid) {
     unsigned int numVertices = static_cast<unsigned int>(mesh.vertices.size());
     unsigned int numIndices = static_cast<unsigned int>(mesh.indices.size());
     unsigned int numBones = static_cast<unsigned int>(mesh.bones.size());
+    VertexLayout vertexLayout = VertexFormat::ChooseLayout(mesh);
+    uint32_t layout = static_cast<uint32_t>(vertexLayout);
+
+    if (vertexLayout != VertexFormat::GetDefaultLayout()) {
+        LOG_CONSOLE("[MeshImporter] WARNING: Mesh has %u bones, too many for the compact layout. Saving full vertices", numBones);
+    }
+
+    file.write(reinterpret_cast<const char*>(&kMeshFileMagic), sizeof(uint32_t));
+    file.write(reinterpret_cast<const char*>(&kMeshFileVersion), sizeof(uint32_t));
+    file.write(reinterpret_cast<const char*>(&layout), sizeof(uint32_t));
 
     file.write(reinterpret_cast<const char*>(&numVertices), sizeof(unsigned int));
     file.write(reinterpret_cast<const char*>(&numIndices), sizeof(unsigned int));
     file.write(reinterpret_cast<const char*>(&numBones), sizeof(unsigned int));
 
-    file.write(reinterpret_cast<const char*>(mesh.vertices.data()), numVertices * sizeof(Vertex));
+    if (layout == static_cast<uint32_t>(VertexLayout::COMPACT)) {
+        // Static stream, then the skinning stream for skinned meshes
+        std::vector<PackedVertex> packed(numVertices);
+        for (unsigned int i = 0; i < numVertices; i++) {
+            packed[i] = VertexFormat::Pack(mesh.vertices[i]);
+        }
+        file.write(reinterpret_cast<const char*>(packed.data()), numVertices * sizeof(PackedVertex));
+
+        if (numBones > 0) {
+            std::vector<PackedSkin> skin(numVertices);
+            for (unsigned int i = 0; i < numVertices; i++) {
+                skin[i] = VertexFormat::PackSkin(mesh.vertices[i]);
+            }
+            file.write(reinterpret_cast<const char*>(skin.data()), numVertices * sizeof(PackedSkin));
+        }
+    }
+    else {
+        file.write(reinterpret_cast<const char*>(mesh.vertices.data()), numVertices * sizeof(Vertex));
+    }
 
     file.write(reinterpret_cast<const char*>(mesh.indices.data()), numIndices * sizeof(unsigned int));
 
@@ -142,6 +215,17 @@ bool MeshImporter::SaveToCustomFormat(const Mesh& mesh, const UID& uid) {
         file.write(reinterpret_cast<const char*>(&bone.offsetMatrix), sizeof(glm::mat4));
     }
 
+    // LODs go last so files written before them still load
+    unsigned int numLODs = static_cast<unsigned int>(mesh.lods.size());
+    file.write(reinterpret_cast<const char*>(&numLODs), sizeof(unsigned int));
+
+    for (const auto& lod : mesh.lods) {
+        unsigned int numLODIndices = static_cast<unsigned int>(lod.indices.size());
+        file.write(reinterpret_cast<const char*>(&lod.error), sizeof(float));
+        file.write(reinterpret_cast<const char*>(&numLODIndices), sizeof(unsigned int));
+        file.write(reinterpret_cast<const char*>(lod.indices.data()), numLODIndices * sizeof(unsigned int));
+    }
+
     file.close();
     return true;
 }
@@ -154,14 +238,47 @@ Mesh MeshImporter::LoadFromCustomFormat(const UID& uid) {
     if (!file.is_open()) return mesh;
 
     unsigned int numVertices = 0, numIndices = 0, numBones = 0;
+    uint32_t magic = 0, version = 0, layout = static_cast<uint32_t>(VertexLayout::FULL);
+
+    file.read(reinterpret_cast<char*>(&magic), sizeof(uint32_t));
+
+    if (magic == kMeshFileMagic) {
+        file.read(reinterpret_cast<char*>(&version), sizeof(uint32_t));
+        file.read(reinterpret_cast<char*>(&layout), sizeof(uint32_t));
+        file.read(reinterpret_cast<char*>(&numVertices), sizeof(unsigned int));
+
+        if (version > kMeshFileVersion) {
+            LOG_CONSOLE("[MeshImporter] ERROR: Mesh file version %u is newer than supported (%u)", version, kMeshFileVersion);
+            return mesh;
+        }
+    }
+    else {
+        numVertices = magic;
+    }
 
-    file.read(reinterpret_cast<char*>(&numVertices), sizeof(unsigned int));
     file.read(reinterpret_cast<char*>(&numIndices), sizeof(unsigned int));
     file.read(reinterpret_cast<char*>(&numBones), sizeof(unsigned int));
 
     if (numVertices > 0) {
         mesh.vertices.resize(numVertices);
-        file.read(reinterpret_cast<char*>(mesh.vertices.data()), numVertices * sizeof(Vertex));
+
+        if (layout == static_cast<uint32_t>(VertexLayout::COMPACT)) {
+            std::vector<PackedVertex> packed(numVertices);
+            std::vector<PackedSkin> skin;
+            file.read(reinterpret_cast<char*>(packed.data()), numVertices * sizeof(PackedVertex));
+
+            if (numBones > 0) {
+                skin.resize(numVertices);
+                file.read(reinterpret_cast<char*>(skin.data()), numVertices * sizeof(PackedSkin));
+            }
+
+            for (unsigned int i = 0; i < numVertices; i++) {
+                VertexFormat::Unpack(packed[i], skin.empty() ? nullptr : &skin[i], mesh.vertices[i]);
+            }
+        }
+        else {
+            file.read(reinterpret_cast<char*>(mesh.vertices.data()), numVertices * sizeof(Vertex));
+        }
     }
     if (numIndices > 0) {
         mesh.indices.resize(numIndices);
@@ -181,6 +298,21 @@ Mesh MeshImporter::LoadFromCustomFormat(const UID& uid) {
         }
     }
 
+    unsigned int numLODs = 0;
+    if (file.read(reinterpret_cast<char*>(&numLODs), sizeof(unsigned int)) && numLODs < kMaxMeshLODs) {
+        mesh.lods.resize(numLODs);
+        for (auto& lod : mesh.lods) {
+            unsigned int numLODIndices = 0;
+            file.read(reinterpret_cast<char*>(&lod.error), sizeof(float));
+            file.read(reinterpret_cast<char*>(&numLODIndices), sizeof(unsigned int));
+
+            lod.indices.resize(numLODIndices);
+            file.read(reinterpret_cast<char*>(lod.indices.data()), numLODIndices * sizeof(unsigned int));
+        }
+
+        if (!file) mesh.lods.clear();
+    }
+
     file.close();
     return mesh;
 }
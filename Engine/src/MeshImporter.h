@@ -18,6 +18,9 @@ public:
     // IMPORT: Convert from Assimp mesh to our Mesh structure
     static Mesh ImportFromAssimp(const aiMesh* assimpMesh);
 
+    // LOD: Build simplified index lists (mesh.lods) by quadric edge collapse
+    static void GenerateLODs(Mesh& mesh);
+
     // SAVE: Save our Mesh to custom binary format in Library/Meshes/
     static bool SaveToCustomFormat(const Mesh& mesh, const UID& uid);
 
@@ -0,0 +1,371 @@
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+namespace
+{
+    const unsigned int kNoCollapse = 0xFFFFFFFFu;
+
+    // Squared normal and UV differences are scaled by the squared edge length and this weight
+    const double kAttributeWeight = 0.5;
+
+    // Triangles that turn more than this (cosine) are rejected as flips
+    const double kMinNormalDot = 0.2;
+
+    struct Vec3
+    {
+        double x, y, z;
+    };
+
+    Vec3 Sub(const Vec3& a, const Vec3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+    double Dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+    Vec3 Cross(const Vec3& a, const Vec3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+
+    // Symmetric 4x4 error matrix of a set of planes
+    struct Quadric
+    {
+        double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+        double b0 = 0, b1 = 0, b2 = 0, c = 0;
+
+        void AddPlane(const Vec3& n, double d)
+        {
+            a00 += n.x * n.x; a01 += n.x * n.y; a02 += n.x * n.z;
+            a11 += n.y * n.y; a12 += n.y * n.z; a22 += n.z * n.z;
+            b0 += n.x * d; b1 += n.y * d; b2 += n.z * d;
+            c += d * d;
+        }
+
+        void Add(const Quadric& q)
+        {
+            a00 += q.a00; a01 += q.a01; a02 += q.a02;
+            a11 += q.a11; a12 += q.a12; a22 += q.a22;
+            b0 += q.b0; b1 += q.b1; b2 += q.b2;
+            c += q.c;
+        }
+
+        // Sum of squared distances from p to the planes
+        double Evaluate(const Vec3& p) const
+        {
+            double result = a00 * p.x * p.x + a11 * p.y * p.y + a22 * p.z * p.z
+                + 2.0 * (a01 * p.x * p.y + a02 * p.x * p.z + a12 * p.y * p.z)
+                + 2.0 * (b0 * p.x + b1 * p.y + b2 * p.z) + c;
+            return result > 0.0 ? result : 0.0;
+        }
+    };
+
+    struct Collapse
+    {
+        unsigned int from;
+        unsigned int to;
+        double cost;
+    };
+
+    // Exact bit pattern of a few floats, used to weld identical vertices
+    struct VertexKey
+    {
+        uint32_t bits[8];
+        bool operator==(const VertexKey& other) const { return std::memcmp(bits, other.bits, sizeof(bits)) == 0; }
+    };
+
+    struct VertexKeyHash
+    {
+        size_t operator()(const VertexKey& key) const
+        {
+            uint64_t hash = 14695981039346656037ull;
+            for (uint32_t word : key.bits)
+            {
+                hash ^= word;
+                hash *= 1099511628211ull;
+            }
+            return (size_t)hash;
+        }
+    };
+
+    const float* Attribute(const float* base, size_t stride, size_t vertex)
+    {
+        return reinterpret_cast<const float*>(reinterpret_cast<const char*>(base) + stride * vertex);
+    }
+
+    uint64_t EdgeKey(unsigned int a, unsigned int b)
+    {
+        if (a > b) std::swap(a, b);
+        return ((uint64_t)a << 32) | b;
+    }
+}
+
+float MeshSimplifier::Simplify(const float* positions, const float* normals, const float* uvs, size_t stride,
+    size_t vertexCount, const std::vector<unsigned int>& indices, size_t targetIndexCount, float maxError,
+    std::vector<unsigned int>& result)
+{
+    result.clear();
+    if (!positions || vertexCount == 0 || indices.size() < 3) return 0.0f;
+
+    // Work on positions scaled to the unit box so errors are relative to the mesh size
+    Vec3 boundsMin = { 1e30, 1e30, 1e30 };
+    Vec3 boundsMax = { -1e30, -1e30, -1e30 };
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        const float* p = Attribute(positions, stride, i);
+        boundsMin = { std::min(boundsMin.x, (double)p[0]), std::min(boundsMin.y, (double)p[1]), std::min(boundsMin.z, (double)p[2]) };
+        boundsMax = { std::max(boundsMax.x, (double)p[0]), std::max(boundsMax.y, (double)p[1]), std::max(boundsMax.z, (double)p[2]) };
+    }
+    double extent = std::max(boundsMax.x - boundsMin.x, std::max(boundsMax.y - boundsMin.y, boundsMax.z - boundsMin.z));
+    double scale = extent > 0.0 ? 1.0 / extent : 1.0;
+
+    std::vector<Vec3> points(vertexCount);
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        const float* p = Attribute(positions, stride, i);
+        points[i] = { (p[0] - boundsMin.x) * scale, (p[1] - boundsMin.y) * scale, (p[2] - boundsMin.z) * scale };
+    }
+
+    // Vertices identical in every attribute are one vertex (importers often leave duplicates),
+    // vertices sharing only the position form a seam
+    std::vector<unsigned int> weld(vertexCount);
+    std::vector<unsigned int> positionOf(vertexCount);
+    {
+        std::unordered_map<VertexKey, unsigned int, VertexKeyHash> vertexMap;
+        std::unordered_map<VertexKey, unsigned int, VertexKeyHash> positionMap;
+        vertexMap.reserve(vertexCount);
+        positionMap.reserve(vertexCount);
+
+        for (size_t i = 0; i < vertexCount; ++i)
+        {
+            VertexKey key = {};
+            std::memcpy(key.bits, Attribute(positions, stride, i), sizeof(float) * 3);
+            positionOf[i] = positionMap.emplace(key, (unsigned int)i).first->second;
+
+            if (normals) std::memcpy(key.bits + 3, Attribute(normals, stride, i), sizeof(float) * 3);
+            if (uvs) std::memcpy(key.bits + 6, Attribute(uvs, stride, i), sizeof(float) * 2);
+            weld[i] = vertexMap.emplace(key, (unsigned int)i).first->second;
+        }
+    }
+
+    std::vector<unsigned int> triangles;
+    triangles.reserve(indices.size());
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        unsigned int a = indices[i], b = indices[i + 1], c = indices[i + 2];
+        if (a >= vertexCount || b >= vertexCount || c >= vertexCount) continue;
+
+        a = weld[a]; b = weld[b]; c = weld[c];
+        if (positionOf[a] == positionOf[b] || positionOf[b] == positionOf[c] || positionOf[a] == positionOf[c]) continue;
+
+        triangles.push_back(a);
+        triangles.push_back(b);
+        triangles.push_back(c);
+    }
+
+    // Plane quadrics are kept per position so both sides of a seam agree
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t i = 0; i < triangles.size(); i += 3)
+    {
+        const Vec3& p0 = points[triangles[i]];
+        Vec3 n = Cross(Sub(points[triangles[i + 1]], p0), Sub(points[triangles[i + 2]], p0));
+        double length = std::sqrt(Dot(n, n));
+        if (length <= 0.0) continue;
+
+        n = { n.x / length, n.y / length, n.z / length };
+        double d = -Dot(n, p0);
+        for (int k = 0; k < 3; ++k)
+        {
+            quadrics[positionOf[triangles[i + k]]].AddPlane(n, d);
+        }
+    }
+
+    // Lock seams, open borders and non-manifold edges
+    std::vector<unsigned char> locked(vertexCount, 0);
+    {
+        std::vector<unsigned int> wedges(vertexCount, 0);
+        std::vector<unsigned char> counted(vertexCount, 0);
+        for (unsigned int v : triangles)
+        {
+            if (counted[v]) continue;
+            counted[v] = 1;
+            wedges[positionOf[v]]++;
+        }
+
+        std::unordered_map<uint64_t, int> edgeUses;
+        edgeUses.reserve(triangles.size());
+        for (size_t i = 0; i < triangles.size(); i += 3)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                edgeUses[EdgeKey(positionOf[triangles[i + k]], positionOf[triangles[i + (k + 1) % 3]])]++;
+            }
+        }
+
+        for (const auto& edge : edgeUses)
+        {
+            if (edge.second == 2) continue;
+            locked[(unsigned int)(edge.first >> 32)] = 1;
+            locked[(unsigned int)(edge.first & 0xFFFFFFFFu)] = 1;
+        }
+
+        for (unsigned int v : triangles)
+        {
+            if (wedges[positionOf[v]] > 1) locked[positionOf[v]] = 1;
+        }
+    }
+
+    double maxCost = (double)maxError * (double)maxError;
+    double reachedCost = 0.0;
+
+    std::vector<unsigned int> adjacencyOffsets(vertexCount + 1);
+    std::vector<unsigned int> adjacency;
+    std::vector<Collapse> collapses;
+    std::vector<unsigned int> collapseTarget(vertexCount, kNoCollapse);
+    std::vector<unsigned char> touched(vertexCount);
+
+    // Each pass collapses a set of edges that don't share a neighbourhood, so the flip test
+    // of one collapse can't be invalidated by another in the same pass
+    while (triangles.size() > targetIndexCount)
+    {
+        size_t triangleCount = triangles.size() / 3;
+
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+        for (unsigned int v : triangles) adjacencyOffsets[v + 1]++;
+        for (size_t i = 0; i < vertexCount; ++i) adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+        adjacency.resize(triangles.size());
+        {
+            std::vector<unsigned int> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (size_t i = 0; i < triangles.size(); ++i)
+            {
+                adjacency[cursor[triangles[i]]++] = (unsigned int)(i / 3);
+            }
+        }
+
+        collapses.clear();
+        for (size_t i = 0; i < triangles.size(); i += 3)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                unsigned int a = triangles[i + k];
+                unsigned int b = triangles[i + (k + 1) % 3];
+
+                for (int direction = 0; direction < 2; ++direction)
+                {
+                    unsigned int from = direction ? b : a;
+                    unsigned int to = direction ? a : b;
+                    if (locked[positionOf[from]]) continue;
+
+                    Quadric q = quadrics[positionOf[from]];
+                    q.Add(quadrics[positionOf[to]]);
+                    double cost = q.Evaluate(points[to]);
+
+                    Vec3 edge = Sub(points[to], points[from]);
+                    double attributeDelta = 0.0;
+                    if (normals)
+                    {
+                        const float* n0 = Attribute(normals, stride, from);
+                        const float* n1 = Attribute(normals, stride, to);
+                        for (int c = 0; c < 3; ++c) attributeDelta += (double)(n1[c] - n0[c]) * (n1[c] - n0[c]);
+                    }
+                    if (uvs)
+                    {
+                        const float* t0 = Attribute(uvs, stride, from);
+                        const float* t1 = Attribute(uvs, stride, to);
+                        for (int c = 0; c < 2; ++c) attributeDelta += (double)(t1[c] - t0[c]) * (t1[c] - t0[c]);
+                    }
+                    cost += kAttributeWeight * attributeDelta * Dot(edge, edge);
+
+                    collapses.push_back({ from, to, cost });
+                }
+            }
+        }
+
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b)
+            {
+                if (a.cost != b.cost) return a.cost < b.cost;
+                if (a.from != b.from) return a.from < b.from;
+                return a.to < b.to;
+            });
+
+        std::fill(touched.begin(), touched.end(), 0);
+        size_t removedTriangles = 0;
+        size_t targetTriangles = targetIndexCount / 3;
+        bool applied = false;
+
+        for (const Collapse& collapse : collapses)
+        {
+            if (collapse.cost > maxCost) break;
+            if (triangleCount - removedTriangles <= targetTriangles) break;
+            if (touched[collapse.from] || touched[collapse.to]) continue;
+
+            // Reject collapses that flip or squash a triangle of the fan
+            bool valid = true;
+            size_t sharedTriangles = 0;
+            for (unsigned int t = adjacencyOffsets[collapse.from]; t < adjacencyOffsets[collapse.from + 1] && valid; ++t)
+            {
+                const unsigned int* tri = &triangles[adjacency[t] * 3];
+                if (tri[0] == collapse.to || tri[1] == collapse.to || tri[2] == collapse.to)
+                {
+                    sharedTriangles++;
+                    continue;
+                }
+
+                Vec3 before[3], after[3];
+                for (int k = 0; k < 3; ++k)
+                {
+                    before[k] = points[tri[k]];
+                    after[k] = tri[k] == collapse.from ? points[collapse.to] : points[tri[k]];
+                }
+
+                Vec3 n0 = Cross(Sub(before[1], before[0]), Sub(before[2], before[0]));
+                Vec3 n1 = Cross(Sub(after[1], after[0]), Sub(after[2], after[0]));
+                double lengths = std::sqrt(Dot(n0, n0) * Dot(n1, n1));
+                if (lengths <= 0.0 || Dot(n0, n1) < kMinNormalDot * lengths) valid = false;
+            }
+            if (!valid) continue;
+
+            collapseTarget[collapse.from] = collapse.to;
+            for (unsigned int t = adjacencyOffsets[collapse.from]; t < adjacencyOffsets[collapse.from + 1]; ++t)
+            {
+                const unsigned int* tri = &triangles[adjacency[t] * 3];
+                touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = 1;
+            }
+            touched[collapse.to] = 1;
+
+            quadrics[positionOf[collapse.to]].Add(quadrics[positionOf[collapse.from]]);
+            reachedCost = std::max(reachedCost, collapse.cost);
+            removedTriangles += sharedTriangles;
+            applied = true;
+        }
+
+        if (!applied) break;
+
+        size_t write = 0;
+        for (size_t i = 0; i < triangles.size(); i += 3)
+        {
+            unsigned int tri[3];
+            for (int k = 0; k < 3; ++k)
+            {
+                unsigned int v = triangles[i + k];
+                tri[k] = collapseTarget[v] != kNoCollapse ? collapseTarget[v] : v;
+            }
+
+            if (positionOf[tri[0]] == positionOf[tri[1]] || positionOf[tri[1]] == positionOf[tri[2]] ||
+                positionOf[tri[0]] == positionOf[tri[2]])
+            {
+                continue;
+            }
+
+            triangles[write++] = tri[0];
+            triangles[write++] = tri[1];
+            triangles[write++] = tri[2];
+        }
+        triangles.resize(write);
+
+        for (size_t i = 0; i < vertexCount; ++i)
+        {
+            if (collapseTarget[i] != kNoCollapse) locked[positionOf[i]] = 1; // no longer referenced
+            collapseTarget[i] = kNoCollapse;
+        }
+    }
+
+    result = std::move(triangles);
+    return (float)std::sqrt(reachedCost);
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Quadric error edge collapse for indexed triangle lists, used to build mesh LODs at import.
+// Has no GL or engine dependency.
+//
+// Edges collapse into one of their endpoints, so the result indexes the same vertex buffer:
+// every LOD shares the mesh's vertices and keeps their normals, UVs and bone weights as is.
+// Vertices on open borders and attribute seams (one position, several vertices) are locked,
+// and a collapse costs extra when the two endpoints have different normals or UVs.
+class MeshSimplifier
+{
+public:
+    // positions, normals and uvs point at the first vertex's attribute and share the same
+    // stride in bytes. normals and uvs can be null.
+    // Collapses edges until the index count drops to targetIndexCount or the next collapse
+    // would exceed maxError, measured as a fraction of the mesh extent.
+    // Returns the largest error introduced.
+    static float Simplify(const float* positions, const float* normals, const float* uvs, size_t stride,
+        size_t vertexCount, const std::vector<unsigned int>& indices, size_t targetIndexCount, float maxError,
+        std::vector<unsigned int>& result);
+};
@@ -61,7 +61,8 @@ bool MetaFile::Save(const std::string& metaFilePath) const {
             {"generateMipmaps", importSettings.generateMipmaps},
             {"filterMode", importSettings.filterMode},
             {"flipHorizontal", importSettings.flipHorizontal},
-            {"maxTextureSize", importSettings.maxTextureSize}
+            {"maxTextureSize", importSettings.maxTextureSize},
+            {"compression", importSettings.compression}
         };
     }
 
@@ -128,6 +129,7 @@ MetaFile MetaFile::Load(const std::string& metaFilePath) {
                 if (settings.contains("filterMode")) meta.importSettings.filterMode = settings["filterMode"].get<int>();
                 if (settings.contains("flipHorizontal")) meta.importSettings.flipHorizontal = settings["flipHorizontal"].get<bool>();
                 if (settings.contains("maxTextureSize")) meta.importSettings.maxTextureSize = settings["maxTextureSize"].get<int>();
+                if (settings.contains("compression")) meta.importSettings.compression = settings["compression"].get<int>();
             }
         }
     }
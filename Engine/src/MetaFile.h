@@ -37,6 +37,7 @@ struct ImportSettings {
     int filterMode = 2;    // 0=Point, 1=Bilinear, 2=Trilinear
     bool flipHorizontal = false;
     int maxTextureSize = 6;     // Index: 0=32, 1=64, 2=128, 3=256, 4=512, 5=1024, 6=2048, 7=4096, 8=8192
+    int compression = 0;        // TextureFormat: 0=None (RGBA8), 1=BC1, 2=BC3, 3=BC5, 4=BC7
 
     // Helper para obtener el modo OpenGL de filtrado
     unsigned int GetGLFilterMode(bool mipmap = false) const {
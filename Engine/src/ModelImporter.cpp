@@ -380,6 +380,8 @@ UID ModelImporter::ProcessMesh(aiMesh* aiMesh, const aiScene* scene, const UID u
         return 0;
     }
 
+    MeshImporter::GenerateLODs(mesh);
+
     // Save to Library using UID-based filename
     if (!MeshImporter::SaveToCustomFormat(mesh, meshUID)) {
         LOG_CONSOLE("ERROR: Failed to save mesh to Library");
@@ -455,9 +457,13 @@ void ModelImporter::CalculateBoundingBox(GameObject* obj, glm::vec3& minBounds,
     {
         const Mesh& mesh = meshComp->GetMesh();
 
-        for (const auto& vertex : mesh.vertices)
+        // Corners of the upload bounds, the vertices may no longer be on the CPU
+        for (int corner = 0; corner < (mesh.IsValid() ? 8 : 0); corner++)
         {
-            glm::vec4 worldPos = worldTransform * glm::vec4(vertex.position, 1.0f);
+            glm::vec3 position((corner & 1) ? mesh.boundsMax.x : mesh.boundsMin.x,
+                (corner & 2) ? mesh.boundsMax.y : mesh.boundsMin.y,
+                (corner & 4) ? mesh.boundsMax.z : mesh.boundsMin.z);
+            glm::vec4 worldPos = worldTransform * glm::vec4(position, 1.0f);
             glm::vec3 pos3(worldPos.x, worldPos.y, worldPos.z);
 
             minBounds.x = std::min(minBounds.x, pos3.x);
@@ -42,6 +42,7 @@
 #include "DeleteCommand.h"
 #include "CreateCommand.h"
 #include "CompositeCommand.h"
+#include "GpuProfiler.h"
 
 ModuleEditor::ModuleEditor() : Module()
 {
@@ -197,6 +198,8 @@ bool ModuleEditor::Update()
 bool ModuleEditor::PostUpdate()
 {
     ImGui::Render();
+
+    GpuProfiler::Scope pass("Editor UI");
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
     return true;
 }
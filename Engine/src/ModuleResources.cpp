@@ -56,6 +56,14 @@ bool ModuleResources::Start() {
 }
 
 bool ModuleResources::Update() {
+    for (UID uid : pendingCPUDataReleases) {
+        Resource* resource = GetResourceDirect(uid);
+        if (resource && resource->GetType() == Resource::MESH) {
+            static_cast<ResourceMesh*>(resource)->TrimCPUData();
+        }
+    }
+    pendingCPUDataReleases.clear();
+
     return true;
 }
 
@@ -3,6 +3,7 @@
 #include "Module.h"
 #include <map>
 #include <string>
+#include <vector>
 
 // Resource UIDs
 typedef unsigned long long UID;
@@ -129,6 +130,10 @@ public:
         }
     }
 
+    // Mesh resources loaded this frame drop their CPU copy on the next update, so components
+    // created along with them can still acquire it without a reload
+    void ScheduleCPUDataRelease(UID uid) { pendingCPUDataReleases.push_back(uid); }
+
     // Check if a resource is loaded in memory
     bool IsResourceLoaded(UID uid) const;
 
@@ -179,4 +184,5 @@ private:
 private:
     std::map<UID, Resource*> resources;  // UID -> Resource* map
     UID nextUID = 1;                     // UID counter
+    std::vector<UID> pendingCPUDataReleases;
 };
\ No newline at end of file
@@ -6,10 +6,12 @@
 #include "Transform.h"
 #include <float.h>
 #include <functional>
+#include <algorithm>
 #include "ComponentMesh.h"
 #include "ComponentCamera.h"
 #include <nlohmann/json.hpp>
 #include <fstream>
+#include <chrono>
 
 ModuleScene::ModuleScene() : Module()
 {
@@ -58,8 +60,7 @@ void ModuleScene::RebuildOctree()
         ComponentMesh* mesh = static_cast<ComponentMesh*>(obj->GetComponent(ComponentType::MESH));
         if (mesh && mesh->IsActive() && mesh->HasMesh())
         {
-            AABB objectAABB;
-            mesh->GetGlobalAABB();
+            AABB objectAABB = mesh->GetGlobalAABB();
 
             sceneAABB.min = glm::min(sceneAABB.min, objectAABB.min);
             sceneAABB.max = glm::max(sceneAABB.max, objectAABB.max);
@@ -94,12 +95,12 @@ void ModuleScene::RebuildOctree()
 
     if (!octree)
     {
-        octree = std::make_unique<Octree>(sceneAABB.min, sceneAABB.max, 4, 5);
+        octree = std::make_unique<Octree>(sceneAABB.min, sceneAABB.max, 4, 5, octreeType);
     }
     else
     {
         octree->Clear();
-        octree->Create(sceneAABB.min, sceneAABB.max, 4, 5);
+        octree->Create(sceneAABB.min, sceneAABB.max, 4, 5, octreeType);
     }
 
     // Insert all game objects
@@ -131,11 +132,206 @@ void ModuleScene::RebuildOctree()
 
     // Reset flag after rebuild
     needsOctreeRebuild = false;
+    movedObjects.clear();
 
     LOG_DEBUG("[ModuleScene] Octree rebuilt with %d objects", insertedCount);
     LOG_CONSOLE("Octree rebuilt: %d objects", insertedCount);
 }
 
+void ModuleScene::NotifyObjectMoved(GameObject* obj)
+{
+    if (!obj || !octree || needsOctreeRebuild) return;
+
+    movedObjects.insert(obj);
+}
+
+void ModuleScene::ForgetObject(GameObject* obj)
+{
+    if (!obj) return;
+
+    movedObjects.erase(obj);
+
+    if (octree)
+    {
+        octree->Remove(obj);
+    }
+}
+
+void ModuleScene::ScheduleEmitterUpdate(EmitterInstance* emitter, float dt)
+{
+    if (emitter) emitterSteps.push_back({ emitter, dt });
+}
+
+void ModuleScene::CancelEmitterUpdate(EmitterInstance* emitter)
+{
+    emitterSteps.erase(std::remove_if(emitterSteps.begin(), emitterSteps.end(),
+        [emitter](const EmitterStep& step) { return step.emitter == emitter; }), emitterSteps.end());
+}
+
+void ModuleScene::UpdateOctree()
+{
+    if (needsOctreeRebuild || !octree)
+    {
+        RebuildOctree();
+        return;
+    }
+
+    // Re-insert objects whose bounds changed since the last update
+    for (GameObject* obj : movedObjects)
+    {
+        octree->Remove(obj);
+
+        ComponentMesh* mesh = static_cast<ComponentMesh*>(obj->GetComponent(ComponentType::MESH));
+        if (!obj->IsActive() || !mesh || !mesh->IsActive() || !mesh->HasMesh())
+            continue;
+
+        // Left the octree bounds, only a rebuild can grow them
+        if (!octree->Insert(obj))
+        {
+            needsOctreeRebuild = true;
+        }
+    }
+    movedObjects.clear();
+
+    if (needsOctreeRebuild)
+    {
+        RebuildOctree();
+    }
+}
+
+void ModuleScene::SetOctreeType(OctreeType type)
+{
+    if (octreeType == type) return;
+
+    octreeType = type;
+    needsOctreeRebuild = true;
+}
+
+void ModuleScene::BenchmarkOctree()
+{
+    UpdateOctree();
+
+    std::vector<GameObject*> objects;
+    std::vector<AABB> bounds;
+
+    std::function<void(GameObject*)> collect = [&](GameObject* obj) {
+        if (!obj || !obj->IsActive()) return;
+
+        ComponentMesh* mesh = static_cast<ComponentMesh*>(obj->GetComponent(ComponentType::MESH));
+        if (mesh && mesh->IsActive() && mesh->HasMesh())
+        {
+            objects.push_back(obj);
+            bounds.push_back(mesh->GetGlobalAABB());
+        }
+
+        for (GameObject* child : obj->GetChildren())
+        {
+            collect(child);
+        }
+        };
+
+    if (root) collect(root);
+
+    if (objects.empty() || !octree)
+    {
+        LOG_CONSOLE("Octree benchmark: no mesh objects in scene");
+        return;
+    }
+
+    // Same bounds as the live tree
+    const AABB& sceneBounds = octree->GetRootAABB();
+
+    auto elapsedMs = [](std::chrono::high_resolution_clock::time_point start) {
+        return std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        };
+
+    const OctreeType types[2] = { OctreeType::STRICT, OctreeType::LOOSE };
+    for (OctreeType type : types)
+    {
+        Octree tree(sceneBounds.min, sceneBounds.max, 4, 5, type);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (GameObject* obj : objects) tree.Insert(obj);
+        float insertMs = elapsedMs(start);
+
+        // One box query per object, around its own bounds
+        std::vector<GameObject*> results;
+        size_t totalResults = 0;
+        start = std::chrono::high_resolution_clock::now();
+        for (const AABB& box : bounds)
+        {
+            results.clear();
+            tree.CollectIntersections(results, box);
+            totalResults += results.size();
+        }
+        float queryMs = elapsedMs(start);
+
+        // What a moved object costs
+        start = std::chrono::high_resolution_clock::now();
+        for (GameObject* obj : objects)
+        {
+            tree.Remove(obj);
+            tree.Insert(obj);
+        }
+        float moveMs = elapsedMs(start);
+
+        LOG_CONSOLE("Octree benchmark [%s]: %d objects, %d nodes, %d entries | insert %.3f ms, %d queries %.3f ms (%d results), reinsert %.3f ms",
+            type == OctreeType::STRICT ? "Strict" : "Loose",
+            (int)objects.size(), tree.GetTotalNodeCount(), tree.GetTotalObjectCount(),
+            insertMs, (int)bounds.size(), queryMs, (int)totalResults, moveMs);
+    }
+}
+
+int ModuleScene::OverlapSphere(const glm::vec3& center, float radius, std::vector<GameObject*>& results)
+{
+    UpdateOctree();
+
+    size_t first = results.size();
+    octree->CollectIntersections(results, Sphere(center, radius));
+
+    // Objects straddling several nodes of a strict tree are reported once per node
+    if (octree->GetType() == OctreeType::STRICT)
+    {
+        std::sort(results.begin() + first, results.end());
+        results.erase(std::unique(results.begin() + first, results.end()), results.end());
+    }
+
+    return static_cast<int>(results.size() - first);
+}
+
+int ModuleScene::OverlapBox(const AABB& box, std::vector<GameObject*>& results)
+{
+    UpdateOctree();
+
+    size_t first = results.size();
+    octree->CollectIntersections(results, box);
+
+    if (octree->GetType() == OctreeType::STRICT)
+    {
+        std::sort(results.begin() + first, results.end());
+        results.erase(std::unique(results.begin() + first, results.end()), results.end());
+    }
+
+    return static_cast<int>(results.size() - first);
+}
+
+int ModuleScene::Nearest(const glm::vec3& point, int k, std::vector<GameObject*>& results, float maxDistance)
+{
+    UpdateOctree();
+
+    size_t first = results.size();
+    octree->CollectNearest(results, point, k, maxDistance);
+
+    return static_cast<int>(results.size() - first);
+}
+
+GameObject* ModuleScene::Raycast(const Ray& ray, float& outDistance, const QueryFilter& filter)
+{
+    UpdateOctree();
+
+    return octree->RayPick(ray, outDistance, filter);
+}
+
 bool ModuleScene::Update()
 {
     // Update all GameObjects
@@ -144,12 +340,15 @@ bool ModuleScene::Update()
         root->Update();
     }
 
-    // Full rebuild only if explicitly requested
+    UpdateEmitters(emitterSteps);
+    emitterSteps.clear();
+
+    // Full rebuild only if explicitly requested, otherwise re-insert moved objects
     if (needsOctreeRebuild)
     {
         LOG_DEBUG("[ModuleScene] Full octree rebuild requested");
-        RebuildOctree();
     }
+    UpdateOctree();
 
     return true;
 }
@@ -167,12 +366,12 @@ bool ModuleScene::FixedUpdate()
 
 bool ModuleScene::PostUpdate()
 {
-    // Full rebuild only if explicitly requested
+    // Full rebuild only if explicitly requested, otherwise re-insert moved objects
     if (needsOctreeRebuild)
     {
         LOG_DEBUG("[ModuleScene] Full octree rebuild requested");
-        RebuildOctree();
     }
+    UpdateOctree();
 
     // Cleanup marked objects
     if (root)
@@ -187,17 +386,21 @@ bool ModuleScene::CleanUp()
 {
     LOG_DEBUG("Cleaning up Scene");
 
-    if (root)
-    {
-        delete root;
-        root = nullptr;
-    }
-
+    // Drop the octree first so destroyed meshes don't have to search it
     if (octree)
     {
         octree->Clear();
         octree.reset();
     }
+    movedObjects.clear();
+
+    staticBatcher.Clear(root);
+
+    if (root)
+    {
+        delete root;
+        root = nullptr;
+    }
 
     return true;
 }
@@ -318,6 +521,10 @@ bool ModuleScene::LoadScene(const std::string& filepath)
     // Force full rebuild after loading scene
     needsOctreeRebuild = true;
 
+    // Scenes loaded while playing are batched right away
+    if (Application::GetInstance().GetPlayState() != Application::PlayState::EDITING)
+        BuildStaticBatches();
+
     LOG_CONSOLE("Scene loaded successfully");
     return true;
 }
@@ -349,6 +556,15 @@ void ModuleScene::ClearScene()
     // Selection
     Application::GetInstance().selectionManager->ClearSelection();
 
+    // Batches reference the objects about to be deleted
+    staticBatcher.Clear(root);
+
+    // Octree
+    if (octree) {
+        octree->Clear();
+    }
+    movedObjects.clear();
+
     // Childrens
     std::vector<GameObject*> children = root->GetChildren();
     for (GameObject* child : children) {
@@ -356,12 +572,23 @@ void ModuleScene::ClearScene()
         delete child;
     }
 
-    // Octree
-    if (octree) {
-        octree->Clear();
+    LOG_CONSOLE("Scene cleared");
+}
+
+void ModuleScene::BuildStaticBatches()
+{
+    if (!staticBatchingEnabled)
+    {
+        staticBatcher.Clear(root);
+        return;
     }
 
-    LOG_CONSOLE("Scene cleared");
+    staticBatcher.Build(root);
+}
+
+void ModuleScene::ClearStaticBatches()
+{
+    staticBatcher.Clear(root);
 }
 
 GameObject* ModuleScene::FindObject(const UID uid) 
@@ -2,8 +2,12 @@
 #include "Module.h"
 #include "Octree.h"
 #include "Globals.h"
+#include "StaticBatcher.h"
+#include "ParticleSystem.h"
 #include <memory>
 #include <vector>
+#include <unordered_set>
+#include <float.h>
 
 class GameObject;
 class FileSystem;
@@ -37,6 +41,23 @@ public:
     void RebuildOctree();
     void MarkOctreeForRebuild() { needsOctreeRebuild = true; }
 
+    OctreeType GetOctreeType() const { return octreeType; }
+    void SetOctreeType(OctreeType type);
+
+    // Builds strict and loose trees over the current scene and logs insert/query/move timings
+    void BenchmarkOctree();
+
+    // Keeps the octree in sync with objects that moved or are being destroyed
+    void NotifyObjectMoved(GameObject* obj);
+    void ForgetObject(GameObject* obj);
+    void UpdateOctree();
+
+    // Spatial queries. Results are appended to the caller's buffer without duplicates
+    int OverlapSphere(const glm::vec3& center, float radius, std::vector<GameObject*>& results);
+    int OverlapBox(const AABB& box, std::vector<GameObject*>& results);
+    int Nearest(const glm::vec3& point, int k, std::vector<GameObject*>& results, float maxDistance = FLT_MAX);
+    GameObject* Raycast(const Ray& ray, float& outDistance, const QueryFilter& filter = nullptr);
+
     // Scene serialization
     bool SaveScene(const std::string& filepath);
     bool LoadScene(const std::string& filepath);
@@ -53,11 +74,29 @@ public:
     std::string SerializeSceneToString();
     bool DeserializeSceneFromString(const std::string& jsonString);
 
+    // Static batching, built when entering play mode and dropped when leaving it
+    void BuildStaticBatches();
+    void ClearStaticBatches();
+    bool IsStaticBatchingEnabled() const { return staticBatchingEnabled; }
+    void SetStaticBatchingEnabled(bool enabled) { staticBatchingEnabled = enabled; }
+    const StaticBatcher& GetStaticBatcher() const { return staticBatcher; }
+
+    // Particle emitters queued by their components, simulated in parallel after the GameObjects update
+    void ScheduleEmitterUpdate(EmitterInstance* emitter, float dt);
+    void CancelEmitterUpdate(EmitterInstance* emitter);
+
 private:
     std::unique_ptr<Octree> octree;
     bool needsOctreeRebuild = false;
+    OctreeType octreeType = OctreeType::LOOSE;
+    std::unordered_set<GameObject*> movedObjects; // queued once however often they move in a frame
     GameObject* root = nullptr;
 
+    StaticBatcher staticBatcher;
+    bool staticBatchingEnabled = true;
+
+    std::vector<EmitterStep> emitterSteps;
+
     Renderer* renderer = nullptr;
     FileSystem* filesystem = nullptr;
 
@@ -37,8 +37,8 @@ void ModuleNavMesh::RecollectGeometry(GameObject* obj, std::vector<float>& verti
         LOG_CONSOLE("Checking mesh for object: %s, HasMesh: %d, Vertices: %d, Indices: %d",
             obj->GetName().c_str(),
             mesh->HasMesh(),
-            (int)mesh->GetMesh().vertices.size(),
-            (int)mesh->GetMesh().indices.size());
+            (int)mesh->GetNumVertices(),
+            (int)mesh->GetNumIndices());
         if (mesh->HasMesh())
             ExtractVertices(mesh, vertices, indices);
     }
@@ -54,13 +54,16 @@ void ModuleNavMesh::ExtractVertices(ComponentMesh* mesh, std::vector<float>& ver
 {
     if (mesh == nullptr || !mesh->HasMesh()) return;
 
-    const Mesh& meshData = mesh->GetMesh();
     GameObject* owner = mesh->owner;
     if (!owner) return;
 
     Transform* trans = (Transform*)owner->GetComponent(ComponentType::TRANSFORM);
     if (!trans) return;
 
+    // Held until the geometry is copied, resource meshes may keep only the GPU copy
+    if (!mesh->AcquireCPUData()) return;
+    const Mesh& meshData = mesh->GetMesh();
+
     glm::mat4 globalMat = trans->GetGlobalMatrix();
 
     // Offset para que los índices apunten correctamente al buffer global
@@ -77,6 +80,8 @@ void ModuleNavMesh::ExtractVertices(ComponentMesh* mesh, std::vector<float>& ver
     // Usar los índices reales del mesh
     for (unsigned int idx : meshData.indices)
         indices.push_back(vertexOffset + (int)idx);
+
+    mesh->ReleaseCPUData();
 }
 void ModuleNavMesh::Bake(GameObject* root)
 {
@@ -0,0 +1,326 @@
+#include "OcclusionCuller.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define OCCLUSION_USE_SSE 1
+#else
+#define OCCLUSION_USE_SSE 0
+#endif
+
+// Vertices closer than this (clip w) are treated as crossing the near plane
+static const float kNearW = 1e-3f;
+
+// Rows handled by one job when rasterizing
+static const int kRowsPerJob = 8;
+
+OcclusionCuller::OcclusionCuller(int width, int height)
+{
+    SetResolution(width, height);
+}
+
+void OcclusionCuller::SetResolution(int newWidth, int newHeight)
+{
+    width = std::max(4, (newWidth + 3) & ~3);
+    height = std::max(1, newHeight);
+    depth.assign(static_cast<size_t>(width) * height, 1.0f);
+}
+
+void OcclusionCuller::BeginFrame(const glm::mat4& viewProj)
+{
+    viewProjection = viewProj;
+
+    occluders.clear();
+    screenVertices.clear();
+    triangles.clear();
+    stats = Stats();
+
+    std::fill(depth.begin(), depth.end(), 1.0f);
+}
+
+void OcclusionCuller::AddOccluder(const glm::mat4& modelMatrix, const float* positions, size_t stride, size_t vertexCount,
+                                  const unsigned int* indices, size_t indexCount)
+{
+    if (!positions || !indices || vertexCount == 0 || indexCount < 3)
+        return;
+
+    Occluder occluder;
+    occluder.modelMatrix = modelMatrix;
+    occluder.positions = positions;
+    occluder.stride = stride;
+    occluder.vertexCount = vertexCount;
+    occluder.indices = indices;
+    occluder.indexCount = indexCount;
+    occluder.firstVertex = screenVertices.size();
+    occluder.firstTriangle = triangles.size();
+
+    occluders.push_back(occluder);
+
+    // Slots are filled in parallel by RasterizeOccluders
+    screenVertices.resize(screenVertices.size() + vertexCount);
+    triangles.resize(triangles.size() + indexCount / 3);
+
+    stats.occluders++;
+    stats.trianglesSubmitted += static_cast<int>(indexCount / 3);
+}
+
+void OcclusionCuller::RasterizeOccluders()
+{
+    if (occluders.empty())
+        return;
+
+    JobSystem& jobs = JobSystem::GetInstance();
+
+    // Vertex transform and triangle setup, one occluder per range
+    jobs.ParallelFor(static_cast<int>(occluders.size()), 1, [this](int begin, int end)
+        {
+            for (int i = begin; i < end; ++i)
+            {
+                TransformOccluder(occluders[i]);
+            }
+        });
+
+    int rasterized = 0;
+    for (const Triangle& triangle : triangles)
+    {
+        if (triangle.valid) rasterized++;
+    }
+    stats.trianglesRasterized = rasterized;
+
+    // Each job owns a band of rows, so no two jobs write the same pixel
+    int bands = (height + kRowsPerJob - 1) / kRowsPerJob;
+    jobs.ParallelFor(bands, 1, [this](int begin, int end)
+        {
+            RasterizeRows(begin * kRowsPerJob, std::min(end * kRowsPerJob, height));
+        });
+}
+
+void OcclusionCuller::TransformOccluder(Occluder& occluder)
+{
+    glm::mat4 mvp = viewProjection * occluder.modelMatrix;
+
+    const unsigned char* base = reinterpret_cast<const unsigned char*>(occluder.positions);
+    ScreenVertex* out = &screenVertices[occluder.firstVertex];
+
+    const float halfWidth = width * 0.5f;
+    const float halfHeight = height * 0.5f;
+
+    for (size_t v = 0; v < occluder.vertexCount; ++v)
+    {
+        const float* p = reinterpret_cast<const float*>(base + v * occluder.stride);
+        glm::vec4 clip = mvp * glm::vec4(p[0], p[1], p[2], 1.0f);
+
+        ScreenVertex& sv = out[v];
+        sv.w = clip.w;
+
+        if (clip.w > kNearW)
+        {
+            float invW = 1.0f / clip.w;
+            sv.x = (clip.x * invW + 1.0f) * halfWidth;
+            sv.y = (clip.y * invW + 1.0f) * halfHeight;
+            sv.z = clip.z * invW;
+        }
+    }
+
+    size_t triangleCount = occluder.indexCount / 3;
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        Triangle& tri = triangles[occluder.firstTriangle + t];
+        tri.valid = false;
+
+        unsigned int i0 = occluder.indices[t * 3 + 0];
+        unsigned int i1 = occluder.indices[t * 3 + 1];
+        unsigned int i2 = occluder.indices[t * 3 + 2];
+        if (i0 >= occluder.vertexCount || i1 >= occluder.vertexCount || i2 >= occluder.vertexCount)
+            continue;
+
+        const ScreenVertex& v0 = out[i0];
+        const ScreenVertex& v1 = out[i1];
+        const ScreenVertex& v2 = out[i2];
+
+        // Skipping triangles that cross the near plane only loses occlusion, never adds it
+        if (v0.w <= kNearW || v1.w <= kNearW || v2.w <= kNearW)
+            continue;
+
+        // Counter-clockwise is front facing, same as GL
+        float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+        if (area <= 0.0f)
+            continue;
+
+        float minX = std::min(std::min(v0.x, v1.x), v2.x);
+        float maxX = std::max(std::max(v0.x, v1.x), v2.x);
+        float minY = std::min(std::min(v0.y, v1.y), v2.y);
+        float maxY = std::max(std::max(v0.y, v1.y), v2.y);
+
+        tri.minX = std::max(0, static_cast<int>(std::floor(minX)));
+        tri.maxX = std::min(width - 1, static_cast<int>(std::ceil(maxX)));
+        tri.minY = std::max(0, static_cast<int>(std::floor(minY)));
+        tri.maxY = std::min(height - 1, static_cast<int>(std::ceil(maxY)));
+        if (tri.minX > tri.maxX || tri.minY > tri.maxY)
+            continue;
+
+        const ScreenVertex* verts[3] = { &v0, &v1, &v2 };
+        for (int e = 0; e < 3; ++e)
+        {
+            // Edge e is opposite to vertex e
+            const ScreenVertex& a = *verts[(e + 1) % 3];
+            const ScreenVertex& b = *verts[(e + 2) % 3];
+            tri.edgeA[e] = -(b.y - a.y);
+            tri.edgeB[e] = (b.x - a.x);
+            tri.edgeC[e] = (b.y - a.y) * a.x - (b.x - a.x) * a.y;
+        }
+
+        float invArea = 1.0f / area;
+        tri.depthA = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) * invArea;
+        tri.depthB = ((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) * invArea;
+        tri.depthC = v0.z - tri.depthA * v0.x - tri.depthB * v0.y;
+
+        tri.valid = true;
+    }
+}
+
+void OcclusionCuller::RasterizeRows(int rowBegin, int rowEnd)
+{
+    for (const Triangle& tri : triangles)
+    {
+        if (!tri.valid || tri.maxY < rowBegin || tri.minY >= rowEnd)
+            continue;
+
+        int y0 = std::max(tri.minY, rowBegin);
+        int y1 = std::min(tri.maxY, rowEnd - 1);
+
+        // Start on a 4-pixel boundary, width is a multiple of 4
+        int x0 = tri.minX & ~3;
+        int x1 = tri.maxX;
+
+        for (int y = y0; y <= y1; ++y)
+        {
+            float* row = &depth[static_cast<size_t>(y) * width];
+            float py = y + 0.5f;
+
+#if OCCLUSION_USE_SSE
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 offsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+
+            __m128 rowE0 = _mm_set1_ps(tri.edgeB[0] * py + tri.edgeC[0]);
+            __m128 rowE1 = _mm_set1_ps(tri.edgeB[1] * py + tri.edgeC[1]);
+            __m128 rowE2 = _mm_set1_ps(tri.edgeB[2] * py + tri.edgeC[2]);
+            __m128 rowZ = _mm_set1_ps(tri.depthB * py + tri.depthC);
+
+            __m128 a0 = _mm_set1_ps(tri.edgeA[0]);
+            __m128 a1 = _mm_set1_ps(tri.edgeA[1]);
+            __m128 a2 = _mm_set1_ps(tri.edgeA[2]);
+            __m128 az = _mm_set1_ps(tri.depthA);
+
+            for (int x = x0; x <= x1; x += 4)
+            {
+                __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), offsets);
+
+                __m128 e0 = _mm_add_ps(_mm_mul_ps(a0, px), rowE0);
+                __m128 e1 = _mm_add_ps(_mm_mul_ps(a1, px), rowE1);
+                __m128 e2 = _mm_add_ps(_mm_mul_ps(a2, px), rowE2);
+
+                __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+                if (_mm_movemask_ps(inside) == 0)
+                    continue;
+
+                __m128 z = _mm_add_ps(_mm_mul_ps(az, px), rowZ);
+                __m128 old = _mm_loadu_ps(row + x);
+                __m128 nearest = _mm_min_ps(old, z);
+
+                // Keep the old value outside the triangle
+                __m128 result = _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, old));
+                _mm_storeu_ps(row + x, result);
+            }
+#else
+            for (int x = x0; x <= x1; ++x)
+            {
+                float px = x + 0.5f;
+                float e0 = tri.edgeA[0] * px + tri.edgeB[0] * py + tri.edgeC[0];
+                float e1 = tri.edgeA[1] * px + tri.edgeB[1] * py + tri.edgeC[1];
+                float e2 = tri.edgeA[2] * px + tri.edgeB[2] * py + tri.edgeC[2];
+                if (e0 < 0.0f || e1 < 0.0f || e2 < 0.0f)
+                    continue;
+
+                float z = tri.depthA * px + tri.depthB * py + tri.depthC;
+                if (z < row[x]) row[x] = z;
+            }
+#endif
+        }
+    }
+}
+
+bool OcclusionCuller::IsOccluded(const AABB& box)
+{
+    stats.occludeesTested++;
+
+    if (occluders.empty())
+        return false;
+
+    const glm::vec3 corners[8] = {
+        glm::vec3(box.min.x, box.min.y, box.min.z),
+        glm::vec3(box.max.x, box.min.y, box.min.z),
+        glm::vec3(box.min.x, box.max.y, box.min.z),
+        glm::vec3(box.max.x, box.max.y, box.min.z),
+        glm::vec3(box.min.x, box.min.y, box.max.z),
+        glm::vec3(box.max.x, box.min.y, box.max.z),
+        glm::vec3(box.min.x, box.max.y, box.max.z),
+        glm::vec3(box.max.x, box.max.y, box.max.z)
+    };
+
+    float minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY;
+    float nearestZ = INFINITY;
+
+    for (const glm::vec3& corner : corners)
+    {
+        glm::vec4 clip = viewProjection * glm::vec4(corner, 1.0f);
+
+        // Box reaches the camera, can't be hidden
+        if (clip.w <= kNearW)
+            return false;
+
+        float invW = 1.0f / clip.w;
+        float sx = (clip.x * invW + 1.0f) * width * 0.5f;
+        float sy = (clip.y * invW + 1.0f) * height * 0.5f;
+
+        minX = std::min(minX, sx);
+        maxX = std::max(maxX, sx);
+        minY = std::min(minY, sy);
+        maxY = std::max(maxY, sy);
+        nearestZ = std::min(nearestZ, clip.z * invW);
+    }
+
+    // Outside the viewport, that's the frustum test's business
+    int x0 = std::max(0, static_cast<int>(std::floor(minX)));
+    int x1 = std::min(width - 1, static_cast<int>(std::ceil(maxX)));
+    int y0 = std::max(0, static_cast<int>(std::floor(minY)));
+    int y1 = std::min(height - 1, static_cast<int>(std::ceil(maxY)));
+    if (x0 > x1 || y0 > y1)
+        return false;
+
+    for (int y = y0; y <= y1; ++y)
+    {
+        const float* row = &depth[static_cast<size_t>(y) * width];
+        int x = x0;
+
+#if OCCLUSION_USE_SSE
+        const __m128 boxZ = _mm_set1_ps(nearestZ);
+        for (; x + 3 <= x1; x += 4)
+        {
+            // Any texel farther than the box front means part of it may show
+            if (_mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(row + x), boxZ)) != 0)
+                return false;
+        }
+#endif
+        for (; x <= x1; ++x)
+        {
+            if (row[x] >= nearestZ)
+                return false;
+        }
+    }
+
+    stats.occludeesCulled++;
+    return true;
+}
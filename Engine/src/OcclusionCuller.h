@@ -0,0 +1,88 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+#include "AABB.h"
+
+// CPU occlusion culling. Occluder triangles are rasterized into a small depth buffer
+// (NDC depth, 1.0 = far) and occludee AABBs are tested against it.
+// Has no GL dependency so it can run and be measured on headless machines.
+class OcclusionCuller
+{
+public:
+    struct Stats
+    {
+        int occluders = 0;
+        int trianglesSubmitted = 0;
+        int trianglesRasterized = 0;
+        int occludeesTested = 0;
+        int occludeesCulled = 0;
+    };
+
+    OcclusionCuller(int width = 256, int height = 128);
+    ~OcclusionCuller() = default;
+
+    // Width is rounded up to a multiple of 4 for the SIMD rows
+    void SetResolution(int width, int height);
+    int GetWidth() const { return width; }
+    int GetHeight() const { return height; }
+
+    void BeginFrame(const glm::mat4& viewProjection);
+
+    // positions points at the first vertex position (3 floats), stride is in bytes
+    void AddOccluder(const glm::mat4& modelMatrix, const float* positions, size_t stride, size_t vertexCount,
+                     const unsigned int* indices, size_t indexCount);
+
+    // Transforms and rasterizes every occluder added since BeginFrame on the job system
+    void RasterizeOccluders();
+
+    // True when the whole box is behind the rasterized occluders
+    bool IsOccluded(const AABB& worldAABB);
+
+    const float* GetDepthBuffer() const { return depth.data(); }
+    const Stats& GetStats() const { return stats; }
+
+private:
+    struct Occluder
+    {
+        glm::mat4 modelMatrix;
+        const float* positions;
+        size_t stride;
+        size_t vertexCount;
+        const unsigned int* indices;
+        size_t indexCount;
+        size_t firstVertex;     // into screenVertices
+        size_t firstTriangle;   // into triangles
+    };
+
+    struct ScreenVertex
+    {
+        float x, y, z, w;
+    };
+
+    // Edge functions and depth plane, evaluated at pixel centres
+    struct Triangle
+    {
+        float edgeA[3], edgeB[3], edgeC[3];
+        float depthA, depthB, depthC;
+        int minX, minY, maxX, maxY;
+        bool valid;
+    };
+
+    void TransformOccluder(Occluder& occluder);
+    void RasterizeRows(int rowBegin, int rowEnd);
+
+private:
+    int width = 0;
+    int height = 0;
+
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+
+    std::vector<float> depth;
+    std::vector<Occluder> occluders;
+    std::vector<ScreenVertex> screenVertices;
+    std::vector<Triangle> triangles;
+
+    Stats stats;
+};
@@ -6,6 +6,8 @@
 #include "Log.h"
 #include <limits>
 #include <functional>
+#include <queue>
+#include <algorithm>
 #include <glad/glad.h>
 #include "ComponentCamera.h"
 #include "Shader.h"
@@ -42,16 +44,27 @@ inline bool RayIntersectsAABB(const glm::vec3& rayOrigin, const glm::vec3& rayDi
     return true;
 }
 
-OctreeNode::OctreeNode(const glm::vec3& min, const glm::vec3& max, int maxObjects, int maxDepth, int currentDepth)
+OctreeNode::OctreeNode(const glm::vec3& min, const glm::vec3& max, int maxObjects, int maxDepth, int currentDepth, float looseness)
     : box(AABB{ min, max })
+    , core(AABB{ min, max })
     , max_objects(maxObjects)
     , max_depth(maxDepth)
     , current_depth(currentDepth)
+    , looseness(looseness)
 {
     for (int i = 0; i < 8; ++i)
     {
         children[i] = nullptr;
     }
+
+    // Grow the query bounds around the same centre
+    if (IsLoose())
+    {
+        glm::vec3 center = (min + max) * 0.5f;
+        glm::vec3 halfSize = (max - min) * 0.5f * looseness;
+        box.min = center - halfSize;
+        box.max = center + halfSize;
+    }
 }
 
 OctreeNode::~OctreeNode()
@@ -98,6 +111,11 @@ bool OctreeNode::GetObjectWorldAABB(GameObject* obj, glm::vec3& outMin, glm::vec
     return true;
 }
 
+bool OctreeNode::IsQueryable(GameObject* obj)
+{
+    return obj != nullptr && obj->IsActive() && !obj->IsMarkedForDeletion();
+}
+
 void OctreeNode::Clear()
 {
     // Clear all children recursively
@@ -179,35 +197,120 @@ bool OctreeNode::Remove(GameObject* obj)
         return false;
 
     // Remove from this node
-    auto it = std::find(objects.begin(), objects.end(), obj);
-    if (it != objects.end())
+    auto newEnd = std::remove(objects.begin(), objects.end(), obj);
+    bool removed = newEnd != objects.end();
+    objects.erase(newEnd, objects.end());
+
+    // Try children too (an object overlapping several children lives in all of them)
+    if (!IsLeaf())
     {
-        objects.erase(it);
+        for (int i = 0; i < 8; ++i)
+        {
+            if (children[i] != nullptr && children[i]->Remove(obj))
+            {
+                removed = true;
+            }
+        }
 
         // After removing, check if we should collapse this node
-        if (!IsLeaf())
+        if (removed)
         {
             CollapseIfPossible();
         }
+    }
 
-        return true;
+    return removed;
+}
+
+bool OctreeNode::ContainsBox(const glm::vec3& worldMin, const glm::vec3& worldMax) const
+{
+    return glm::all(glm::greaterThanEqual(worldMin, box.min)) && glm::all(glm::lessThanEqual(worldMax, box.max));
+}
+
+int OctreeNode::GetChildIndex(const glm::vec3& point) const
+{
+    // Matches the child layout in Subdivide: +1 for high x, +2 for high z, +4 for high y
+    glm::vec3 center = (core.min + core.max) * 0.5f;
+    int index = 0;
+    if (point.x >= center.x) index |= 1;
+    if (point.z >= center.z) index |= 2;
+    if (point.y >= center.y) index |= 4;
+    return index;
+}
+
+OctreeNode* OctreeNode::InsertLoose(GameObject* obj, const glm::vec3& worldMin, const glm::vec3& worldMax,
+                                    std::unordered_map<GameObject*, OctreeNode*>& handles)
+{
+    if (IsLeaf())
+    {
+        if (objects.size() < static_cast<size_t>(max_objects) || current_depth >= max_depth)
+        {
+            objects.push_back(obj);
+            handles[obj] = this;
+            return this;
+        }
+
+        Subdivide();
+        RedistributeLoose(handles);
     }
 
-    // Try children
-    if (!IsLeaf())
+    // Only the child owning the centre can hold it, and only if it fits its loose bounds
+    OctreeNode* child = children[GetChildIndex((worldMin + worldMax) * 0.5f)];
+    if (child->ContainsBox(worldMin, worldMax))
     {
-        for (int i = 0; i < 8; ++i)
+        return child->InsertLoose(obj, worldMin, worldMax, handles);
+    }
+
+    objects.push_back(obj);
+    handles[obj] = this;
+    return this;
+}
+
+void OctreeNode::RedistributeLoose(std::unordered_map<GameObject*, OctreeNode*>& handles)
+{
+    std::vector<GameObject*> objectsToRedistribute;
+    objectsToRedistribute.swap(objects);
+
+    for (GameObject* obj : objectsToRedistribute)
+    {
+        glm::vec3 worldMin, worldMax;
+        if (!GetObjectWorldAABB(obj, worldMin, worldMax))
         {
-            if (children[i] != nullptr && children[i]->Remove(obj))
-            {
-                // After child removed object, check if we should collapse
-                CollapseIfPossible();
-                return true;
-            }
+            objects.push_back(obj);
+            continue;
+        }
+
+        OctreeNode* child = children[GetChildIndex((worldMin + worldMax) * 0.5f)];
+        if (child->ContainsBox(worldMin, worldMax))
+        {
+            child->InsertLoose(obj, worldMin, worldMax, handles);
+        }
+        else
+        {
+            objects.push_back(obj);
         }
     }
+}
 
-    return false;
+void OctreeNode::CollapseEmptyLeaves(OctreeNode* leaf)
+{
+    OctreeNode* node = leaf;
+    while (node->parent != nullptr && node->IsLeaf() && node->objects.empty())
+    {
+        OctreeNode* parent = node->parent;
+        for (int i = 0; i < 8; ++i)
+        {
+            if (!parent->children[i]->IsLeaf() || !parent->children[i]->objects.empty())
+                return;
+        }
+
+        for (int i = 0; i < 8; ++i)
+        {
+            delete parent->children[i];
+            parent->children[i] = nullptr;
+        }
+        node = parent;
+    }
 }
 
 void OctreeNode::CollapseIfPossible()
@@ -276,65 +379,73 @@ void OctreeNode::CollapseIfPossible()
             }
         }
 
-        // Move all objects to this node
+        // Move all objects to this node, once each
+        std::sort(allObjects.begin(), allObjects.end());
+        allObjects.erase(std::unique(allObjects.begin(), allObjects.end()), allObjects.end());
         objects = allObjects;
     }
 }
 
 void OctreeNode::Subdivide()
 {
-    glm::vec3 center = (box.min + box.max) * 0.5f;
+    // Children split the core bounds, loose ones grow their own query bounds
+    glm::vec3 center = (core.min + core.max) * 0.5f;
 
     // Create 8 children
     // Bottom 4 (lower half in Y)
     children[0] = new OctreeNode(
-        glm::vec3(box.min.x, box.min.y, box.min.z),
+        glm::vec3(core.min.x, core.min.y, core.min.z),
         glm::vec3(center.x, center.y, center.z),
-        max_objects, max_depth, current_depth + 1
+        max_objects, max_depth, current_depth + 1, looseness
     );
 
     children[1] = new OctreeNode(
-        glm::vec3(center.x, box.min.y, box.min.z),
-        glm::vec3(box.max.x, center.y, center.z),
-        max_objects, max_depth, current_depth + 1
+        glm::vec3(center.x, core.min.y, core.min.z),
+        glm::vec3(core.max.x, center.y, center.z),
+        max_objects, max_depth, current_depth + 1, looseness
     );
 
     children[2] = new OctreeNode(
-        glm::vec3(box.min.x, box.min.y, center.z),
-        glm::vec3(center.x, center.y, box.max.z),
-        max_objects, max_depth, current_depth + 1
+        glm::vec3(core.min.x, core.min.y, center.z),
+        glm::vec3(center.x, center.y, core.max.z),
+        max_objects, max_depth, current_depth + 1, looseness
     );
 
     children[3] = new OctreeNode(
-        glm::vec3(center.x, box.min.y, center.z),
-        glm::vec3(box.max.x, center.y, box.max.z),
-        max_objects, max_depth, current_depth + 1
+        glm::vec3(center.x, core.min.y, center.z),
+        glm::vec3(core.max.x, center.y, core.max.z),
+        max_objects, max_depth, current_depth + 1, looseness
     );
 
     // Top 4 (upper half in Y)
     children[4] = new OctreeNode(
-        glm::vec3(box.min.x, center.y, box.min.z),
-        glm::vec3(center.x, box.max.y, center.z),
-        max_objects, max_depth, current_depth + 1
+        glm::vec3(core.min.x, center.y, core.min.z),
+        glm::vec3(center.x, core.max.y, center.z),
+        max_objects, max_depth, current_depth + 1, looseness
     );
 
     children[5] = new OctreeNode(
-        glm::vec3(center.x, center.y, box.min.z),
-        glm::vec3(box.max.x, box.max.y, center.z),
-        max_objects, max_depth, current_depth + 1
+        glm::vec3(center.x, center.y, core.min.z),
+        glm::vec3(core.max.x, core.max.y, center.z),
+        max_objects, max_depth, current_depth + 1, looseness
     );
 
     children[6] = new OctreeNode(
-        glm::vec3(box.min.x, center.y, center.z),
-        glm::vec3(center.x, box.max.y, box.max.z),
-        max_objects, max_depth, current_depth + 1
+        glm::vec3(core.min.x, center.y, center.z),
+        glm::vec3(center.x, core.max.y, core.max.z),
+        max_objects, max_depth, current_depth + 1, looseness
     );
 
     children[7] = new OctreeNode(
         glm::vec3(center.x, center.y, center.z),
-        glm::vec3(box.max.x, box.max.y, box.max.z),
-        max_objects, max_depth, current_depth + 1
+        glm::vec3(core.max.x, core.max.y, core.max.z),
+        max_objects, max_depth, current_depth + 1, looseness
     );
+
+    for (int i = 0; i < 8; ++i)
+    {
+        children[i]->parent = this;
+    }
 }
 
 void OctreeNode::RedistributeObjects()
@@ -348,13 +459,12 @@ void OctreeNode::RedistributeObjects()
     {
         bool added = false;
 
-        // Try to add to children
+        // Add to every child it overlaps, same as Insert
         for (int i = 0; i < 8; ++i)
         {
             if (children[i] != nullptr && children[i]->Insert(obj))
             {
                 added = true;
-                break; // Object added to a child
             }
         }
 
@@ -373,10 +483,10 @@ Octree::Octree()
 {
 }
 
-Octree::Octree(const glm::vec3& min, const glm::vec3& max, int maxObjects, int maxDepth)
+Octree::Octree(const glm::vec3& min, const glm::vec3& max, int maxObjects, int maxDepth, OctreeType type, float looseness)
     : root(nullptr)
 {
-    Create(min, max, maxObjects, maxDepth);
+    Create(min, max, maxObjects, maxDepth, type, looseness);
 }
 
 Octree::~Octree()
@@ -384,10 +494,18 @@ Octree::~Octree()
     Clear();
 }
 
-void Octree::Create(const glm::vec3& min, const glm::vec3& max, int maxObjects, int maxDepth)
+void Octree::Create(const glm::vec3& min, const glm::vec3& max, int maxObjects, int maxDepth, OctreeType type, float looseness)
 {
     Clear();
-    root = new OctreeNode(min, max, maxObjects, maxDepth, 0);
+    this->type = type;
+
+    // The root keeps the requested bounds so Insert still rejects objects outside the scene
+    float rootLooseness = (type == OctreeType::LOOSE) ? std::max(looseness, 1.0f + 1e-3f) : 1.0f;
+    root = new OctreeNode(min, max, maxObjects, maxDepth, 0, rootLooseness);
+    if (type == OctreeType::LOOSE)
+    {
+        root->box = root->core;
+    }
 }
 
 void Octree::Clear()
@@ -397,14 +515,26 @@ void Octree::Clear()
         delete root;
         root = nullptr;
     }
+
+    nodeHandles.clear();
 }
 
 bool Octree::Insert(GameObject* obj)
 {
-    if (root == nullptr)
+    if (root == nullptr || obj == nullptr)
+        return false;
+
+    if (type == OctreeType::STRICT)
+        return root->Insert(obj);
+
+    if (nodeHandles.count(obj))
+        return true;
+
+    glm::vec3 worldMin, worldMax;
+    if (!OctreeNode::GetObjectWorldAABB(obj, worldMin, worldMax) || !root->ContainsBox(worldMin, worldMax))
         return false;
 
-    return root->Insert(obj);
+    return root->InsertLoose(obj, worldMin, worldMax, nodeHandles) != nullptr;
 }
 
 bool Octree::Remove(GameObject* obj)
@@ -412,7 +542,27 @@ bool Octree::Remove(GameObject* obj)
     if (root == nullptr)
         return false;
 
-    return root->Remove(obj);
+    if (type == OctreeType::STRICT)
+        return root->Remove(obj);
+
+    auto handle = nodeHandles.find(obj);
+    if (handle == nodeHandles.end())
+        return false;
+
+    OctreeNode* node = handle->second;
+    std::vector<GameObject*>& nodeObjects = node->objects;
+    auto it = std::find(nodeObjects.begin(), nodeObjects.end(), obj);
+    if (it != nodeObjects.end())
+    {
+        *it = nodeObjects.back();
+        nodeObjects.pop_back();
+    }
+
+    nodeHandles.erase(handle);
+
+    // Moving objects would otherwise leave subdivided empty nodes behind for queries to walk
+    OctreeNode::CollapseEmptyLeaves(node);
+    return true;
 }
 
 void Octree::DebugDraw() const
@@ -423,12 +573,109 @@ void Octree::DebugDraw() const
     }
 }
 
-GameObject* Octree::RayPick(const Ray& ray, float& outDistance) const
+GameObject* Octree::RayPick(const Ray& ray, float& outDistance, const QueryFilter& filter) const
 {
     if (root == nullptr)
         return nullptr;
 
-    return root->RayPick(ray, outDistance);
+    return root->RayPick(ray, outDistance, filter);
+}
+
+static float DistanceToAABBSq(const glm::vec3& point, const glm::vec3& aabbMin, const glm::vec3& aabbMax)
+{
+    glm::vec3 delta = glm::clamp(point, aabbMin, aabbMax) - point;
+    return glm::dot(delta, delta);
+}
+
+void Octree::CollectNearest(std::vector<GameObject*>& objects_out, const glm::vec3& point, int k, float maxDistance) const
+{
+    if (root == nullptr || k <= 0)
+        return;
+
+    typedef std::pair<float, const OctreeNode*> NodeEntry;
+    typedef std::pair<float, GameObject*> ObjectEntry;
+
+    // Best-first traversal: nodes are visited in order of distance to the point
+    std::priority_queue<NodeEntry, std::vector<NodeEntry>, std::greater<NodeEntry>> nodeQueue;
+
+    // Max-heap of the k best candidates found so far
+    std::vector<ObjectEntry> best;
+    best.reserve(k + 1);
+
+    float limitSq = (maxDistance < std::numeric_limits<float>::max()) ? maxDistance * maxDistance : std::numeric_limits<float>::max();
+
+    nodeQueue.push({ DistanceToAABBSq(point, root->box.min, root->box.max), root });
+
+    while (!nodeQueue.empty())
+    {
+        NodeEntry entry = nodeQueue.top();
+        nodeQueue.pop();
+
+        // Nothing left can beat the current k-th candidate
+        if (entry.first > limitSq)
+            break;
+
+        const OctreeNode* node = entry.second;
+
+        for (GameObject* obj : node->objects)
+        {
+            glm::vec3 worldMin, worldMax;
+            if (!OctreeNode::IsQueryable(obj) || !OctreeNode::GetObjectWorldAABB(obj, worldMin, worldMax))
+                continue;
+
+            float distSq = DistanceToAABBSq(point, worldMin, worldMax);
+            if (distSq > limitSq)
+                continue;
+
+            // Straddling objects are stored in several nodes of a strict tree
+            bool duplicate = false;
+            if (type == OctreeType::STRICT)
+            {
+                for (const ObjectEntry& candidate : best)
+                {
+                    if (candidate.second == obj) { duplicate = true; break; }
+                }
+            }
+            if (duplicate)
+                continue;
+
+            best.push_back({ distSq, obj });
+            std::push_heap(best.begin(), best.end());
+
+            if (best.size() > static_cast<size_t>(k))
+            {
+                std::pop_heap(best.begin(), best.end());
+                best.pop_back();
+            }
+
+            if (best.size() == static_cast<size_t>(k))
+            {
+                limitSq = std::min(limitSq, best.front().first);
+            }
+        }
+
+        if (node->HasChildren())
+        {
+            for (int i = 0; i < 8; ++i)
+            {
+                const OctreeNode* child = node->children[i];
+                if (child == nullptr)
+                    continue;
+
+                float childDistSq = DistanceToAABBSq(point, child->box.min, child->box.max);
+                if (childDistSq <= limitSq)
+                {
+                    nodeQueue.push({ childDistSq, child });
+                }
+            }
+        }
+    }
+
+    std::sort_heap(best.begin(), best.end());
+    for (const ObjectEntry& candidate : best)
+    {
+        objects_out.push_back(candidate.second);
+    }
 }
 
 int Octree::GetTotalObjectCount() const
@@ -481,7 +728,7 @@ int Octree::GetTotalNodeCount() const
     return count;
 }
 
-GameObject* OctreeNode::RayPick(const Ray& ray, float& outDistance) const
+GameObject* OctreeNode::RayPick(const Ray& ray, float& outDistance, const QueryFilter& filter) const
 {
     // Check if ray intersects this node's AABB
     float distance;
@@ -496,7 +743,8 @@ GameObject* OctreeNode::RayPick(const Ray& ray, float& outDistance) const
     // Check objects in this node
     for (GameObject* obj : objects)
     {
-        if (!obj || !obj->IsActive()) continue;
+        if (!IsQueryable(obj)) continue;
+        if (filter && !filter(obj)) continue;
 
         glm::vec3 worldMin, worldMax;
         if (GetObjectWorldAABB(obj, worldMin, worldMax))
@@ -520,8 +768,20 @@ GameObject* OctreeNode::RayPick(const Ray& ray, float& outDistance) const
         {
             if (children[i] != nullptr)
             {
+                // Skip children that start farther away than the best hit so far
+                const AABB& childBox = children[i]->box;
+                bool originInside = glm::all(glm::greaterThanEqual(ray.origin, childBox.min)) &&
+                                    glm::all(glm::lessThanEqual(ray.origin, childBox.max));
+
+                float childEntry = 0.0f;
+                if (!originInside &&
+                    (!RayIntersectsAABB(ray.origin, ray.direction, childBox.min, childBox.max, childEntry) || childEntry > closestDistance))
+                {
+                    continue;
+                }
+
                 float childDistance;
-                GameObject* childResult = children[i]->RayPick(ray, childDistance);
+                GameObject* childResult = children[i]->RayPick(ray, childDistance, filter);
                 if (childResult != nullptr && childDistance < closestDistance)
                 {
                     closestDistance = childDistance;
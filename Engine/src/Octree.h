@@ -2,6 +2,8 @@
 
 #include <glm/glm.hpp>
 #include <vector>
+#include <functional>
+#include <unordered_map>
 #include "AABB.h"
 
 class GameObject;
@@ -15,10 +17,27 @@ struct Ray
     Ray(const glm::vec3& o, const glm::vec3& d) : origin(o), direction(d) {}
 };
 
+struct Sphere
+{
+    glm::vec3 center;
+    float radius;
+
+    Sphere(const glm::vec3& c, float r) : center(c), radius(r) {}
+};
+
+// Optional predicate used to skip objects in spatial queries
+typedef std::function<bool(GameObject*)> QueryFilter;
+
+enum class OctreeType
+{
+    STRICT, // Objects are stored in every child they overlap
+    LOOSE   // Child bounds are grown by a factor, each object lives in exactly one node
+};
+
 class OctreeNode
 {
 public:
-    OctreeNode(const glm::vec3& min, const glm::vec3& max, int maxObjects = 4, int maxDepth = 5, int currentDepth = 0);
+    OctreeNode(const glm::vec3& min, const glm::vec3& max, int maxObjects = 4, int maxDepth = 5, int currentDepth = 0, float looseness = 1.0f);
     ~OctreeNode();
 
     void Clear();
@@ -29,9 +48,10 @@ public:
     void CollectIntersections(std::vector<GameObject*>& objects, const TYPE& primitive) const;
 
     // New methods needed by Octree
-    GameObject* RayPick(const Ray& ray, float& outDistance) const;
+    GameObject* RayPick(const Ray& ray, float& outDistance, const QueryFilter& filter = nullptr) const;
     int GetObjectCount() const;
     bool HasChildren() const { return children[0] != nullptr; }
+    bool IsLoose() const { return looseness > 1.0f; }
 
     // Debug
     void DebugDraw() const;
@@ -43,32 +63,49 @@ private:
     void CollapseIfPossible(); // Collapse node if it has few objects
     bool IsLeaf() const { return children[0] == nullptr; }
 
+    // Loose mode: places the object in the deepest node whose loose bounds contain it
+    OctreeNode* InsertLoose(GameObject* obj, const glm::vec3& worldMin, const glm::vec3& worldMax,
+                            std::unordered_map<GameObject*, OctreeNode*>& handles);
+    void RedistributeLoose(std::unordered_map<GameObject*, OctreeNode*>& handles);
+    bool ContainsBox(const glm::vec3& worldMin, const glm::vec3& worldMax) const;
+    int GetChildIndex(const glm::vec3& point) const;
+    // Loose mode: deletes the children of each ancestor once all eight are empty leaves
+    static void CollapseEmptyLeaves(OctreeNode* leaf);
+
     // Helper to get world-space AABB of a GameObject
     static bool GetObjectWorldAABB(GameObject* obj, glm::vec3& outMin, glm::vec3& outMax);
 
+    // Objects that are inactive or pending deletion never show up in queries
+    static bool IsQueryable(GameObject* obj);
+
     // Grant Octree access to private members for counting
     friend class Octree;
 
 private:
     
-    AABB box;
+    AABB box;   // Bounds used by queries, grown by 'looseness' in loose mode
+    AABB core;  // Bounds used for subdivision
 
     std::vector<GameObject*> objects;
     OctreeNode* children[8];  // 8 children for octree
+    OctreeNode* parent = nullptr;
 
     int max_objects;    // Max objects before subdividing
     int max_depth;      // Max depth of tree
     int current_depth;  // Current depth level
+    float looseness;    // 1 = strict
 };
 
 class Octree
 {
 public:
     Octree();
-    Octree(const glm::vec3& min, const glm::vec3& max, int maxObjects = 4, int maxDepth = 5);
+    Octree(const glm::vec3& min, const glm::vec3& max, int maxObjects = 4, int maxDepth = 5,
+           OctreeType type = OctreeType::STRICT, float looseness = 2.0f);
     ~Octree();
 
-    void Create(const glm::vec3& min, const glm::vec3& max, int maxObjects = 4, int maxDepth = 5);
+    void Create(const glm::vec3& min, const glm::vec3& max, int maxObjects = 4, int maxDepth = 5,
+                OctreeType type = OctreeType::STRICT, float looseness = 2.0f);
     void Clear();
     bool Insert(GameObject* obj);
     bool Remove(GameObject* obj);
@@ -77,17 +114,26 @@ public:
     void CollectIntersections(std::vector<GameObject*>& objects, const TYPE& primitive) const;
 
     // Ray picking
-    GameObject* RayPick(const Ray& ray, float& outDistance) const;
+    GameObject* RayPick(const Ray& ray, float& outDistance, const QueryFilter& filter = nullptr) const;
+
+    // K nearest objects to a point (by distance to their world AABB), closest first
+    void CollectNearest(std::vector<GameObject*>& objects, const glm::vec3& point, int k, float maxDistance) const;
 
     // Statistics
     int GetTotalObjectCount() const;
     int GetTotalNodeCount() const;
+    OctreeType GetType() const { return type; }
+    const AABB& GetRootAABB() const { static AABB empty{}; return root ? root->core : empty; }
 
     // Debug
     void DebugDraw() const;
 
 private:
     OctreeNode* root;
+    OctreeType type = OctreeType::STRICT;
+
+    // Loose mode: node holding each object, so removal doesn't search the tree
+    std::unordered_map<GameObject*, OctreeNode*> nodeHandles;
 };
 
 
@@ -126,6 +172,82 @@ inline void OctreeNode::CollectIntersections(std::vector<GameObject*>& objects_o
     }
 }
 
+// Specialization for AABB overlap
+template<>
+inline void OctreeNode::CollectIntersections(std::vector<GameObject*>& objects_out, const AABB& query) const
+{
+    if (query.max.x < box.min.x || query.min.x > box.max.x ||
+        query.max.y < box.min.y || query.min.y > box.max.y ||
+        query.max.z < box.min.z || query.min.z > box.max.z)
+    {
+        return;
+    }
+
+    for (GameObject* obj : objects)
+    {
+        glm::vec3 worldMin, worldMax;
+        if (!IsQueryable(obj) || !GetObjectWorldAABB(obj, worldMin, worldMax))
+            continue;
+
+        if (query.max.x < worldMin.x || query.min.x > worldMax.x ||
+            query.max.y < worldMin.y || query.min.y > worldMax.y ||
+            query.max.z < worldMin.z || query.min.z > worldMax.z)
+            continue;
+
+        objects_out.push_back(obj);
+    }
+
+    if (!IsLeaf())
+    {
+        for (int i = 0; i < 8; ++i)
+        {
+            if (children[i] != nullptr)
+            {
+                children[i]->CollectIntersections(objects_out, query);
+            }
+        }
+    }
+}
+
+// Specialization for Sphere overlap
+template<>
+inline void OctreeNode::CollectIntersections(std::vector<GameObject*>& objects_out, const Sphere& sphere) const
+{
+    const float radiusSq = sphere.radius * sphere.radius;
+
+    glm::vec3 closest = glm::clamp(sphere.center, box.min, box.max);
+    glm::vec3 delta = closest - sphere.center;
+    if (glm::dot(delta, delta) > radiusSq)
+    {
+        return;
+    }
+
+    for (GameObject* obj : objects)
+    {
+        glm::vec3 worldMin, worldMax;
+        if (!IsQueryable(obj) || !GetObjectWorldAABB(obj, worldMin, worldMax))
+            continue;
+
+        closest = glm::clamp(sphere.center, worldMin, worldMax);
+        delta = closest - sphere.center;
+        if (glm::dot(delta, delta) > radiusSq)
+            continue;
+
+        objects_out.push_back(obj);
+    }
+
+    if (!IsLeaf())
+    {
+        for (int i = 0; i < 8; ++i)
+        {
+            if (children[i] != nullptr)
+            {
+                children[i]->CollectIntersections(objects_out, sphere);
+            }
+        }
+    }
+}
+
 template<typename TYPE>
 void Octree::CollectIntersections(std::vector<GameObject*>& objects, const TYPE& primitive) const
 {
@@ -0,0 +1,261 @@
+#include "ParticleRenderer.h"
+#include "ParticleSystem.h"
+#include "Shader.h"
+#include "GLState.h"
+#include "Log.h"
+#include <algorithm>
+#include <cfloat>
+#include <cstddef>
+#include <cstring>
+
+bool ParticleRenderer::Init()
+{
+    shader = std::make_unique<Shader>();
+    if (!shader->CreateParticleShader())
+    {
+        LOG_CONSOLE("ERROR: Failed to compile particle shader");
+        return false;
+    }
+
+    // Triangle strip corners, also used as the billboard offsets
+    float corners[] = {
+        -0.5f, -0.5f,
+         0.5f, -0.5f,
+        -0.5f,  0.5f,
+         0.5f,  0.5f,
+    };
+
+    GLsizeiptr size = (GLsizeiptr)sizeof(ParticleInstance) * kRegions * kParticlesPerRegion;
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &quadVBO);
+    glGenBuffers(1, &instanceBuffer);
+
+    GLState::BindVertexArray(vao);
+
+    glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+    instanceData = (ParticleInstance*)glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+
+    // Position and size, color, rotation and frame. Regions are selected with the base instance
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(ParticleInstance), (void*)offsetof(ParticleInstance, position));
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ParticleInstance), (void*)offsetof(ParticleInstance, color));
+    glVertexAttribDivisor(2, 1);
+    glEnableVertexAttribArray(3);
+    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(ParticleInstance), (void*)offsetof(ParticleInstance, rotation));
+    glVertexAttribDivisor(3, 1);
+
+    GLState::BindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    if (!instanceData)
+    {
+        LOG_CONSOLE("ERROR: Could not map the particle buffer");
+        CleanUp();
+        return false;
+    }
+
+    return true;
+}
+
+void ParticleRenderer::CleanUp()
+{
+    for (GLsync& fence : fences)
+    {
+        if (fence) glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    if (instanceBuffer != 0)
+    {
+        if (instanceData)
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+        glDeleteBuffers(1, &instanceBuffer);
+    }
+    if (quadVBO != 0) glDeleteBuffers(1, &quadVBO);
+    if (vao != 0) GLState::DeleteVertexArrays(1, &vao);
+
+    instanceBuffer = 0;
+    instanceData = nullptr;
+    quadVBO = 0;
+    vao = 0;
+
+    if (shader) shader->Delete();
+    shader.reset();
+}
+
+void ParticleRenderer::BeginFrame()
+{
+    if (!instanceData) return;
+
+    region = (region + 1) % kRegions;
+    cursor = 0;
+    packed = 0;
+
+    // The GPU may still be reading this region from a few frames ago
+    GLsync& fence = fences[region];
+    if (fence)
+    {
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+}
+
+void ParticleRenderer::EndFrame()
+{
+    if (!instanceData || cursor == 0) return;
+
+    fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void ParticleRenderer::SortByDepth(const EmitterInstance& emitter, const glm::mat4& modelView)
+{
+    const ParticlePool& pool = emitter.particles;
+    size_t count = (size_t)pool.Count();
+
+    // View space looks down -z, larger depth is further away
+    float minDepth = FLT_MAX;
+    float maxDepth = -FLT_MAX;
+    depths.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        float depth = -(modelView[0][2] * pool.posX[i] + modelView[1][2] * pool.posY[i] + modelView[2][2] * pool.posZ[i] + modelView[3][2]);
+        depths[i] = depth;
+        minDepth = std::min(minDepth, depth);
+        maxDepth = std::max(maxDepth, depth);
+    }
+
+    // Quantized over the emitter's own depth range, inverted so far particles come first
+    float scale = maxDepth > minDepth ? 65535.0f / (maxDepth - minDepth) : 0.0f;
+    keys.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        keys[i] = (uint16_t)(65535 - (uint32_t)((depths[i] - minDepth) * scale));
+    }
+
+    order.resize(count);
+    orderScratch.resize(count);
+    for (size_t i = 0; i < count; ++i) order[i] = (uint32_t)i;
+
+    // Two 8 bit LSD passes, stable so equal keys keep their spawn order
+    for (int shift = 0; shift < 16; shift += 8)
+    {
+        uint32_t offsets[256] = {};
+        for (uint32_t index : order) offsets[(keys[index] >> shift) & 0xFF]++;
+
+        uint32_t sum = 0;
+        for (uint32_t& offset : offsets)
+        {
+            uint32_t digitCount = offset;
+            offset = sum;
+            sum += digitCount;
+        }
+
+        for (uint32_t index : order) orderScratch[offsets[(keys[index] >> shift) & 0xFF]++] = index;
+        order.swap(orderScratch);
+    }
+}
+
+int ParticleRenderer::Pack(const EmitterInstance& emitter, const glm::mat4& modelMatrix, const glm::mat4& viewMatrix,
+    ParticleBatch& batch)
+{
+    const ParticlePool& pool = emitter.particles;
+    if (!instanceData || pool.Empty()) return 0;
+
+    int count = std::min(pool.Count(), kParticlesPerRegion - packed);
+    if (count <= 0) return 0;
+
+    // Additive blending doesn't depend on the order
+    bool sorted = emitter.sortParticles && !emitter.additiveBlending;
+    if (sorted) SortByDepth(emitter, viewMatrix * modelMatrix);
+
+    ParticleBatch::Emitter packedEmitter;
+    packedEmitter.model = modelMatrix;
+    packedEmitter.atlasSize = glm::vec2((float)emitter.textureCols, (float)emitter.textureRows);
+    packedEmitter.texture = emitter.textureID;
+    packedEmitter.additive = emitter.additiveBlending;
+    packedEmitter.first = (int)batch.instances.size();
+    packedEmitter.count = count;
+
+    int totalFrames = emitter.textureRows * emitter.textureCols;
+    batch.instances.resize(batch.instances.size() + count);
+    ParticleInstance* out = batch.instances.data() + packedEmitter.first;
+
+    for (int i = 0; i < count; ++i)
+    {
+        int index = sorted ? (int)order[i] : i;
+
+        int frame = 0;
+        if (totalFrames > 1)
+        {
+            frame = (int)(pool.animationTime[index] * totalFrames);
+            frame = emitter.animLoop ? frame % totalFrames : std::min(frame, totalFrames - 1);
+        }
+
+        ParticleInstance instance;
+        instance.position[0] = pool.posX[index];
+        instance.position[1] = pool.posY[index];
+        instance.position[2] = pool.posZ[index];
+        instance.size = pool.size[index];
+        instance.color = pool.color[index];
+        instance.rotation = glm::radians(pool.rotation[index]);
+        instance.frame = (float)frame;
+        out[i] = instance;
+    }
+    packed += count;
+
+    batch.emitters.push_back(packedEmitter);
+    return count;
+}
+
+void ParticleRenderer::Draw(const ParticleBatch& batch)
+{
+    if (!instanceData || batch.emitters.empty()) return;
+
+    // Packing kept the frame within the region, the copy always fits
+    int first = region * kParticlesPerRegion + cursor;
+    memcpy(instanceData + first, batch.instances.data(), batch.instances.size() * sizeof(ParticleInstance));
+    cursor += (int)batch.instances.size();
+
+    GLState::Enable(GL_BLEND);
+    GLState::DepthMask(GL_FALSE);
+    GLState::Disable(GL_CULL_FACE);
+
+    shader->Use();
+    shader->SetInt("particleTexture", 0);
+    GLState::BindVertexArray(vao);
+
+    for (const ParticleBatch::Emitter& emitter : batch.emitters)
+    {
+        GLState::BlendFunc(GL_SRC_ALPHA, emitter.additive ? GL_ONE : GL_ONE_MINUS_SRC_ALPHA);
+
+        shader->SetMat4("model", emitter.model);
+        shader->SetVec2("atlasSize", emitter.atlasSize);
+        shader->SetBool("hasTexture", emitter.texture != 0);
+        GLState::BindTextureUnit(0, emitter.texture);
+
+        glDrawArraysInstancedBaseInstance(GL_TRIANGLE_STRIP, 0, 4, emitter.count, first + emitter.first);
+    }
+
+    GLState::BindVertexArray(0);
+
+    // Restore state
+    GLState::DepthMask(GL_TRUE);
+    GLState::Disable(GL_BLEND);
+    GLState::Enable(GL_CULL_FACE);
+    GLState::BindTexture(GL_TEXTURE_2D, 0);
+}
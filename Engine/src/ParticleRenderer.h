@@ -0,0 +1,85 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+class Shader;
+struct EmitterInstance;
+
+// Per-particle data read by the particle shader, one entry per instance
+struct ParticleInstance
+{
+    float position[3];
+    float size;
+    uint32_t color;     // RGBA8
+    float rotation;     // radians
+    float frame;        // sprite sheet frame
+};
+
+// Emitters of one camera packed on the CPU, in the order they are drawn
+struct ParticleBatch
+{
+    struct Emitter
+    {
+        glm::mat4 model = glm::mat4(1.0f);
+        glm::vec2 atlasSize = glm::vec2(1.0f);
+        unsigned int texture = 0;
+        bool additive = false;
+        int first = 0;      // into instances
+        int count = 0;
+    };
+
+    std::vector<ParticleInstance> instances;
+    std::vector<Emitter> emitters;
+
+    void Clear() { instances.clear(); emitters.clear(); }
+};
+
+// Draws every emitter with a single instanced draw of a camera facing quad.
+// Particles are streamed into a persistently mapped ring buffer split in regions,
+// one per frame in flight, each guarded by a fence. Packing is kept apart from drawing,
+// so a batch can be packed while the thread holding the context draws the previous one.
+class ParticleRenderer
+{
+public:
+    ParticleRenderer() = default;
+    ~ParticleRenderer() = default;
+
+    bool Init();
+    void CleanUp();
+
+    void BeginFrame();
+    void EndFrame();
+
+    // Sorts the emitter's particles and appends them to the batch, within the room the region
+    // has left for the frame. No GL calls are made here. Returns the number of particles packed
+    int Pack(const EmitterInstance& emitter, const glm::mat4& modelMatrix, const glm::mat4& viewMatrix, ParticleBatch& batch);
+    // Copies the batch into the region and draws its emitters. Matrices block must hold the camera
+    void Draw(const ParticleBatch& batch);
+
+    static const int kRegions = 3;
+    static const int kParticlesPerRegion = 65536;
+
+private:
+    // Back to front order of the particles, radix sorted on their quantized view depth
+    void SortByDepth(const EmitterInstance& emitter, const glm::mat4& modelView);
+
+    std::unique_ptr<Shader> shader;
+
+    unsigned int vao = 0;
+    unsigned int quadVBO = 0;
+    unsigned int instanceBuffer = 0;
+    ParticleInstance* instanceData = nullptr;
+    GLsync fences[kRegions] = {};
+    int region = 0;
+    int cursor = 0;         // next free entry in the current region, advanced by Draw
+    int packed = 0;         // entries of the current region taken by packed batches
+
+    std::vector<uint32_t> order;
+    std::vector<uint32_t> orderScratch;
+    std::vector<uint16_t> keys;
+    std::vector<float> depths;
+};
@@ -1,14 +1,83 @@
 #define GLM_ENABLE_EXPERIMENTAL
 #include "ParticleSystem.h"
-#include <glad/glad.h>
+#include "JobSystem.h"
+#include "Log.h"
 #include <algorithm>
-#include <cstdlib>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <memory>
 #include <glm/gtx/vector_angle.hpp>
 
-// Helper for random numbers
-float RandomFloat(float min, float max) {
-    if (max - min < 0.0001f) return min; // Avoid division by zero
-    return min + static_cast<float>(rand()) / (static_cast<float>(RAND_MAX / (max - min)));
+void ParticlePool::SetCapacity(int maxCount) {
+    maxCount = std::max(maxCount, 0);
+    count = std::min(count, maxCount);
+
+    int newCapacity = (maxCount + 3) & ~3;
+    if (newCapacity == capacity) return;
+
+    std::vector<__m128> newStorage((size_t)kFloatStreams * newCapacity / 4, _mm_setzero_ps());
+    std::vector<__m128i> newColorStorage((size_t)newCapacity / 4, _mm_setzero_si128());
+    int kept = count;
+
+    // Streams are laid out one after another
+    float* oldBase = storage.empty() ? nullptr : reinterpret_cast<float*>(storage.data());
+    float* newBase = reinterpret_cast<float*>(newStorage.data());
+    for (int stream = 0; stream < kFloatStreams && oldBase; ++stream) {
+        std::copy(oldBase + (size_t)stream * capacity, oldBase + (size_t)stream * capacity + kept, newBase + (size_t)stream * newCapacity);
+    }
+    if (color) std::copy(color, color + kept, reinterpret_cast<uint32_t*>(newColorStorage.data()));
+
+    storage.swap(newStorage);
+    colorStorage.swap(newColorStorage);
+    capacity = newCapacity;
+
+    float* streams[kFloatStreams];
+    for (int stream = 0; stream < kFloatStreams; ++stream) streams[stream] = newBase + (size_t)stream * capacity;
+
+    posX = streams[0]; posY = streams[1]; posZ = streams[2];
+    velX = streams[3]; velY = streams[4]; velZ = streams[5];
+    age = streams[6]; invLifetime = streams[7];
+    size = streams[8]; sizeStart = streams[9]; sizeEnd = streams[10];
+    rotation = streams[11]; angularVelocity = streams[12];
+    animationTime = streams[13];
+    for (int c = 0; c < 4; ++c) {
+        colorStart[c] = streams[14 + c];
+        colorEnd[c] = streams[18 + c];
+    }
+    color = reinterpret_cast<uint32_t*>(colorStorage.data());
+}
+
+bool ParticlePool::Add(const Particle& p) {
+    if (count >= capacity) return false;
+
+    int i = count++;
+    posX[i] = p.position.x; posY[i] = p.position.y; posZ[i] = p.position.z;
+    velX[i] = p.velocity.x; velY[i] = p.velocity.y; velZ[i] = p.velocity.z;
+    age[i] = 0.0f;
+    invLifetime[i] = p.maxLifetime > 0.0f ? 1.0f / p.maxLifetime : FLT_MAX;
+    size[i] = p.size; sizeStart[i] = p.sizeStart; sizeEnd[i] = p.sizeEnd;
+    rotation[i] = p.rotation;
+    angularVelocity[i] = p.angularVelocity;
+    animationTime[i] = p.animationTime;
+    for (int c = 0; c < 4; ++c) {
+        colorStart[c][i] = p.colorStart[c];
+        colorEnd[c][i] = p.colorEnd[c];
+    }
+    color[i] = 0;
+    return true;
+}
+
+void ParticlePool::SwapRemove(int index) {
+    int last = --count;
+    if (index == last) return;
+
+    float* base = reinterpret_cast<float*>(storage.data());
+    for (int stream = 0; stream < kFloatStreams; ++stream) {
+        float* data = base + (size_t)stream * capacity;
+        data[index] = data[last];
+    }
+    color[index] = color[last];
 }
 
 void ModuleEmitterSpawn::ResetDefaults() {
@@ -36,30 +105,29 @@ void ModuleEmitterSpawn::ResetDefaults() {
 
 // Creation of the particle
 void ModuleEmitterSpawn::Spawn(EmitterInstance* emitter, Particle* particle) {
-    particle->active = true;
-    float speed = RandomFloat(speedMin, speedMax);
+    float speed = emitter->random.Range(speedMin, speedMax);
     glm::vec3 offset(0.0f);
     glm::vec3 dir(0, 1, 0); // Default direction is up
 
     if (shape == EmitterShape::BOX) {
         // Random point inside a box
         offset = glm::vec3(
-            RandomFloat(-emissionArea.x, emissionArea.x),
-            RandomFloat(-emissionArea.y, emissionArea.y),
-            RandomFloat(-emissionArea.z, emissionArea.z)
+            emitter->random.Range(-emissionArea.x, emissionArea.x),
+            emitter->random.Range(-emissionArea.y, emissionArea.y),
+            emitter->random.Range(-emissionArea.z, emissionArea.z)
         );
         // Direction up with variation
-        dir = glm::vec3(RandomFloat(-0.2f, 0.2f), 1.0f, RandomFloat(-0.2f, 0.2f));
+        dir = glm::vec3(emitter->random.Range(-0.2f, 0.2f), 1.0f, emitter->random.Range(-0.2f, 0.2f));
     }
     else if (shape == EmitterShape::SPHERE) {
         // Sphere: Random point in unit vector
-        glm::vec3 randomDir = glm::vec3(RandomFloat(-1.0f, 1.0f), RandomFloat(-1.0f, 1.0f), RandomFloat(-1.0f, 1.0f));
+        glm::vec3 randomDir = glm::vec3(emitter->random.Range(-1.0f, 1.0f), emitter->random.Range(-1.0f, 1.0f), emitter->random.Range(-1.0f, 1.0f));
         if (glm::length(randomDir) > 0.01f) randomDir = glm::normalize(randomDir);
         else randomDir = glm::vec3(0, 1, 0);
 
         float r = emissionRadius;
         // If not Shell, randomize radius to fill the volume
-        if (!emitFromShell) r *= std::cbrt(RandomFloat(0.0f, 1.0f));
+        if (!emitFromShell) r *= std::cbrt(emitter->random.Range(0.0f, 1.0f));
 
         offset = randomDir * r;
         dir = randomDir; // Explosion outwards
@@ -68,10 +136,10 @@ void ModuleEmitterSpawn::Spawn(EmitterInstance* emitter, Particle* particle) {
         // Cone: Advanced trigonometric logic
         float angleRad = glm::radians(coneAngle);
         float r = coneRadius;
-        if (!emitFromShell) r *= sqrt(RandomFloat(0.0f, 1.0f));
+        if (!emitFromShell) r *= sqrt(emitter->random.Range(0.0f, 1.0f));
 
         // Random polar angle (around Y circle)
-        float theta = RandomFloat(0.0f, glm::two_pi<float>());
+        float theta = emitter->random.Range(0.0f, glm::two_pi<float>());
 
         // Position at the cone base
         float x = r * cos(theta);
@@ -83,7 +151,7 @@ void ModuleEmitterSpawn::Spawn(EmitterInstance* emitter, Particle* particle) {
         if (glm::length(baseDir) < 0.01f) baseDir = glm::vec3(1, 0, 0);
 
         // Rotate UP vector towards the cone edge by a random amount
-        float tiltAngle = RandomFloat(0.0f, angleRad);
+        float tiltAngle = emitter->random.Range(0.0f, angleRad);
 
         // Rotation axis: perpendicular to base direction and UP
         glm::vec3 rotationAxis = glm::cross(glm::vec3(0, 1, 0), baseDir);
@@ -93,9 +161,9 @@ void ModuleEmitterSpawn::Spawn(EmitterInstance* emitter, Particle* particle) {
     }
     else if (shape == EmitterShape::CIRCLE) {
         // Circle: Plane on the ground (XZ)
-        float theta = RandomFloat(0.0f, glm::two_pi<float>());
+        float theta = emitter->random.Range(0.0f, glm::two_pi<float>());
         float r = circleRadius;
-        if (!emitFromShell) r *= sqrt(RandomFloat(0.0f, 1.0f));
+        if (!emitFromShell) r *= sqrt(emitter->random.Range(0.0f, 1.0f));
 
         offset = glm::vec3(r * cos(theta), 0.0f, r * sin(theta));
         dir = glm::vec3(0, 1, 0); // Goes straight up like a column or portal
@@ -113,7 +181,7 @@ void ModuleEmitterSpawn::Spawn(EmitterInstance* emitter, Particle* particle) {
     particle->velocity = glm::normalize(dir) * speed;
 
     // Initialize Properties
-    particle->lifetime = RandomFloat(lifetimeMin, lifetimeMax);
+    particle->lifetime = emitter->random.Range(lifetimeMin, lifetimeMax);
     particle->maxLifetime = particle->lifetime;
 
     // Start and End values
@@ -134,8 +202,8 @@ void ModuleEmitterSpawn::Spawn(EmitterInstance* emitter, Particle* particle) {
     }
 
     // Spin
-    particle->rotation = RandomFloat(0.0f, 360.0f);
-    particle->angularVelocity = RandomFloat(rotationSpeedMin, rotationSpeedMax);
+    particle->rotation = emitter->random.Range(0.0f, 360.0f);
+    particle->angularVelocity = emitter->random.Range(rotationSpeedMin, rotationSpeedMax);
 
     // Animation
     particle->animationTime = 0.0f;
@@ -146,10 +214,23 @@ void ModuleEmitterMovement::ResetDefaults() {
 }
 
 void ModuleEmitterMovement::Update(EmitterInstance* emitter, float dt) {
-    for (auto& p : emitter->particles) {
-        if (!p.active) continue;
-        p.velocity += gravity * dt;
-        p.position += p.velocity * dt;
+    ParticlePool& pool = emitter->particles;
+
+    const __m128 step = _mm_set1_ps(dt);
+    const __m128 gx = _mm_set1_ps(gravity.x * dt);
+    const __m128 gy = _mm_set1_ps(gravity.y * dt);
+    const __m128 gz = _mm_set1_ps(gravity.z * dt);
+
+    for (int i = 0; i < pool.Count(); i += 4) {
+        __m128 vx = _mm_add_ps(_mm_load_ps(pool.velX + i), gx);
+        __m128 vy = _mm_add_ps(_mm_load_ps(pool.velY + i), gy);
+        __m128 vz = _mm_add_ps(_mm_load_ps(pool.velZ + i), gz);
+        _mm_store_ps(pool.velX + i, vx);
+        _mm_store_ps(pool.velY + i, vy);
+        _mm_store_ps(pool.velZ + i, vz);
+        _mm_store_ps(pool.posX + i, _mm_add_ps(_mm_load_ps(pool.posX + i), _mm_mul_ps(vx, step)));
+        _mm_store_ps(pool.posY + i, _mm_add_ps(_mm_load_ps(pool.posY + i), _mm_mul_ps(vy, step)));
+        _mm_store_ps(pool.posZ + i, _mm_add_ps(_mm_load_ps(pool.posZ + i), _mm_mul_ps(vz, step)));
     }
 }
 
@@ -162,23 +243,24 @@ void ModuleEmitterNoise::ResetDefaults() {
 void ModuleEmitterNoise::Update(EmitterInstance* emitter, float dt) {
     if (!active) return;
 
-    for (auto& p : emitter->particles) {
-        if (!p.active) continue;
+    ParticlePool& pool = emitter->particles;
+    float step = strength * dt;
 
+    for (int i = 0; i < pool.Count(); ++i) {
         // Turbulence simulation using trigonometric functions (faster than Perlin)
-        float timeScale = p.maxLifetime - p.lifetime; // Lived time
-        float noiseArg = (p.position.x * 0.5f + p.position.z * 0.5f + timeScale) * frequency;
-
-        glm::vec3 noiseVel;
-        noiseVel.x = sin(noiseArg) * strength;
-        noiseVel.y = cos(noiseArg * 0.7f) * strength * 0.5f; // Less impact on Y
-        noiseVel.z = sin(noiseArg * 1.3f) * strength;
+        float noiseArg = (pool.posX[i] * 0.5f + pool.posZ[i] * 0.5f + pool.age[i]) * frequency;
 
-        p.position += noiseVel * dt;
+        pool.posX[i] += sin(noiseArg) * step;
+        pool.posY[i] += cos(noiseArg * 0.7f) * step * 0.5f; // Less impact on Y
+        pool.posZ[i] += sin(noiseArg * 1.3f) * step;
     }
 }
 
-EmitterInstance::EmitterInstance() { particles.reserve(maxParticles); }
+EmitterInstance::EmitterInstance() {
+    static std::atomic<uint32_t> nextSeed{ 1 };
+    random.Seed(nextSeed.fetch_add(1) * 0x9E3779B9u);
+    particles.SetCapacity(maxParticles);
+}
 
 EmitterInstance::~EmitterInstance() {
     for (auto m : modules) delete m;
@@ -194,7 +276,7 @@ void EmitterInstance::Init() {
 }
 
 void EmitterInstance::Reset() {
-    particles.clear();
+    particles.Clear();
     timeSinceLastEmit = 0.0f;
     systemTime = 0.0f;
 
@@ -212,6 +294,7 @@ void EmitterInstance::ResetValues() {
     prewarm = false;
 
     additiveBlending = false;
+    sortParticles = true;
     textureRows = 1;
     textureCols = 1;
     animationSpeed = 1.0f;
@@ -255,6 +338,9 @@ glm::vec4 EmitterInstance::EvaluateGradient(float t, std::vector<ColorKey>& grad
 void EmitterInstance::Update(float dt) {
     if (!active) return;
 
+    // Follows Max Particles edits
+    particles.SetCapacity(maxParticles);
+
     systemTime += dt;
     if (emissionRateDistance > 0.0f && simulationSpace == SimulationSpace::WORLD) {
         float dist = glm::distance(ownerPosition, lastPosition);
@@ -271,14 +357,10 @@ void EmitterInstance::Update(float dt) {
 
             // Temporary, modify ownerPosition to trick the Spawn function
             for (int i = 0; i < count; i++) {
-                if (particles.size() >= (size_t)maxParticles) break;
-
                 float t = (float)(i + 1) / (float)(count + 1);
                 ownerPosition = glm::mix(startPos, endPos, t);
 
-                Particle p;
-                for (auto mod : modules) mod->Spawn(this, &p);
-                particles.push_back(p);
+                if (!SpawnParticle()) break;
             }
             ownerPosition = endPos; // Restore real position
         }
@@ -308,11 +390,7 @@ void EmitterInstance::Update(float dt) {
         timeSinceLastEmit += dt;
         float emitInterval = 1.0f / emissionRate;
         while (timeSinceLastEmit >= emitInterval) {
-            if (particles.size() < (size_t)maxParticles) {
-                Particle p;
-                for (auto mod : modules) mod->Spawn(this, &p);
-                particles.push_back(p);
-            }
+            SpawnParticle();
             timeSinceLastEmit -= emitInterval;
         }
     }
@@ -321,30 +399,51 @@ void EmitterInstance::Update(float dt) {
     ModuleEmitterSpawn* spawner = nullptr;
     for (auto m : modules) if (m->type == ParticleModuleType::SPAWNER) spawner = (ModuleEmitterSpawn*)m;
 
-    for (auto& p : particles) {
-        if (!p.active) continue;
-
-        p.lifetime -= dt;
-        if (p.lifetime <= 0.0f) {
-            p.active = false;
+    bool gradient = spawner && !spawner->colorGradient.empty();
+
+    const __m128 step = _mm_set1_ps(dt);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 scale255 = _mm_set1_ps(255.0f);
+    const __m128 animScale = _mm_set1_ps(animationSpeed);
+
+    ParticlePool& pool = particles;
+    for (int i = 0; i < pool.Count(); i += 4) {
+        // Age and life ratio, dead particles are removed once the modules ran
+        __m128 age = _mm_add_ps(_mm_load_ps(pool.age + i), step);
+        _mm_store_ps(pool.age + i, age);
+        __m128 lifeRatio = _mm_min_ps(_mm_mul_ps(age, _mm_load_ps(pool.invLifetime + i)), one);
+
+        __m128 sizeStart = _mm_load_ps(pool.sizeStart + i);
+        __m128 sizeEnd = _mm_load_ps(pool.sizeEnd + i);
+        _mm_store_ps(pool.size + i, _mm_add_ps(sizeStart, _mm_mul_ps(_mm_sub_ps(sizeEnd, sizeStart), lifeRatio)));
+
+        __m128 rotation = _mm_load_ps(pool.rotation + i);
+        _mm_store_ps(pool.rotation + i, _mm_add_ps(rotation, _mm_mul_ps(_mm_load_ps(pool.angularVelocity + i), step)));
+
+        _mm_store_ps(pool.animationTime + i, _mm_mul_ps(lifeRatio, animScale));
+
+        if (gradient) {
+            // Gradient keys are searched per particle
+            alignas(16) float ratios[4];
+            _mm_store_ps(ratios, lifeRatio);
+            for (int lane = 0; lane < 4; ++lane) {
+                glm::vec4 c = glm::clamp(EvaluateGradient(ratios[lane], spawner->colorGradient), 0.0f, 1.0f) * 255.0f + 0.5f;
+                pool.color[i + lane] = (uint32_t)c.r | ((uint32_t)c.g << 8) | ((uint32_t)c.b << 16) | ((uint32_t)c.a << 24);
+            }
             continue;
         }
 
-        float lifeRatio = 1.0f - (p.lifetime / p.maxLifetime);
-
-        // Update Color (Gradient or simple interpolation)
-        if (spawner && !spawner->colorGradient.empty()) {
-            p.color = EvaluateGradient(lifeRatio, spawner->colorGradient);
-        }
-        else {
-            p.color = glm::mix(p.colorStart, p.colorEnd, lifeRatio);
+        // Color interpolation packed to RGBA8
+        __m128i packed = _mm_setzero_si128();
+        for (int c = 0; c < 4; ++c) {
+            __m128 start = _mm_load_ps(pool.colorStart[c] + i);
+            __m128 end = _mm_load_ps(pool.colorEnd[c] + i);
+            __m128 value = _mm_add_ps(start, _mm_mul_ps(_mm_sub_ps(end, start), lifeRatio));
+            value = _mm_mul_ps(_mm_min_ps(_mm_max_ps(value, zero), one), scale255);
+            packed = _mm_or_si128(packed, _mm_slli_epi32(_mm_cvtps_epi32(value), 8 * c));
         }
-
-        p.size = glm::mix(p.sizeStart, p.sizeEnd, lifeRatio);
-        p.rotation += p.angularVelocity * dt;
-
-        // Animation time
-        p.animationTime = lifeRatio * animationSpeed;
+        _mm_store_si128(reinterpret_cast<__m128i*>(pool.color + i), packed);
     }
 
     // Update modules (Movement, Noise)
@@ -355,9 +454,12 @@ void EmitterInstance::Update(float dt) {
 }
 
 void EmitterInstance::KillDeadParticles() {
-    // Remove all dead particles
-    particles.erase(std::remove_if(particles.begin(), particles.end(),
-        [](const Particle& p) { return !p.active; }), particles.end());
+    // The last particle takes the place of a dead one, so the index is checked again
+    int i = 0;
+    while (i < particles.Count()) {
+        if (particles.age[i] * particles.invLifetime[i] >= 1.0f) particles.SwapRemove(i);
+        else ++i;
+    }
 }
 
 // Explosion effect
@@ -365,116 +467,83 @@ void EmitterInstance::Burst(int count) {
     if (!active) return;
 
     for (int i = 0; i < count; ++i) {
-        if (particles.size() < (size_t)maxParticles) {
-            Particle p;
-            // Force spawn
-            for (auto mod : modules) mod->Spawn(this, &p);
-            particles.push_back(p);
-        }
+        if (!SpawnParticle()) break;
     }
 }
 
-void EmitterInstance::Draw(glm::vec3 cameraPos) {
-    if (particles.empty()) return;
-
-    // Draw far to near (Z-Sorting for transparency)
-    for (auto& p : particles) p.distanceToCamera = glm::distance(p.position, cameraPos);
-    std::sort(particles.begin(), particles.end(), [](const Particle& a, const Particle& b) {
-        return a.distanceToCamera > b.distanceToCamera;
-        });
+bool EmitterInstance::SpawnParticle() {
+    if (particles.Count() >= maxParticles) return false;
+    particles.SetCapacity(maxParticles);
 
-    // Render state
-    glEnable(GL_BLEND);
-    glDepthMask(GL_FALSE); // Disable for transparent objects
-    glDisable(GL_CULL_FACE);
+    Particle p;
+    for (auto mod : modules) mod->Spawn(this, &p);
+    return particles.Add(p);
+}
 
-    // Blending Mode
-    if (additiveBlending) {
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE); // Glow
-    }
-    else {
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // Standard Alpha
+void EmitterInstance::Step(float dt) {
+    // Prewarm logic, instant simulation at start
+    if (prewarm && systemTime == 0.0f) {
+        float simStep = 0.1f;
+        float simTime = 2.0f; // Simulate 2 seconds instantly
+        for (float t = 0; t < simTime; t += simStep) {
+            Update(simStep);
+        }
     }
 
-    // Texture Setup
-    glActiveTexture(GL_TEXTURE0);
-    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE); // Multiply Texture * Color
+    Update(dt);
+}
 
-    if (textureID != 0) {
-        glEnable(GL_TEXTURE_2D);
-        glBindTexture(GL_TEXTURE_2D, textureID);
-    }
-    else {
-        glDisable(GL_TEXTURE_2D);
-    }
+void UpdateEmitters(const std::vector<EmitterStep>& steps) {
+    JobSystem::GetInstance().ParallelFor((int)steps.size(), 1, [&steps](int begin, int end) {
+        for (int i = begin; i < end; ++i) steps[i].emitter->Step(steps[i].dt);
+    });
+}
 
-    glBegin(GL_QUADS);
-
-    // Animation frame sizes
-    int totalFrames = textureRows * textureCols;
-    float frameWidth = 1.0f / (float)textureCols;
-    float frameHeight = 1.0f / (float)textureRows;
-
-    for (const auto& p : particles) {
-        // BILLBOARDING
-        // Coordinate system aligned with the camera
-        glm::vec3 direction = glm::normalize(cameraPos - p.position);
-        glm::vec3 worldUp = (glm::abs(direction.y) > 0.99f) ? glm::vec3(0, 0, 1) : glm::vec3(0, 1, 0);
-        glm::vec3 baseRight = glm::normalize(glm::cross(worldUp, direction));
-        glm::vec3 baseUp = glm::normalize(glm::cross(direction, baseRight));
-
-        // Apply Particle Rotation
-        float rad = glm::radians(p.rotation);
-        float c = cos(rad);
-        float s = sin(rad);
-
-        // Rotate Vectors
-        glm::vec3 right = baseRight * c + baseUp * s;
-        glm::vec3 up = baseRight * -s + baseUp * c;
-
-        float halfSize = p.size * 0.5f;
-
-        // Vertex Positions
-        glm::vec3 v1 = p.position - (right * halfSize) + (up * halfSize);
-        glm::vec3 v2 = p.position + (right * halfSize) + (up * halfSize);
-        glm::vec3 v3 = p.position + (right * halfSize) - (up * halfSize);
-        glm::vec3 v4 = p.position - (right * halfSize) - (up * halfSize);
-
-        // UV animation
-        int currentFrame = 0;
-        if (totalFrames > 1) {
-            if (animLoop) {
-                currentFrame = (int)(p.animationTime * totalFrames) % totalFrames;
-            }
-            else {
-                currentFrame = (int)(p.animationTime * totalFrames);
-                if (currentFrame >= totalFrames) currentFrame = totalFrames - 1;
-            }
+void EmitterInstance::Benchmark() {
+    auto elapsedMs = [](std::chrono::high_resolution_clock::time_point start) {
+        return std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        };
+
+    // Long lived particles so the count holds over the measured frames
+    auto fill = [](EmitterInstance& emitter, int count) {
+        emitter.Init();
+        emitter.emissionRate = 0.0f;
+        emitter.maxParticles = count;
+        for (auto m : emitter.modules) {
+            if (m->type != ParticleModuleType::SPAWNER) continue;
+            ModuleEmitterSpawn* spawner = (ModuleEmitterSpawn*)m;
+            spawner->lifetimeMin = 1000.0f;
+            spawner->lifetimeMax = 1000.0f;
+        }
+        emitter.Burst(count);
+        };
+
+    const int counts[2] = { 100000, 1000000 };
+    const int frames = 10;
+    const int emitterCount = 16;
+    const float dt = 1.0f / 60.0f;
+
+    for (int count : counts) {
+        EmitterInstance single;
+        fill(single, count);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int frame = 0; frame < frames; ++frame) single.Update(dt);
+        float singleMs = elapsedMs(start) / frames;
+
+        std::vector<std::unique_ptr<EmitterInstance>> emitters;
+        std::vector<EmitterStep> steps;
+        for (int i = 0; i < emitterCount; ++i) {
+            emitters.push_back(std::make_unique<EmitterInstance>());
+            fill(*emitters.back(), count / emitterCount);
+            steps.push_back({ emitters.back().get(), dt });
         }
 
-        int col = currentFrame % textureCols;
-        int row = currentFrame / textureCols;
-
-        // Map UV coordinates based on grid position
-        float uLeft = col * frameWidth;
-        float uRight = uLeft + frameWidth;
-        float vTop = 1.0f - (row * frameHeight);
-        float vBottom = vTop - frameHeight;
-
-        glColor4f(p.color.r, p.color.g, p.color.b, p.color.a);
+        start = std::chrono::high_resolution_clock::now();
+        for (int frame = 0; frame < frames; ++frame) UpdateEmitters(steps);
+        float parallelMs = elapsedMs(start) / frames;
 
-        glTexCoord2f(uLeft, vTop);    glVertex3f(v1.x, v1.y, v1.z);
-        glTexCoord2f(uRight, vTop);   glVertex3f(v2.x, v2.y, v2.z);
-        glTexCoord2f(uRight, vBottom); glVertex3f(v3.x, v3.y, v3.z);
-        glTexCoord2f(uLeft, vBottom);  glVertex3f(v4.x, v4.y, v4.z);
+        LOG_CONSOLE("Particles %d: 1 emitter %.2f ms (%.0f particles/ms) | %d emitters on %d threads %.2f ms (%.0f particles/ms)",
+            count, singleMs, count / singleMs, emitterCount, JobSystem::GetInstance().GetWorkerCount(), parallelMs, count / parallelMs);
     }
-
-    glEnd();
-
-    // Restore state
-    glDepthMask(GL_TRUE);
-    glDisable(GL_BLEND);
-    glEnable(GL_CULL_FACE);
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glDisable(GL_TEXTURE_2D);
 }
\ No newline at end of file
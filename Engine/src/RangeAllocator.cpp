@@ -0,0 +1,98 @@
+#include "RangeAllocator.h"
+
+#include <algorithm>
+
+RangeAllocator::RangeAllocator(uint32_t capacity)
+{
+    Reset(capacity);
+}
+
+void RangeAllocator::Reset(uint32_t newCapacity)
+{
+    freeBlocks.clear();
+    capacity = newCapacity;
+    used = 0;
+
+    if (capacity > 0) freeBlocks.push_back({ 0, capacity });
+}
+
+uint32_t RangeAllocator::Allocate(uint32_t count)
+{
+    if (count == 0) return kInvalidOffset;
+
+    for (size_t i = 0; i < freeBlocks.size(); ++i)
+    {
+        Block& block = freeBlocks[i];
+        if (block.count < count) continue;
+
+        uint32_t offset = block.offset;
+        block.offset += count;
+        block.count -= count;
+        if (block.count == 0) freeBlocks.erase(freeBlocks.begin() + i);
+
+        used += count;
+        return offset;
+    }
+
+    return kInvalidOffset;
+}
+
+void RangeAllocator::Free(uint32_t offset, uint32_t count)
+{
+    if (count == 0 || offset == kInvalidOffset) return;
+
+    InsertFree(offset, count);
+    used -= count;
+}
+
+void RangeAllocator::Grow(uint32_t newCapacity)
+{
+    if (newCapacity <= capacity) return;
+
+    uint32_t oldCapacity = capacity;
+    capacity = newCapacity;
+    InsertFree(oldCapacity, newCapacity - oldCapacity);
+}
+
+uint32_t RangeAllocator::GetLargestFreeBlock() const
+{
+    uint32_t largest = 0;
+    for (const Block& block : freeBlocks)
+    {
+        largest = std::max(largest, block.count);
+    }
+    return largest;
+}
+
+void RangeAllocator::InsertFree(uint32_t offset, uint32_t count)
+{
+    auto next = std::lower_bound(freeBlocks.begin(), freeBlocks.end(), offset,
+        [](const Block& block, uint32_t value) { return block.offset < value; });
+
+    // Merge with the block that ends where this one starts
+    if (next != freeBlocks.begin())
+    {
+        auto previous = next - 1;
+        if (previous->offset + previous->count == offset)
+        {
+            previous->count += count;
+
+            if (next != freeBlocks.end() && previous->offset + previous->count == next->offset)
+            {
+                previous->count += next->count;
+                freeBlocks.erase(next);
+            }
+            return;
+        }
+    }
+
+    // Or with the one that starts where this one ends
+    if (next != freeBlocks.end() && offset + count == next->offset)
+    {
+        next->offset = offset;
+        next->count += count;
+        return;
+    }
+
+    freeBlocks.insert(next, { offset, count });
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// First-fit allocator of element ranges inside [0, capacity). It only does the
+// bookkeeping, so it has no GL dependency and can back any kind of buffer.
+// Freed ranges are merged with their free neighbours.
+class RangeAllocator
+{
+public:
+    static const uint32_t kInvalidOffset = 0xFFFFFFFFu;
+
+    explicit RangeAllocator(uint32_t capacity = 0);
+
+    void Reset(uint32_t capacity);
+
+    // Returns the first element of the range, or kInvalidOffset when no free block fits
+    uint32_t Allocate(uint32_t count);
+    void Free(uint32_t offset, uint32_t count);
+
+    // Adds [capacity, newCapacity) to the free space
+    void Grow(uint32_t newCapacity);
+
+    uint32_t GetCapacity() const { return capacity; }
+    uint32_t GetUsed() const { return used; }
+    uint32_t GetLargestFreeBlock() const;
+    size_t GetFreeBlockCount() const { return freeBlocks.size(); }
+
+private:
+    struct Block
+    {
+        uint32_t offset;
+        uint32_t count;
+    };
+
+    void InsertFree(uint32_t offset, uint32_t count);
+
+    std::vector<Block> freeBlocks; // sorted by offset, never adjacent
+    uint32_t capacity = 0;
+    uint32_t used = 0;
+};
@@ -0,0 +1,190 @@
+#include "RenderCommandBuffer.h"
+
+void RenderCommandBuffer::Clear()
+{
+    commands.clear();
+    matrices.clear();
+    materials.clear();
+    instances.clear();
+    indirectCommands.clear();
+    indirectLODs.clear();
+    timerNames.clear();
+    passes.clear();
+}
+
+void RenderCommandBuffer::Push(CommandType type, uint32_t a, uint32_t b, uint32_t c, uint32_t d, uint32_t e, uint32_t f)
+{
+    Command command;
+    command.type = type;
+    command.args[0] = a;
+    command.args[1] = b;
+    command.args[2] = c;
+    command.args[3] = d;
+    command.args[4] = e;
+    command.args[5] = f;
+    commands.push_back(command);
+}
+
+uint32_t RenderCommandBuffer::AddInstance(const glm::mat4& model, const glm::mat4& normal)
+{
+    MeshInstanceData instance;
+    instance.model = model;
+    instance.normal = normal;
+    instances.push_back(instance);
+    return (uint32_t)instances.size() - 1;
+}
+
+void RenderCommandBuffer::SetStencil(int ref, unsigned int writeMask)
+{
+    Push(CommandType::SET_STENCIL, (uint32_t)ref, writeMask);
+}
+
+void RenderCommandBuffer::BindMaterial(unsigned int texture, const MaterialUniformData* material, uint32_t slot)
+{
+    if (!material)
+    {
+        Push(CommandType::BIND_MATERIAL, texture, (uint32_t)-1);
+        return;
+    }
+
+    Push(CommandType::BIND_MATERIAL, texture, slot);
+    materials.push_back({ slot, *material });
+}
+
+void RenderCommandBuffer::SetDrawID(uint32_t drawID)
+{
+    Push(CommandType::SET_DRAW_ID, drawID);
+}
+
+void RenderCommandBuffer::SetModel(const glm::mat4& model)
+{
+    Push(CommandType::SET_MODEL, (uint32_t)matrices.size());
+    matrices.push_back(model);
+}
+
+void RenderCommandBuffer::SetSkinning(unsigned int globalSSBO, unsigned int offsetSSBO, const glm::mat4& meshInverse,
+    const std::vector<glm::mat4>& bones)
+{
+    // The palette follows the inverse in the matrix list
+    Push(CommandType::SET_SKINNING, globalSSBO, offsetSSBO, (uint32_t)matrices.size(), (uint32_t)bones.size());
+    matrices.push_back(meshInverse);
+    matrices.insert(matrices.end(), bones.begin(), bones.end());
+}
+
+void RenderCommandBuffer::Draw(unsigned int vao, uint32_t indexCount, uint32_t firstIndex, bool skinned, int lod)
+{
+    Push(CommandType::DRAW, vao, indexCount, firstIndex, skinned ? 1u : 0u, (uint32_t)lod);
+}
+
+void RenderCommandBuffer::DrawInstanced(unsigned int vao, uint32_t indexCount, uint32_t firstIndex,
+    uint32_t instanceBase, uint32_t instanceCount, int lod)
+{
+    Push(CommandType::DRAW_INSTANCED, vao, indexCount, firstIndex, instanceBase, instanceCount, (uint32_t)lod);
+}
+
+uint32_t RenderCommandBuffer::AddIndirectCommands(const std::vector<DrawElementsIndirectCommand>& indirect,
+    const std::vector<uint8_t>& lods)
+{
+    uint32_t first = (uint32_t)indirectCommands.size();
+    indirectCommands.insert(indirectCommands.end(), indirect.begin(), indirect.end());
+    indirectLODs.insert(indirectLODs.end(), lods.begin(), lods.end());
+    indirectLODs.resize(indirectCommands.size(), 0);
+    return first;
+}
+
+void RenderCommandBuffer::DrawIndirect(uint32_t firstCommand, uint32_t commandCount, uint32_t instanceBase)
+{
+    Push(CommandType::DRAW_INDIRECT, firstCommand, commandCount, instanceBase);
+}
+
+void RenderCommandBuffer::BeginList(uint32_t uniformSet)
+{
+    Push(CommandType::BEGIN_LIST, uniformSet);
+}
+
+void RenderCommandBuffer::EndList()
+{
+    Push(CommandType::END_LIST);
+}
+
+void RenderCommandBuffer::BeginTimer(const char* name)
+{
+    Push(CommandType::BEGIN_TIMER, (uint32_t)timerNames.size());
+    timerNames.push_back(name);
+}
+
+void RenderCommandBuffer::EndTimer()
+{
+    Push(CommandType::END_TIMER);
+}
+
+void RenderCommandBuffer::RunPass(std::function<void()> pass)
+{
+    Push(CommandType::RUN_PASS, (uint32_t)passes.size());
+    passes.push_back(std::move(pass));
+}
+
+void RenderCommandBuffer::Execute(RenderBackend& backend) const
+{
+    uint32_t instanceOffset = 0;
+    if (!instances.empty())
+        instanceOffset = backend.UploadInstances(instances.data(), instances.size());
+
+    if (!indirectCommands.empty())
+    {
+        std::vector<DrawElementsIndirectCommand> uploaded = indirectCommands;
+        for (DrawElementsIndirectCommand& command : uploaded) command.baseInstance += instanceOffset;
+        backend.UploadIndirectCommands(uploaded.data(), indirectLODs.data(), uploaded.size());
+    }
+
+    for (const MaterialSlot& material : materials)
+        backend.UpdateMaterial(material.slot, material.values);
+
+    for (const Command& command : commands)
+    {
+        const uint32_t* args = command.args;
+
+        switch (command.type)
+        {
+        case CommandType::SET_STENCIL:
+            backend.SetStencil((int)args[0], args[1]);
+            break;
+        case CommandType::BIND_MATERIAL:
+            backend.BindMaterial(args[0], (int)args[1]);
+            break;
+        case CommandType::SET_DRAW_ID:
+            backend.SetDrawID(args[0]);
+            break;
+        case CommandType::SET_MODEL:
+            backend.SetModel(matrices[args[0]]);
+            break;
+        case CommandType::SET_SKINNING:
+            backend.SetSkinning(args[0], args[1], matrices[args[2]], args[3] > 0 ? &matrices[args[2] + 1] : nullptr, args[3]);
+            break;
+        case CommandType::DRAW:
+            backend.Draw(args[0], args[1], args[2], args[3] != 0, (int)args[4]);
+            break;
+        case CommandType::DRAW_INSTANCED:
+            backend.DrawInstanced(args[0], args[1], args[2], args[3] + instanceOffset, args[4], (int)args[5]);
+            break;
+        case CommandType::DRAW_INDIRECT:
+            backend.DrawIndirect(args[0], args[1], args[2] + instanceOffset);
+            break;
+        case CommandType::BEGIN_LIST:
+            backend.BeginList(args[0]);
+            break;
+        case CommandType::END_LIST:
+            backend.EndList();
+            break;
+        case CommandType::BEGIN_TIMER:
+            backend.BeginTimer(timerNames[args[0]]);
+            break;
+        case CommandType::END_TIMER:
+            backend.EndTimer();
+            break;
+        case CommandType::RUN_PASS:
+            backend.RunPass(passes[args[0]]);
+            break;
+        }
+    }
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "IndirectCommandBuilder.h"
+#include "Shader.h"
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Receives the commands of a RenderCommandBuffer on replay. The renderer's backend issues them
+// to GL, a backend that records the calls checks a stream without a context
+class RenderBackend
+{
+public:
+    virtual ~RenderBackend() = default;
+
+    // Sent once before the commands. Returns the slot the first instance was copied to, the
+    // replay adds it to every instance base of the buffer
+    virtual uint32_t UploadInstances(const MeshInstanceData* instances, size_t count) = 0;
+    // Base instances are already offset, the LOD of each command is only counted
+    virtual void UploadIndirectCommands(const DrawElementsIndirectCommand* commands, const uint8_t* lods, size_t count) = 0;
+    // Sent before the commands for every material the buffer binds. Slots persist between
+    // replays, the backend only uploads the values of a slot that changed
+    virtual void UpdateMaterial(uint32_t slot, const MaterialUniformData& material) = 0;
+    virtual void SetStencil(int ref, unsigned int writeMask) = 0;
+    // A slot of -1 is the default MaterialData
+    virtual void BindMaterial(unsigned int texture, int slot) = 0;
+    virtual void SetDrawID(uint32_t drawID) = 0;
+    virtual void SetModel(const glm::mat4& model) = 0;
+    // The bone palette goes into globalSSBO before the skinned draw reads it
+    virtual void SetSkinning(unsigned int globalSSBO, unsigned int offsetSSBO, const glm::mat4& meshInverse,
+        const glm::mat4* bones, uint32_t boneCount) = 0;
+    virtual void Draw(unsigned int vao, uint32_t indexCount, uint32_t firstIndex, bool skinned, int lod) = 0;
+    virtual void DrawInstanced(unsigned int vao, uint32_t indexCount, uint32_t firstIndex,
+        uint32_t instanceBase, uint32_t instanceCount, int lod) = 0;
+    virtual void DrawIndirect(uint32_t firstCommand, uint32_t commandCount, uint32_t instanceBase) = 0;
+    // Draws until EndList read the uniforms of the set, draw kind switches are sent again
+    virtual void BeginList(uint32_t uniformSet) = 0;
+    virtual void EndList() = 0;
+    virtual void BeginTimer(const char* name) = 0;
+    virtual void EndTimer() = 0;
+    virtual void RunPass(const std::function<void()>& pass) = 0;
+};
+
+// The frame of a camera flattened to plain values: GL names, index ranges, stencil and texture
+// changes, with matrices, per-instance data, bone palettes and MaterialData values stored next
+// to the commands. Work that isn't a mesh draw goes in as passes holding copies of what they
+// read. Recording reads the scene and replay only talks to the backend, so the buffer can be
+// replayed on another thread while the next one is recorded. No GL calls are made here.
+class RenderCommandBuffer
+{
+public:
+    void Clear();
+
+    // Copied into the buffer, returns the instance base of the copy. Bases are relative to the
+    // buffer until the replay uploads its instances
+    uint32_t AddInstance(const glm::mat4& model, const glm::mat4& normal);
+    uint32_t GetInstanceCount() const { return (uint32_t)instances.size(); }
+
+    void SetStencil(int ref, unsigned int writeMask);
+    // The values are copied and sent with the material's slot, null binds the default MaterialData
+    void BindMaterial(unsigned int texture, const MaterialUniformData* material, uint32_t slot = 0);
+    void SetDrawID(uint32_t drawID);
+    void SetModel(const glm::mat4& model);
+    // Applies to the next skinned Draw, the palette is copied
+    void SetSkinning(unsigned int globalSSBO, unsigned int offsetSSBO, const glm::mat4& meshInverse,
+        const std::vector<glm::mat4>& bones);
+    void Draw(unsigned int vao, uint32_t indexCount, uint32_t firstIndex, bool skinned, int lod);
+    void DrawInstanced(unsigned int vao, uint32_t indexCount, uint32_t firstIndex, uint32_t instanceBase,
+        uint32_t instanceCount, int lod);
+
+    // Appended to the commands uploaded at the start of the replay, one LOD per command.
+    // Returns the index of the first, DrawIndirect ranges index into all of them
+    uint32_t AddIndirectCommands(const std::vector<DrawElementsIndirectCommand>& commands, const std::vector<uint8_t>& lods);
+    void DrawIndirect(uint32_t firstCommand, uint32_t commandCount, uint32_t instanceBase);
+
+    void BeginList(uint32_t uniformSet);
+    void EndList();
+    // Names must outlive the buffer (string literals)
+    void BeginTimer(const char* name);
+    void EndTimer();
+    // Runs in order with the draws on the replaying thread. Captures must be copies, the
+    // recording side has moved on by then
+    void RunPass(std::function<void()> pass);
+
+    void Execute(RenderBackend& backend) const;
+
+    size_t GetCommandCount() const { return commands.size(); }
+    bool IsEmpty() const { return commands.empty(); }
+
+private:
+    enum class CommandType : uint8_t
+    {
+        SET_STENCIL,
+        BIND_MATERIAL,
+        SET_DRAW_ID,
+        SET_MODEL,
+        SET_SKINNING,
+        DRAW,
+        DRAW_INSTANCED,
+        DRAW_INDIRECT,
+        BEGIN_LIST,
+        END_LIST,
+        BEGIN_TIMER,
+        END_TIMER,
+        RUN_PASS,
+    };
+
+    // Arguments depend on the type, matrices, timer names and passes are indices into their lists
+    struct Command
+    {
+        CommandType type;
+        uint32_t args[6];
+    };
+
+    struct MaterialSlot
+    {
+        uint32_t slot;
+        MaterialUniformData values;
+    };
+
+    void Push(CommandType type, uint32_t a = 0, uint32_t b = 0, uint32_t c = 0, uint32_t d = 0, uint32_t e = 0, uint32_t f = 0);
+
+    std::vector<Command> commands;
+    std::vector<glm::mat4> matrices;
+    std::vector<MaterialSlot> materials;
+    std::vector<MeshInstanceData> instances;
+    std::vector<DrawElementsIndirectCommand> indirectCommands;
+    std::vector<uint8_t> indirectLODs;
+    std::vector<const char*> timerNames;
+    std::vector<std::function<void()>> passes;
+};
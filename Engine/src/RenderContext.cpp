@@ -1,6 +1,7 @@
 #include "RenderContext.h"
 #include "RenderContext.h"
 #include "Application.h"
+#include "GLState.h"
 #include <SDL3/SDL.h>
 #include <glad/glad.h>
 #include <iostream>
@@ -44,12 +45,12 @@ bool RenderContext::Start()
     }
 
     // Enable depth test
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LESS);
+    GLState::Enable(GL_DEPTH_TEST);
+    GLState::DepthFunc(GL_LESS);
 
     // Enable culling
-    glEnable(GL_CULL_FACE);
-    glCullFace(GL_BACK);
+    GLState::Enable(GL_CULL_FACE);
+    GLState::CullFace(GL_BACK);
     glFrontFace(GL_CCW);
 
     return true;
@@ -0,0 +1,131 @@
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace SortKey
+{
+    uint32_t QuantizeDepth(float distance, float farPlane)
+    {
+        const uint32_t maxDepth = (1u << kDepthBits) - 1;
+
+        if (!(distance > 0.0f) || farPlane <= 0.0f) return 0;
+        if (distance >= farPlane) return maxDepth;
+
+        return static_cast<uint32_t>(distance / farPlane * static_cast<float>(maxDepth));
+    }
+
+    uint32_t HashMaterial(uint64_t id)
+    {
+        if (id == 0) return 0;
+
+        // Fibonacci hashing, 0 stays reserved for "no texture"
+        uint64_t hash = id * 11400714819323198485ull;
+        uint32_t folded = static_cast<uint32_t>(hash >> (64 - kMaterialBits));
+        return folded == 0 ? 1 : folded;
+    }
+
+    uint64_t MakeOpaque(uint32_t layer, uint32_t shader, uint32_t material, uint32_t mesh, uint32_t depth)
+    {
+        uint64_t key = layer & ((1u << kLayerBits) - 1);
+        key = (key << kShaderBits) | (shader & ((1u << kShaderBits) - 1));
+        key = (key << kMaterialBits) | (material & ((1u << kMaterialBits) - 1));
+        key = (key << kMeshBits) | (mesh & ((1u << kMeshBits) - 1));
+        key = (key << kDepthBits) | (depth & ((1u << kDepthBits) - 1));
+        return key;
+    }
+
+    uint64_t MakeTransparent(uint32_t layer, uint32_t shader, uint32_t material, uint32_t mesh, uint32_t depth)
+    {
+        const uint32_t depthMask = (1u << kDepthBits) - 1;
+
+        uint64_t key = layer & ((1u << kLayerBits) - 1);
+        key = (key << kDepthBits) | (depthMask - (depth & depthMask));
+        key = (key << kShaderBits) | (shader & ((1u << kShaderBits) - 1));
+        key = (key << kMaterialBits) | (material & ((1u << kMaterialBits) - 1));
+        key = (key << kMeshBits) | (mesh & ((1u << kMeshBits) - 1));
+        return key;
+    }
+
+    uint64_t MakeDepthOnly(uint32_t mesh, uint32_t depth)
+    {
+        depth &= (1u << kDepthBits) - 1;
+
+        uint64_t key = depth >> (kDepthBits - kDepthBandBits);
+        key = (key << kMeshBits) | (mesh & ((1u << kMeshBits) - 1));
+        key = (key << kDepthBits) | depth;
+        return key;
+    }
+}
+
+void RenderQueue::Sort()
+{
+    RadixSort(packets, scratch);
+}
+
+void RenderQueue::Merge(const std::vector<DrawPacket>& sortedRun)
+{
+    if (sortedRun.empty()) return;
+
+    scratch.resize(packets.size() + sortedRun.size());
+    std::merge(sortedRun.begin(), sortedRun.end(), packets.begin(), packets.end(), scratch.begin(),
+        [](const DrawPacket& a, const DrawPacket& b) { return a.key < b.key; });
+    packets.swap(scratch);
+}
+
+void RenderQueue::RadixSort(std::vector<DrawPacket>& packets, std::vector<DrawPacket>& scratch)
+{
+    const size_t count = packets.size();
+    if (count < 2) return;
+
+    // All eight histograms in a single read of the keys
+    uint32_t histograms[8][256];
+    memset(histograms, 0, sizeof(histograms));
+
+    for (const DrawPacket& packet : packets)
+    {
+        uint64_t key = packet.key;
+        for (int digit = 0; digit < 8; ++digit)
+        {
+            histograms[digit][(key >> (digit * 8)) & 0xFF]++;
+        }
+    }
+
+    scratch.resize(count);
+    DrawPacket* source = packets.data();
+    DrawPacket* destination = scratch.data();
+
+    for (int digit = 0; digit < 8; ++digit)
+    {
+        uint32_t* histogram = histograms[digit];
+
+        // Every key has the same byte here, this pass would not move anything
+        uint32_t firstByte = (source[0].key >> (digit * 8)) & 0xFF;
+        if (histogram[firstByte] == count) continue;
+
+        uint32_t offset = 0;
+        for (int bucket = 0; bucket < 256; ++bucket)
+        {
+            uint32_t bucketCount = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucketCount;
+        }
+
+        const int shift = digit * 8;
+        for (size_t i = 0; i < count; ++i)
+        {
+            const DrawPacket& packet = source[i];
+            destination[histogram[(packet.key >> shift) & 0xFF]++] = packet;
+        }
+
+        DrawPacket* swap = source;
+        source = destination;
+        destination = swap;
+    }
+
+    // An odd number of passes leaves the result in the scratch buffer
+    if (source != packets.data())
+    {
+        packets.swap(scratch);
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// One draw in a render queue. The index points into the caller's array of draw data,
+// so sorting only moves 16 byte packets around.
+struct DrawPacket
+{
+    uint64_t key;
+    uint32_t index;
+};
+
+// Sort key layout, most significant bits first. Equal state fields end up next to
+// each other, so walking the sorted queue changes state as little as possible.
+//
+//   Opaque:      layer(2) | shader(4) | material(14) | mesh(20) | depth(24)
+//   Transparent: layer(2) | inverted depth(24) | shader(4) | material(14) | mesh(20)
+//   Depth only:  depth band(6) | mesh(20) | depth(24)
+namespace SortKey
+{
+    const uint32_t kLayerBits = 2;
+    const uint32_t kShaderBits = 4;
+    const uint32_t kMaterialBits = 14;
+    const uint32_t kMeshBits = 20;
+    const uint32_t kDepthBits = 24;
+    const uint32_t kDepthBandBits = 6;
+
+    // Maps a view distance in [0, farPlane] to an integer depth
+    uint32_t QuantizeDepth(float distance, float farPlane);
+
+    // Folds a 64 bit id (resource UID, GL name) down to the material field
+    uint32_t HashMaterial(uint64_t id);
+
+    // State first, then front to back for early-z
+    uint64_t MakeOpaque(uint32_t layer, uint32_t shader, uint32_t material, uint32_t mesh, uint32_t depth);
+
+    // Back to front, state only breaks ties
+    uint64_t MakeTransparent(uint32_t layer, uint32_t shader, uint32_t material, uint32_t mesh, uint32_t depth);
+
+    // Front to back in coarse bands, copies of a mesh inside a band stay adjacent and instance
+    uint64_t MakeDepthOnly(uint32_t mesh, uint32_t depth);
+}
+
+// Flat list of draw packets sorted by key with an LSD radix sort (8 bit digits).
+// Digits that are equal for every packet are skipped, which is the common case for
+// the high state bits of a small scene.
+class RenderQueue
+{
+public:
+    void Clear() { packets.clear(); }
+    void Reserve(size_t count) { packets.reserve(count); }
+    void Push(uint64_t key, uint32_t index) { packets.push_back({ key, index }); }
+
+    void Sort();
+
+    // Merges a run that is already sorted into the sorted queue, on equal keys the run goes first
+    void Merge(const std::vector<DrawPacket>& sortedRun);
+
+    size_t Size() const { return packets.size(); }
+    bool Empty() const { return packets.empty(); }
+    const std::vector<DrawPacket>& GetPackets() const { return packets; }
+
+    static void RadixSort(std::vector<DrawPacket>& packets, std::vector<DrawPacket>& scratch);
+
+private:
+    std::vector<DrawPacket> packets;
+    std::vector<DrawPacket> scratch; // kept between frames to avoid reallocating
+};
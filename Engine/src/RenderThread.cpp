@@ -0,0 +1,138 @@
+#include "RenderThread.h"
+
+RenderThread::RenderThread(std::function<bool()> acquireContext, std::function<void()> releaseContext)
+    : acquireContext(std::move(acquireContext)), releaseContext(std::move(releaseContext))
+{
+}
+
+RenderThread::~RenderThread()
+{
+    Stop();
+}
+
+bool RenderThread::Start()
+{
+    if (worker.joinable()) return !HasFailed();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = true;
+        failed = false;
+    }
+    worker = std::thread(&RenderThread::WorkerLoop, this);
+
+    // The context is taken and given back once before any frame depends on it
+    Submit([]() {});
+    EndFrame();
+
+    if (HasFailed())
+    {
+        Stop();
+        return false;
+    }
+    return true;
+}
+
+void RenderThread::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!worker.joinable()) return;
+        running = false;
+    }
+    wakeCondition.notify_one();
+    worker.join();
+}
+
+uint64_t RenderThread::Submit(std::function<void()> job)
+{
+    uint64_t ticket = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(std::move(job));
+        ticket = ++submitted;
+    }
+    wakeCondition.notify_one();
+    return ticket;
+}
+
+void RenderThread::WaitFor(uint64_t ticket)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    doneCondition.wait(lock, [this, ticket]() { return completed >= ticket; });
+}
+
+void RenderThread::EndFrame()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!worker.joinable()) return;
+
+    releaseRequested = true;
+    wakeCondition.notify_one();
+
+    // Jobs go before the release, an answered request means the queue is empty
+    doneCondition.wait(lock, [this]() { return !releaseRequested; });
+}
+
+bool RenderThread::HasFailed() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return failed;
+}
+
+void RenderThread::WorkerLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true)
+    {
+        wakeCondition.wait(lock, [this]() { return !jobs.empty() || releaseRequested || !running; });
+
+        if (!jobs.empty())
+        {
+            std::function<void()> job = std::move(jobs.front());
+            jobs.pop_front();
+            bool acquire = !contextHeld && !failed;
+            bool skip = failed;
+            lock.unlock();
+
+            if (acquire) skip = !acquireContext();
+            if (!skip) job();
+
+            lock.lock();
+            if (acquire)
+            {
+                contextHeld = !skip;
+                failed = skip;
+            }
+            completed++;
+            doneCondition.notify_all();
+            continue;
+        }
+
+        if (releaseRequested)
+        {
+            if (contextHeld)
+            {
+                lock.unlock();
+                releaseContext();
+                lock.lock();
+                contextHeld = false;
+            }
+            releaseRequested = false;
+            doneCondition.notify_all();
+            continue;
+        }
+
+        if (!running) break;
+    }
+
+    // The context must not stay current on a thread that is gone
+    if (contextHeld)
+    {
+        lock.unlock();
+        releaseContext();
+        lock.lock();
+        contextHeld = false;
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <cstdint>
+
+// Runs the replay of recorded frames on a thread of its own while the caller records the next
+// one. Jobs run in the order they were submitted. The worker makes the GL context current with
+// the first job of a frame and releases it in EndFrame, the caller must not use the context in
+// between. The hooks do the make current and release, tests pass hooks that don't touch GL.
+class RenderThread
+{
+public:
+    RenderThread(std::function<bool()> acquireContext, std::function<void()> releaseContext);
+    ~RenderThread();
+
+    RenderThread(const RenderThread&) = delete;
+    RenderThread& operator=(const RenderThread&) = delete;
+
+    // Called with the context released. Runs an empty frame and returns false if the worker
+    // couldn't take the context, the thread is stopped again then
+    bool Start();
+    // Runs what was submitted and joins the worker
+    void Stop();
+    bool IsRunning() const { return worker.joinable(); }
+
+    // Returns a ticket that WaitFor takes. Captures must be copies, as with command buffer passes
+    uint64_t Submit(std::function<void()> job);
+    void WaitFor(uint64_t ticket);
+    // Waits for every job, the context is released when this returns
+    void EndFrame();
+
+    // Set when the context couldn't be made current, the jobs of the frame were dropped
+    bool HasFailed() const;
+
+private:
+    void WorkerLoop();
+
+private:
+    std::function<bool()> acquireContext;
+    std::function<void()> releaseContext;
+
+    std::thread worker;
+
+    mutable std::mutex mutex;
+    std::condition_variable wakeCondition;
+    std::condition_variable doneCondition;
+
+    std::deque<std::function<void()>> jobs;
+    uint64_t submitted = 0;     // tickets keep counting across restarts
+    uint64_t completed = 0;
+    bool releaseRequested = false;
+    bool contextHeld = false;   // by the worker
+    bool failed = false;
+
+    bool running = false;
+};
@@ -12,16 +12,43 @@
 #include "CameraLens.h"
 #include "ModulePhysics.h"
 #include "ComponentPostProcessing.h"
+#include "ComponentLight.h"
+#include "GeometryArena.h"
+#include "VertexFormat.h"
+#include "ShaderCache.h"
+#include "TextureStreamer.h"
+#include "UploadManager.h"
+#include "GLState.h"
+#include "GpuProfiler.h"
 #include <glad/glad.h>
 #include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 #include <stack>
 #include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <fstream>
+#include <sstream>
 
 #include "tracy/Tracy.hpp"
 
+// Room for a few frames of uploads at the default budget
+static const size_t kStagingRingSize = 32 * 1024 * 1024;
+
 Renderer::Renderer()
 {
     LOG_DEBUG("Renderer Constructor");
+    occlusionCuller = std::make_unique<OcclusionCuller>();
+    particleRenderer = std::make_unique<ParticleRenderer>();
+
+    // The window and context are looked up when the worker takes them, after the modules started
+    renderThread = std::make_unique<RenderThread>(
+        []() {
+            Application& app = Application::GetInstance();
+            return SDL_GL_MakeCurrent(app.window->GetWindow(), app.renderContext->GetContext());
+        },
+        []() { SDL_GL_MakeCurrent(Application::GetInstance().window->GetWindow(), nullptr); });
 }
 
 Renderer::~Renderer()
@@ -34,12 +61,18 @@ bool Renderer::Start()
     LOG_DEBUG("=== Initializing Renderer Module ===");
     LOG_CONSOLE("Initializing renderer and shaders...");
 
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_STENCIL_TEST);
-    glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
-    glEnable(GL_CULL_FACE);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GLState::Enable(GL_DEPTH_TEST);
+    GLState::Enable(GL_STENCIL_TEST);
+    GLState::StencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+    GLState::Enable(GL_CULL_FACE);
+    GLState::Enable(GL_BLEND);
+    GLState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    ShaderCache& shaderCache = ShaderCache::GetInstance();
+    shaderCache.Init();
+    TextureStreamer::GetInstance().Init();
+    UploadManager::GetInstance().Init(kStagingRingSize);
+    auto shadersStart = std::chrono::high_resolution_clock::now();
 
     defaultShader = make_unique<Shader>();
     if (!defaultShader->CreateNoTexture())
@@ -132,16 +165,20 @@ bool Renderer::Start()
         LOG_CONSOLE("depth shader compiled successfully");
     }
 
-    pickingShader = make_unique<Shader>();
-    if (!pickingShader->CreatePickingShader())
+    depthPrepassShader = make_unique<Shader>();
+    if (!depthPrepassShader->CreateDepthPrepass())
     {
-        LOG_DEBUG("ERROR: Failed to create picking shader");
-        LOG_CONSOLE("ERROR: Failed to compile picking shader");
+        LOG_DEBUG("ERROR: Failed to create depth pre-pass shader");
+        LOG_CONSOLE("ERROR: Failed to compile depth pre-pass shader");
+        return false;
     }
-    else
+
+    overdrawShader = make_unique<Shader>();
+    if (!overdrawShader->CreateOverdraw())
     {
-        LOG_DEBUG("picking shader created successfully - Program ID: %d", pickingShader->GetProgramID());
-        LOG_CONSOLE("picking shader compiled successfully");
+        LOG_DEBUG("ERROR: Failed to create overdraw shader");
+        LOG_CONSOLE("ERROR: Failed to compile overdraw shader");
+        return false;
     }
 
     // UI overlay shader
@@ -169,14 +206,14 @@ bool Renderer::Start()
     };
     glGenVertexArrays(1, &quadVAO);
     glGenBuffers(1, &quadVBO);
-    glBindVertexArray(quadVAO);
+    GLState::BindVertexArray(quadVAO);
     glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(quadVerts), quadVerts, GL_STATIC_DRAW);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
-    glBindVertexArray(0);
+    GLState::BindVertexArray(0);
 
     glGenBuffers(1, &ssboBones);
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboBones);
@@ -187,20 +224,64 @@ bool Renderer::Start()
     glBindBuffer(GL_UNIFORM_BUFFER, uboMatrices);
     glBufferData(GL_UNIFORM_BUFFER, 2 * sizeof(glm::mat4), NULL, GL_STATIC_DRAW);
     glBindBuffer(GL_UNIFORM_BUFFER, 0);
-    glBindBufferBase(GL_UNIFORM_BUFFER, 0, uboMatrices);
+    glBindBufferBase(GL_UNIFORM_BUFFER, UBO_MATRICES, uboMatrices);
+
+    glGenBuffers(1, &uboFrameData);
+    glBindBuffer(GL_UNIFORM_BUFFER, uboFrameData);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniformData), NULL, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, UBO_FRAME_DATA, uboFrameData);
+
+    // Every cluster is empty until the first camera bins its lights
+    std::vector<LightCluster> emptyClusters(LightClusterer::kClusterCount, LightCluster{ 0, 0 });
+    glGenBuffers(1, &lightGridBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, lightGridBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, emptyClusters.size() * sizeof(LightCluster), emptyClusters.data(), GL_DYNAMIC_DRAW);
+    glGenBuffers(1, &lightBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, lightBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(LightData), nullptr, GL_DYNAMIC_DRAW);
+    glGenBuffers(1, &lightIndexBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, lightIndexBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(uint32_t), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SSBO_LIGHTS, lightBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SSBO_LIGHT_GRID, lightGridBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SSBO_LIGHT_INDICES, lightIndexBuffer);
+
+    MaterialUniformData defaultMaterial = { glm::vec3(1.0f), 1.0f };
+    glGenBuffers(1, &uboDefaultMaterial);
+    glBindBuffer(GL_UNIFORM_BUFFER, uboDefaultMaterial);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(MaterialUniformData), &defaultMaterial, GL_STATIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    GLint uniformAlignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+    sceneMaterialStride = ((int)sizeof(MaterialUniformData) + uniformAlignment - 1) / uniformAlignment * uniformAlignment;
+    glGenBuffers(1, &uboSceneMaterials);
+
+    CreateInstanceBuffer();
+
+    if (!particleRenderer->Init())
+    {
+        LOG_DEBUG("ERROR: Failed to create particle renderer");
+        return false;
+    }
 
     defaultTexture = make_unique<Texture>();
     defaultTexture->CreateCheckerboard();
     LOG_DEBUG("Default checkerboard texture created");
 
-    defaultUniforms.projection = glGetUniformLocation(defaultShader->GetProgramID(), "projection");
-    defaultUniforms.view = glGetUniformLocation(defaultShader->GetProgramID(), "view");
-    defaultUniforms.model = glGetUniformLocation(defaultShader->GetProgramID(), "model");
-    defaultUniforms.texture1 = glGetUniformLocation(defaultShader->GetProgramID(), "texture1");
+    CacheUniforms(*defaultShader, defaultUniforms);
+    CacheUniforms(*depthShader, depthUniforms);
+    CacheUniforms(*depthPrepassShader, prepassUniforms);
+    CacheUniforms(*overdrawShader, overdrawUniforms);
+    CacheUniforms(*outlineShader, outlineUniforms);
+    CacheUniforms(*lineShader, lineUniforms);
 
-    outlineUniforms.projection = glGetUniformLocation(outlineShader->GetProgramID(), "projection");
-    outlineUniforms.view = glGetUniformLocation(outlineShader->GetProgramID(), "view");
-    outlineUniforms.model = glGetUniformLocation(outlineShader->GetProgramID(), "model");
+    // Constant for the whole run, set once instead of per draw
+    defaultShader->Use();
+    glUniform1i(defaultUniforms.texture1, 0);
+    defaultShader->SetInt("hasTexture", 1);
+    GLState::UseProgram(0);
 
     // Initialize Post Processing Shader
     postProcessShader = make_unique<Shader>();
@@ -349,6 +430,14 @@ bool Renderer::Start()
     )";
     postProcessShader->LoadFromSource(ppVertex, ppFragment, nullptr);
 
+    // Includes the UI, particle and post processing shaders, warm when all come from the cache
+    const ShaderCache::Stats& cacheStats = shaderCache.GetStats();
+    LOG_CONSOLE("Engine shaders ready in %.2f ms (%d from binary cache, %d compiled)",
+        std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - shadersStart).count(),
+        cacheStats.hits, cacheStats.compiled);
+
+    PrecompileProjectShaders();
+
     LOG_DEBUG("Renderer initialized successfully");
     LOG_CONSOLE("Renderer ready");
 
@@ -369,91 +458,205 @@ bool Renderer::PreUpdate()
 
 void Renderer::LoadMesh(Mesh& mesh)
 {
-    // Create and configure VAO
-    glGenVertexArrays(1, &mesh.VAO);
-    glBindVertexArray(mesh.VAO);
+    VertexFormat::Upload(mesh);
 
-    // Upload vertex data to GPU
-    glGenBuffers(1, &mesh.VBO);
-    glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
-    glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(Vertex), &mesh.vertices[0], GL_STATIC_DRAW);
-
-    // Configure vertex attributes
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+    LOG_DEBUG("Mesh loaded - VAO: %d, Vertices: %d, Indices: %d", mesh.VAO, mesh.vertices.size(), mesh.indices.size());
+}
 
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+void Renderer::UnloadMesh(Mesh& mesh)
+{
+    VertexFormat::Release(mesh);
+}
 
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoords));
+void Renderer::PrecompileProjectShaders()
+{
+    std::vector<ShaderVariant> variants;
+    for (const auto& pair : Application::GetInstance().resources->GetAllResources())
+    {
+        const Resource* resource = pair.second;
+        if (resource->GetType() != Resource::SHADER) continue;
 
-    glEnableVertexAttribArray(3);
-    glVertexAttribIPointer(3, 4, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, boneIDs));
+        std::ifstream file(resource->GetAssetFile());
+        if (!file.is_open()) continue;
 
-    glEnableVertexAttribArray(4);
-    glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, weights));
+        std::stringstream buffer;
+        buffer << file.rdbuf();
 
-    // Upload index data
-    glGenBuffers(1, &mesh.EBO);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(unsigned int), &mesh.indices[0], GL_STATIC_DRAW);
+        ShaderVariant variant;
+        if (ResourceShader::SplitStages(buffer.str(), variant.vertex, variant.fragment, variant.geometry))
+            variants.push_back(std::move(variant));
+    }
 
-    glBindVertexArray(0);
+    ShaderCache::GetInstance().PrecompileInBackground(std::move(variants));
+}
 
-    LOG_DEBUG("Mesh loaded - VAO: %d, Vertices: %d, Indices: %d", mesh.VAO, mesh.vertices.size(), mesh.indices.size());
+void Renderer::CacheUniforms(const Shader& shader, ShaderUniforms& uniforms)
+{
+    uniforms.projection = shader.GetUniformLocation("projection");
+    uniforms.view = shader.GetUniformLocation("view");
+    uniforms.model = shader.GetUniformLocation("model");
+    uniforms.texture1 = shader.GetUniformLocation("texture1");
+    uniforms.hasBonesLoc = shader.GetUniformLocation("hasBones");
+    uniforms.meshInverseLoc = shader.GetUniformLocation("meshInverse");
+    uniforms.drawID = shader.GetUniformLocation("drawID");
+    uniforms.useInstancing = shader.GetUniformLocation("useInstancing");
+    uniforms.instanceBase = shader.GetUniformLocation("instanceBase");
 }
 
-void Renderer::UnloadMesh(Mesh& mesh)
+void Renderer::CreateInstanceBuffer()
 {
-    if (mesh.VAO != 0)
+    GLsizeiptr size = (GLsizeiptr)sizeof(MeshInstanceData) * kInstanceRegions * kInstancesPerRegion;
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glGenBuffers(1, &instanceBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, instanceBuffer);
+    glBufferStorage(GL_SHADER_STORAGE_BUFFER, size, nullptr, flags);
+    instanceData = (MeshInstanceData*)glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, size, flags);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    if (!instanceData)
     {
-        glDeleteVertexArrays(1, &mesh.VAO);
-        mesh.VAO = 0;
+        LOG_CONSOLE("WARNING: Could not map the instance buffer, instancing disabled");
+        glDeleteBuffers(1, &instanceBuffer);
+        instanceBuffer = 0;
+        return;
     }
 
-    if (mesh.VBO != 0)
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SSBO_INSTANCES, instanceBuffer);
+}
+
+void Renderer::SetMultiDrawIndirect(bool enabled)
+{
+    multiDrawEnabled = enabled;
+    if (!enabled) return;
+
+    // The arena is only allocated the first time multi-draw is turned on
+    GeometryArena& arena = GeometryArena::GetInstance();
+    if (!arena.IsInitialized()) arena.Init(256 * 1024, 1024 * 1024);
+    if (indirectBuffer == 0) glGenBuffers(1, &indirectBuffer);
+}
+
+void Renderer::SetRenderThreadEnabled(bool enabled)
+{
+    renderThreadEnabled = enabled;
+
+    // Between frames the worker holds no context and has no jobs left
+    if (!enabled) renderThread->Stop();
+}
+
+bool Renderer::BeginThreadedReplay()
+{
+    // A single camera would only wait for its own replay
+    if (!renderThreadEnabled || activeCameras.size() < 2) return false;
+
+    Application& app = Application::GetInstance();
+    SDL_Window* window = app.window->GetWindow();
+    SDL_GL_MakeCurrent(window, nullptr);
+
+    if (!renderThread->IsRunning() && !renderThread->Start())
     {
-        glDeleteBuffers(1, &mesh.VBO);
-        mesh.VBO = 0;
+        LOG_CONSOLE("[Renderer] WARNING: The render thread could not take the GL context, cameras replay inline: %s", SDL_GetError());
+        renderThreadEnabled = false;
+        SDL_GL_MakeCurrent(window, app.renderContext->GetContext());
+        return false;
     }
 
-    if (mesh.EBO != 0)
+    return true;
+}
+
+void Renderer::EndThreadedReplay()
+{
+    renderThread->EndFrame();
+
+    Application& app = Application::GetInstance();
+    SDL_GL_MakeCurrent(app.window->GetWindow(), app.renderContext->GetContext());
+
+    if (renderThread->HasFailed())
     {
-        glDeleteBuffers(1, &mesh.EBO);
-        mesh.EBO = 0;
+        LOG_CONSOLE("[Renderer] WARNING: The render thread lost the GL context, cameras replay inline from the next frame: %s", SDL_GetError());
+        renderThreadEnabled = false;
+        renderThread->Stop();
     }
 }
 
-void Renderer::DrawMesh(const ComponentMesh* meshComp)
+void Renderer::BeginInstanceFrame()
 {
-    if (meshComp->GetMesh().VAO == 0) return;
+    if (!instanceData) return;
 
-    GLint currentProgram;
-    glGetIntegerv(GL_CURRENT_PROGRAM, &currentProgram);
+    instanceRegion = (instanceRegion + 1) % kInstanceRegions;
+    instanceCursor = 0;
+    instanceUploadCursor = 0;
 
-    if (meshComp->HasSkinning())
+    // The GPU may still be reading this region from a few frames ago
+    GLsync& fence = instanceFences[instanceRegion];
+    if (fence)
     {
-        ComponentSkinnedMesh* skinnedComp = (ComponentSkinnedMesh*)meshComp;
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SSBO_INSTANCES, instanceBuffer);
+}
+
+void Renderer::EndInstanceFrame()
+{
+    if (!instanceData || instanceCursor == 0) return;
+
+    instanceFences[instanceRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+bool Renderer::CanInstanceTogether(const RenderObject& a, const RenderObject& b)
+{
+    if (a.mesh->HasSkinning() || b.mesh->HasSkinning()) return false;
+    if (a.mesh->GetMesh().VAO != b.mesh->GetMesh().VAO || a.lod != b.lod) return false;
+
+    return SameDrawState(a, b);
+}
+
+bool Renderer::SameDrawState(const RenderObject& a, const RenderObject& b)
+{
+    if (a.mesh->owner->IsSelected() != b.mesh->owner->IsSelected()) return false;
+
+    ComponentMaterial* materialA = a.mesh->GetAttachedMaterial();
+    ComponentMaterial* materialB = b.mesh->GetAttachedMaterial();
+    if (materialA == materialB) return true;
+    if (!materialA || !materialB) return false;
+
+    // Different components with the same texture and parameters still draw identically
+    return materialA->GetTextureUID() == materialB->GetTextureUID() &&
+        materialA->IsUsingCheckerboard() == materialB->IsUsingCheckerboard() &&
+        materialA->GetDiffuseColor() == materialB->GetDiffuseColor() &&
+        materialA->GetOpacity() == materialB->GetOpacity();
+}
 
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, skinnedComp->GetSSBOGlobal());
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, skinnedComp->GetSSBOOffset());
+void Renderer::DrawMesh(const OverlayMesh& mesh, const ShaderUniforms& uniforms)
+{
+    if (mesh.vao == 0) return;
+
+    replayStats.drawCalls++;
+    replayStats.lodTriangles[mesh.lod] += (int)mesh.indexCount / 3;
+
+    if (mesh.skinned)
+    {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, mesh.ssboGlobal);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, mesh.ssboOffset);
 
-        glUniform1i(glGetUniformLocation(currentProgram, "hasBones"), true);
+        glUniform1i(uniforms.hasBonesLoc, true);
 
-        glUniformMatrix4fv(glGetUniformLocation(currentProgram, "meshInverse"), 1, GL_FALSE,
-            glm::value_ptr(skinnedComp->GetMeshInverse()));
+        glUniformMatrix4fv(uniforms.meshInverseLoc, 1, GL_FALSE,
+            glm::value_ptr(mesh.meshInverse));
     }
     else
     {
-        glUniform1i(glGetUniformLocation(currentProgram, "hasBones"), false);
+        glUniform1i(uniforms.hasBonesLoc, false);
     }
 
-    glBindVertexArray(meshComp->GetMesh().VAO);
-    glDrawElements(GL_TRIANGLES, (GLsizei)meshComp->GetNumIndices(), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
+    GLState::BindVertexArray(mesh.vao);
+    glDrawElements(GL_TRIANGLES, (GLsizei)mesh.indexCount, GL_UNSIGNED_INT, (const void*)(mesh.firstIndex * sizeof(unsigned int)));
+    GLState::BindVertexArray(0);
 
-    if (meshComp->HasSkinning())
+    if (mesh.skinned)
     {
         glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
         glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0);
@@ -462,6 +665,12 @@ void Renderer::DrawMesh(const ComponentMesh* meshComp)
 
 void Renderer::AddMesh(ComponentMesh* mesh) {
     meshes.push_back(mesh);
+
+    RenderCacheEntry entry;
+    entry.mesh = mesh;
+    renderCacheIndex[mesh] = renderCache.size();
+    renderCache.push_back(entry);
+    dirtyMeshes.push_back(mesh);
 }
 
 void Renderer::RemoveMesh(ComponentMesh* mesh) {
@@ -470,6 +679,279 @@ void Renderer::RemoveMesh(ComponentMesh* mesh) {
         *it = meshes.back();
         meshes.pop_back();
     }
+
+    auto cached = renderCacheIndex.find(mesh);
+    if (cached != renderCacheIndex.end()) {
+        size_t index = cached->second;
+        renderCacheIndex.erase(cached);
+
+        if (index != renderCache.size() - 1) {
+            renderCache[index] = renderCache.back();
+            renderCacheIndex[renderCache[index].mesh] = index;
+        }
+        renderCache.pop_back();
+
+        // Entry indices moved, the lists are rebuilt before the next draw
+        staticEntriesDirty = true;
+    }
+
+    auto dirty = std::find(dirtyMeshes.begin(), dirtyMeshes.end(), mesh);
+    if (dirty != dirtyMeshes.end()) {
+        *dirty = dirtyMeshes.back();
+        dirtyMeshes.pop_back();
+    }
+}
+
+void Renderer::MarkMeshDirty(ComponentMesh* mesh) {
+    auto cached = renderCacheIndex.find(mesh);
+    if (cached == renderCacheIndex.end()) return;
+
+    RenderCacheEntry& entry = renderCache[cached->second];
+    if (!entry.dirty) {
+        entry.dirty = true;
+        dirtyMeshes.push_back(mesh);
+    }
+}
+
+// Frames without changes before a mesh moves to the static list
+static const unsigned int kStaticSettleFrames = 60;
+
+void Renderer::UpdateRenderCache()
+{
+    renderFrame++;
+
+    for (ComponentMesh* mesh : dirtyMeshes)
+    {
+        RenderCacheEntry& entry = renderCache[renderCacheIndex[mesh]];
+
+        entry.valid = mesh->owner && mesh->owner->transform && mesh->GetMesh().IsValid();
+        if (entry.valid) {
+            entry.globalModelMatrix = mesh->owner->transform->GetGlobalMatrix();
+            entry.normalMatrix = glm::transpose(glm::inverse(entry.globalModelMatrix));
+            entry.globalAABB = mesh->GetGlobalAABB();
+            entry.center = (entry.globalAABB.min + entry.globalAABB.max) * 0.5f;
+        }
+
+        entry.dirty = false;
+        entry.lastChangedFrame = renderFrame;
+
+        if (!entry.listedDynamic) staticEntriesDirty = true;
+    }
+    dirtyMeshes.clear();
+
+    // Bone palettes are computed once per frame, before any camera records its draws
+    for (RenderCacheEntry& entry : renderCache)
+    {
+        if (entry.valid && entry.mesh->owner->IsActive()) entry.mesh->UpdateSkinningMatrices();
+    }
+
+    // Dynamic meshes that stopped changing become static. Skipped when a rebuild
+    // is already pending, since removals may have left the indices stale
+    for (size_t i = 0; i < dynamicEntries.size() && !staticEntriesDirty; ++i)
+    {
+        const RenderCacheEntry& entry = renderCache[dynamicEntries[i]];
+        if (!entry.mesh->HasSkinning() && renderFrame - entry.lastChangedFrame > kStaticSettleFrames) {
+            staticEntriesDirty = true;
+        }
+    }
+
+    if (staticEntriesDirty) RebuildStaticEntries();
+
+    // Cameras that stopped drawing let go of their packets
+    staticPackets.erase(std::remove_if(staticPackets.begin(), staticPackets.end(),
+        [this](const StaticPackets& cache) { return renderFrame - cache.lastUsedFrame > kStaticSettleFrames; }),
+        staticPackets.end());
+}
+
+void Renderer::UploadArenaMeshes()
+{
+    GeometryArena& arena = GeometryArena::GetInstance();
+    if (!multiDrawEnabled || !instancingEnabled || !instanceData || !arena.IsInitialized()) return;
+
+    // Meshes already in the arena return right away, the ones that don't fit draw on their own
+    const UploadManager& uploadManager = UploadManager::GetInstance();
+    for (RenderCacheEntry& entry : renderCache)
+    {
+        ComponentMesh* mesh = entry.mesh;
+        if (!entry.valid || !mesh->owner->IsActive() || mesh->HasSkinning() || mesh->IsStaticBatched()) continue;
+        if (!uploadManager.IsComplete(mesh->GetMesh().uploadTicket)) continue;
+
+        ComponentMaterial* material = mesh->GetAttachedMaterial();
+        if (material && material->IsActive() && material->GetOpacity() < 1.0f) continue;
+
+        arena.Upload(mesh->GetMesh());
+    }
+}
+
+void Renderer::RebuildStaticEntries()
+{
+    staticEntries.clear();
+    dynamicEntries.clear();
+
+    for (size_t i = 0; i < renderCache.size(); ++i)
+    {
+        RenderCacheEntry& entry = renderCache[i];
+        entry.listedStatic = false;
+        entry.listedDynamic = false;
+
+        if (!entry.valid) continue;
+
+        // Bones move without the transform changing, skinned meshes are never static
+        if (!entry.mesh->HasSkinning() && renderFrame - entry.lastChangedFrame > kStaticSettleFrames) {
+            entry.listedStatic = true;
+            staticEntries.push_back(i);
+        }
+        else {
+            entry.listedDynamic = true;
+            dynamicEntries.push_back(i);
+        }
+    }
+
+    staticEntriesDirty = false;
+    staticListVersion++;
+}
+
+int Renderer::SelectLOD(RenderCacheEntry& entry, const CameraLens* camera, float screenSize)
+{
+    CameraLOD* slot = &entry.lods[0];
+    for (CameraLOD& candidate : entry.lods)
+    {
+        if (candidate.camera == camera)
+        {
+            slot = &candidate;
+            break;
+        }
+        if (candidate.frame < slot->frame) slot = &candidate;
+    }
+
+    // A camera new to this mesh starts from the full detail level
+    int previousLOD = slot->camera == camera ? slot->lod : 0;
+    slot->camera = camera;
+    slot->frame = renderFrame;
+    slot->lod = entry.mesh->SelectLOD(screenSize, previousLOD);
+    return slot->lod;
+}
+
+int Renderer::GetDrawnLOD(const ComponentMesh* mesh, const CameraLens* camera) const
+{
+    auto cached = renderCacheIndex.find(const_cast<ComponentMesh*>(mesh));
+    if (cached == renderCacheIndex.end()) return -1;
+
+    for (const CameraLOD& slot : renderCache[cached->second].lods)
+    {
+        if (slot.camera == camera) return slot.lod;
+    }
+    return -1;
+}
+
+Renderer::StaticDrawState Renderer::GetStaticDrawState(ComponentMesh* mesh, bool depthPrepass) const
+{
+    StaticDrawState state;
+    if (mesh->owner->IsActive()) state.flags |= 1 << 0;
+    if (mesh->IsStaticBatched()) state.flags |= 1 << 1;
+    if (UploadManager::GetInstance().IsComplete(mesh->GetMesh().uploadTicket)) state.flags |= 1 << 2;
+    if (mesh->owner->IsSelected()) state.flags |= 1 << 3;
+
+    ComponentMaterial* material = mesh->GetAttachedMaterial();
+    if (material)
+    {
+        state.texture = material->GetTextureUID();
+        if (material->IsActive()) state.flags |= 1 << 4;
+        if (material->GetOpacity() < 1.0f) state.flags |= 1 << 5;
+        if (material->IsUsingCheckerboard()) state.flags |= 1 << 6;
+        if (depthPrepass && material->HasCutout()) state.flags |= 1 << 7;
+    }
+    return state;
+}
+
+bool Renderer::CanReuseStaticPackets(const StaticPackets& cache, const CameraLens* camera, uint32_t settings, bool depthPrepass) const
+{
+    if (!cache.built || cache.listVersion != staticListVersion || cache.settings != settings) return false;
+    if (cache.view != camera->GetViewMatrix() || cache.projection != camera->GetProjectionMatrix()) return false;
+    if (cache.screenHeight != camera->textureHeight) return false;
+
+    // Occluders decide which static meshes were left out, a moved one changes the depth buffer
+    if (cache.occluders != frameOccluders) return false;
+    for (ComponentMesh* occluder : frameOccluders)
+    {
+        auto cached = renderCacheIndex.find(occluder);
+        if (cached == renderCacheIndex.end() || renderCache[cached->second].lastChangedFrame > cache.builtFrame) return false;
+    }
+
+    for (size_t i = 0; i < staticEntries.size(); ++i)
+    {
+        StaticDrawState state = GetStaticDrawState(renderCache[staticEntries[i]].mesh, depthPrepass);
+        if (state.flags != cache.drawStates[i].flags || state.texture != cache.drawStates[i].texture) return false;
+    }
+    return true;
+}
+
+void Renderer::BenchmarkRenderQueue()
+{
+    struct BenchDraw
+    {
+        float distance;
+        uint32_t material;
+        uint32_t mesh;
+    };
+
+    auto elapsedMs = [](std::chrono::high_resolution_clock::time_point start) {
+        return std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        };
+
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> distanceDist(0.0f, 1000.0f);
+    std::uniform_int_distribution<uint32_t> materialDist(0, 63);
+    std::uniform_int_distribution<uint32_t> meshDist(1, 512);
+
+    const int counts[3] = { 10000, 25000, 50000 };
+    for (int count : counts)
+    {
+        std::vector<BenchDraw> draws(count);
+        for (BenchDraw& draw : draws)
+        {
+            draw = { distanceDist(rng), materialDist(rng), meshDist(rng) };
+        }
+
+        // Material or mesh switches seen while walking the sorted draws
+        auto countStateChanges = [&](uint32_t index, uint32_t& lastMaterial, uint32_t& lastMesh, int& changes) {
+            const BenchDraw& draw = draws[index];
+            if (draw.material != lastMaterial || draw.mesh != lastMesh) changes++;
+            lastMaterial = draw.material;
+            lastMesh = draw.mesh;
+            };
+
+        // Previous path: one node per draw keyed by distance
+        auto start = std::chrono::high_resolution_clock::now();
+        std::multimap<float, uint32_t> map;
+        for (uint32_t i = 0; i < (uint32_t)count; ++i) map.emplace(draws[i].distance, i);
+        float mapSortMs = elapsedMs(start);
+
+        uint32_t lastMaterial = ~0u, lastMesh = ~0u;
+        int mapChanges = 0;
+        start = std::chrono::high_resolution_clock::now();
+        for (auto pair = map.rbegin(); pair != map.rend(); ++pair) countStateChanges(pair->second, lastMaterial, lastMesh, mapChanges);
+        float mapSubmitMs = elapsedMs(start);
+
+        RenderQueue queue;
+        start = std::chrono::high_resolution_clock::now();
+        for (uint32_t i = 0; i < (uint32_t)count; ++i)
+        {
+            const BenchDraw& draw = draws[i];
+            queue.Push(SortKey::MakeOpaque(LAYER_DEFAULT, 0, draw.material, draw.mesh, SortKey::QuantizeDepth(draw.distance, 1000.0f)), i);
+        }
+        queue.Sort();
+        float queueSortMs = elapsedMs(start);
+
+        lastMaterial = ~0u, lastMesh = ~0u;
+        int queueChanges = 0;
+        start = std::chrono::high_resolution_clock::now();
+        for (const DrawPacket& packet : queue.GetPackets()) countStateChanges(packet.index, lastMaterial, lastMesh, queueChanges);
+        float queueSubmitMs = elapsedMs(start);
+
+        LOG_CONSOLE("Render queue %d draws: multimap %.2f ms sort, %.2f ms submit, %d state changes | radix %.2f ms sort, %.2f ms submit, %d state changes",
+            count, mapSortMs, mapSubmitMs, mapChanges, queueSortMs, queueSubmitMs, queueChanges);
+    }
 }
 
 void Renderer::AddParticle(ComponentParticleSystem* particle) {
@@ -522,6 +1004,149 @@ void Renderer::RemoveCanvas(ComponentCanvas* canvas)
     }
 }
 
+void Renderer::AddLight(ComponentLight* light)
+{
+    if (std::find(lights.begin(), lights.end(), light) == lights.end()) lights.push_back(light);
+}
+
+void Renderer::RemoveLight(ComponentLight* light)
+{
+    auto it = std::find(lights.begin(), lights.end(), light);
+    if (it != lights.end())
+    {
+        *it = lights.back();
+        lights.pop_back();
+    }
+}
+
+unsigned int Renderer::AcquireMaterialSlot()
+{
+    if (freeMaterialSlots.empty()) return materialSlotCount++;
+
+    unsigned int slot = freeMaterialSlots.back();
+    freeMaterialSlots.pop_back();
+    return slot;
+}
+
+void Renderer::ReleaseMaterialSlot(unsigned int slot)
+{
+    // The buffer keeps the old values, the next material in the slot differs and uploads its own
+    freeMaterialSlots.push_back(slot);
+}
+
+void Renderer::UpdateLights(CameraLens* camera, int width, int height)
+{
+    auto binStart = std::chrono::high_resolution_clock::now();
+
+    const glm::mat4& view = camera->GetViewMatrix();
+    lightData.clear();
+    lightSpheres.clear();
+
+    for (ComponentLight* light : lights)
+    {
+        if (!light->IsActive() || !light->owner->IsActive() || light->intensity <= 0.0f || light->range <= 0.0f) continue;
+
+        const glm::mat4& global = light->owner->transform->GetGlobalMatrix();
+
+        LightData data = {};
+        data.position = glm::vec3(global[3]);
+        data.range = light->range;
+        data.color = light->color;
+        data.intensity = light->intensity;
+        data.direction = glm::normalize(glm::vec3(global[2]));
+        data.spotCosOuter = -2.0f;
+        data.spotCosInner = -1.0f;
+        if (light->lightType == LightType::SPOT)
+        {
+            // The inner cosine stays above the outer one, smoothstep needs distinct edges
+            float halfAngle = glm::radians(light->spotAngle * 0.5f);
+            data.spotCosOuter = std::cos(halfAngle);
+            data.spotCosInner = std::max(std::cos(halfAngle * (1.0f - light->spotBlend)), data.spotCosOuter + 0.0001f);
+        }
+
+        lightData.push_back(data);
+        lightSpheres.push_back(glm::vec4(glm::vec3(view * glm::vec4(data.position, 1.0f)), data.range));
+    }
+
+    lightClusterer.SetProjection(camera->GetProjectionMatrix(), camera->GetNearPlane(), camera->GetFarPlane());
+    lightClusterer.Build(lightSpheres);
+
+    const std::vector<LightCluster>& clusters = lightClusterer.GetClusters();
+    const std::vector<uint32_t>& indices = lightClusterer.GetLightIndices();
+
+    // The clusterer is binned again by the next camera, the pass keeps its own copies
+    sceneCommands->RunPass([this, data = lightData, clusters, indices]() { UploadLights(data, clusters, indices); });
+
+    clusterScale = glm::vec4((float)LightClusterer::kTilesX / std::max(width, 1), (float)LightClusterer::kTilesY / std::max(height, 1),
+        lightClusterer.GetSliceScale(), lightClusterer.GetSliceBias());
+    clusterDepth = glm::vec2(camera->GetNearPlane(), camera->GetFarPlane());
+
+    frameStats.lights += (int)lightData.size();
+    frameStats.lightIndices += (int)indices.size();
+    frameStats.lightBinTimeMs += std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - binStart).count();
+}
+
+void Renderer::UploadLights(const std::vector<LightData>& data, const std::vector<LightCluster>& clusters,
+    const std::vector<uint32_t>& indices)
+{
+    // Orphaned every camera, the draws of the previous camera still read the old storage
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, lightBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, std::max<size_t>(data.size(), 1) * sizeof(LightData),
+        data.empty() ? nullptr : data.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, lightGridBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, clusters.size() * sizeof(LightCluster), clusters.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, lightIndexBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, std::max<size_t>(indices.size(), 1) * sizeof(uint32_t),
+        indices.empty() ? nullptr : indices.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SSBO_LIGHTS, lightBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SSBO_LIGHT_GRID, lightGridBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SSBO_LIGHT_INDICES, lightIndexBuffer);
+}
+
+void Renderer::BenchmarkLightClustering()
+{
+    auto elapsedMs = [](std::chrono::high_resolution_clock::time_point start) {
+        return std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        };
+
+    // Lights spread through the first 150 units of a 60 degree view
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> spreadDist(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> depthDist(1.0f, 150.0f);
+    std::uniform_real_distribution<float> rangeDist(1.0f, 12.0f);
+
+    const float nearPlane = 0.1f;
+    const float farPlane = 500.0f;
+    LightClusterer clusterer;
+    clusterer.SetProjection(glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, nearPlane, farPlane), nearPlane, farPlane);
+
+    const int counts[5] = { 64, 128, 256, 512, 1024 };
+    for (int count : counts)
+    {
+        std::vector<glm::vec4> spheres(count);
+        for (glm::vec4& sphere : spheres)
+        {
+            float depth = depthDist(rng);
+            sphere = glm::vec4(spreadDist(rng) * depth * 0.6f, spreadDist(rng) * depth * 0.35f, -depth, rangeDist(rng));
+        }
+
+        // The first build sizes the lists
+        clusterer.Build(spheres);
+
+        const int runs = 20;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < runs; ++i) clusterer.Build(spheres);
+        float buildMs = elapsedMs(start) / runs;
+
+        int occupied = clusterer.GetOccupiedClusters();
+        size_t indices = clusterer.GetLightIndices().size();
+        LOG_CONSOLE("Light clustering %d lights: %.3f ms per build, %d of %d clusters lit, %.1f lights per lit cluster instead of %d per fragment",
+            count, buildMs, occupied, LightClusterer::kClusterCount, occupied > 0 ? (float)indices / occupied : 0.0f, count);
+    }
+}
+
 void Renderer::AddPostProcessing(ComponentPostProcessing* component)
 {
     postProcessingComponents.push_back(component);
@@ -535,22 +1160,58 @@ void Renderer::RemovePostProcessing(ComponentPostProcessing* component)
     }
 }
 
+void Renderer::CollectFrameStats()
+{
+    // Draws are counted by the replay, the rest while the scene was prepared
+    RenderStats stats = replayStats;
+    stats.lights = frameStats.lights;
+    stats.lightIndices = frameStats.lightIndices;
+    stats.lightBinTimeMs = frameStats.lightBinTimeMs;
+    stats.submitTimeMs = frameStats.submitTimeMs;
+    stats.staticPacketRebuilds = frameStats.staticPacketRebuilds;
+    renderStats = stats;
+}
+
 bool Renderer::PostUpdate()
 {
     bool ret = true;
 
+    // State changed outside the renderer since the last frame (editor, previews) is forgotten
+    GLState::BeginFrame();
+    GpuProfiler::GetInstance().BeginFrame();
+    ShaderCache::GetInstance().Update();
+    UploadManager::GetInstance().Update();
+
     int width = 0, height = 0;
     Application::GetInstance().window->GetWindowSize(width, height);
 
+    UpdateRenderCache();
+    UploadArenaMeshes();
+
+    frameStats = RenderStats();
+    replayStats = RenderStats();
+    BeginInstanceFrame();
+    particleRenderer->BeginFrame();
+
+    // The main thread gives the context away until every camera has been replayed
+    replayThreaded = BeginThreadedReplay();
     for (CameraLens* camera : activeCameras)
     {
         RenderScene(camera);
     }
+    if (replayThreaded) EndThreadedReplay();
+    replayThreaded = false;
+
+    EndInstanceFrame();
+    particleRenderer->EndFrame();
+    CollectFrameStats();
+
+    TextureStreamer::GetInstance().Update();
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
     glViewport(0, 0, width, height);
     
-    glDisable(GL_SCISSOR_TEST);
+    GLState::Disable(GL_SCISSOR_TEST);
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
@@ -561,6 +1222,27 @@ bool Renderer::RenderScene(CameraLens* camera)
 {
     if (!camera) return false;
 
+    int index = frameCommandIndex;
+    RenderCommandBuffer& commands = frameCommands[index];
+    frameCommandIndex = (index + 1) % 2;
+
+    // The camera recorded two cameras ago may still be replaying from this buffer
+    if (replayThreaded) renderThread->WaitFor(frameTickets[index]);
+
+    commands.Clear();
+    sceneCommands = &commands;
+    RecordScene(camera);
+    sceneCommands = nullptr;
+
+    if (replayThreaded)
+        frameTickets[index] = renderThread->Submit([this, &commands]() { ReplayCommands(commands); });
+    else
+        ReplayCommands(commands);
+    return true;
+}
+
+void Renderer::RecordScene(CameraLens* camera)
+{
     int width = 0, height = 0;
     if (camera->fboID == 0)
         Application::GetInstance().window->GetWindowSize(width, height);
@@ -570,129 +1252,395 @@ bool Renderer::RenderScene(CameraLens* camera)
     }
 
     bool usingMSAA = msaaEnabled && camera->msaaFBO != 0;
-
-    if (usingMSAA) {
-        glBindFramebuffer(GL_FRAMEBUFFER, camera->msaaFBO);
-        glEnable(GL_MULTISAMPLE);
-    }
-    else {
-        glBindFramebuffer(GL_FRAMEBUFFER, (camera->fboID != 0) ? camera->fboID : 0);
-        glDisable(GL_MULTISAMPLE);
+    GLuint targetFBO = camera->fboID;
+    GLuint msaaFBO = camera->msaaFBO;
+    glm::vec4 clearColor = showOverdraw ? glm::vec4(0.0f, 0.0f, 0.0f, 1.0f) : glm::vec4(clearColorR, clearColorG, clearColorB, 1.0f);
+
+    // Object IDs for picking are written alongside color in the opaque and transparent passes
+    writingObjectIDs = camera->GetDebugCamera() && camera->idTextureID != 0 && (!usingMSAA || camera->msaaIdBuffer != 0);
+    bool objectIDs = writingObjectIDs;
+    if (objectIDs) {
+        pickingIDs.clear();
+        pickingIDs.push_back(0);
     }
 
-    glViewport(0, 0, width, height);
+    sceneCommands->RunPass([this, usingMSAA, targetFBO, msaaFBO, width, height, clearColor, objectIDs]() {
+        if (usingMSAA) {
+            glBindFramebuffer(GL_FRAMEBUFFER, msaaFBO);
+            GLState::Enable(GL_MULTISAMPLE);
+        }
+        else {
+            glBindFramebuffer(GL_FRAMEBUFFER, targetFBO);
+            GLState::Disable(GL_MULTISAMPLE);
+        }
 
-    //Clear buffers
-    glDisable(GL_SCISSOR_TEST);
-    glClearColor(clearColorR, clearColorG, clearColorB, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
-    glClearStencil(0);
+        glViewport(0, 0, width, height);
+
+        //Clear buffers
+        GLState::Disable(GL_SCISSOR_TEST);
+        glClearColor(clearColor.r, clearColor.g, clearColor.b, clearColor.a);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+        glClearStencil(0);
+
+        if (objectIDs) BeginObjectIDs();
+    });
 
     //Camera Matrices
-    UpdateViewMatrix(camera->GetViewMatrix());
-    UpdateProjectionMatrix(camera->GetProjectionMatrix());
-    glBindBufferBase(GL_UNIFORM_BUFFER, 0, uboMatrices);
+    UpdateLights(camera, width, height);
+
+    glm::mat4 view = camera->GetViewMatrix();
+    glm::mat4 projection = camera->GetProjectionMatrix();
+    FrameUniformData frameData = {};
+    frameData.lightDir = lightDir;
+    frameData.viewPos = camera->position;
+    frameData.clusterScale = clusterScale;
+    frameData.clusterDepth = clusterDepth;
+
+    sceneCommands->RunPass([this, view, projection, frameData]() {
+        UpdateViewMatrix(view);
+        UpdateProjectionMatrix(projection);
+        UpdateFrameData(frameData);
+        glBindBufferBase(GL_UNIFORM_BUFFER, UBO_MATRICES, uboMatrices);
+        glBindBufferBase(GL_UNIFORM_BUFFER, UBO_FRAME_DATA, uboFrameData);
+    });
 
     //Build Render List
-    opaqueList.clear();
-    transparentList.clear();
+    drawObjects.clear();
+    opaqueQueue.Clear();
+    prepassQueue.Clear();
+    lateOpaqueQueue.Clear();
+    transparentQueue.Clear();
     particlesList.clear();
     canvasList.clear();
+    RasterizeOccluders(camera);
+
+    auto buildStart = std::chrono::high_resolution_clock::now();
     BuildRenderLists(camera);
+    buildListsTimeMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - buildStart).count();
 
-    if (showZBuffer) {
-        depthShader->Use();
-        depthShader->SetFloat("nearPlane", camera->GetNearPlane());
-        depthShader->SetFloat("farPlane",  camera->GetFarPlane());
-    }
-    else {
-        defaultShader->Use();
+    // --- Render ---
+    sceneCommands->RunPass([]() {
+        GLState::Enable(GL_STENCIL_TEST);
+        GLState::StencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+
+        GLState::Enable(GL_DEPTH_TEST);
+        GLState::DepthMask(GL_TRUE);
+        GLState::Disable(GL_BLEND);
+        GLState::Enable(GL_CULL_FACE);
+    });
+    auto submitStart = std::chrono::high_resolution_clock::now();
+
+    // Only filled while the pre-pass is on
+    bool depthPrepass = !prepassQueue.Empty();
+    if (depthPrepass) {
+        sceneCommands->BeginTimer("Depth Pre-Pass");
+        RecordDepthPrepass();
+        sceneCommands->EndTimer();
     }
 
-    // --- Render ---
-    glEnable(GL_STENCIL_TEST);
-    glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+    bool overdraw = showOverdraw;
+    bool zBuffer = showZBuffer;
+    float nearPlane = camera->GetNearPlane();
+    float farPlane = camera->GetFarPlane();
+    sceneCommands->RunPass([this, overdraw, zBuffer, nearPlane, farPlane]() {
+        if (overdraw) {
+            overdrawShader->Use();
+            GLState::Enable(GL_BLEND);
+            GLState::BlendFunc(GL_ONE, GL_ONE);
+        }
+        else if (zBuffer) {
+            depthShader->Use();
+            depthShader->SetFloat("nearPlane", nearPlane);
+            depthShader->SetFloat("farPlane", farPlane);
+        }
+        else {
+            defaultShader->Use();
+        }
+    });
 
-    glEnable(GL_DEPTH_TEST);
-    glDepthMask(GL_TRUE);
-    glDisable(GL_BLEND);
-    glEnable(GL_CULL_FACE);
-    DrawRenderList(opaqueList, camera);
+    // The query is GL state of the replay, it decides there whether a count starts
+    bool measuringOverdraw = showOverdraw && camera->GetDebugCamera();
+    if (measuringOverdraw)
+        sceneCommands->RunPass([this, width, height]() { overdrawQueryActive = BeginOverdrawQuery(width, height); });
 
-    glEnable(GL_BLEND);
-    glDepthMask(GL_FALSE);
-    DrawRenderList(transparentList, camera);
-    DrawParticlesList(camera);
+    {
+        sceneCommands->BeginTimer("Opaque");
+
+        // Depth is already laid down, each pixel is shaded once by the surface that wrote it
+        if (depthPrepass) {
+            sceneCommands->RunPass([]() {
+                GLState::DepthFunc(GL_EQUAL);
+                GLState::DepthMask(GL_FALSE);
+            });
+        }
+        RecordRenderList(opaqueQueue, true);
+        if (depthPrepass) {
+            sceneCommands->RunPass([]() {
+                GLState::DepthFunc(GL_LESS);
+                GLState::DepthMask(GL_TRUE);
+            });
+        }
+        if (!lateOpaqueQueue.Empty()) RecordRenderList(lateOpaqueQueue, true);
+
+        sceneCommands->EndTimer();
+    }
+
+    if (measuringOverdraw) {
+        sceneCommands->RunPass([this]() {
+            if (overdrawQueryActive) glEndQuery(GL_SAMPLES_PASSED);
+            overdrawQueryActive = false;
+        });
+    }
+
+    // Transparent draws keep their back to front order, no instancing
+    sceneCommands->RunPass([]() {
+        GLState::Enable(GL_BLEND);
+        GLState::DepthMask(GL_FALSE);
+    });
+    {
+        sceneCommands->BeginTimer("Transparent");
+        RecordRenderList(transparentQueue, false);
+        sceneCommands->EndTimer();
+    }
+    if (showOverdraw) sceneCommands->RunPass([]() { GLState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); });
+    frameStats.submitTimeMs += std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - submitStart).count();
+
+    if (objectIDs) sceneCommands->RunPass([]() { glDrawBuffer(GL_COLOR_ATTACHMENT0); });
+
+    {
+        sceneCommands->BeginTimer("Particles");
+        RecordParticles(camera);
+        sceneCommands->EndTimer();
+    }
 
     if (camera->GetDebugCamera()) {
+        sceneCommands->BeginTimer("Editor Overlays");
         Application::GetInstance().physics->DrawDebug();
-        DrawStencilList(camera);
-        DrawNormalsList(camera);
-        DrawMeshLinesList(camera);
-        DrawLinesList(camera);
+
+        // The lists keep filling up until the next frame, the passes draw what they held now
+        std::vector<OverlayMesh> stencilMeshes = MakeOverlayMeshes(stencilList);
+        std::vector<OverlayMesh> normalMeshes = MakeOverlayMeshes(normalsList);
+        std::vector<OverlayMesh> lineMeshes = MakeOverlayMeshes(meshLinesList);
+        sceneCommands->RunPass([this, stencilMeshes, normalMeshes, lineMeshes, lines = linesList, view, projection]() {
+            DrawStencilList(stencilMeshes, view, projection);
+            DrawNormalsList(normalMeshes);
+            DrawMeshLinesList(lineMeshes);
+            DrawLinesList(lines);
+        });
+        sceneCommands->EndTimer();
     }
 
-    glDisable(GL_STENCIL_TEST);
-    glStencilMask(0xFF);
-    glStencilFunc(GL_ALWAYS, 0, 0xFF);
-    glEnable(GL_DEPTH_TEST);
-    glDepthMask(GL_TRUE);
-    glDisable(GL_BLEND);
-    glEnable(GL_CULL_FACE);
-    glBindVertexArray(0);
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glUseProgram(0);
+    sceneCommands->RunPass([]() {
+        GLState::Disable(GL_STENCIL_TEST);
+        GLState::StencilMask(0xFF);
+        GLState::StencilFunc(GL_ALWAYS, 0, 0xFF);
+        GLState::Enable(GL_DEPTH_TEST);
+        GLState::DepthMask(GL_TRUE);
+        GLState::Disable(GL_BLEND);
+        GLState::Enable(GL_CULL_FACE);
+        GLState::BindVertexArray(0);
+        GLState::BindTexture(GL_TEXTURE_2D, 0);
+        GLState::UseProgram(0);
+    });
 
 
     if (usingMSAA) {
-        GLuint targetFBO = (camera->fboID != 0) ? camera->fboID : 0;
-        glBindFramebuffer(GL_READ_FRAMEBUFFER, camera->msaaFBO);
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, targetFBO);
-        glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
-        glDisable(GL_MULTISAMPLE);
+        sceneCommands->BeginTimer("MSAA Resolve");
+        sceneCommands->RunPass([targetFBO, msaaFBO, width, height, objectIDs]() {
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, msaaFBO);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, targetFBO);
+            glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+            if (objectIDs) {
+                glReadBuffer(GL_COLOR_ATTACHMENT1);
+                glDrawBuffer(GL_COLOR_ATTACHMENT1);
+                glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+                glReadBuffer(GL_COLOR_ATTACHMENT0);
+                glDrawBuffer(GL_COLOR_ATTACHMENT0);
+            }
+
+            GLState::Disable(GL_MULTISAMPLE);
+        });
+        sceneCommands->EndTimer();
     }
 
-    DrawPostProcessing(camera);
-    DrawCanvasList(camera);
+    {
+        sceneCommands->BeginTimer("Post-Processing");
+        RecordPostProcessing(camera);
+        sceneCommands->EndTimer();
+    }
+    {
+        sceneCommands->BeginTimer("Canvas");
+        RecordCanvasList(camera);
+        sceneCommands->EndTimer();
+    }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    return true;
+    if (objectIDs) {
+        RecordPickReadback(camera);
+        writingObjectIDs = false;
+    }
+
+    sceneCommands->RunPass([]() { glBindFramebuffer(GL_FRAMEBUFFER, 0); });
 }
 
 void Renderer::BuildRenderLists(const CameraLens* camera)
 {
-    for (ComponentMesh* mesh : meshes)
-    {
-        if (!mesh || !mesh->owner || !mesh->owner->transform) continue;
-        if (!mesh->owner->IsActive()) continue;
+    // A mesh was removed since the last cache update
+    if (staticEntriesDirty) RebuildStaticEntries();
+
+    bool testOcclusion = occlusionCullingEnabled && !frameOccluders.empty();
+    float farPlane = camera->GetFarPlane();
+    float projectionScale = camera->GetProjectionMatrix()[1][1];
+    float screenHeight = (float)std::max(camera->textureHeight, 1);
+    TextureStreamer& textureStreamer = TextureStreamer::GetInstance();
+    const UploadManager& uploadManager = UploadManager::GetInstance();
+    bool depthPrepass = depthPrepassEnabled && !wireframeMode;
+    std::vector<std::pair<UID, float>>* textureUsage = nullptr; // set while the static packets are built
+
+    auto submit = [&](RenderCacheEntry& entry)
+        {
+            ComponentMesh* mesh = entry.mesh;
+            if (!mesh->owner->IsActive() || mesh->IsStaticBatched()) return;
 
-        Mesh resMesh = mesh->GetMesh();
-        if (!resMesh.IsValid()) continue;
+            // Buffers still being staged are not drawn, nor copied into the geometry arena
+            if (!uploadManager.IsComplete(mesh->GetMesh().uploadTicket)) return;
 
-        glm::mat4 globalModelMatrix = mesh->owner->transform->GetGlobalMatrix();
+            if (testOcclusion && !mesh->HasSkinning() &&
+                !std::binary_search(frameOccluders.begin(), frameOccluders.end(), mesh) &&
+                occlusionCuller->IsOccluded(entry.globalAABB))
+            {
+                return;
+            }
 
-        const AABB& globalAABB = mesh->GetGlobalAABB();
+            // Projected bounding radius over half the screen height
+            float distance = glm::distance(entry.center, camera->position);
+            float radius = glm::length(entry.globalAABB.max - entry.globalAABB.min) * 0.5f;
+            float screenRadius = radius * projectionScale / std::max(distance, 0.001f);
+            int lod = 0;
+            if (meshLODEnabled && mesh->GetLODCount() > 1)
+            {
+                lod = SelectLOD(entry, camera, screenRadius);
+            }
 
-        if (/*camera->GetFrustum()->InFrustum(mesh->GetGlobalAABB())*/true)
-        {
-            mesh->UpdateSkinningMatrices();
+            uint32_t index = (uint32_t)drawObjects.size();
+            drawObjects.push_back({ mesh, entry.globalModelMatrix, entry.normalMatrix, lod });
 
-            RenderObject renderObject = { mesh, globalModelMatrix };
+            // The texture is the only state a material binds, the skinned path is the shader variant
+            ComponentMaterial* material = mesh->GetAttachedMaterial();
+            uint32_t layer = mesh->owner->IsSelected() ? LAYER_SELECTED : LAYER_DEFAULT;
+            uint32_t shader = mesh->HasSkinning() ? 1 : 0;
+            uint32_t materialKey = 0;
+            if (material) materialKey = material->IsUsingCheckerboard() ? 1 : SortKey::HashMaterial(material->GetTextureUID());
 
-            glm::vec3 aabbCenter = (globalAABB.min + globalAABB.max) * 0.5f;
-            float distanceToCamera = glm::distance(aabbCenter, camera->position);
+            // Coverage in pixels drives which mip levels of the texture stay resident
+            if (material && !material->IsUsingCheckerboard() && material->GetTextureUID() != 0)
+            {
+                textureStreamer.ReportUsage(material->GetTextureUID(), screenRadius * screenHeight);
+                if (textureUsage) textureUsage->emplace_back(material->GetTextureUID(), screenRadius * screenHeight);
+            }
+            uint32_t depth = SortKey::QuantizeDepth(distance, farPlane);
+            uint32_t meshKey = (mesh->GetMesh().VAO << 2) | (uint32_t)lod;
 
-            if (mesh->GetAttachedMaterial() && mesh->GetAttachedMaterial()->IsActive() && mesh->GetAttachedMaterial()->GetOpacity() < 1.0f)
+            if (material && material->IsActive() && material->GetOpacity() < 1.0f)
+            {
+                transparentQueue.Push(SortKey::MakeTransparent(layer, shader, materialKey, meshKey, depth), index);
+            }
+            else if (!depthPrepass)
             {
-                transparentList.emplace(distanceToCamera, renderObject);
+                opaqueQueue.Push(SortKey::MakeOpaque(layer, shader, materialKey, meshKey, depth), index);
+            }
+            else if (mesh->HasSkinning() || mesh->GetMesh().depthVAO == 0 || (material && material->HasCutout()))
+            {
+                // Positions alone can't place skinned vertices nor cut out texels
+                lateOpaqueQueue.Push(SortKey::MakeOpaque(layer, shader, materialKey, meshKey, depth), index);
             }
             else
             {
-                opaqueList.emplace(distanceToCamera, renderObject);
+                opaqueQueue.Push(SortKey::MakeOpaque(layer, shader, materialKey, meshKey, depth), index);
+                prepassQueue.Push(SortKey::MakeDepthOnly((mesh->GetMesh().depthVAO << 2) | (uint32_t)lod, depth), index);
             }
+        };
+
+    StaticPackets* cache = nullptr;
+    for (StaticPackets& candidate : staticPackets)
+    {
+        if (candidate.camera == camera) cache = &candidate;
+    }
+    if (!cache)
+    {
+        staticPackets.emplace_back();
+        cache = &staticPackets.back();
+        cache->camera = camera;
+    }
+    cache->lastUsedFrame = renderFrame;
+
+    uint32_t settings = (testOcclusion ? 1 : 0) | (depthPrepass ? 2 : 0) | (meshLODEnabled ? 4 : 0);
+    if (!CanReuseStaticPackets(*cache, camera, settings, depthPrepass))
+    {
+        cache->textureUsage.clear();
+        textureUsage = &cache->textureUsage;
+        for (size_t index : staticEntries)
+        {
+            submit(renderCache[index]);
+        }
+        textureUsage = nullptr;
+
+        opaqueQueue.Sort();
+        prepassQueue.Sort();
+        lateOpaqueQueue.Sort();
+        transparentQueue.Sort();
+
+        cache->objects = drawObjects;
+        cache->opaque = opaqueQueue.GetPackets();
+        cache->prepass = prepassQueue.GetPackets();
+        cache->lateOpaque = lateOpaqueQueue.GetPackets();
+        cache->transparent = transparentQueue.GetPackets();
+
+        cache->drawStates.resize(staticEntries.size());
+        for (size_t i = 0; i < staticEntries.size(); ++i)
+        {
+            cache->drawStates[i] = GetStaticDrawState(renderCache[staticEntries[i]].mesh, depthPrepass);
+        }
+        cache->occluders = frameOccluders;
+        cache->view = camera->GetViewMatrix();
+        cache->projection = camera->GetProjectionMatrix();
+        cache->screenHeight = camera->textureHeight;
+        cache->settings = settings;
+        cache->listVersion = staticListVersion;
+        cache->builtFrame = renderFrame;
+        cache->built = true;
+        frameStats.staticPacketRebuilds++;
+
+        opaqueQueue.Clear();
+        prepassQueue.Clear();
+        lateOpaqueQueue.Clear();
+        transparentQueue.Clear();
+    }
+    else
+    {
+        drawObjects = cache->objects;
+        for (const auto& usage : cache->textureUsage)
+        {
+            textureStreamer.ReportUsage(usage.first, usage.second);
         }
     }
 
+    // Dynamic packets index past the static objects, only they are sorted this frame
+    for (size_t index : dynamicEntries)
+    {
+        submit(renderCache[index]);
+    }
+
+    opaqueQueue.Sort();
+    prepassQueue.Sort();
+    lateOpaqueQueue.Sort();
+    transparentQueue.Sort();
+
+    opaqueQueue.Merge(cache->opaque);
+    prepassQueue.Merge(cache->prepass);
+    lateOpaqueQueue.Merge(cache->lateOpaque);
+    transparentQueue.Merge(cache->transparent);
+
     for (ComponentParticleSystem* ps : particles)
     {
         if (!ps || !ps->owner || !ps->owner->transform) continue;
@@ -726,7 +1674,73 @@ void Renderer::BuildRenderLists(const CameraLens* camera)
     }
 }
 
-void Renderer::DrawPostProcessing(const CameraLens* camera)
+void Renderer::RasterizeOccluders(const CameraLens* camera)
+{
+    frameOccluders.clear();
+    if (!occlusionCullingEnabled) return;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    occlusionCuller->BeginFrame(camera->GetProjectionMatrix() * camera->GetViewMatrix());
+
+    // Rank candidates by how much of the screen they roughly cover
+    occluderCandidates.clear();
+    for (ComponentMesh* mesh : meshes)
+    {
+        if (!mesh || !mesh->owner || !mesh->owner->transform) continue;
+        if (!mesh->owner->IsActive()) continue;
+        if (mesh->HasSkinning() || mesh->IsStaticBatched()) continue;
+
+        // Rasterized from the CPU copy. Flagged occluders hold theirs, auto picks only use resident ones
+        const Mesh& resMesh = mesh->GetMesh();
+        if (!resMesh.IsValid() || !resMesh.HasCPUData() || resMesh.indices.size() < 3) continue;
+
+        ComponentMaterial* material = mesh->GetAttachedMaterial();
+        bool transparent = material && material->IsActive() && material->GetOpacity() < 1.0f;
+
+        if (!mesh->IsOccluder() && (!autoOccluders || transparent)) continue;
+
+        AABB globalAABB = mesh->GetGlobalAABB();
+        glm::vec3 center = (globalAABB.min + globalAABB.max) * 0.5f;
+        float radius = glm::length(globalAABB.max - globalAABB.min) * 0.5f;
+        float distance = std::max(glm::distance(center, camera->position), 0.001f);
+        float screenSize = radius / distance;
+
+        // Small auto picks cost more to rasterize than they save
+        if (!mesh->IsOccluder() && screenSize < 0.25f) continue;
+
+        // Flagged occluders always go first
+        float score = mesh->IsOccluder() ? screenSize + 1000.0f : screenSize;
+        occluderCandidates.emplace_back(score, mesh);
+    }
+
+    std::sort(occluderCandidates.begin(), occluderCandidates.end(),
+        [](const std::pair<float, ComponentMesh*>& a, const std::pair<float, ComponentMesh*>& b) { return a.first > b.first; });
+
+    int trianglesUsed = 0;
+    for (const auto& candidate : occluderCandidates)
+    {
+        ComponentMesh* mesh = candidate.second;
+        const Mesh& resMesh = mesh->GetMesh();
+
+        int triangles = static_cast<int>(resMesh.indices.size() / 3);
+        if (trianglesUsed + triangles > occluderTriangleBudget) continue;
+        trianglesUsed += triangles;
+
+        occlusionCuller->AddOccluder(mesh->owner->transform->GetGlobalMatrix(),
+            &resMesh.vertices[0].position.x, sizeof(Vertex), resMesh.vertices.size(),
+            resMesh.indices.data(), resMesh.indices.size());
+        frameOccluders.push_back(mesh);
+    }
+
+    occlusionCuller->RasterizeOccluders();
+    std::sort(frameOccluders.begin(), frameOccluders.end());
+
+    auto end = std::chrono::high_resolution_clock::now();
+    occlusionTimeMs = std::chrono::duration<float, std::milli>(end - start).count();
+}
+
+void Renderer::RecordPostProcessing(const CameraLens* camera)
 {
     if (!camera->IsUsingPostProcessing()) return;
 
@@ -739,314 +1753,867 @@ void Renderer::DrawPostProcessing(const CameraLens* camera)
 
     if (!activePP) return;
 
-    ResizePostProcessingBuffer(camera->textureWidth, camera->textureHeight);
-
-    glBindFramebuffer(GL_READ_FRAMEBUFFER, (camera->fboID != 0) ? camera->fboID : 0);
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, postProcessFBO);
-    glBlitFramebuffer(0, 0, camera->textureWidth, camera->textureHeight,
-        0, 0, camera->textureWidth, camera->textureHeight,
-        GL_COLOR_BUFFER_BIT, GL_NEAREST);
-
-    glBindFramebuffer(GL_FRAMEBUFFER, camera->fboID);
-
-    postProcessShader->Use();
-
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, postProcessTexture);
-    postProcessShader->SetInt("sceneTexture", 0);
-
-    // Color Grading
-    postProcessShader->SetBool("gradingEnabled", activePP->colorGrading.enabled);
-    postProcessShader->SetFloat("exposure", activePP->colorGrading.exposure);
-    postProcessShader->SetFloat("contrast", activePP->colorGrading.contrast);
-    postProcessShader->SetFloat("saturation", activePP->colorGrading.saturation);
-    postProcessShader->SetInt("toneMapper", activePP->colorGrading.toneMapper);
-    postProcessShader->SetFloat("gamma", activePP->colorGrading.gamma);
-    postProcessShader->SetFloat("temperature", activePP->colorGrading.temperature);
-    postProcessShader->SetFloat("tint", activePP->colorGrading.tint);
-    postProcessShader->SetVec3("colorFilter", activePP->colorGrading.colorFilter);
-
-    // Bloom
-    postProcessShader->SetBool("bloomEnabled", activePP->bloom.enabled);
-    postProcessShader->SetFloat("bloomIntensity", activePP->bloom.intensity);
-    postProcessShader->SetFloat("bloomThreshold", activePP->bloom.threshold);
-    postProcessShader->SetFloat("bloomSoftKnee", activePP->bloom.softKnee);
-    postProcessShader->SetVec3("bloomTint", activePP->bloom.tint);
-
-    // Chromatic Aberration
-    postProcessShader->SetBool("caEnabled", activePP->lens.chromaticAberrationEnabled);
-    postProcessShader->SetFloat("caIntensity", activePP->lens.chromaticAberrationIntensity);
-
-    // Vignette
-    postProcessShader->SetBool("vignetteEnabled", activePP->lens.vignetteEnabled);
-    postProcessShader->SetFloat("vignetteIntensity", activePP->lens.vignetteIntensity);
-    postProcessShader->SetFloat("vignetteSmoothness", activePP->lens.vignetteSmoothness);
-    postProcessShader->SetFloat("vignetteRoundness", activePP->lens.vignetteRoundness);
-    postProcessShader->SetVec3("vignetteColor", activePP->lens.vignetteColor);
-
-    // Grain
-    postProcessShader->SetBool("grainEnabled", activePP->grain.enabled);
-    postProcessShader->SetFloat("grainIntensity", activePP->grain.intensity);
-    postProcessShader->SetFloat("grainScale", std::max(0.001f, activePP->grain.scale));
-    postProcessShader->SetFloat("grainTime", activePP->grain.animated
-        ? Application::GetInstance().time->GetTotalTimeStatic() : 0.0f);
-
-    glDisable(GL_DEPTH_TEST);
-    glDisable(GL_CULL_FACE);
-    glBindVertexArray(quadVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-    glBindVertexArray(0);
-    glUseProgram(0);
+    // The component's settings as they are now, the pass runs once the camera is replayed
+    ColorGradingSettings colorGrading = activePP->colorGrading;
+    BloomSettings bloom = activePP->bloom;
+    LensSettings lens = activePP->lens;
+    GrainSettings grain = activePP->grain;
+    float grainTime = grain.animated ? Application::GetInstance().time->GetTotalTimeStatic() : 0.0f;
+    GLuint fbo = camera->fboID;
+    int width = camera->textureWidth;
+    int height = camera->textureHeight;
+
+    sceneCommands->RunPass([this, colorGrading, bloom, lens, grain, grainTime, fbo, width, height]() {
+        ResizePostProcessingBuffer(width, height);
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, postProcessFBO);
+        glBlitFramebuffer(0, 0, width, height,
+            0, 0, width, height,
+            GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+        postProcessShader->Use();
+
+        GLState::BindTextureUnit(0, postProcessTexture);
+        postProcessShader->SetInt("sceneTexture", 0);
+
+        // Color Grading
+        postProcessShader->SetBool("gradingEnabled", colorGrading.enabled);
+        postProcessShader->SetFloat("exposure", colorGrading.exposure);
+        postProcessShader->SetFloat("contrast", colorGrading.contrast);
+        postProcessShader->SetFloat("saturation", colorGrading.saturation);
+        postProcessShader->SetInt("toneMapper", colorGrading.toneMapper);
+        postProcessShader->SetFloat("gamma", colorGrading.gamma);
+        postProcessShader->SetFloat("temperature", colorGrading.temperature);
+        postProcessShader->SetFloat("tint", colorGrading.tint);
+        postProcessShader->SetVec3("colorFilter", colorGrading.colorFilter);
+
+        // Bloom
+        postProcessShader->SetBool("bloomEnabled", bloom.enabled);
+        postProcessShader->SetFloat("bloomIntensity", bloom.intensity);
+        postProcessShader->SetFloat("bloomThreshold", bloom.threshold);
+        postProcessShader->SetFloat("bloomSoftKnee", bloom.softKnee);
+        postProcessShader->SetVec3("bloomTint", bloom.tint);
+
+        // Chromatic Aberration
+        postProcessShader->SetBool("caEnabled", lens.chromaticAberrationEnabled);
+        postProcessShader->SetFloat("caIntensity", lens.chromaticAberrationIntensity);
+
+        // Vignette
+        postProcessShader->SetBool("vignetteEnabled", lens.vignetteEnabled);
+        postProcessShader->SetFloat("vignetteIntensity", lens.vignetteIntensity);
+        postProcessShader->SetFloat("vignetteSmoothness", lens.vignetteSmoothness);
+        postProcessShader->SetFloat("vignetteRoundness", lens.vignetteRoundness);
+        postProcessShader->SetVec3("vignetteColor", lens.vignetteColor);
+
+        // Grain
+        postProcessShader->SetBool("grainEnabled", grain.enabled);
+        postProcessShader->SetFloat("grainIntensity", grain.intensity);
+        postProcessShader->SetFloat("grainScale", std::max(0.001f, grain.scale));
+        postProcessShader->SetFloat("grainTime", grainTime);
+
+        GLState::Disable(GL_DEPTH_TEST);
+        GLState::Disable(GL_CULL_FACE);
+        GLState::BindVertexArray(quadVAO);
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+        GLState::BindVertexArray(0);
+        GLState::UseProgram(0);
+    });
 }
 
-void Renderer::DrawRenderList(const std::multimap<float, RenderObject>& map, const CameraLens* camera)
+// Replays the command buffer of a camera, each list with the uniforms of its pass shader
+class Renderer::SceneBackend : public RenderBackend
 {
-    for (auto pair = map.rbegin(); pair != map.rend(); ++pair)
+public:
+    SceneBackend(Renderer& renderer, unsigned int arenaVAO)
+        : renderer(renderer), stats(renderer.replayStats), uniforms(&renderer.defaultUniforms), arenaVAO(arenaVAO)
+    {
+    }
+
+    ~SceneBackend()
+    {
+        if (timerOpen) GpuProfiler::GetInstance().EndPass();
+    }
+
+    uint32_t UploadInstances(const MeshInstanceData* instances, size_t count) override
+    {
+        // Recording kept the frame's instances within the region, the copy always fits
+        uint32_t base = (uint32_t)(renderer.instanceRegion * kInstancesPerRegion + renderer.instanceUploadCursor);
+        memcpy(renderer.instanceData + base, instances, count * sizeof(MeshInstanceData));
+        renderer.instanceUploadCursor += (int)count;
+        return base;
+    }
+
+    void UploadIndirectCommands(const DrawElementsIndirectCommand* commands, const uint8_t* lods, size_t count) override
+    {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, renderer.indirectBuffer);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, count * sizeof(DrawElementsIndirectCommand), commands, GL_STREAM_DRAW);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        indirectCommands = commands;
+        indirectLODs = lods;
+    }
+
+    void UpdateMaterial(uint32_t slot, const MaterialUniformData& material) override
+    {
+        std::vector<MaterialUniformData>& values = renderer.sceneMaterialValues;
+        std::vector<bool>& uploaded = renderer.sceneMaterialUploaded;
+        if (slot >= values.size()) GrowMaterials(slot + 1);
+
+        if (uploaded[slot] && memcmp(&values[slot], &material, sizeof(MaterialUniformData)) == 0) return;
+
+        glBindBuffer(GL_UNIFORM_BUFFER, renderer.uboSceneMaterials);
+        glBufferSubData(GL_UNIFORM_BUFFER, (GLintptr)slot * renderer.sceneMaterialStride, sizeof(MaterialUniformData), &material);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        values[slot] = material;
+        uploaded[slot] = true;
+    }
+
+    void SetStencil(int ref, unsigned int writeMask) override
     {
-        RenderObject renderObject = pair->second;
+        GLState::StencilFunc(GL_ALWAYS, ref, 0xFF);
+        GLState::StencilMask(writeMask);
+    }
+
+    void BindMaterial(unsigned int texture, int slot) override
+    {
+        GLState::BindTexture(GL_TEXTURE_2D, texture);
+        if (slot < 0)
+        {
+            glBindBufferBase(GL_UNIFORM_BUFFER, UBO_MATERIAL_DATA, renderer.uboDefaultMaterial);
+            return;
+        }
+
+        glBindBufferRange(GL_UNIFORM_BUFFER, UBO_MATERIAL_DATA, renderer.uboSceneMaterials,
+            (GLintptr)slot * renderer.sceneMaterialStride, sizeof(MaterialUniformData));
+    }
+
+    void SetDrawID(uint32_t drawID) override
+    {
+        glUniform1ui(uniforms->drawID, drawID);
+    }
+
+    void SetModel(const glm::mat4& model) override
+    {
+        glUniformMatrix4fv(uniforms->model, 1, GL_FALSE, glm::value_ptr(model));
+    }
+
+    void SetSkinning(unsigned int globalSSBO, unsigned int offsetSSBO, const glm::mat4& meshInverse,
+        const glm::mat4* bones, uint32_t boneCount) override
+    {
+        if (globalSSBO != 0 && boneCount > 0)
+        {
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, globalSSBO);
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, boneCount * sizeof(glm::mat4), bones);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        }
+
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, globalSSBO);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, offsetSSBO);
+        glUniformMatrix4fv(uniforms->meshInverseLoc, 1, GL_FALSE, glm::value_ptr(meshInverse));
+    }
+
+    void Draw(unsigned int vao, uint32_t indexCount, uint32_t firstIndex, bool skinned, int lod) override
+    {
+        SetInstancing(false);
+        SetBones(skinned);
+        CountDraw(indexCount, 1, lod);
+
+        GLState::BindVertexArray(vao);
+        glDrawElements(GL_TRIANGLES, (GLsizei)indexCount, GL_UNSIGNED_INT, (const void*)(firstIndex * sizeof(unsigned int)));
+
+        if (skinned)
+        {
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0);
+        }
+    }
+
+    void DrawInstanced(unsigned int vao, uint32_t indexCount, uint32_t firstIndex,
+        uint32_t instanceBase, uint32_t instanceCount, int lod) override
+    {
+        SetInstancing(true);
+        SetBones(false);
+        CountDraw(indexCount, instanceCount, lod);
+        if (!depthOnly)
+        {
+            stats.instancedDrawCalls++;
+            stats.instancedObjects += (int)instanceCount;
+        }
+        glUniform1i(uniforms->instanceBase, (GLint)instanceBase);
+
+        GLState::BindVertexArray(vao);
+        glDrawElementsInstancedBaseInstance(GL_TRIANGLES, (GLsizei)indexCount, GL_UNSIGNED_INT,
+            (const void*)(firstIndex * sizeof(unsigned int)), (GLsizei)instanceCount, instanceBase);
+    }
+
+    void DrawIndirect(uint32_t firstCommand, uint32_t commandCount, uint32_t instanceBase) override
+    {
+        SetInstancing(true);
+        SetBones(false);
+        glUniform1i(uniforms->instanceBase, (GLint)instanceBase);
+
+        stats.drawCalls++;
+        stats.indirectCommands += (int)commandCount;
+        for (uint32_t i = firstCommand; i < firstCommand + commandCount; ++i)
+        {
+            stats.lodTriangles[indirectLODs[i]] += (int)(indirectCommands[i].count / 3 * indirectCommands[i].instanceCount);
+        }
+
+        if (!indirectBound) glBindBuffer(GL_DRAW_INDIRECT_BUFFER, renderer.indirectBuffer);
+        indirectBound = true;
+
+        GLState::BindVertexArray(arenaVAO);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+            (const void*)(firstCommand * sizeof(DrawElementsIndirectCommand)), (GLsizei)commandCount, 0);
+    }
+
+    void BeginList(uint32_t uniformSet) override
+    {
+        switch (uniformSet)
+        {
+        case UNIFORMS_ZBUFFER: uniforms = &renderer.depthUniforms; break;
+        case UNIFORMS_OVERDRAW: uniforms = &renderer.overdrawUniforms; break;
+        case UNIFORMS_PREPASS: uniforms = &renderer.prepassUniforms; break;
+        default: uniforms = &renderer.defaultUniforms; break;
+        }
+        depthOnly = uniformSet == UNIFORMS_PREPASS;
+
+        // Another program may have been bound since the last list
+        instancing = -1;
+        bones = -1;
+    }
+
+    void EndList() override
+    {
+        SetInstancing(false);
+        GLState::BindVertexArray(0);
+        if (indirectBound) glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        indirectBound = false;
+    }
+
+    void BeginTimer(const char* name) override
+    {
+        timerOpen = GpuProfiler::GetInstance().BeginPass(name);
+    }
+
+    void EndTimer() override
+    {
+        if (timerOpen) GpuProfiler::GetInstance().EndPass();
+        timerOpen = false;
+    }
+
+    void RunPass(const std::function<void()>& pass) override
+    {
+        pass();
+    }
+
+private:
+    // Reallocates the material buffer with room for count slots, spread out to the offset
+    // alignment, and uploads the slots it held again
+    void GrowMaterials(uint32_t count)
+    {
+        std::vector<MaterialUniformData>& values = renderer.sceneMaterialValues;
+        std::vector<bool>& uploaded = renderer.sceneMaterialUploaded;
+
+        size_t capacity = std::max<size_t>(values.size(), 64);
+        while (capacity < count) capacity *= 2;
+
+        std::vector<unsigned char> staging(capacity * renderer.sceneMaterialStride, 0);
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            if (uploaded[i]) memcpy(staging.data() + i * renderer.sceneMaterialStride, &values[i], sizeof(MaterialUniformData));
+        }
+
+        glBindBuffer(GL_UNIFORM_BUFFER, renderer.uboSceneMaterials);
+        glBufferData(GL_UNIFORM_BUFFER, staging.size(), staging.data(), GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+        values.resize(capacity);
+        uploaded.resize(capacity, false);
+    }
+
+    // Depth only draws are counted apart and add no triangles
+    void CountDraw(uint32_t indexCount, uint32_t instanceCount, int lod)
+    {
+        if (depthOnly)
+        {
+            stats.prepassDrawCalls++;
+            return;
+        }
+
+        stats.drawCalls++;
+        stats.lodTriangles[lod] += (int)(indexCount / 3 * instanceCount);
+    }
+
+    // Switch uniforms only change between runs of different draw kinds
+    void SetInstancing(bool enabled)
+    {
+        if (instancing == (int)enabled) return;
+        glUniform1i(uniforms->useInstancing, enabled);
+        instancing = (int)enabled;
+    }
+
+    void SetBones(bool enabled)
+    {
+        if (bones == (int)enabled) return;
+        glUniform1i(uniforms->hasBonesLoc, enabled);
+        bones = (int)enabled;
+    }
+
+    Renderer& renderer;
+    RenderStats& stats;
+    const ShaderUniforms* uniforms;
+    unsigned int arenaVAO = 0;
+    bool depthOnly = false;
+    bool indirectBound = false;
+    bool timerOpen = false;
+    const DrawElementsIndirectCommand* indirectCommands = nullptr; // valid for the replay
+    const uint8_t* indirectLODs = nullptr;
+    int instancing = -1;
+    int bones = -1;
+};
+
+void Renderer::ReplayCommands(const RenderCommandBuffer& commands)
+{
+    GeometryArena& arena = GeometryArena::GetInstance();
+    {
+        SceneBackend backend(*this, arena.IsInitialized() ? arena.GetVAO() : 0);
+        commands.Execute(backend);
+    }
+    replayStats.renderCommands += (int)commands.GetCommandCount();
+}
+
+void Renderer::RecordRenderList(const RenderQueue& queue, bool allowInstancing)
+{
+    GeometryArena& arena = GeometryArena::GetInstance();
+
+    allowInstancing = allowInstancing && instancingEnabled && instanceData;
+
+    sceneCommands->BeginList(showOverdraw ? UNIFORMS_OVERDRAW : showZBuffer ? UNIFORMS_ZBUFFER : UNIFORMS_DEFAULT);
+    if (allowInstancing && multiDrawEnabled && arena.IsInitialized())
+    {
+        indirectFallback.clear();
+        RecordMultiIndirect(queue.GetPackets());
+        RecordPackets(indirectFallback, true);
+    }
+    else
+    {
+        RecordPackets(queue.GetPackets(), allowInstancing);
+    }
+    sceneCommands->EndList();
+}
+
+void Renderer::RecordDepthPrepass()
+{
+    sceneCommands->RunPass([this]() {
+        depthPrepassShader->Use();
+        GLState::ColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        GLState::StencilMask(0x00);
+    });
+
+    sceneCommands->BeginList(UNIFORMS_PREPASS);
+    RecordDepthPackets(prepassQueue.GetPackets());
+    sceneCommands->EndList();
+
+    sceneCommands->RunPass([]() { GLState::ColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE); });
+}
+
+void Renderer::RecordDepthPackets(const std::vector<DrawPacket>& packets)
+{
+    bool allowInstancing = instancingEnabled && instanceData;
+
+    size_t first = 0;
+    while (first < packets.size())
+    {
+        const RenderObject& renderObject = drawObjects[packets[first].index];
+        const Mesh& mesh = renderObject.mesh->GetMesh();
+
+        // Depth only draws share nothing but the mesh and its LOD
+        size_t last = first + 1;
+        if (allowInstancing)
+        {
+            size_t maxCount = (size_t)(kInstancesPerRegion - instanceCursor);
+            while (last < packets.size() && last - first < maxCount)
+            {
+                const RenderObject& next = drawObjects[packets[last].index];
+                if (next.mesh->GetMesh().depthVAO != mesh.depthVAO || next.lod != renderObject.lod) break;
+                ++last;
+            }
+        }
+
+        int lod = std::min(renderObject.lod, mesh.GetLODCount() - 1);
+        uint32_t indexCount = mesh.GetLODIndexCount(lod);
+        uint32_t firstIndex = mesh.GetLODFirstIndex(lod);
+
+        if (last - first == 1)
+        {
+            sceneCommands->SetModel(renderObject.globalModelMatrix);
+            sceneCommands->Draw(mesh.depthVAO, indexCount, firstIndex, false, lod);
+        }
+        else
+        {
+            uint32_t base = sceneCommands->GetInstanceCount();
+            for (size_t i = first; i < last; ++i)
+            {
+                const RenderObject& object = drawObjects[packets[i].index];
+                sceneCommands->AddInstance(object.globalModelMatrix, object.normalMatrix);
+            }
+            instanceCursor += (int)(last - first);
+
+            sceneCommands->DrawInstanced(mesh.depthVAO, indexCount, firstIndex, base, (uint32_t)(last - first), lod);
+        }
+
+        first = last;
+    }
+}
+
+bool Renderer::BeginOverdrawQuery(int width, int height)
+{
+    if (overdrawQuery == 0) glGenQueries(1, &overdrawQuery);
+
+    // The previous count is read once the GPU has it, no new query starts until then
+    if (overdrawQueryPending)
+    {
+        GLuint available = GL_FALSE;
+        glGetQueryObjectuiv(overdrawQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) return false;
+
+        GLuint64 samples = 0;
+        glGetQueryObjectui64v(overdrawQuery, GL_QUERY_RESULT, &samples);
+        opaqueOverdraw = overdrawTargetSamples > 0.0 ? (float)(samples / overdrawTargetSamples) : 0.0f;
+        overdrawQueryPending = false;
+    }
+
+    GLint samplesPerPixel = 0;
+    glGetIntegerv(GL_SAMPLES, &samplesPerPixel);
+    overdrawTargetSamples = (double)width * height * std::max(samplesPerPixel, 1);
+
+    glBeginQuery(GL_SAMPLES_PASSED, overdrawQuery);
+    overdrawQueryPending = true;
+    return true;
+}
+
+void Renderer::RecordPackets(const std::vector<DrawPacket>& packets, bool allowInstancing)
+{
+    // Selected meshes share a layer, so the stencil state flips at most twice per queue
+    int stencilState = -1;
+    ComponentMaterial* boundMaterial = nullptr;
+    sceneCommands->BindMaterial(0, nullptr);
+
+    size_t first = 0;
+    while (first < packets.size())
+    {
+        const RenderObject& renderObject = drawObjects[packets[first].index];
         ComponentMesh* meshComp = renderObject.mesh;
 
-        if (meshComp->GetDrawNormals()) normalsList.push_back(renderObject);
-        if (meshComp->GetDrawMesh()) meshLinesList.push_back(renderObject);
-        if (meshComp->owner->IsSelected()) {
-            stencilList.push_back(renderObject);
-            glStencilFunc(GL_ALWAYS, 1, 0xFF);
-            glStencilMask(0xFF);
+        // Packets are sorted by state, so draws that can share an instanced draw are adjacent
+        size_t last = first + 1;
+        if (allowInstancing)
+        {
+            size_t maxCount = (size_t)(kInstancesPerRegion - instanceCursor);
+            while (last < packets.size() && last - first < maxCount &&
+                CanInstanceTogether(renderObject, drawObjects[packets[last].index]))
+            {
+                ++last;
+            }
         }
-        else {
-            glStencilFunc(GL_ALWAYS, 0, 0xFF);
-            glStencilMask(0x00);
+
+        for (size_t i = first; i < last; ++i)
+        {
+            CollectDebugLists(drawObjects[packets[i].index]);
         }
 
-        ComponentMaterial* materialComp = meshComp->GetAttachedMaterial();
-        materialComp->Use();
+        RecordDrawState(renderObject, stencilState, boundMaterial);
 
-        GLint currentProgram;
-        glGetIntegerv(GL_CURRENT_PROGRAM, &currentProgram);
-        glUniform3fv(glGetUniformLocation(currentProgram, "lightDir"), 1, glm::value_ptr(lightDir));
-        glUniform3fv(glGetUniformLocation(currentProgram, "viewPos"), 1, glm::value_ptr(camera->position));
+        if (writingObjectIDs) {
+            // Instances add their offset in the batch to the first ID
+            sceneCommands->SetDrawID((uint32_t)pickingIDs.size());
+            for (size_t i = first; i < last; ++i) {
+                pickingIDs.push_back(drawObjects[packets[i].index].mesh->owner->GetUID());
+            }
+        }
 
-        glUniform1i(glGetUniformLocation(currentProgram, "texture1"), 0);
-        glUniform1i(glGetUniformLocation(currentProgram, "hasTexture"), true);
-        glUniformMatrix4fv(glGetUniformLocation(currentProgram, "model"), 1, GL_FALSE, glm::value_ptr(renderObject.globalModelMatrix));
+        if (last - first == 1)
+        {
+            sceneCommands->SetModel(renderObject.globalModelMatrix);
+            RecordMesh(meshComp, renderObject.lod);
+        }
+        else
+        {
+            uint32_t base = sceneCommands->GetInstanceCount();
+            for (size_t i = first; i < last; ++i)
+            {
+                const RenderObject& object = drawObjects[packets[i].index];
+                sceneCommands->AddInstance(object.globalModelMatrix, object.normalMatrix);
+            }
+            instanceCursor += (int)(last - first);
 
-        if (materialComp) {
-            glUniform3fv(glGetUniformLocation(currentProgram, "materialDiffuse"), 1, glm::value_ptr(materialComp->GetDiffuseColor()));
-            glUniform1f(glGetUniformLocation(currentProgram, "opacity"), materialComp->GetOpacity());
+            RecordMeshInstanced(meshComp, renderObject.lod, base, (uint32_t)(last - first));
         }
 
-        DrawMesh(meshComp);
+        first = last;
     }
 }
 
-void Renderer::DrawParticlesList(const CameraLens* camera)
+void Renderer::RecordMultiIndirect(const std::vector<DrawPacket>& packets)
 {
-    if (particlesList.empty()) return;
+    // Slots follow the instances the buffer already holds, one instance per draw
+    indirectBuilder.Clear(sceneCommands->GetInstanceCount());
+    indirectLODs.clear();
+    indirectBatchObjects.clear();
+    indirectBatchPickIDs.clear();
+
+    // Build the commands, batches break wherever the render state changes
+    for (const DrawPacket& packet : packets)
+    {
+        const RenderObject& renderObject = drawObjects[packet.index];
+        ComponentMesh* meshComp = renderObject.mesh;
 
-    glUseProgram(0);
+        // UploadArenaMeshes copied what fits before recording started
+        bool full = instanceCursor + (int)indirectBuilder.GetInstanceCount() >= kInstancesPerRegion;
+        if (meshComp->HasSkinning() || full || !meshComp->GetMesh().arenaRange.IsValid())
+        {
+            indirectFallback.push_back(packet);
+            continue;
+        }
 
-    glMatrixMode(GL_PROJECTION);
-    glPushMatrix();
-    glLoadMatrixf(glm::value_ptr(camera->GetProjectionMatrix()));
+        if (indirectBatchObjects.empty() || !SameDrawState(*indirectBatchObjects.back(), renderObject))
+        {
+            indirectBuilder.BeginBatch();
+            indirectBatchObjects.push_back(&renderObject);
+            indirectBatchPickIDs.push_back((GLuint)pickingIDs.size());
+        }
+
+        const Mesh& mesh = meshComp->GetMesh();
+        const ArenaRange& range = mesh.arenaRange;
+        indirectBuilder.AddDraw(range.firstIndex + mesh.GetLODFirstIndex(renderObject.lod),
+            mesh.GetLODIndexCount(renderObject.lod), range.baseVertex);
+        if (indirectBuilder.GetCommands().size() > indirectLODs.size()) indirectLODs.push_back((uint8_t)renderObject.lod);
+        sceneCommands->AddInstance(renderObject.globalModelMatrix, renderObject.normalMatrix);
+
+        CollectDebugLists(renderObject);
+        if (writingObjectIDs) pickingIDs.push_back(meshComp->owner->GetUID());
+    }
+
+    instanceCursor += (int)indirectBuilder.GetInstanceCount();
 
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
-    glLoadMatrixf(glm::value_ptr(camera->GetViewMatrix()));
+    const std::vector<DrawElementsIndirectCommand>& commands = indirectBuilder.GetCommands();
+    if (commands.empty()) return;
 
-    for (const auto& pair : particlesList)
+    uint32_t firstCommand = sceneCommands->AddIndirectCommands(commands, indirectLODs);
+
+    int stencilState = -1;
+    ComponentMaterial* boundMaterial = nullptr;
+    sceneCommands->BindMaterial(0, nullptr);
+
+    const std::vector<IndirectBatch>& batches = indirectBuilder.GetBatches();
+    for (size_t i = 0; i < batches.size(); ++i)
     {
-        // Aplicar la matriz de modelo de la entidad (si es LOCAL)
-        glMatrixMode(GL_MODELVIEW);
-        glPushMatrix();
-        glMultMatrixf(glm::value_ptr(pair.second.modelMatrix));
+        const IndirectBatch& batch = batches[i];
+
+        RecordDrawState(*indirectBatchObjects[i], stencilState, boundMaterial);
+        if (writingObjectIDs) sceneCommands->SetDrawID(indirectBatchPickIDs[i]);
+        sceneCommands->DrawIndirect(firstCommand + batch.firstCommand, batch.commandCount, batch.firstInstance);
+    }
+}
 
-        pair.second.system->GetEmitter()->Draw(camera->position);
+void Renderer::RecordDrawState(const RenderObject& renderObject, int& stencilState, ComponentMaterial*& boundMaterial)
+{
+    int selected = renderObject.mesh->owner->IsSelected() ? 1 : 0;
+    if (selected != stencilState) {
+        sceneCommands->SetStencil(selected, selected ? 0xFF : 0x00);
+        stencilState = selected;
+    }
+
+    // Texture and MaterialData only change between materials
+    ComponentMaterial* materialComp = renderObject.mesh->GetAttachedMaterial();
+    if (materialComp != boundMaterial) {
+        if (materialComp)
+        {
+            MaterialUniformData materialData = materialComp->GetUniformData();
+            sceneCommands->BindMaterial(materialComp->GetTextureID(), &materialData, materialComp->GetUniformSlot());
+        }
+        else sceneCommands->BindMaterial(0, nullptr);
+        boundMaterial = materialComp;
+    }
+}
+
+void Renderer::RecordMesh(const ComponentMesh* meshComp, int lod)
+{
+    const Mesh& mesh = meshComp->GetMesh();
+    if (mesh.VAO == 0) return;
 
-        glPopMatrix();
+    lod = std::min(lod, mesh.GetLODCount() - 1);
+
+    bool skinned = meshComp->HasSkinning();
+    if (skinned)
+    {
+        const ComponentSkinnedMesh* skinnedComp = (const ComponentSkinnedMesh*)meshComp;
+        sceneCommands->SetSkinning(skinnedComp->GetSSBOGlobal(), skinnedComp->GetSSBOOffset(), skinnedComp->GetMeshInverse(),
+            skinnedComp->GetBoneMatrices());
     }
 
-    // 3. Restaurar matrices
-    glMatrixMode(GL_PROJECTION);
-    glPopMatrix();
-    glMatrixMode(GL_MODELVIEW);
-    glPopMatrix();
+    sceneCommands->Draw(mesh.VAO, mesh.GetLODIndexCount(lod), mesh.GetLODFirstIndex(lod), skinned, lod);
 }
 
-void Renderer::DrawCanvasList(const CameraLens* camera)
+void Renderer::RecordMeshInstanced(const ComponentMesh* meshComp, int lod, uint32_t instanceBase, uint32_t instanceCount)
 {
-    if (canvasList.empty()) return;
+    const Mesh& mesh = meshComp->GetMesh();
+    if (mesh.VAO == 0) return;
 
-    // Asegurarse de renderizar en el FBO correcto
-    glBindFramebuffer(GL_FRAMEBUFFER, (camera->fboID != 0) ? camera->fboID : 0);
-    glViewport(0, 0, camera->textureWidth, camera->textureHeight);
+    sceneCommands->DrawInstanced(mesh.VAO, mesh.GetLODIndexCount(lod), mesh.GetLODFirstIndex(lod), instanceBase, instanceCount, lod);
+}
 
-    glDisable(GL_DEPTH_TEST);
-    glDisable(GL_CULL_FACE);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+void Renderer::CollectDebugLists(const RenderObject& renderObject)
+{
+    ComponentMesh* meshComp = renderObject.mesh;
 
-    uiShader->Use();
-    glBindVertexArray(quadVAO);
+    if (meshComp->GetDrawNormals()) normalsList.push_back(renderObject);
+    if (meshComp->GetDrawMesh()) meshLinesList.push_back(renderObject);
+    if (meshComp->owner->IsSelected()) stencilList.push_back(renderObject);
+}
+
+void Renderer::RecordParticles(const CameraLens* camera)
+{
+    if (particlesList.empty()) return;
+
+    // Emitters far to near, the Matrices block already holds this camera
+    glm::mat4 view = camera->GetViewMatrix();
+    particleBatch.Clear();
+    for (auto it = particlesList.rbegin(); it != particlesList.rend(); ++it)
+    {
+        particleRenderer->Pack(*it->second.system->GetEmitter(), it->second.modelMatrix, view, particleBatch);
+    }
+    if (particleBatch.emitters.empty()) return;
+
+    sceneCommands->RunPass([this, batch = particleBatch]() {
+        particleRenderer->Draw(batch);
+        GLState::UseProgram(0);
 
+        replayStats.particleDrawCalls += (int)batch.emitters.size();
+        replayStats.particles += (int)batch.instances.size();
+    });
+}
+
+void Renderer::RecordCanvasList(const CameraLens* camera)
+{
+    if (canvasList.empty()) return;
+
+    // Views are updated and their trees taken here, the replay renders them into their textures
+    int width = camera->textureWidth;
+    int height = camera->textureHeight;
     for (CanvasObject& canvasObject : canvasList)
     {
         ComponentCanvas* c = canvasObject.canvas;
-        c->Resize(camera->textureWidth, camera->textureHeight);
+        c->Resize(width, height);
         c->Update();
-        c->RenderToTexture();
+        canvasObject.render = c->PrepareRender();
+        canvasObject.loaded = c->IsLoaded();
+        canvasObject.opacity = c->GetOpacity();
+    }
 
-        glBindFramebuffer(GL_FRAMEBUFFER, (camera->fboID != 0) ? camera->fboID : 0);
-        glViewport(0, 0, camera->textureWidth, camera->textureHeight);
+    GLuint fbo = camera->fboID;
+    sceneCommands->RunPass([this, canvases = canvasList, fbo, width, height]() {
+        // Asegurarse de renderizar en el FBO correcto
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glViewport(0, 0, width, height);
 
-        // Restaurar TODO el estado que Noesis rompe
-        glUseProgram(0);
-        glBindVertexArray(0);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, 0);
+        GLState::Disable(GL_DEPTH_TEST);
+        GLState::Disable(GL_CULL_FACE);
+        GLState::Enable(GL_BLEND);
+        GLState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
         uiShader->Use();
-        glBindVertexArray(quadVAO);  // ? Re-bindear despus de limpiar
+        GLState::BindVertexArray(quadVAO);
+
+        for (const CanvasObject& canvasObject : canvases)
+        {
+            ComponentCanvas* c = canvasObject.canvas;
+            c->RenderToTexture(width, height, canvasObject.render);
+            if (canvasObject.render) replayStats.canvasRenders++;
+            else if (canvasObject.loaded) replayStats.canvasRendersSkipped++;
 
-        glBindTexture(GL_TEXTURE_2D, c->GetTextureID());
-        uiShader->SetInt("uTexture", 0);
-        uiShader->SetFloat("uOpacity", c->GetOpacity());
+            glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+            glViewport(0, 0, width, height);
 
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        glDisable(GL_DEPTH_TEST);
-        glDisable(GL_CULL_FACE);
+            // Restaurar TODO el estado que Noesis rompe
+            GLState::UseProgram(0);
+            GLState::BindVertexArray(0);
+            GLState::BindTextureUnit(0, 0);
 
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+            uiShader->Use();
+            GLState::BindVertexArray(quadVAO);  // ? Re-bindear despus de limpiar
+
+            GLState::BindTexture(GL_TEXTURE_2D, c->GetTextureID());
+            uiShader->SetInt("uTexture", 0);
+            uiShader->SetFloat("uOpacity", canvasObject.opacity);
+
+            GLState::Enable(GL_BLEND);
+            GLState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            GLState::Disable(GL_DEPTH_TEST);
+            GLState::Disable(GL_CULL_FACE);
+
+            glDrawArrays(GL_TRIANGLES, 0, 6);
+        }
+
+        GLState::Enable(GL_DEPTH_TEST);
+        GLState::Disable(GL_BLEND);
+        GLState::BindVertexArray(0);
+        GLState::UseProgram(0);
+    });
+}
+
+std::vector<Renderer::OverlayMesh> Renderer::MakeOverlayMeshes(const std::vector<RenderObject>& objects) const
+{
+    std::vector<OverlayMesh> overlays;
+    overlays.reserve(objects.size());
+
+    for (const RenderObject& renderObject : objects)
+    {
+        const ComponentMesh* meshComp = renderObject.mesh;
+        const Mesh& mesh = meshComp->GetMesh();
+
+        OverlayMesh overlay;
+        overlay.model = renderObject.globalModelMatrix;
+        overlay.vao = mesh.VAO;
+        overlay.lod = std::min(renderObject.lod, mesh.GetLODCount() - 1);
+        overlay.indexCount = mesh.GetLODIndexCount(overlay.lod);
+        overlay.firstIndex = mesh.GetLODFirstIndex(overlay.lod);
+        overlay.vertexCount = (uint32_t)mesh.GetVertexCount();
+
+        if (meshComp->HasSkinning())
+        {
+            const ComponentSkinnedMesh* skinned = (const ComponentSkinnedMesh*)meshComp;
+            overlay.skinned = true;
+            overlay.ssboGlobal = skinned->GetSSBOGlobal();
+            overlay.ssboOffset = skinned->GetSSBOOffset();
+            overlay.meshInverse = skinned->GetMeshInverse();
+        }
+
+        overlays.push_back(overlay);
     }
 
-    glEnable(GL_DEPTH_TEST);
-    glDisable(GL_BLEND);
-    glBindVertexArray(0);
-    glUseProgram(0);
+    return overlays;
 }
-void Renderer::DrawStencilList(const CameraLens* camera)
+
+void Renderer::DrawStencilList(const std::vector<OverlayMesh>& meshes, const glm::mat4& view, const glm::mat4& projection)
 {
-    if (stencilList.empty()) return;
+    if (meshes.empty()) return;
 
     GLboolean depthWriteEnabled;
     glGetBooleanv(GL_DEPTH_WRITEMASK, &depthWriteEnabled);
 
-    glEnable(GL_STENCIL_TEST);
-    glDisable(GL_CULL_FACE);
+    GLState::Enable(GL_STENCIL_TEST);
+    GLState::Disable(GL_CULL_FACE);
 
-    for (RenderObject renderObject : stencilList)
+    for (const OverlayMesh& mesh : meshes)
     {
-        ComponentMesh* meshComp = renderObject.mesh;
-
         glClear(GL_STENCIL_BUFFER_BIT);
 
 
-        glStencilFunc(GL_ALWAYS, 1, 0xFF);
-        glStencilMask(0xFF);
-        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        GLState::StencilFunc(GL_ALWAYS, 1, 0xFF);
+        GLState::StencilMask(0xFF);
+        GLState::ColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
 
-        glDisable(GL_DEPTH_TEST);
-        glDepthMask(GL_FALSE);
+        GLState::Disable(GL_DEPTH_TEST);
+        GLState::DepthMask(GL_FALSE);
 
         defaultShader->Use();
-        glUniformMatrix4fv(glGetUniformLocation(defaultShader->GetProgramID(), "model"), 1, GL_FALSE, glm::value_ptr(renderObject.globalModelMatrix));
-        DrawMesh(meshComp);
+        glUniformMatrix4fv(defaultUniforms.model, 1, GL_FALSE, glm::value_ptr(mesh.model));
+        DrawMesh(mesh, defaultUniforms);
 
-        glStencilFunc(GL_NOTEQUAL, 1, 0xFF);
-        glStencilMask(0x00);
-        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        GLState::StencilFunc(GL_NOTEQUAL, 1, 0xFF);
+        GLState::StencilMask(0x00);
+        GLState::ColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
 
-        glDisable(GL_DEPTH_TEST);
+        GLState::Disable(GL_DEPTH_TEST);
 
         outlineShader->Use();
-        glUniformMatrix4fv(outlineUniforms.projection, 1, GL_FALSE, glm::value_ptr(camera->GetProjectionMatrix()));
-        glUniformMatrix4fv(outlineUniforms.view, 1, GL_FALSE, glm::value_ptr(camera->GetViewMatrix()));
-        glUniformMatrix4fv(outlineUniforms.model, 1, GL_FALSE, glm::value_ptr(renderObject.globalModelMatrix));
+        glUniformMatrix4fv(outlineUniforms.projection, 1, GL_FALSE, glm::value_ptr(projection));
+        glUniformMatrix4fv(outlineUniforms.view, 1, GL_FALSE, glm::value_ptr(view));
+        glUniformMatrix4fv(outlineUniforms.model, 1, GL_FALSE, glm::value_ptr(mesh.model));
 
         outlineShader->SetVec3("outlineColor", glm::vec3(1.0f, 0.41f, 0.71f));
         outlineShader->SetFloat("outlineThickness", 0.04f);
 
-        DrawMesh(meshComp);
+        DrawMesh(mesh, outlineUniforms);
     }
 
-    glDepthMask(depthWriteEnabled);
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_CULL_FACE);
-    glDisable(GL_STENCIL_TEST);
+    GLState::DepthMask(depthWriteEnabled);
+    GLState::Enable(GL_DEPTH_TEST);
+    GLState::Enable(GL_CULL_FACE);
+    GLState::Disable(GL_STENCIL_TEST);
 }
 
-void Renderer::DrawNormalsList(const CameraLens* camera)
+void Renderer::DrawNormalsList(const std::vector<OverlayMesh>& meshes)
 {
-    if (normalsList.empty()) return;
+    if (meshes.empty()) return;
 
-    glEnable(GL_DEPTH_TEST);
-    glDisable(GL_BLEND);
+    GLState::Enable(GL_DEPTH_TEST);
+    GLState::Disable(GL_BLEND);
 
     normalsShader->Use();
     normalsShader->SetVec4("lineColor", glm::vec4(0.0f, 1.0f, 1.0f, 1.0f));
 
-    for (RenderObject renderObject : normalsList)
+    for (const OverlayMesh& mesh : meshes)
     {
-        ComponentMesh* meshComp = renderObject.mesh;
-
-        glUniformMatrix4fv(glGetUniformLocation(normalsShader->GetProgramID(), "model"),
-            1, GL_FALSE, glm::value_ptr(renderObject.globalModelMatrix));
+        normalsShader->SetMat4("model", mesh.model);
 
-        if (meshComp->HasSkinning())
+        if (mesh.skinned)
         {
-            ComponentSkinnedMesh* skinned = (ComponentSkinnedMesh*)meshComp;
-            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, skinned->GetSSBOGlobal());
-            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, skinned->GetSSBOOffset());
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, mesh.ssboGlobal);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, mesh.ssboOffset);
             normalsShader->SetBool("hasBones", true);
-            normalsShader->SetMat4("meshInverse", skinned->GetMeshInverse());
+            normalsShader->SetMat4("meshInverse", mesh.meshInverse);
         }
         else
         {
             normalsShader->SetBool("hasBones", false);
         }
 
-        glBindVertexArray(meshComp->GetMesh().VAO);
-        glDrawArrays(GL_POINTS, 0, (GLsizei)meshComp->GetMesh().vertices.size());
+        GLState::BindVertexArray(mesh.vao);
+        glDrawArrays(GL_POINTS, 0, (GLsizei)mesh.vertexCount);
 
-        glBindVertexArray(0);
+        GLState::BindVertexArray(0);
     }
 }
 
-void Renderer::DrawMeshLinesList(const CameraLens* camera)
+void Renderer::DrawMeshLinesList(const std::vector<OverlayMesh>& meshes)
 {
-    if (meshLinesList.empty()) return;
+    if (meshes.empty()) return;
 
     meshShader->Use();
     meshShader->SetVec4("lineColor", glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
 
-    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-    glEnable(GL_POLYGON_OFFSET_LINE);
+    GLState::PolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    GLState::Enable(GL_POLYGON_OFFSET_LINE);
     glPolygonOffset(-1.0f, -1.0f);
 
-    for (RenderObject renderObject : meshLinesList)
+    for (const OverlayMesh& mesh : meshes)
     {
-        ComponentMesh* meshComp = renderObject.mesh;
-
-        meshShader->SetMat4("model", renderObject.globalModelMatrix);
+        meshShader->SetMat4("model", mesh.model);
 
-        if (meshComp->HasSkinning()) {
-            ComponentSkinnedMesh* skinned = (ComponentSkinnedMesh*)meshComp;
-            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, skinned->GetSSBOGlobal());
-            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, skinned->GetSSBOOffset());
+        if (mesh.skinned) {
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, mesh.ssboGlobal);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, mesh.ssboOffset);
             meshShader->SetBool("hasBones", true);
-            meshShader->SetMat4("meshInverse", skinned->GetMeshInverse());
+            meshShader->SetMat4("meshInverse", mesh.meshInverse);
         }
         else {
             meshShader->SetBool("hasBones", false);
         }
 
-        glBindVertexArray(meshComp->GetMesh().VAO);
-        glDrawElements(GL_TRIANGLES, (GLsizei)meshComp->GetNumIndices(), GL_UNSIGNED_INT, 0);
+        // Wireframe of the level actually drawn
+        GLState::BindVertexArray(mesh.vao);
+        glDrawElements(GL_TRIANGLES, (GLsizei)mesh.indexCount, GL_UNSIGNED_INT,
+            (const void*)(mesh.firstIndex * sizeof(unsigned int)));
     }
 
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-    glDisable(GL_POLYGON_OFFSET_LINE);
-    glBindVertexArray(0);
+    GLState::PolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    GLState::Disable(GL_POLYGON_OFFSET_LINE);
+    GLState::BindVertexArray(0);
 }
 
 
@@ -1055,6 +2622,8 @@ bool Renderer::CleanUp()
 {
     LOG_DEBUG("Cleaning up Renderer");
 
+    renderThread->Stop();
+
     UnloadMesh(sphere);
     UnloadMesh(cylinder);
     UnloadMesh(pyramid);
@@ -1063,12 +2632,58 @@ bool Renderer::CleanUp()
     if (lineShader)     lineShader->Delete();
     if (outlineShader)  outlineShader->Delete();
     if (depthShader)    depthShader->Delete();
+    if (depthPrepassShader) depthPrepassShader->Delete();
+    if (overdrawShader) overdrawShader->Delete();
     if (waterShader)    waterShader->Delete();
     if (uiShader)       uiShader->Delete();
 
+    ShaderCache::GetInstance().CleanUp();
+    TextureStreamer::GetInstance().CleanUp();
+    UploadManager::GetInstance().CleanUp();
+    GpuProfiler::GetInstance().CleanUp();
+
+    for (GLsync& fence : instanceFences)
+    {
+        if (fence) glDeleteSync(fence);
+        fence = nullptr;
+    }
+    if (instanceBuffer != 0)
+    {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, instanceBuffer);
+        glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        glDeleteBuffers(1, &instanceBuffer);
+        instanceBuffer = 0;
+        instanceData = nullptr;
+    }
+
+    if (indirectBuffer != 0) glDeleteBuffers(1, &indirectBuffer);
+    indirectBuffer = 0;
+    if (overdrawQuery != 0) glDeleteQueries(1, &overdrawQuery);
+    overdrawQuery = 0;
+    overdrawQueryPending = false;
+    particleRenderer->CleanUp();
+    GeometryArena::GetInstance().CleanUp();
+
+    if (uboFrameData != 0) glDeleteBuffers(1, &uboFrameData);
+    if (uboDefaultMaterial != 0) glDeleteBuffers(1, &uboDefaultMaterial);
+    if (uboSceneMaterials != 0) glDeleteBuffers(1, &uboSceneMaterials);
+    uboFrameData = 0;
+    uboDefaultMaterial = 0;
+    uboSceneMaterials = 0;
+    sceneMaterialValues.clear();
+    sceneMaterialUploaded.clear();
+
+    if (lightBuffer != 0) glDeleteBuffers(1, &lightBuffer);
+    if (lightGridBuffer != 0) glDeleteBuffers(1, &lightGridBuffer);
+    if (lightIndexBuffer != 0) glDeleteBuffers(1, &lightIndexBuffer);
+    lightBuffer = 0;
+    lightGridBuffer = 0;
+    lightIndexBuffer = 0;
+
     if (quadVAO != 0)
     {
-        glDeleteVertexArrays(1, &quadVAO);
+        GLState::DeleteVertexArrays(1, &quadVAO);
         glDeleteBuffers(1, &quadVBO);
         quadVAO = 0;
         quadVBO = 0;
@@ -1076,13 +2691,13 @@ bool Renderer::CleanUp()
 
     if (normalLinesVAO != 0)
     {
-        glDeleteVertexArrays(1, &normalLinesVAO);
+        GLState::DeleteVertexArrays(1, &normalLinesVAO);
         glDeleteBuffers(1, &normalLinesVBO);
     }
 
     if (postProcessFBO != 0) {
         glDeleteFramebuffers(1, &postProcessFBO);
-        glDeleteTextures(1, &postProcessTexture);
+        GLState::DeleteTextures(1, &postProcessTexture);
         glDeleteRenderbuffers(1, &postProcessRBO);
         postProcessFBO = 0;
         postProcessTexture = 0;
@@ -1092,11 +2707,24 @@ bool Renderer::CleanUp()
     }
     if (postProcessShader) postProcessShader->Delete();
 
+    if (pickReadback.fence) glDeleteSync(pickReadback.fence);
+    if (pickReadback.pbo != 0) glDeleteBuffers(1, &pickReadback.pbo);
+    pickReadback = PickReadback();
+
     meshes.clear();
     activeCameras.clear();
     postProcessingComponents.clear();
-    opaqueList.clear();
-    transparentList.clear();
+    drawObjects.clear();
+    opaqueQueue.Clear();
+    prepassQueue.Clear();
+    lateOpaqueQueue.Clear();
+    transparentQueue.Clear();
+    renderCache.clear();
+    renderCacheIndex.clear();
+    dirtyMeshes.clear();
+    staticEntries.clear();
+    dynamicEntries.clear();
+    staticPackets.clear();
     stencilList.clear();
     normalsList.clear();
     meshLinesList.clear();
@@ -1121,7 +2749,7 @@ void Renderer::ResizePostProcessingBuffer(int width, int height)
     if (postProcessCurrentW != width || postProcessCurrentH != height) {
         glBindFramebuffer(GL_FRAMEBUFFER, postProcessFBO);
 
-        glBindTexture(GL_TEXTURE_2D, postProcessTexture);
+        GLState::BindTexture(GL_TEXTURE_2D, postProcessTexture);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -1158,16 +2786,6 @@ void Renderer::CreateSkinningSSBOs(unsigned int& ssboGlobal, unsigned int& ssboO
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 }
 
-void Renderer::UploadGlobalMatricesToGPU(unsigned int ssbo, const std::vector<glm::mat4>& globalMatrices)
-{
-    if (ssbo == 0) return;
-
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo);
-    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, globalMatrices.size() * sizeof(glm::mat4), globalMatrices.data());
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, ssbo);
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
-}
-
 void Renderer::DeleteSSBO(unsigned int& ssbo)
 {
     if (ssbo != 0)
@@ -1178,21 +2796,21 @@ void Renderer::DeleteSSBO(unsigned int& ssbo)
 }
 
 
-void Renderer::DrawLinesList(const CameraLens* camera)
+void Renderer::DrawLinesList(const std::vector<RenderLine>& lines)
 {
-    if (linesList.empty() || !camera) return;
+    if (lines.empty()) return;
 
     GLuint lineVAO, lineVBO;
     glGenVertexArrays(1, &lineVAO);
     glGenBuffers(1, &lineVBO);
 
-    glBindVertexArray(lineVAO);
+    GLState::BindVertexArray(lineVAO);
     glBindBuffer(GL_ARRAY_BUFFER, lineVBO);
 
     std::vector<float> vertexData;
-    vertexData.reserve(linesList.size() * 2 * 7);
+    vertexData.reserve(lines.size() * 2 * 7);
 
-    for (const auto& line : linesList)
+    for (const auto& line : lines)
     {
         // Punto A
         vertexData.push_back(line.start.x); vertexData.push_back(line.start.y); vertexData.push_back(line.start.z);
@@ -1203,16 +2821,15 @@ void Renderer::DrawLinesList(const CameraLens* camera)
         vertexData.push_back(line.color.r); vertexData.push_back(line.color.g); vertexData.push_back(line.color.b); vertexData.push_back(line.color.a);
     }
 
-    glEnable(GL_DEPTH_TEST);
-    glDepthMask(GL_TRUE);
-    glDisable(GL_CULL_FACE);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GLState::Enable(GL_DEPTH_TEST);
+    GLState::DepthMask(GL_TRUE);
+    GLState::Disable(GL_CULL_FACE);
+    GLState::Enable(GL_BLEND);
+    GLState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     lineShader->Use();
-    GLuint shaderProgram = lineShader->GetProgramID();
 
-    glBindVertexArray(lineVAO);
+    GLState::BindVertexArray(lineVAO);
     glBindBuffer(GL_ARRAY_BUFFER, lineVBO);
     glBufferData(GL_ARRAY_BUFFER, vertexData.size() * sizeof(float), vertexData.data(), GL_STREAM_DRAW);
 
@@ -1222,14 +2839,13 @@ void Renderer::DrawLinesList(const CameraLens* camera)
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 7 * sizeof(float), (void*)(3 * sizeof(float)));
 
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(camera->GetProjectionMatrix()));
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(camera->GetViewMatrix()));
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(glm::mat4(1.0f)));
+    // Projection and view come from the Matrices block
+    glUniformMatrix4fv(lineUniforms.model, 1, GL_FALSE, glm::value_ptr(glm::mat4(1.0f)));
 
-    glDrawArrays(GL_LINES, 0, (GLsizei)linesList.size() * 2);
+    glDrawArrays(GL_LINES, 0, (GLsizei)lines.size() * 2);
 
-    glBindVertexArray(0);
-    glUseProgram(0);
+    GLState::BindVertexArray(0);
+    GLState::UseProgram(0);
 }
 
 
@@ -1237,9 +2853,9 @@ void Renderer::SetDepthTest(bool enabled)
 {
     depthTestEnabled = enabled;
     if (enabled)
-        glEnable(GL_DEPTH_TEST);
+        GLState::Enable(GL_DEPTH_TEST);
     else
-        glDisable(GL_DEPTH_TEST);
+        GLState::Disable(GL_DEPTH_TEST);
 
     LOG_DEBUG("Depth test %s", enabled ? "enabled" : "disabled");
 }
@@ -1248,9 +2864,9 @@ void Renderer::SetFaceCulling(bool enabled)
 {
     faceCullingEnabled = enabled;
     if (enabled)
-        glEnable(GL_CULL_FACE);
+        GLState::Enable(GL_CULL_FACE);
     else
-        glDisable(GL_CULL_FACE);
+        GLState::Disable(GL_CULL_FACE);
 
     LOG_DEBUG("Face culling %s", enabled ? "enabled" : "disabled");
 }
@@ -1259,9 +2875,9 @@ void Renderer::SetWireframeMode(bool enabled)
 {
     wireframeMode = enabled;
     if (enabled)
-        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+        GLState::PolygonMode(GL_FRONT_AND_BACK, GL_LINE);
     else
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+        GLState::PolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
     LOG_DEBUG("Wireframe mode %s", enabled ? "enabled" : "disabled");
 }
@@ -1280,10 +2896,10 @@ void Renderer::SetCullFaceMode(int mode)
 
     switch (mode)
     {
-    case 0: glCullFace(GL_BACK); break;
-    case 1: glCullFace(GL_FRONT); break;
-    case 2: glCullFace(GL_FRONT_AND_BACK); break;
-    default: glCullFace(GL_BACK); break;
+    case 0: GLState::CullFace(GL_BACK); break;
+    case 1: GLState::CullFace(GL_FRONT); break;
+    case 2: GLState::CullFace(GL_FRONT_AND_BACK); break;
+    default: GLState::CullFace(GL_BACK); break;
     }
 
     const char* modeStr[] = { "Back", "Front", "Front and Back" };
@@ -1368,124 +2984,117 @@ void Renderer::UpdateViewMatrix(glm::mat4 vm) {
     glBindBuffer(GL_UNIFORM_BUFFER, 0);
 }
 
-UID Renderer::GetObjectInPixel(const CameraLens* camera, int x, int y)
-{
-    if (!camera) return 0;
-
-    GLint last_viewport[4]; glGetIntegerv(GL_VIEWPORT, last_viewport);
-    GLint last_fbo; glGetIntegerv(GL_FRAMEBUFFER_BINDING, &last_fbo);
-
-    glBindFramebuffer(GL_FRAMEBUFFER, (camera->fboID != 0) ? camera->fboID : 0);
-    glViewport(0, 0, camera->textureWidth, camera->textureHeight);
+void Renderer::UpdateFrameData(const FrameUniformData& data) {
+    glBindBuffer(GL_UNIFORM_BUFFER, uboFrameData);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniformData), &data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
 
-    UpdateViewMatrix(camera->GetViewMatrix());
-    UpdateProjectionMatrix(camera->GetProjectionMatrix());
+void Renderer::RequestPick(const CameraLens* camera, int x, int y)
+{
+    if (!camera) return;
 
-    glBindBufferBase(GL_UNIFORM_BUFFER, 0, uboMatrices);
+    // A newer request replaces one that hasn't been read back yet
+    pickRequest.camera = camera;
+    pickRequest.x = x;
+    pickRequest.y = y;
+    pickRequest.pending = true;
+}
 
-    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+bool Renderer::PollPick(UID& outUID)
+{
+    if (!pickReadback.inFlight) return false;
 
-    glEnable(GL_DEPTH_TEST);
-    glDisable(GL_BLEND);
+    GLenum status = glClientWaitSync(pickReadback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) return false;
 
-    pickingShader->Use();
-    std::map<uint32_t, UID> pickingMap;
-    uint32_t nextID = 1;
+    glDeleteSync(pickReadback.fence);
+    pickReadback.fence = nullptr;
+    pickReadback.inFlight = false;
 
-    for (ComponentMesh* meshComponent : meshes)
+    GLuint idFound = 0;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pickReadback.pbo);
+    if (const GLuint* data = (const GLuint*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, sizeof(GLuint), GL_MAP_READ_BIT))
     {
-        if (!meshComponent || !meshComponent->owner->IsActive()) continue;
+        idFound = *data;
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
 
-        Mesh& mesh = meshComponent->GetMesh();
-        if (mesh.VAO == 0) continue;
+    outUID = (idFound < pickReadback.ids.size()) ? pickReadback.ids[idFound] : 0;
+    return true;
+}
 
-        if (/*!camera->GetFrustum()->InFrustum(meshComponent->GetGlobalAABB())*/false) continue;
+void Renderer::BeginObjectIDs()
+{
+    const GLenum drawBuffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glDrawBuffers(2, drawBuffers);
 
-        UID realUID = meshComponent->owner->GetUID();
-        uint32_t currentPickingID = nextID++;
-        pickingMap[currentPickingID] = realUID;
+    const GLuint clearID[4] = { 0, 0, 0, 0 };
+    glClearBufferuiv(GL_COLOR, 1, clearID);
+}
 
-        glm::vec4 pickingColor = {
-            ((currentPickingID & 0x000000FF) >> 0) / 255.0f,
-            ((currentPickingID & 0x0000FF00) >> 8) / 255.0f,
-            ((currentPickingID & 0x00FF0000) >> 16) / 255.0f,
-            ((currentPickingID & 0xFF000000) >> 24) / 255.0f
-        };
+void Renderer::RecordPickReadback(const CameraLens* camera)
+{
+    if (!pickRequest.pending || pickRequest.camera != camera || pickReadback.inFlight) return;
+    pickRequest.pending = false;
 
-        pickingShader->SetVec4("pickingColor", pickingColor);
+    int readX = pickRequest.x;
+    int readY = camera->textureHeight - pickRequest.y;
+    if (readX < 0 || readY < 0 || readX >= camera->textureWidth || readY >= camera->textureHeight) return;
 
-        glm::mat4 model = meshComponent->owner->transform->GetGlobalMatrix();
-        pickingShader->SetMat4("model", model);
+    // The IDs of this camera's draws, the fence is set by the replay before PollPick can run
+    pickReadback.ids = pickingIDs;
+    pickReadback.inFlight = true;
 
-        if (meshComponent->HasSkinning())
+    GLuint fbo = camera->fboID;
+    sceneCommands->RunPass([this, fbo, readX, readY]() {
+        if (pickReadback.pbo == 0)
         {
-            ComponentSkinnedMesh* skinned = (ComponentSkinnedMesh*)meshComponent;
-            pickingShader->SetMat4("meshInverse", skinned->GetMeshInverse());
-            pickingShader->SetBool("hasBones", true);
-
-            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, skinned->GetSSBOGlobal());
-            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, skinned->GetSSBOOffset());
+            glGenBuffers(1, &pickReadback.pbo);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, pickReadback.pbo);
+            glBufferData(GL_PIXEL_PACK_BUFFER, sizeof(GLuint), nullptr, GL_STREAM_READ);
         }
         else
         {
-            pickingShader->SetBool("hasBones", false);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, pickReadback.pbo);
         }
 
-        glBindVertexArray(mesh.VAO);
-        glDrawElements(GL_TRIANGLES, (GLsizei)mesh.indices.size(), GL_UNSIGNED_INT, 0);
-    }
-
-    int readX = x;
-    int readY = camera->textureHeight - y;
-
-    unsigned char pixel[4];
-    glReadPixels(readX, readY, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
-
-    uint32_t idFound = (uint32_t)pixel[0] |
-        ((uint32_t)pixel[1] << 8) |
-        ((uint32_t)pixel[2] << 16) |
-        ((uint32_t)pixel[3] << 24);
-
-    UID finalUID = 0;
-    if (idFound > 0 && pickingMap.find(idFound) != pickingMap.end()) {
-        finalUID = pickingMap[idFound];
-    }
-
-    glBindFramebuffer(GL_FRAMEBUFFER, last_fbo);
-    glViewport(last_viewport[0], last_viewport[1], last_viewport[2], last_viewport[3]);
-    glEnable(GL_BLEND);
-    glUseProgram(0);
-    glBindVertexArray(0);
+        // Queued copy into the PBO, the CPU only touches it after the fence signals
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+        glReadBuffer(GL_COLOR_ATTACHMENT1);
+        glReadPixels(readX, readY, 1, 1, GL_RED_INTEGER, GL_UNSIGNED_INT, 0);
+        glReadBuffer(GL_COLOR_ATTACHMENT0);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
 
-    return finalUID;
+        pickReadback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    });
 }
 
 void Renderer::SetMSAA(bool enabled) {
     msaaEnabled = enabled;
     if (msaaEnabled)
-        glEnable(GL_MULTISAMPLE);
+        GLState::Enable(GL_MULTISAMPLE);
     else
-        glDisable(GL_MULTISAMPLE);
+        GLState::Disable(GL_MULTISAMPLE);
 }
 
 void Renderer::DrawFullscreenTexture(unsigned int textureID)
 {
-    glDisable(GL_DEPTH_TEST);
-    glDisable(GL_CULL_FACE);
+    GLState::Disable(GL_DEPTH_TEST);
+    GLState::Disable(GL_CULL_FACE);
 
     uiShader->Use();
 
     uiShader->SetFloat("uOpacity", 1.0f);
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, textureID);
+    GLState::BindTextureUnit(0, textureID);
     uiShader->SetInt("uTexture", 0);
 
-    glBindVertexArray(quadVAO);
+    GLState::BindVertexArray(quadVAO);
     glDrawArrays(GL_TRIANGLES, 0, 6);
 
-    glBindVertexArray(0);
-    glUseProgram(0);
-    glEnable(GL_DEPTH_TEST);
+    GLState::BindVertexArray(0);
+    GLState::UseProgram(0);
+    GLState::Enable(GL_DEPTH_TEST);
 }
\ No newline at end of file
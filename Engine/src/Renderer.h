@@ -8,15 +8,25 @@
 #include <memory>
 #include <map>
 #include <vector>
+#include <unordered_map>
 #include "Primitives.h"
 #include "ComponentCamera.h"
+#include "OcclusionCuller.h"
+#include "ParticleRenderer.h"
+#include "RenderQueue.h"
+#include "IndirectCommandBuilder.h"
+#include "RenderCommandBuffer.h"
+#include "RenderThread.h"
+#include "LightClusterer.h"
 
 class GameObject;
 class ComponentMesh;
+class ComponentMaterial;
 class ComponentParticleSystem;
 class CameraLens;
 class ComponentCanvas;
 class ComponentPostProcessing;
+class ComponentLight;
 
 class Renderer : public Module
 {
@@ -24,8 +34,85 @@ class Renderer : public Module
     {
         ComponentMesh* mesh;
         glm::mat4 globalModelMatrix;
+        glm::mat4 normalMatrix; // only read by instanced draws
+        int lod = 0;
+    };
+
+    // Sort key layers, drawn in this order within a queue
+    enum RenderLayer : uint32_t
+    {
+        LAYER_DEFAULT = 0,
+        LAYER_SELECTED = 1, // writes the outline stencil
+    };
+
+    static const int kLODCameras = 4;
+
+    // LOD a camera drew a mesh with last, the starting point of its hysteresis
+    struct CameraLOD
+    {
+        const CameraLens* camera = nullptr;
+        unsigned int frame = 0;
+        int lod = 0;
+    };
+
+    // Persistent per-mesh draw data, refreshed only when the mesh or its transform changes
+    struct RenderCacheEntry
+    {
+        ComponentMesh* mesh = nullptr;
+        glm::mat4 globalModelMatrix = glm::mat4(1.0f);
+        glm::mat4 normalMatrix = glm::mat4(1.0f);
+        AABB globalAABB;
+        glm::vec3 center = glm::vec3(0.0f);
+        unsigned int lastChangedFrame = 0;
+        bool valid = false;
+        bool dirty = true;
+        bool listedStatic = false;
+        bool listedDynamic = false;
+        CameraLOD lods[kLODCameras];    // the least recent camera gives its slot away
+    };
+
+    // What a static mesh was queued with, outside of its cache entry
+    struct StaticDrawState
+    {
+        UID texture = 0;
+        uint32_t flags = 0;
+    };
+
+    // The static list keyed and sorted for one camera. Reused until the camera moves, the list
+    // is rebuilt or the draw state of one of its meshes changes
+    struct StaticPackets
+    {
+        const CameraLens* camera = nullptr;
+        glm::mat4 view = glm::mat4(1.0f);
+        glm::mat4 projection = glm::mat4(1.0f);
+        int screenHeight = 0;
+        uint32_t settings = 0;          // switches that change how meshes are queued
+        unsigned int listVersion = 0;
+        unsigned int builtFrame = 0;
+        unsigned int lastUsedFrame = 0;
+        bool built = false;
+
+        std::vector<StaticDrawState> drawStates;    // one per static entry
+        std::vector<ComponentMesh*> occluders;      // frameOccluders the packets were culled with
+        std::vector<RenderObject> objects;          // first part of drawObjects
+        std::vector<DrawPacket> opaque, prepass, lateOpaque, transparent;
+        std::vector<std::pair<UID, float>> textureUsage;    // reported again every frame
     };
    
+    // Per-draw uniform locations of the mesh shaders, everything else comes from uniform buffers
+    struct ShaderUniforms
+    {
+        GLint projection = -1;
+        GLint view = -1;
+        GLint model = -1;
+        GLint texture1 = -1;
+        GLint hasBonesLoc = -1;
+        GLint meshInverseLoc = -1;
+        GLint drawID = -1;
+        GLint useInstancing = -1;
+        GLint instanceBase = -1;
+    };
+
     struct ParticleObject
     {
         ComponentParticleSystem* system;
@@ -35,6 +122,33 @@ class Renderer : public Module
     struct CanvasObject
     {
         ComponentCanvas* canvas;
+        bool render = false;    // PrepareRender took the view, the replay renders it
+        bool loaded = false;
+        float opacity = 1.0f;
+    };
+
+    // A mesh of the debug lists as plain values, so the overlays are drawn without the component
+    struct OverlayMesh
+    {
+        glm::mat4 model = glm::mat4(1.0f);
+        glm::mat4 meshInverse = glm::mat4(1.0f);
+        GLuint vao = 0;
+        uint32_t indexCount = 0;    // of the level drawn
+        uint32_t firstIndex = 0;
+        uint32_t vertexCount = 0;
+        GLuint ssboGlobal = 0;
+        GLuint ssboOffset = 0;
+        bool skinned = false;
+        int lod = 0;
+    };
+
+    // Uniform sets the scene backend draws a recorded list with
+    enum UniformSet : uint32_t
+    {
+        UNIFORMS_DEFAULT = 0,
+        UNIFORMS_ZBUFFER,
+        UNIFORMS_OVERDRAW,
+        UNIFORMS_PREPASS,   // depth only, counted apart
     };
 
     struct RenderLine {
@@ -60,7 +174,7 @@ public:
     
     void AddMesh(ComponentMesh* mesh);
     void RemoveMesh(ComponentMesh* mesh);
-    void DrawMesh(const ComponentMesh* meshComp);
+    void MarkMeshDirty(ComponentMesh* mesh); // transform or mesh data changed
     
     // Particles management
     void AddParticle(ComponentParticleSystem* particle);
@@ -78,11 +192,18 @@ public:
     void AddPostProcessing(ComponentPostProcessing* component);
     void RemovePostProcessing(ComponentPostProcessing* component);
 
-    // Scene Rendering
+    // Light management, point and spot lights are shaded per cluster
+    void AddLight(ComponentLight* light);
+    void RemoveLight(ComponentLight* light);
+
+    // Material slots of the persistent MaterialData buffer, only bookkeeping, no GL calls
+    unsigned int AcquireMaterialSlot();
+    void ReleaseMaterialSlot(unsigned int slot);
+
+    // Scene Rendering. The camera is recorded into a frame command buffer and replayed
     bool RenderScene(CameraLens* renderCamera);
 
     void CreateSkinningSSBOs(unsigned int& ssboGlobal, unsigned int& ssboOffset, const std::vector<glm::mat4>& offsets);
-    void UploadGlobalMatricesToGPU(unsigned int ssbo, const std::vector<glm::mat4>& globalMatrices);
     void DeleteSSBO(unsigned int& ssbo);
 
     // Shader access
@@ -117,6 +238,82 @@ public:
     bool IsShowingZBuffer() const { return showZBuffer; }
     void SetShowZBuffer(bool show) { showZBuffer = show; }
 
+    // Overdraw visualization, every shaded fragment adds to its pixel. The opaque passes of the
+    // debug camera are measured as shaded samples per sample of the target
+    bool IsShowingOverdraw() const { return showOverdraw; }
+    void SetShowOverdraw(bool show) { showOverdraw = show; }
+    float GetOpaqueOverdraw() const { return opaqueOverdraw; }
+
+    // Opaque meshes lay down depth from a position only stream first, then shade with GL_EQUAL
+    bool IsDepthPrepassEnabled() const { return depthPrepassEnabled; }
+    void SetDepthPrepass(bool enabled) { depthPrepassEnabled = enabled; }
+
+    // Occlusion culling
+    bool IsOcclusionCullingEnabled() const { return occlusionCullingEnabled; }
+    void SetOcclusionCulling(bool enabled) { occlusionCullingEnabled = enabled; }
+
+    // Pick large opaque meshes as occluders on top of the ones flagged in the inspector
+    bool IsAutoOccludersEnabled() const { return autoOccluders; }
+    void SetAutoOccluders(bool enabled) { autoOccluders = enabled; }
+
+    int GetOccluderTriangleBudget() const { return occluderTriangleBudget; }
+    void SetOccluderTriangleBudget(int budget) { occluderTriangleBudget = budget; }
+
+    const OcclusionCuller::Stats& GetOcclusionStats() const { return occlusionCuller->GetStats(); }
+    float GetOcclusionTimeMs() const { return occlusionTimeMs; }
+
+    // Render list stats
+    float GetBuildListsTimeMs() const { return buildListsTimeMs; }
+    int GetStaticRenderObjectCount() const { return (int)staticEntries.size(); }
+    int GetDynamicRenderObjectCount() const { return (int)dynamicEntries.size(); }
+
+    // Logs sort + submit timings of the radix render queue against a std::multimap
+    void BenchmarkRenderQueue();
+    // Logs the CPU time of binning 64 to 1024 random lights into the clusters
+    void BenchmarkLightClustering();
+
+    // Opaque draws sharing mesh and material state are merged into one instanced draw
+    bool IsInstancingEnabled() const { return instancingEnabled; }
+    void SetInstancing(bool enabled) { instancingEnabled = enabled; }
+
+    // Opaque static meshes are copied into a shared geometry arena and drawn with
+    // glMultiDrawElementsIndirect, one call per material batch
+    bool IsMultiDrawIndirectEnabled() const { return multiDrawEnabled; }
+    void SetMultiDrawIndirect(bool enabled);
+
+    // With more than one camera, each camera replays on a thread holding the GL context while
+    // the next one is recorded. Off, or when the thread can't take the context, cameras replay
+    // right after they are recorded
+    bool IsRenderThreadEnabled() const { return renderThreadEnabled; }
+    void SetRenderThreadEnabled(bool enabled);
+
+    // Meshes with LODs draw a simplified level picked from their projected size
+    bool IsMeshLODEnabled() const { return meshLODEnabled; }
+    void SetMeshLOD(bool enabled) { meshLODEnabled = enabled; }
+    // Level the camera drew the mesh with last, -1 if it hasn't drawn it
+    int GetDrawnLOD(const ComponentMesh* mesh, const CameraLens* camera) const;
+
+    struct RenderStats
+    {
+        int drawCalls = 0;          // mesh draws, an instanced draw counts once
+        int instancedDrawCalls = 0;
+        int instancedObjects = 0;   // meshes drawn through instanced draws
+        int indirectCommands = 0;   // commands submitted through multi-draw indirect
+        int prepassDrawCalls = 0;   // depth only draws, instanced ones count once
+        int renderCommands = 0;     // commands recorded into the scene command buffers
+        int particleDrawCalls = 0;  // one instanced draw per emitter
+        int particles = 0;
+        int canvasRenders = 0;      // canvases whose view changed and was rendered again
+        int canvasRendersSkipped = 0;   // canvases that kept their texture
+        int lights = 0;             // point and spot lights binned into clusters
+        int lightIndices = 0;       // entries of the cluster light lists
+        float lightBinTimeMs = 0.0f;
+        int lodTriangles[kMaxMeshLODs] = {};    // triangles drawn from each LOD level
+        float submitTimeMs = 0.0f;  // CPU time spent recording the opaque and transparent passes
+        int staticPacketRebuilds = 0;   // cameras whose static packets were keyed and sorted again
+    };
+    const RenderStats& GetRenderStats() const { return renderStats; }
+
     // Draw forms
     void DrawLine(const glm::vec3& start, const glm::vec3& end, const glm::vec4& color);
     void DrawArc(glm::vec3 center, glm::quat rotation, float r, int segments, glm::vec4 col, glm::vec3 axisA, glm::vec3 axisB);
@@ -127,24 +324,64 @@ public:
     // Cameras
     void UpdateProjectionMatrix(glm::mat4 projectionMatrix);
     void UpdateViewMatrix(glm::mat4 viewMatrix);
+    void UpdateFrameData(const FrameUniformData& data);
 
     // Perfect Pixel Picking
-    UID GetObjectInPixel(const CameraLens* camera, int x, int y);
+    // The debug camera writes a draw ID per pixel during the main pass.
+    // RequestPick/PollPick go through a PBO and return the result once the GPU is done,
+    // without stalling.
+    void RequestPick(const CameraLens* camera, int x, int y);
+    bool PollPick(UID& outUID);
 
 private:
 
     void ApplyRenderSettings();
 
     // Draw Functions
-    void DrawRenderList(const std::multimap<float, RenderObject>& map, const CameraLens* camera);
-    void DrawParticlesList(const CameraLens* camera);
-    void DrawLinesList(const CameraLens* camera);
-    void DrawStencilList(const CameraLens* camera);
-    void DrawNormalsList(const CameraLens* camera);
-    void DrawMeshLinesList(const CameraLens* camera);
-    void DrawCanvasList(const CameraLens* camera);
-    void DrawPostProcessing(const CameraLens* camera);
+    // False while the previous count is still in flight
+    bool BeginOverdrawQuery(int width, int height);
+    void CollectDebugLists(const RenderObject& renderObject);
+    std::vector<OverlayMesh> MakeOverlayMeshes(const std::vector<RenderObject>& objects) const;
+    void DrawMesh(const OverlayMesh& mesh, const ShaderUniforms& uniforms);
+
+    // Cameras are recorded into sceneCommands, then replayed through a SceneBackend. Only the
+    // replay makes GL calls, recording reads the scene
+    class SceneBackend;
+    void RecordScene(CameraLens* camera);
+    void ReplayCommands(const RenderCommandBuffer& commands);
+    void RecordRenderList(const RenderQueue& queue, bool allowInstancing);
+    void RecordDepthPrepass();
+    void RecordPackets(const std::vector<DrawPacket>& packets, bool allowInstancing);
+    void RecordMultiIndirect(const std::vector<DrawPacket>& packets);
+    void RecordDrawState(const RenderObject& renderObject, int& stencilState, ComponentMaterial*& boundMaterial);
+    void RecordMesh(const ComponentMesh* meshComp, int lod);
+    void RecordMeshInstanced(const ComponentMesh* meshComp, int lod, uint32_t instanceBase, uint32_t instanceCount);
+    void RecordDepthPackets(const std::vector<DrawPacket>& packets);
+    static bool SameDrawState(const RenderObject& a, const RenderObject& b);
+    static bool CanInstanceTogether(const RenderObject& a, const RenderObject& b);
+    void CacheUniforms(const Shader& shader, ShaderUniforms& uniforms);
+    void RecordParticles(const CameraLens* camera);
+    void RecordCanvasList(const CameraLens* camera);
+    void RecordPostProcessing(const CameraLens* camera);
+    void RecordPickReadback(const CameraLens* camera);
+    void DrawLinesList(const std::vector<RenderLine>& lines);
+    void DrawStencilList(const std::vector<OverlayMesh>& meshes, const glm::mat4& view, const glm::mat4& projection);
+    void DrawNormalsList(const std::vector<OverlayMesh>& meshes);
+    void DrawMeshLinesList(const std::vector<OverlayMesh>& meshes);
     void BuildRenderLists(const CameraLens* camera);
+    // Bins the lights for the camera and records the upload of the cluster buffers
+    void UpdateLights(CameraLens* camera, int width, int height);
+    void UploadLights(const std::vector<LightData>& data, const std::vector<LightCluster>& clusters,
+        const std::vector<uint32_t>& indices);
+    void UpdateRenderCache();
+    // Copies the meshes multi-draw can reach into the geometry arena before any camera is recorded
+    void UploadArenaMeshes();
+    void RebuildStaticEntries();
+    int SelectLOD(RenderCacheEntry& entry, const CameraLens* camera, float screenSize);
+    StaticDrawState GetStaticDrawState(ComponentMesh* mesh, bool depthPrepass) const;
+    bool CanReuseStaticPackets(const StaticPackets& cache, const CameraLens* camera, uint32_t settings, bool depthPrepass) const;
+    void RasterizeOccluders(const CameraLens* camera);
+    void BeginObjectIDs();
 
     // Shaders
     std::unique_ptr<Shader> defaultShader;
@@ -152,9 +389,10 @@ private:
     std::unique_ptr<Shader> lineShader;
     std::unique_ptr<Shader> outlineShader;
     std::unique_ptr<Shader> depthShader;
+    std::unique_ptr<Shader> depthPrepassShader;
+    std::unique_ptr<Shader> overdrawShader;
     std::unique_ptr<Shader> normalsShader;
     std::unique_ptr<Shader> meshShader;
-    std::unique_ptr<Shader> pickingShader;
     std::unique_ptr<Shader> uiShader;
 
     // Default assets
@@ -177,14 +415,7 @@ private:
     size_t normalLinesCapacity = 0;
 
     // Cached uniform locations to avoid repeated lookups
-    struct ShaderUniforms {
-        GLint projection = -1;
-        GLint view = -1;
-        GLint model = -1;
-        GLint texture1 = -1;
-        GLint hasBonesLoc = -1;
-        GLint meshInverseLoc = -1;
-    } defaultUniforms, lineUniforms, outlineUniforms;
+    ShaderUniforms defaultUniforms, lineUniforms, outlineUniforms, depthUniforms, prepassUniforms, overdrawUniforms;
 
     // UI overlay quad
     GLuint quadVAO = 0;
@@ -192,9 +423,126 @@ private:
 
     // zBuffer visualization
     bool showZBuffer = false;
+
+    // Overdraw visualization. The samples query is read once available instead of waiting on it
+    bool showOverdraw = false;
+    GLuint overdrawQuery = 0;
+    bool overdrawQueryPending = false;
+    bool overdrawQueryActive = false;   // the replay began a count for the camera
+    double overdrawTargetSamples = 0.0;
+    float opaqueOverdraw = 0.0f;
+
+    bool depthPrepassEnabled = false;
+
+    // Render cache. Meshes that haven't changed for a while are "static": their
+    // entries are not refreshed and the lists are only rebuilt when membership changes.
+    std::vector<RenderCacheEntry> renderCache;
+    std::unordered_map<ComponentMesh*, size_t> renderCacheIndex;
+    std::vector<ComponentMesh*> dirtyMeshes;
+    std::vector<size_t> staticEntries;
+    std::vector<size_t> dynamicEntries;
+    bool staticEntriesDirty = true;
+    unsigned int staticListVersion = 0; // bumped by every rebuild, packets built from an older list are stale
+    unsigned int renderFrame = 0;
+    float buildListsTimeMs = 0.0f;
+
+    // Picking
+    bool writingObjectIDs = false;
+    std::vector<UID> pickingIDs; // draw ID -> GameObject UID, 0 is the background
+
+    struct PickRequest
+    {
+        const CameraLens* camera = nullptr;
+        int x = 0;
+        int y = 0;
+        bool pending = false;
+    } pickRequest;
+
+    struct PickReadback
+    {
+        GLuint pbo = 0;
+        GLsync fence = nullptr;
+        std::vector<UID> ids; // copy of pickingIDs from the frame that was read
+        bool inFlight = false;
+    } pickReadback;
+
+    // Occlusion culling
+    std::unique_ptr<OcclusionCuller> occlusionCuller;
+    bool occlusionCullingEnabled = false;
+    bool autoOccluders = true;
+    int occluderTriangleBudget = 20000;
+    float occlusionTimeMs = 0.0f;
+    std::vector<std::pair<float, ComponentMesh*>> occluderCandidates;
+    std::vector<ComponentMesh*> frameOccluders; // sorted, occluders never test themselves
  
     // SHADERS
     unsigned int uboMatrices;
+    unsigned int uboFrameData = 0;
+    unsigned int uboDefaultMaterial = 0; // bound for meshes without a material
+    unsigned int uboSceneMaterials = 0;  // MaterialData of every material slot
+    int sceneMaterialStride = 256;       // one slot per uniform buffer offset alignment
+    std::vector<MaterialUniformData> sceneMaterialValues;   // what each slot of the buffer holds
+    std::vector<bool> sceneMaterialUploaded;
+    std::vector<unsigned int> freeMaterialSlots;
+    unsigned int materialSlotCount = 0;
+
+    // Clustered lighting, binned again for each camera
+    std::vector<ComponentLight*> lights;
+    LightClusterer lightClusterer;
+    std::vector<LightData> lightData;       // enabled lights, as the shader reads them
+    std::vector<glm::vec4> lightSpheres;    // their view space bounds
+    unsigned int lightBuffer = 0;
+    unsigned int lightGridBuffer = 0;
+    unsigned int lightIndexBuffer = 0;
+    glm::vec4 clusterScale = glm::vec4(0.0f);   // FrameData values of the last binned camera
+    glm::vec2 clusterDepth = glm::vec2(0.1f, 1000.0f);
+
+    // Hands the project's shader assets to the binary cache, built on a background context
+    void PrecompileProjectShaders();
+
+    // Instancing. The instance buffer is persistently mapped and split in regions,
+    // one per frame in flight, each guarded by a fence.
+    void CreateInstanceBuffer();
+    void BeginInstanceFrame();
+    void EndInstanceFrame();
+
+    static const int kInstanceRegions = 3;
+    static const int kInstancesPerRegion = 16384;
+
+    bool meshLODEnabled = true;
+
+    bool instancingEnabled = true;
+    unsigned int instanceBuffer = 0;
+    MeshInstanceData* instanceData = nullptr;
+    GLsync instanceFences[kInstanceRegions] = {};
+    int instanceRegion = 0;
+    int instanceCursor = 0;         // entries of the current region recorded so far
+    int instanceUploadCursor = 0;   // next free entry in the current region, advanced by the replay
+
+    // Multi-draw indirect
+    bool multiDrawEnabled = false;
+    unsigned int indirectBuffer = 0;
+    IndirectCommandBuilder indirectBuilder;
+    std::vector<const RenderObject*> indirectBatchObjects; // render state of each batch
+    std::vector<GLuint> indirectBatchPickIDs;              // first picking ID of each batch
+    std::vector<DrawPacket> indirectFallback;              // draws that can't go through the arena
+    std::vector<uint8_t> indirectLODs;                     // LOD of each command, for the stats
+
+    RenderCommandBuffer frameCommands[2];   // cameras alternate, one replays while the next records
+    int frameCommandIndex = 0;
+    RenderCommandBuffer* sceneCommands = nullptr;          // buffer of the camera being recorded
+    uint64_t frameTickets[2] = {};          // render thread job replaying each buffer
+
+    std::unique_ptr<RenderThread> renderThread;
+    bool renderThreadEnabled = true;
+    bool replayThreaded = false;            // the camera loop of this frame replays on renderThread
+    bool BeginThreadedReplay();
+    void EndThreadedReplay();
+
+    RenderStats renderStats; // last completed frame
+    RenderStats frameStats;  // frame being rendered, counted while preparing the scene
+    RenderStats replayStats; // draws of the frame being rendered, counted by the replay
+    void CollectFrameStats();
     unsigned int ssboBones;
 
     // LISTS
@@ -204,9 +552,15 @@ private:
     std::vector<CameraLens*> activeCameras;
     std::vector<ComponentPostProcessing*> postProcessingComponents;
 
-    std::multimap<float, RenderObject> opaqueList;
-    std::multimap<float, RenderObject> transparentList;
+    std::vector<RenderObject> drawObjects; // indexed by the packets of both queues
+    std::vector<StaticPackets> staticPackets;   // one per camera drawn recently
+    RenderQueue opaqueQueue;               // by state, then front to back
+    RenderQueue prepassQueue;              // depth pre-pass, front to back in bands
+    RenderQueue lateOpaqueQueue;           // opaques the pre-pass leaves out (skinned, cutout textures)
+    RenderQueue transparentQueue;          // back to front
     std::multimap<float, ParticleObject> particlesList;
+    std::unique_ptr<ParticleRenderer> particleRenderer;
+    ParticleBatch particleBatch;
     std::vector<RenderObject> stencilList;
     std::vector<RenderObject> normalsList;
     std::vector<RenderObject> meshLinesList;
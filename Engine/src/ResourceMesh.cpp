@@ -1,10 +1,16 @@
 #include "ResourceMesh.h"
 #include "MeshImporter.h"
+#include "VertexFormat.h"
+#include "Application.h"
 #include "Log.h"
 #include <glad/glad.h>
 
+MeshResidency ResourceMesh::defaultResidency = MeshResidency::RELEASE_AFTER_UPLOAD;
+size_t ResourceMesh::totalCPUBytes = 0;
+size_t ResourceMesh::totalGPUBytes = 0;
+
 ResourceMesh::ResourceMesh(UID uid)
-    : Resource(uid, Resource::MESH) {
+    : Resource(uid, Resource::MESH), residency(defaultResidency) {
 }
 
 ResourceMesh::~ResourceMesh() {
@@ -37,54 +43,14 @@ bool ResourceMesh::LoadInMemory() {
         return false;
     }
 
-    glGenVertexArrays(1, &mesh.VAO);
-    glGenBuffers(1, &mesh.VBO);
-    glGenBuffers(1, &mesh.EBO);
-
-    glBindVertexArray(mesh.VAO);
-
-    // VBO
-    glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
-    glBufferData(GL_ARRAY_BUFFER,
-        mesh.vertices.size() * sizeof(Vertex),
-        mesh.vertices.data(),
-        GL_STATIC_DRAW);
-
-    // EBO
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-        mesh.indices.size() * sizeof(unsigned int),
-        mesh.indices.data(),
-        GL_STATIC_DRAW);
-
-    // Atributos de vrtice
-    // Position
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-
-    // Normal
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-        (void*)offsetof(Vertex, normal));
-
-    // TexCoords
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-        (void*)offsetof(Vertex, texCoords));
-
-    // Bones
-    glEnableVertexAttribArray(3);
-    glVertexAttribIPointer(3, 4, GL_INT, sizeof(Vertex),
-        (void*)offsetof(Vertex, boneIDs));
-
-    // Weights
-    glEnableVertexAttribArray(4);
-    glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-        (void*)offsetof(Vertex, weights));
-
-    glBindVertexArray(0);
+    VertexFormat::Upload(mesh);
 
     loadedInMemory = true;
+    UpdateMemoryStats();
+
+    if (residency == MeshResidency::RELEASE_AFTER_UPLOAD) {
+        Application::GetInstance().resources->ScheduleCPUDataRelease(uid);
+    }
 
     return true;
 }
@@ -94,25 +60,90 @@ void ResourceMesh::UnloadFromMemory() {
         return;
     }
 
-    if (mesh.VAO != 0) {
-        glDeleteVertexArrays(1, &mesh.VAO);
-        mesh.VAO = 0;
-    }
-
-    if (mesh.VBO != 0) {
-        glDeleteBuffers(1, &mesh.VBO);
-        mesh.VBO = 0;
-    }
+    GeometryArena::GetInstance().Free(mesh);
 
-    if (mesh.EBO != 0) {
-        glDeleteBuffers(1, &mesh.EBO);
-        mesh.EBO = 0;
-    }
+    VertexFormat::Release(mesh);
 
     mesh.vertices.clear();
     mesh.indices.clear();
     mesh.textures.clear();
     mesh.bones.clear();
+    mesh.lods.clear();
 
     loadedInMemory = false;
+    cpuDataUsers = 0;
+    UpdateMemoryStats();
+}
+
+bool ResourceMesh::AcquireCPUData() {
+    if (!loadedInMemory) {
+        return false;
+    }
+
+    if (!mesh.HasCPUData()) {
+        Mesh cpuMesh = MeshImporter::LoadFromCustomFormat(uid);
+
+        if (cpuMesh.vertices.size() != mesh.gpuVertexCount || cpuMesh.lods.size() != mesh.lods.size()) {
+            LOG_CONSOLE("[ResourceMesh] ERROR: Library file no longer matches the uploaded mesh (UID: %llu)", uid);
+            return false;
+        }
+
+        mesh.vertices = std::move(cpuMesh.vertices);
+        mesh.indices = std::move(cpuMesh.indices);
+        for (size_t i = 0; i < mesh.lods.size(); i++) {
+            mesh.lods[i].indices = std::move(cpuMesh.lods[i].indices);
+        }
+
+        LOG_DEBUG("[ResourceMesh] Reloaded CPU data of mesh %llu", uid);
+        UpdateMemoryStats();
+    }
+
+    cpuDataUsers++;
+    return true;
+}
+
+void ResourceMesh::ReleaseCPUData() {
+    if (cpuDataUsers > 0) {
+        cpuDataUsers--;
+    }
+
+    TrimCPUData();
+}
+
+void ResourceMesh::TrimCPUData() {
+    if (!loadedInMemory || cpuDataUsers > 0 || residency != MeshResidency::RELEASE_AFTER_UPLOAD) {
+        return;
+    }
+
+    // Never drop data that isn't on the GPU
+    if (!mesh.IsValid() || !mesh.HasCPUData()) {
+        return;
+    }
+
+    mesh.ReleaseCPUData();
+    UpdateMemoryStats();
+}
+
+void ResourceMesh::SetResidency(MeshResidency newResidency) {
+    residency = newResidency;
+
+    if (residency == MeshResidency::KEEP_CPU && loadedInMemory && !mesh.HasCPUData()) {
+        // Reload once and keep it
+        if (AcquireCPUData()) {
+            cpuDataUsers--;
+        }
+    }
+
+    TrimCPUData();
+}
+
+void ResourceMesh::UpdateMemoryStats() {
+    totalCPUBytes -= countedCPUBytes;
+    totalGPUBytes -= countedGPUBytes;
+
+    countedCPUBytes = loadedInMemory ? mesh.GetCPUBytes() : 0;
+    countedGPUBytes = loadedInMemory ? mesh.GetGPUBytes() : 0;
+
+    totalCPUBytes += countedCPUBytes;
+    totalGPUBytes += countedGPUBytes;
 }
\ No newline at end of file
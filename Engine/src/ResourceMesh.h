@@ -1,6 +1,8 @@
 #pragma once
 
 #include "ModuleResources.h"
+#include "GeometryArena.h"
+#include "VertexFormat.h"
 #include "glm/glm.hpp"
 
 // Vertex data structure
@@ -74,20 +76,89 @@ struct Bone {
     glm::mat4 offsetMatrix;
 };
 
+// LOD 0 plus up to three simplified levels
+const int kMaxMeshLODs = 4;
+
+// Simplified index list over the same vertices as the full mesh
+struct MeshLOD {
+    std::vector<unsigned int> indices;
+    float error = 0.0f;     // simplification error relative to the mesh size
+};
+
 // Mesh container with vertex data and OpenGL buffer IDs
 struct Mesh {
     std::vector<Vertex> vertices = {};
     std::vector<unsigned int> indices = {};
     std::vector<Bone> bones = {};
     std::vector<TextureInfo> textures = {};
+    std::vector<MeshLOD> lods = {};     // LOD 1 and up, LOD 0 is indices
 
     // OpenGL buffer IDs 
     unsigned int VAO = 0;
     unsigned int VBO = 0;
+    unsigned int skinVBO = 0;           // bone ids and weights, compact layout only
     unsigned int EBO = 0;
+    unsigned int depthVAO = 0;          // position only stream for the depth pre-pass, static meshes only
+    unsigned int positionVBO = 0;
+    size_t gpuVertexBytes = 0;
+    uint64_t uploadTicket = 0;          // UploadManager ticket of the buffer contents
+
+    // Filled on upload, they outlive the CPU copy when a resource drops it
+    VertexLayout gpuLayout = VertexLayout::FULL;
+    unsigned int gpuVertexCount = 0;
+    unsigned int gpuIndexCounts[kMaxMeshLODs] = {};
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+
+    // Range in the shared geometry arena, only set once drawn through multi-draw indirect
+    ArenaRange arenaRange;
 
     bool IsValid() const { return VAO != 0; }
     bool IsSkinned() { return bones.size() != 0; }
+
+    // Vertices and indices are only guaranteed on the CPU for direct meshes, see ResourceMesh
+    bool HasCPUData() const { return !vertices.empty() && !indices.empty(); }
+    unsigned int GetVertexCount() const { return vertices.empty() ? gpuVertexCount : (unsigned int)vertices.size(); }
+    unsigned int GetIndexCount() const { return GetLODIndexCount(0); }
+
+    // The index buffer holds LOD 0 followed by every simplified level
+    int GetLODCount() const { return 1 + (int)lods.size(); }
+    unsigned int GetLODIndexCount(int lod) const {
+        const std::vector<unsigned int>& lodIndices = lod <= 0 ? indices : lods[lod - 1].indices;
+        return lodIndices.empty() ? gpuIndexCounts[lod <= 0 ? 0 : lod] : (unsigned int)lodIndices.size();
+    }
+    unsigned int GetLODFirstIndex(int lod) const {
+        unsigned int first = 0;
+        for (int i = 0; i < lod; ++i) first += GetLODIndexCount(i);
+        return first;
+    }
+    std::vector<unsigned int> GetGPUIndices() const {
+        std::vector<unsigned int> all = indices;
+        for (const MeshLOD& lod : lods) all.insert(all.end(), lod.indices.begin(), lod.indices.end());
+        return all;
+    }
+
+    size_t GetCPUBytes() const {
+        size_t bytes = vertices.size() * sizeof(Vertex) + indices.size() * sizeof(unsigned int);
+        for (const MeshLOD& lod : lods) bytes += lod.indices.size() * sizeof(unsigned int);
+        return bytes;
+    }
+    size_t GetGPUBytes() const {
+        return gpuVertexBytes + (size_t)GetLODFirstIndex(GetLODCount()) * sizeof(unsigned int);
+    }
+
+    // Frees vertices and every index list, counts and bounds stay
+    void ReleaseCPUData() {
+        std::vector<Vertex>().swap(vertices);
+        std::vector<unsigned int>().swap(indices);
+        for (MeshLOD& lod : lods) std::vector<unsigned int>().swap(lod.indices);
+    }
+};
+
+// What happens to a mesh resource's vertices and indices once they are on the GPU
+enum class MeshResidency {
+    RELEASE_AFTER_UPLOAD,   // re-read from the Library while someone holds them
+    KEEP_CPU
 };
 
 class ResourceMesh : public Resource {
@@ -100,10 +171,41 @@ public:
 
     // getters
     const Mesh& GetMesh() const { return mesh; }
-    unsigned int GetNumVertices() const { return mesh.vertices.size(); }
-    unsigned int GetNumIndices() const { return mesh.indices.size(); }
-    unsigned int GetNumTriangles() const { return mesh.indices.size() / 3; }
+    unsigned int GetNumVertices() const { return mesh.GetVertexCount(); }
+    unsigned int GetNumIndices() const { return mesh.GetIndexCount(); }
+    unsigned int GetNumTriangles() const { return mesh.GetIndexCount() / 3; }
+
+    // Physics cooking, navmesh baking, occluders and static batching read vertices on the CPU.
+    // Acquire reloads them from the Library if they were dropped, and keeps them until
+    // the matching release
+    bool AcquireCPUData();
+    void ReleaseCPUData();
+
+    // Drops the CPU copy unless it is held or the residency keeps it
+    void TrimCPUData();
+
+    void SetResidency(MeshResidency residency);
+    MeshResidency GetResidency() const { return residency; }
+
+    // Residency given to mesh resources when they are created
+    static void SetDefaultResidency(MeshResidency residency) { defaultResidency = residency; }
+    static MeshResidency GetDefaultResidency() { return defaultResidency; }
+
+    // Over every loaded mesh resource
+    static size_t GetTotalCPUBytes() { return totalCPUBytes; }
+    static size_t GetTotalGPUBytes() { return totalGPUBytes; }
 
 private:
+    void UpdateMemoryStats();
+
     Mesh mesh;  
+    MeshResidency residency;
+    int cpuDataUsers = 0;
+
+    size_t countedCPUBytes = 0;
+    size_t countedGPUBytes = 0;
+
+    static MeshResidency defaultResidency;
+    static size_t totalCPUBytes;
+    static size_t totalGPUBytes;
 };
\ No newline at end of file
@@ -49,8 +49,18 @@ bool ResourceShader::Compile() {
     if (sourceCode.empty() || !shader) return false;
 
     std::string vertexSource, fragmentSource, geometrySource;
+    if (!SplitStages(sourceCode, vertexSource, fragmentSource, geometrySource)) {
+        LOG_CONSOLE("ERROR: Shader source must contain at least vertex and fragment types");
+        return false;
+    }
+
+    const char* gSrc = geometrySource.empty() ? nullptr : geometrySource.c_str();
+    return shader->LoadFromSource(vertexSource.c_str(), fragmentSource.c_str(), gSrc);
+}
+
+bool ResourceShader::SplitStages(const std::string& source, std::string& vertexSource, std::string& fragmentSource, std::string& geometrySource) {
     std::string currentType;
-    std::stringstream ss(sourceCode);
+    std::stringstream ss(source);
     std::string line;
 
     while (std::getline(ss, line)) {
@@ -68,13 +78,7 @@ bool ResourceShader::Compile() {
         }
     }
 
-    if (vertexSource.empty() || fragmentSource.empty()) {
-        LOG_CONSOLE("ERROR: Shader source must contain at least vertex and fragment types");
-        return false;
-    }
-
-    const char* gSrc = geometrySource.empty() ? nullptr : geometrySource.c_str();
-    return shader->LoadFromSource(vertexSource.c_str(), fragmentSource.c_str(), gSrc);
+    return !vertexSource.empty() && !fragmentSource.empty();
 }
 
 void ResourceShader::SetSourceCode(const std::string& source) {
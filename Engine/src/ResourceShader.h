@@ -14,6 +14,9 @@ public:
 
     // Shader-specific
     bool Compile();
+
+    // Splits a "#type" annotated source into its stages
+    static bool SplitStages(const std::string& source, std::string& vertex, std::string& fragment, std::string& geometry);
     
     void SetSourceCode(const std::string& source);
     const std::string& GetSourceCode() const { return sourceCode; }
@@ -3,6 +3,13 @@
 #include "Log.h"
 #include <glad/glad.h>
 #include "MetaFile.h"
+#include "TextureStreamer.h"
+#include "UploadManager.h"
+#include "GLState.h"
+#include <algorithm>
+
+size_t ResourceTexture::totalGPUBytes = 0;
+size_t ResourceTexture::totalUncompressedBytes = 0;
 
 ResourceTexture::ResourceTexture(UID uid)
     : Resource(uid, Resource::TEXTURE) {
@@ -32,20 +39,22 @@ bool ResourceTexture::LoadInMemory() {
 
     LOG_DEBUG("[ResourceTexture] Loading from Library: %s", filename.c_str());
 
-    // Load texture data from custom format
-    TextureData textureData = TextureImporter::LoadFromCustomFormat(uid);
+    // Load texture data from custom format, only the small levels when streaming
+    TextureStreamer& streamer = TextureStreamer::GetInstance();
+    TextureData textureData = TextureImporter::LoadFromCustomFormat(uid, streamer.IsEnabled() ? TextureStreamer::kInitialSize : 0);
 
     if (!textureData.IsValid()) {
         LOG_DEBUG("[ResourceTexture] ERROR: Failed to load texture data");
         return false;
     }
 
-    LOG_DEBUG("[ResourceTexture] Loaded texture data: %dx%d, %d channels",
-        textureData.width, textureData.height, textureData.channels);
+    LOG_DEBUG("[ResourceTexture] Loaded texture data: %dx%d, %d channels, %s, %zu levels",
+        textureData.width, textureData.height, textureData.channels,
+        BlockCompression::GetFormatName(textureData.format), textureData.levels.size());
 
     // Create OpenGL texture
     glGenTextures(1, &gpu_id);
-    glBindTexture(GL_TEXTURE_2D, gpu_id);
+    GLState::BindTexture(GL_TEXTURE_2D, gpu_id);
 
     // Load .meta to get import settings
     MetaFile meta = MetaFileManager::LoadMeta(assetsFile);
@@ -84,22 +93,50 @@ bool ResourceTexture::LoadInMemory() {
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     }
 
-    // Upload texture data to GPU
-    GLenum format = (textureData.channels == 4) ? GL_RGBA : GL_RGB;
-    glTexImage2D(GL_TEXTURE_2D, 0, format, textureData.width, textureData.height,0, format, GL_UNSIGNED_BYTE, textureData.pixels);
+    // Upload every level read, compressed blocks go to the GPU as they are
+    width = textureData.width;
+    height = textureData.height;
+    depth = textureData.channels;
+    compression = textureData.format;
+    levels = textureData.levels;
+
+    // Textures imported without a mip chain still get one from the GPU
+    bool compressed = BlockCompression::IsCompressed(compression);
+    bool generateOnGPU = meta.uid != 0 && meta.importSettings.generateMipmaps && levels.size() == 1 && !compressed;
+
+    // Small levels go now so the texture is drawable, larger ones are staged over the next frames
+    // and lower the base level as they land. The streamer does the same with the levels it reads
+    unsigned int firstSync = (unsigned int)textureData.firstLevel;
+    if (!generateOnGPU) {
+        while (firstSync + 1 < levels.size() &&
+            std::max(levels[firstSync].width, levels[firstSync].height) > TextureStreamer::kInitialSize) {
+            firstSync++;
+        }
+    }
+
+    for (size_t level = firstSync; level < levels.size(); ++level) {
+        UploadLevel((unsigned int)level, textureData.GetLevelData(level));
+    }
+
+    residentLevel = firstSync;
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, (GLint)residentLevel);
+    if (!generateOnGPU) {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)levels.size() - 1);
+    }
 
     // Check for OpenGL errors
     GLenum error = glGetError();
     if (error != GL_NO_ERROR) {
         LOG_DEBUG("[ResourceTexture] OpenGL ERROR after glTexImage2D: 0x%04X", error);
-        glBindTexture(GL_TEXTURE_2D, 0);
-        glDeleteTextures(1, &gpu_id);
+        GLState::BindTexture(GL_TEXTURE_2D, 0);
+        GLState::DeleteTextures(1, &gpu_id);
         gpu_id = 0;
+        levels.clear();
         return false;
     }
 
     // Generate mipmaps if enabled
-    if (meta.uid != 0 && meta.importSettings.generateMipmaps) {
+    if (generateOnGPU) {
         glGenerateMipmap(GL_TEXTURE_2D);
 
         error = glGetError();
@@ -111,17 +148,36 @@ bool ResourceTexture::LoadInMemory() {
         }
     }
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::BindTexture(GL_TEXTURE_2D, 0);
 
     // Store texture info
-    width = textureData.width;
-    height = textureData.height;
-    depth = textureData.channels;
-    bytes = textureData.width * textureData.height * textureData.channels;
+    mips = (unsigned int)levels.size();
+    bytes = 0;
+    uncompressedBytes = 0;
+    for (size_t level = residentLevel; level < levels.size(); ++level) CountLevel((unsigned int)level, true);
     format = (textureData.channels == 4) ? RGBA : RGB;
 
+    // Checked on the largest level read. Mips average alpha, so cutouts of a few texels in larger levels can fade out
+    opaque = compression == TextureFormat::BC1 || compression == TextureFormat::BC5;
+    if (compression == TextureFormat::RGBA8) {
+        const unsigned char* texels = textureData.GetLevelData(textureData.firstLevel);
+        size_t texelCount = levels[textureData.firstLevel].size / 4;
+        opaque = true;
+        for (size_t i = 0; i < texelCount && opaque; ++i) opaque = texels[i * 4 + 3] == 255;
+    }
+
     loadedInMemory = true;
 
+    for (unsigned int level = firstSync; level-- > textureData.firstLevel;) {
+        const unsigned char* levelData = textureData.GetLevelData(level);
+        QueueLevel(level, std::vector<unsigned char>(levelData, levelData + levels[level].size));
+    }
+
+    if (levels.size() > 1 && streamer.IsEnabled()) {
+        streamer.Register(this);
+        streamed = true;
+    }
+
     LOG_DEBUG("[ResourceTexture] Successfully loaded in GPU memory (ID: %u)", gpu_id);
 
     return true;
@@ -134,17 +190,112 @@ void ResourceTexture::UnloadFromMemory() {
 
     LOG_DEBUG("[ResourceTexture] Unloading from memory: UID=%llu, GPU_ID=%u", uid, gpu_id);
 
+    if (streamed) {
+        TextureStreamer::GetInstance().Unregister(this);
+        streamed = false;
+    }
+
+    UploadManager::GetInstance().Cancel(this);
+    uploadingLevels = 0;
+
     if (gpu_id != 0) {
-        glDeleteTextures(1, &gpu_id);
+        GLState::DeleteTextures(1, &gpu_id);
         gpu_id = 0;
     }
 
+    totalGPUBytes -= bytes;
+    totalUncompressedBytes -= uncompressedBytes;
+    levels.clear();
+    residentLevel = 0;
+
     width = 0;
     height = 0;
     depth = 0;
+    mips = 0;
     bytes = 0;
+    uncompressedBytes = 0;
     format = UNKNOWN;
+    compression = TextureFormat::RGBA8;
+    opaque = false;
 
     loadedInMemory = false;
 }
 
+
+void ResourceTexture::UploadLevel(unsigned int level, const unsigned char* data) {
+    const TextureLevel& mip = levels[level];
+
+    if (BlockCompression::IsCompressed(compression)) {
+        glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)level, BlockCompression::GetGLFormat(compression),
+            mip.width, mip.height, 0, mip.size, data);
+    }
+    else {
+        GLenum glFormat = (depth == 4) ? GL_RGBA : GL_RGB;
+        glTexImage2D(GL_TEXTURE_2D, (GLint)level, glFormat, mip.width, mip.height, 0, glFormat, GL_UNSIGNED_BYTE, data);
+    }
+}
+
+void ResourceTexture::CountLevel(unsigned int level, bool resident) {
+    unsigned int levelBytes = levels[level].size;
+    unsigned int levelUncompressed = levels[level].width * levels[level].height * 4;
+
+    if (resident) {
+        bytes += levelBytes;
+        uncompressedBytes += levelUncompressed;
+        totalGPUBytes += levelBytes;
+        totalUncompressedBytes += levelUncompressed;
+    }
+    else {
+        bytes -= levelBytes;
+        uncompressedBytes -= levelUncompressed;
+        totalGPUBytes -= levelBytes;
+        totalUncompressedBytes -= levelUncompressed;
+    }
+}
+
+void ResourceTexture::QueueLevel(unsigned int level, std::vector<unsigned char> data) {
+    GLenum glFormat = BlockCompression::IsCompressed(compression) ? BlockCompression::GetGLFormat(compression)
+        : ((depth == 4) ? GL_RGBA : GL_RGB);
+    const TextureLevel& mip = levels[level];
+
+    // Levels land in queue order, so the base level only ever steps down by one
+    uploadingLevels++;
+    UploadManager::GetInstance().UploadTextureLevel(this, gpu_id, (int)level, mip.width, mip.height, glFormat,
+        BlockCompression::IsCompressed(compression), std::move(data), [this, level]() {
+            GLState::BindTexture(GL_TEXTURE_2D, gpu_id);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, (GLint)level);
+            GLState::BindTexture(GL_TEXTURE_2D, 0);
+
+            residentLevel = level;
+            CountLevel(level, true);
+            uploadingLevels--;
+        });
+}
+
+bool ResourceTexture::UploadNextLevel(std::vector<unsigned char> data) {
+    if (!loadedInMemory || residentLevel == 0 || IsUploading()) return false;
+
+    unsigned int level = residentLevel - 1;
+    if (data.size() != levels[level].size) return false;
+
+    QueueLevel(level, std::move(data));
+    return true;
+}
+
+void ResourceTexture::DropTopLevel() {
+    if (!loadedInMemory || residentLevel + 1 >= levels.size() || IsUploading()) return;
+
+    unsigned int level = residentLevel;
+
+    // Outside the base/max range the empty level doesn't affect completeness
+    GLState::BindTexture(GL_TEXTURE_2D, gpu_id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, (GLint)level + 1);
+    if (BlockCompression::IsCompressed(compression))
+        glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)level, BlockCompression::GetGLFormat(compression), 0, 0, 0, 0, nullptr);
+    else
+        glTexImage2D(GL_TEXTURE_2D, (GLint)level, GL_RGBA, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    GLState::BindTexture(GL_TEXTURE_2D, 0);
+
+    residentLevel = level + 1;
+    CountLevel(level, false);
+}
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "ModuleResources.h"
+#include "BlockCompression.h"
+#include "TextureImporter.h"
+#include <vector>
 
 class ResourceTexture : public Resource {
 public:
@@ -27,7 +30,25 @@ public:
     unsigned int GetDepth() const { return depth; }
     unsigned int GetGPU_ID() const { return gpu_id; }
     Format GetFormat() const { return format; }
+    TextureFormat GetCompression() const { return compression; }
+    // No texel is translucent, so the mesh shader's alpha cutout never discards. BC3 and BC7
+    // are not decoded to check and count as translucent
+    bool IsOpaque() const { return opaque; }
 
+    // Streaming. Levels above the resident one are not on the GPU
+    unsigned int GetLevelCount() const { return (unsigned int)levels.size(); }
+    unsigned int GetResidentLevel() const { return residentLevel; }
+    const TextureLevel& GetLevel(unsigned int level) const { return levels[level]; }
+    // Levels queued on the UploadManager, the resident level changes as they land
+    bool IsUploading() const { return uploadingLevels > 0; }
+    // Queues the level above the resident one, it becomes the base level once on the GPU
+    bool UploadNextLevel(std::vector<unsigned char> data);
+    // Frees the resident level, the next smaller one becomes the base level
+    void DropTopLevel();
+
+    // GPU bytes of every loaded texture, and what they would take as RGBA8 with the same levels
+    static size_t GetTotalGPUBytes() { return totalGPUBytes; }
+    static size_t GetTotalUncompressedBytes() { return totalUncompressedBytes; }
 
 public:
     unsigned int width = 0;
@@ -35,6 +56,22 @@ public:
     unsigned int depth = 0;
     unsigned int mips = 0;
     unsigned int bytes = 0;
+    unsigned int uncompressedBytes = 0;
     unsigned int gpu_id = 0;  // OpenGL texture ID
     Format format = UNKNOWN;
+    TextureFormat compression = TextureFormat::RGBA8;
+
+private:
+    void UploadLevel(unsigned int level, const unsigned char* data);
+    void QueueLevel(unsigned int level, std::vector<unsigned char> data);
+    void CountLevel(unsigned int level, bool resident);
+
+    std::vector<TextureLevel> levels;
+    unsigned int residentLevel = 0;
+    unsigned int uploadingLevels = 0;
+    bool opaque = false;
+    bool streamed = false;
+
+    static size_t totalGPUBytes;
+    static size_t totalUncompressedBytes;
 };
\ No newline at end of file
@@ -97,6 +97,8 @@ void SceneWindow::Draw()
     if (Application::GetInstance().input->GetMouseButtonDown(1) == KEY_DOWN && Application::GetInstance().input->GetKey(SDL_SCANCODE_LALT) != KEY_REPEAT)
         SelectObject();
 
+    ResolvePendingPick();
+
 
     ImGuizmo::BeginFrame();
 
@@ -118,13 +120,44 @@ void SceneWindow::SelectObject()
 
     if (!isHovered) return;
 
-    GameObject* objToSelect = GetGameObjectUnderMouse();
+    ImVec2 mousePos = ImGui::GetMousePos();
+
+    int mouseX = (int)(mousePos.x - sceneViewportPos.x);
+    int mouseY = (int)(mousePos.y - sceneViewportPos.y);
+
+    // Resolved a frame or two later by ResolvePendingPick, without stalling on the GPU
+    Application::GetInstance().renderer->RequestPick(
+        Application::GetInstance().editor->GetEditorCamera()->GetCameraLens(),
+        mouseX,
+        mouseY
+    );
+
+    pickPending = true;
+    pickTextureUID = 0;
+    pickAdditive = Application::GetInstance().input.get()->GetKey(SDL_SCANCODE_LSHIFT) || Application::GetInstance().input.get()->GetKey(SDL_SCANCODE_RSHIFT);
+}
+
+void SceneWindow::ResolvePendingPick()
+{
+    // Always drain the readback so a result never lingers into the next click
+    UID pickedUID = 0;
+    if (!Application::GetInstance().renderer->PollPick(pickedUID)) return;
+    if (!pickPending) return;
+
+    pickPending = false;
 
-    bool shiftPressed = Application::GetInstance().input.get()->GetKey(SDL_SCANCODE_LSHIFT) || Application::GetInstance().input.get()->GetKey(SDL_SCANCODE_RSHIFT);
+    GameObject* objToSelect = (pickedUID != 0) ? Application::GetInstance().scene->FindObject(pickedUID) : nullptr;
+
+    if (pickTextureUID != 0)
+    {
+        ApplyDroppedTexture(objToSelect, pickTextureUID);
+        pickTextureUID = 0;
+        return;
+    }
 
     if (objToSelect) {
 
-        if (shiftPressed)
+        if (pickAdditive)
         {
             Application::GetInstance().selectionManager->ToggleSelection(objToSelect);
         }
@@ -231,75 +264,17 @@ void SceneWindow::HandleAssetDropTarget()
             {
                 LOG_CONSOLE("Applying texture...");
 
-                GameObject* targetObject = GetGameObjectUnderMouse();
-
-                if (targetObject)
-                {
-                    // Apply texture to the specific object under the mouse
-                    ComponentMaterial* material = static_cast<ComponentMaterial*>(
-                        targetObject->GetComponent(ComponentType::MATERIAL)
-                        );
+                ImVec2 mousePos = ImGui::GetMousePos();
 
-                    if (!material)
-                    {
-                        material = static_cast<ComponentMaterial*>(
-                            targetObject->CreateComponent(ComponentType::MATERIAL)
-                            );
-                    }
-
-                    if (material && material->LoadTextureByUID(dropData->assetUID))
-                    {
-                        LOG_CONSOLE("Texture applied to: %s", targetObject->GetName().c_str());
-                    }
-                    else
-                    {
-                        LOG_CONSOLE("ERROR: Failed to apply texture to: %s", targetObject->GetName().c_str());
-                    }
-                }
-                else
-                {
-                    // Fallback 
-                    std::vector<GameObject*> selectedObjects =
-                        Application::GetInstance().selectionManager->GetSelectedObjects();
-
-                    if (selectedObjects.empty())
-                    {
-                        LOG_CONSOLE("No object under mouse and no selection");
-                        break;
-                    }
-
-                    int successCount = 0;
-                    for (GameObject* obj : selectedObjects)
-                    {
-                        if (!obj || !obj->IsActive())
-                            continue;
-
-                        ComponentMaterial* material = static_cast<ComponentMaterial*>(
-                            obj->GetComponent(ComponentType::MATERIAL)
-                            );
-
-                        if (!material)
-                        {
-                            material = static_cast<ComponentMaterial*>(
-                                obj->CreateComponent(ComponentType::MATERIAL)
-                                );
-                        }
-
-                        if (material && material->LoadTextureByUID(dropData->assetUID))
-                        {
-                            successCount++;
-                        }
-                    }
+                // Applied by ResolvePendingPick once the ID buffer read back finds the object under the mouse
+                Application::GetInstance().renderer->RequestPick(
+                    Application::GetInstance().editor->GetEditorCamera()->GetCameraLens(),
+                    (int)(mousePos.x - sceneViewportPos.x),
+                    (int)(mousePos.y - sceneViewportPos.y)
+                );
 
-                    if (successCount > 0)
-                    {
-                        LOG_CONSOLE("Texture applied to %d selected object(s)", successCount);
-                    }
-                    else
-                    {
-                        LOG_CONSOLE("ERROR: Failed to apply texture");
-                    }
-                }
+                pickPending = true;
+                pickTextureUID = dropData->assetUID;
                 break;
             }
 
@@ -696,23 +671,73 @@ void SceneWindow::ApplyMeshTransformFromFBX(GameObject* meshObject, unsigned lon
     }
 }
 
-GameObject* SceneWindow::GetGameObjectUnderMouse()
+void SceneWindow::ApplyDroppedTexture(GameObject* targetObject, unsigned long long textureUID)
 {
+    if (targetObject)
+    {
+        // Apply texture to the specific object under the mouse
+        ComponentMaterial* material = static_cast<ComponentMaterial*>(
+            targetObject->GetComponent(ComponentType::MATERIAL)
+            );
 
-    ImVec2 mousePos = ImGui::GetMousePos();
+        if (!material)
+        {
+            material = static_cast<ComponentMaterial*>(
+                targetObject->CreateComponent(ComponentType::MATERIAL)
+                );
+        }
 
-    int mouseX = (int)(mousePos.x - sceneViewportPos.x);
-    int mouseY = (int)(mousePos.y - sceneViewportPos.y);
+        if (material && material->LoadTextureByUID(textureUID))
+        {
+            LOG_CONSOLE("Texture applied to: %s", targetObject->GetName().c_str());
+        }
+        else
+        {
+            LOG_CONSOLE("ERROR: Failed to apply texture to: %s", targetObject->GetName().c_str());
+        }
+    }
+    else
+    {
+        // Fallback 
+        std::vector<GameObject*> selectedObjects =
+            Application::GetInstance().selectionManager->GetSelectedObjects();
 
-    UID objectToSelectUID = Application::GetInstance().renderer->GetObjectInPixel(
-        Application::GetInstance().editor->GetEditorCamera()->GetCameraLens(),
-        mouseX,
-        mouseY
-    );
+        if (selectedObjects.empty())
+        {
+            LOG_CONSOLE("No object under mouse and no selection");
+            return;
+        }
+
+        int successCount = 0;
+        for (GameObject* obj : selectedObjects)
+        {
+            if (!obj || !obj->IsActive())
+                continue;
+
+            ComponentMaterial* material = static_cast<ComponentMaterial*>(
+                obj->GetComponent(ComponentType::MATERIAL)
+                );
 
-    if (objectToSelectUID != 0) {
-        GameObject* objectToSelect = Application::GetInstance().scene->FindObject(objectToSelectUID);
-        return objectToSelect;
+            if (!material)
+            {
+                material = static_cast<ComponentMaterial*>(
+                    obj->CreateComponent(ComponentType::MATERIAL)
+                    );
+            }
+
+            if (material && material->LoadTextureByUID(textureUID))
+            {
+                successCount++;
+            }
+        }
+
+        if (successCount > 0)
+        {
+            LOG_CONSOLE("Texture applied to %d selected object(s)", successCount);
+        }
+        else
+        {
+            LOG_CONSOLE("ERROR: Failed to apply texture");
+        }
     }
-    return nullptr;
 }
\ No newline at end of file
@@ -30,6 +30,7 @@ public:
 
 private:
     void SelectObject();
+    void ResolvePendingPick();
     void HandleGizmoInput();
     void DrawGizmo();
     void HandleAssetDropTarget();  
@@ -41,7 +42,12 @@ private:
     ImVec2 sceneViewportPos;
     ImVec2 sceneViewportSize;
 
-    GameObject* GetGameObjectUnderMouse();
+    void ApplyDroppedTexture(GameObject* targetObject, unsigned long long textureUID);
+
+    // Click selection and texture drops are read back asynchronously from the ID buffer
+    bool pickPending = false;
+    bool pickAdditive = false;
+    unsigned long long pickTextureUID = 0;  // texture dropped on the view, 0 for a click
 
     bool isGizmoActive = false;
 
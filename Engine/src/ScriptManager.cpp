@@ -30,6 +30,7 @@
 
 #include <filesystem>
 #include <cmath>            
+#include <float.h>
 ScriptManager::ScriptManager() : Module(), L(nullptr) {
     name = "ScriptManager";
 }
@@ -57,6 +58,7 @@ bool ScriptManager::Start() {
     RegisterGameObjectAPI();
     RegisterComponentAPI();
     RegisterPrefabAPI();
+    RegisterSceneAPI();
 
     LOG_CONSOLE("[ScriptManager] Started successfully");
     return true;
@@ -1467,6 +1469,136 @@ void ScriptManager::RegisterPrefabAPI() {
 
 }
 
+// SCENE API
+
+// Reused between calls so queries from Update() don't allocate
+static std::vector<GameObject*> sceneQueryResults;
+
+static void PushGameObject(lua_State* L, GameObject* obj) {
+    GameObject** udata = static_cast<GameObject**>(lua_newuserdata(L, sizeof(GameObject*)));
+    *udata = obj;
+
+    luaL_getmetatable(L, "GameObject");
+    lua_setmetatable(L, -2);
+}
+
+static void PushGameObjectArray(lua_State* L, const std::vector<GameObject*>& objects) {
+    lua_createtable(L, static_cast<int>(objects.size()), 0);
+
+    for (size_t i = 0; i < objects.size(); ++i) {
+        PushGameObject(L, objects[i]);
+        lua_rawseti(L, -2, static_cast<lua_Integer>(i + 1));
+    }
+}
+
+// Scene.OverlapSphere(x, y, z, radius) -> { GameObject, ... }
+static int Lua_Scene_OverlapSphere(lua_State* L) {
+    glm::vec3 center(
+        static_cast<float>(luaL_checknumber(L, 1)),
+        static_cast<float>(luaL_checknumber(L, 2)),
+        static_cast<float>(luaL_checknumber(L, 3)));
+    float radius = static_cast<float>(luaL_checknumber(L, 4));
+
+    sceneQueryResults.clear();
+    Application::GetInstance().scene->OverlapSphere(center, radius, sceneQueryResults);
+
+    PushGameObjectArray(L, sceneQueryResults);
+    return 1;
+}
+
+// Scene.OverlapBox(minX, minY, minZ, maxX, maxY, maxZ) -> { GameObject, ... }
+static int Lua_Scene_OverlapBox(lua_State* L) {
+    AABB box;
+    box.min = glm::vec3(
+        static_cast<float>(luaL_checknumber(L, 1)),
+        static_cast<float>(luaL_checknumber(L, 2)),
+        static_cast<float>(luaL_checknumber(L, 3)));
+    box.max = glm::vec3(
+        static_cast<float>(luaL_checknumber(L, 4)),
+        static_cast<float>(luaL_checknumber(L, 5)),
+        static_cast<float>(luaL_checknumber(L, 6)));
+
+    sceneQueryResults.clear();
+    Application::GetInstance().scene->OverlapBox(box, sceneQueryResults);
+
+    PushGameObjectArray(L, sceneQueryResults);
+    return 1;
+}
+
+// Scene.Nearest(x, y, z, k [, maxDistance]) -> { GameObject, ... } sorted closest first
+static int Lua_Scene_Nearest(lua_State* L) {
+    glm::vec3 point(
+        static_cast<float>(luaL_checknumber(L, 1)),
+        static_cast<float>(luaL_checknumber(L, 2)),
+        static_cast<float>(luaL_checknumber(L, 3)));
+    int k = static_cast<int>(luaL_optinteger(L, 4, 1));
+    float maxDistance = static_cast<float>(luaL_optnumber(L, 5, FLT_MAX));
+
+    sceneQueryResults.clear();
+    Application::GetInstance().scene->Nearest(point, k, sceneQueryResults, maxDistance);
+
+    PushGameObjectArray(L, sceneQueryResults);
+    return 1;
+}
+
+// Scene.Raycast(ox, oy, oz, dx, dy, dz [, maxDistance [, ignore]]) -> GameObject, distance
+static int Lua_Scene_Raycast(lua_State* L) {
+    glm::vec3 origin(
+        static_cast<float>(luaL_checknumber(L, 1)),
+        static_cast<float>(luaL_checknumber(L, 2)),
+        static_cast<float>(luaL_checknumber(L, 3)));
+    glm::vec3 direction(
+        static_cast<float>(luaL_checknumber(L, 4)),
+        static_cast<float>(luaL_checknumber(L, 5)),
+        static_cast<float>(luaL_checknumber(L, 6)));
+    float maxDistance = static_cast<float>(luaL_optnumber(L, 7, FLT_MAX));
+
+    GameObject* ignore = nullptr;
+    if (lua_gettop(L) >= 8 && !lua_isnil(L, 8)) {
+        GameObject** ignorePtr = static_cast<GameObject**>(luaL_checkudata(L, 8, "GameObject"));
+        ignore = ignorePtr ? *ignorePtr : nullptr;
+    }
+
+    if (glm::length(direction) < 0.0001f) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    Ray ray(origin, glm::normalize(direction));
+    float distance = 0.0f;
+    GameObject* hit = Application::GetInstance().scene->Raycast(ray, distance,
+        [ignore](GameObject* obj) { return obj != ignore; });
+
+    if (!hit || distance > maxDistance) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    PushGameObject(L, hit);
+    lua_pushnumber(L, distance);
+    return 2;
+}
+
+void ScriptManager::RegisterSceneAPI() {
+    lua_newtable(L);
+
+    lua_pushcfunction(L, Lua_Scene_OverlapSphere);
+    lua_setfield(L, -2, "OverlapSphere");
+
+    lua_pushcfunction(L, Lua_Scene_OverlapBox);
+    lua_setfield(L, -2, "OverlapBox");
+
+    lua_pushcfunction(L, Lua_Scene_Nearest);
+    lua_setfield(L, -2, "Nearest");
+
+    lua_pushcfunction(L, Lua_Scene_Raycast);
+    lua_setfield(L, -2, "Raycast");
+
+    lua_setglobal(L, "Scene");
+
+    LOG_CONSOLE("[ScriptManager] Scene API registered");
+}
+
 static GameWindow* GetGameWindow() {
     #ifndef WAVE_GAME
     GameWindow* window = Application::GetInstance().editor->GetGameWindow();
@@ -51,4 +51,5 @@ public:
     void RegisterGameObjectAPI();
     void RegisterComponentAPI();
     void RegisterPrefabAPI();
+    void RegisterSceneAPI();
 };
\ No newline at end of file
@@ -3,6 +3,11 @@
 #include <iostream>
 #include <glm/gtc/type_ptr.hpp>
 #include "Log.h"
+#include "ShaderCache.h"
+#include "GLState.h"
+#include "LightClusterer.h"
+#include <chrono>
+#include <string>
 
 Shader::Shader() : shaderProgram(0)
 {
@@ -33,6 +38,93 @@ Shader::Shader() : shaderProgram(0)
         "    }\n"
         "    return skinMat;\n"
         "}\n";
+
+    // Instanced and multi-draw indirect draws read their matrices from the instance buffer.
+    // instanceBase is the first slot of the batch, used to offset the picking ID
+    instancingDeclarations =
+        "struct Instance { mat4 model; mat4 normal; };\n"
+        "layout(std430, binding = 2) readonly buffer InstanceData { Instance gInstances[]; };\n"
+        "uniform bool useInstancing;\n"
+        "uniform int instanceBase;\n"
+        "uniform uint drawID;\n"
+        "flat out uint vDrawID;\n";
+
+    frameDataBlock =
+        "layout(std140, binding = 1) uniform FrameData {\n"
+        "    vec3 lightDir;\n"
+        "    vec3 viewPos;\n"
+        "    vec4 clusterScale;\n"
+        "    vec2 clusterDepth;\n"
+        "};\n";
+
+    materialDataBlock =
+        "layout(std140, binding = 2) uniform MaterialData {\n"
+        "    vec3 materialDiffuse;\n"
+        "    float opacity;\n"
+        "};\n";
+
+    // Point and spot lights of the fragment's cluster, the grid size is declared before this.
+    // Needs the FrameData block
+    clusteredLighting =
+        "struct Light { vec4 positionRange; vec4 colorIntensity; vec4 directionCosOuter; vec4 cosInner; };\n"
+        "layout(std430, binding = 3) readonly buffer LightData { Light gLights[]; };\n"
+        "layout(std430, binding = 4) readonly buffer LightGrid { uvec2 gClusters[]; };\n"
+        "layout(std430, binding = 5) readonly buffer LightIndices { uint gLightIndices[]; };\n"
+        "vec3 ClusterLighting(vec3 fragPos, vec3 norm, vec3 baseColor) {\n"
+        "    float zNear = clusterDepth.x;\n"
+        "    float zFar = clusterDepth.y;\n"
+        "    float depth = 2.0 * zNear * zFar / (zFar + zNear - (gl_FragCoord.z * 2.0 - 1.0) * (zFar - zNear));\n"
+        "    uvec2 tile = min(uvec2(gl_FragCoord.xy * clusterScale.xy), uvec2(kClusterTilesX - 1u, kClusterTilesY - 1u));\n"
+        "    uint slice = uint(clamp(log(depth) * clusterScale.z + clusterScale.w, 0.0, float(kClusterSlices - 1u)));\n"
+        "    uvec2 cluster = gClusters[(slice * kClusterTilesY + tile.y) * kClusterTilesX + tile.x];\n"
+        "    vec3 viewDir = normalize(viewPos - fragPos);\n"
+        "    vec3 result = vec3(0.0);\n"
+        "    for (uint i = 0u; i < cluster.y; ++i) {\n"
+        "        Light light = gLights[gLightIndices[cluster.x + i]];\n"
+        "        vec3 toLight = light.positionRange.xyz - fragPos;\n"
+        "        float dist = length(toLight);\n"
+        "        vec3 dir = toLight / max(dist, 0.0001);\n"
+        "        float falloff = clamp(1.0 - dist / light.positionRange.w, 0.0, 1.0);\n"
+        "        falloff *= falloff;\n"
+        "        falloff *= smoothstep(light.directionCosOuter.w, light.cosInner.x, dot(-dir, light.directionCosOuter.xyz));\n"
+        "        float diff = max(dot(norm, dir), 0.0);\n"
+        "        float spec = pow(max(dot(norm, normalize(dir + viewDir)), 0.0), 32.0) * 0.25;\n"
+        "        result += (diff * baseColor + spec) * light.colorIntensity.rgb * light.colorIntensity.w * falloff;\n"
+        "    }\n"
+        "    return result;\n"
+        "}\n";
+
+    // Vertex stage of every scene pass. gl_Position is invariant, so the depth pre-pass writes
+    // exactly the depth the shading pass tests GL_EQUAL against
+    meshVertexShader =
+        "invariant gl_Position;\n"
+        "layout(location = 0) in vec3 aPos;\n"
+        "layout(location = 1) in vec3 aNormal;\n"
+        "layout(location = 2) in vec2 aTexCoord;\n"
+        "layout(location = 3) in ivec4 boneIDs;\n"
+        "layout(location = 4) in vec4 weights;\n"
+        "out vec3 FragPos;\n"
+        "out vec3 Normal;\n"
+        "out vec2 TexCoord;\n"
+        "void main() {\n"
+        "    mat4 skinMat = GetSkinMatrix(boneIDs, weights);\n"
+        "    vec4 skinnedPos = skinMat * vec4(aPos, 1.0);\n"
+        "    vec3 skinnedNormal = mat3(skinMat) * aNormal;\n"
+        "    int instance = gl_BaseInstance + gl_InstanceID;\n"
+        "    mat4 modelMat = model;\n"
+        "    mat3 normalMat;\n"
+        "    if (useInstancing) {\n"
+        "        modelMat = gInstances[instance].model;\n"
+        "        normalMat = mat3(gInstances[instance].normal);\n"
+        "    } else {\n"
+        "        normalMat = mat3(transpose(inverse(model)));\n"
+        "    }\n"
+        "    FragPos = vec3(modelMat * skinnedPos);\n"
+        "    Normal = normalMat * skinnedNormal;\n"
+        "    TexCoord = aTexCoord;\n"
+        "    gl_Position = projection * view * vec4(FragPos, 1.0);\n"
+        "    vDrawID = drawID + uint(useInstancing ? instance - instanceBase : 0);\n"
+        "}\n";
 }
 
 Shader::~Shader()
@@ -42,11 +134,24 @@ Shader::~Shader()
 
 void Shader::Use() const
 {
-    glUseProgram(shaderProgram);
+    GLState::UseProgram(shaderProgram);
 }
 
 bool Shader::LoadFromSource(const char* vSource, const char* fSource, const char* gSource)
 {
+    // Linked binary from a previous run, skips the driver compile
+    ShaderCache& cache = ShaderCache::GetInstance();
+    uint64_t cacheKey = cache.MakeKey(vSource, fSource, gSource);
+    if (unsigned int cachedProgram = cache.LoadProgram(cacheKey))
+    {
+        if (shaderProgram != 0) glDeleteProgram(shaderProgram);
+        shaderProgram = cachedProgram;
+        CacheUniformLocations();
+        return true;
+    }
+
+    auto compileStart = std::chrono::high_resolution_clock::now();
+
     unsigned int vertexShader = CompileShader(GL_VERTEX_SHADER, vSource);
     if (vertexShader == 0) return false;
 
@@ -70,6 +175,7 @@ bool Shader::LoadFromSource(const char* vSource, const char* fSource, const char
     glAttachShader(newProgram, vertexShader);
     glAttachShader(newProgram, fragmentShader);
     if (geometryShader != 0) glAttachShader(newProgram, geometryShader);
+    if (cache.IsEnabled()) glProgramParameteri(newProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glLinkProgram(newProgram);
 
     int success;
@@ -90,15 +196,53 @@ bool Shader::LoadFromSource(const char* vSource, const char* fSource, const char
     glDeleteShader(fragmentShader);
     if (geometryShader != 0) glDeleteShader(geometryShader);
 
+    cache.AddCompileTime(std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - compileStart).count());
+    cache.SaveProgram(cacheKey, newProgram);
+
     // If there was an old program, delete it
     if (shaderProgram != 0) {
         glDeleteProgram(shaderProgram);
     }
 
     shaderProgram = newProgram;
+    CacheUniformLocations();
     return true;
 }
 
+void Shader::CacheUniformLocations()
+{
+    uniformLocations.clear();
+
+    int count = 0;
+    glGetProgramiv(shaderProgram, GL_ACTIVE_UNIFORMS, &count);
+
+    char name[256];
+    for (int i = 0; i < count; ++i)
+    {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(shaderProgram, (GLuint)i, sizeof(name), &length, &size, &type, name);
+
+        // Uniforms inside blocks report -1 and are fed through their buffers
+        int location = glGetUniformLocation(shaderProgram, name);
+        if (location < 0) continue;
+
+        std::string uniformName(name, length);
+        uniformLocations[uniformName] = location;
+
+        // Arrays are reported as "name[0]", also answer to the bare name
+        size_t bracket = uniformName.find('[');
+        if (bracket != std::string::npos) uniformLocations[uniformName.substr(0, bracket)] = location;
+    }
+}
+
+int Shader::GetUniformLocation(const std::string& name) const
+{
+    auto it = uniformLocations.find(name);
+    return it != uniformLocations.end() ? it->second : -1;
+}
+
 unsigned int Shader::CompileShader(unsigned int type, const char* source)
 {
     unsigned int shader = glCreateShader(type);
@@ -133,19 +277,24 @@ void Shader::Delete()
     }
 }
 
+void Shader::SetVec2(const std::string& name, const glm::vec2& value) const
+{
+    glUniform2fv(GetUniformLocation(name), 1, &value[0]);
+}
+
 void Shader::SetVec3(const std::string& name, const glm::vec3& value) const
 {
-    glUniform3fv(glGetUniformLocation(shaderProgram, name.c_str()), 1, &value[0]);
+    glUniform3fv(GetUniformLocation(name), 1, &value[0]);
 }
 
 void Shader::SetFloat(const std::string& name, float value) const
 {
-    glUniform1f(glGetUniformLocation(shaderProgram, name.c_str()), value);
+    glUniform1f(GetUniformLocation(name), value);
 }
 
 void Shader::SetMat4(const std::string& name, const glm::mat4& mat) const
 {
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
 }
 
 bool Shader::CreateSimpleColor()
@@ -299,23 +448,13 @@ bool Shader::CreateSingleColor()
 
 bool Shader::CreateDepthVisualization()
 {
-    std::string vert = std::string(shaderHeader) + skinningDeclarations + skinningFunction +
-        "layout(location = 0) in vec3 aPos;\n"
-        "layout(location = 1) in vec3 aNormal;\n"
-        "layout(location = 2) in vec2 aTexCoord;\n"
-        "layout(location = 3) in ivec4 boneIDs;\n"
-        "layout(location = 4) in vec4 weights;\n"
-        "out vec2 TexCoord;\n"
-        "void main() {\n"
-        "    mat4 skinMat = GetSkinMatrix(boneIDs, weights);\n"
-        "    vec4 skinnedPos = skinMat * vec4(aPos, 1.0);\n"
-        "    gl_Position = projection * view * model * skinnedPos;\n"
-        "    TexCoord = aTexCoord;\n"
-        "}\n";
+    std::string vert = std::string(shaderHeader) + skinningDeclarations + skinningFunction + instancingDeclarations + meshVertexShader;
 
     std::string frag =
         "#version 460 core\n"
-        "out vec4 FragColor;\n"
+        "layout(location = 0) out vec4 FragColor;\n"
+        "layout(location = 1) out uint ObjectID;\n"
+        "flat in uint vDrawID;\n"
         "uniform float nearPlane;\n"
         "uniform float farPlane;\n"
         "float LinearizeDepth(float depth) {\n"
@@ -325,6 +464,38 @@ bool Shader::CreateDepthVisualization()
         "void main() {\n"
         "    float depth = LinearizeDepth(gl_FragCoord.z) / farPlane;\n"
         "    FragColor = vec4(vec3(depth), 1.0);\n"
+        "    ObjectID = vDrawID;\n"
+        "}\n";
+
+    return LoadFromSource(vert.c_str(), frag.c_str());
+}
+
+bool Shader::CreateDepthPrepass()
+{
+    std::string vert = std::string(shaderHeader) + skinningDeclarations + skinningFunction + instancingDeclarations + meshVertexShader;
+
+    // Depth only, color writes are masked off while it runs
+    std::string frag =
+        "#version 460 core\n"
+        "void main() {\n"
+        "}\n";
+
+    return LoadFromSource(vert.c_str(), frag.c_str());
+}
+
+bool Shader::CreateOverdraw()
+{
+    std::string vert = std::string(shaderHeader) + skinningDeclarations + skinningFunction + instancingDeclarations + meshVertexShader;
+
+    // Drawn with additive blending, every shaded fragment brightens its pixel by one step
+    std::string frag =
+        "#version 460 core\n"
+        "layout(location = 0) out vec4 FragColor;\n"
+        "layout(location = 1) out uint ObjectID;\n"
+        "flat in uint vDrawID;\n"
+        "void main() {\n"
+        "    FragColor = vec4(0.12, 0.05, 0.02, 1.0);\n"
+        "    ObjectID = vDrawID;\n"
         "}\n";
 
     return LoadFromSource(vert.c_str(), frag.c_str());
@@ -355,37 +526,23 @@ bool Shader::CreateLinesShader()
 
 bool Shader::CreateNoTexture()
 {
-    std::string vert = std::string(shaderHeader) + skinningDeclarations + skinningFunction +
-        "layout(location = 0) in vec3 aPos;\n"
-        "layout(location = 1) in vec3 aNormal;\n"
-        "layout(location = 2) in vec2 aTexCoord;\n"
-        "layout(location = 3) in ivec4 boneIDs;\n"
-        "layout(location = 4) in vec4 weights;\n"
-        "out vec3 FragPos;\n"
-        "out vec3 Normal;\n"
-        "out vec2 TexCoord;\n"
-        "void main() {\n"
-        "    mat4 skinMat = GetSkinMatrix(boneIDs, weights);\n"
-        "    vec4 skinnedPos = skinMat * vec4(aPos, 1.0);\n"
-        "    vec3 skinnedNormal = mat3(skinMat) * aNormal;\n"
-        "    FragPos = vec3(model * skinnedPos);\n"
-        "    Normal = mat3(transpose(inverse(model))) * skinnedNormal;\n"
-        "    TexCoord = aTexCoord;\n"
-        "    gl_Position = projection * view * vec4(FragPos, 1.0);\n"
-        "}\n";
+    std::string vert = std::string(shaderHeader) + skinningDeclarations + skinningFunction + instancingDeclarations + meshVertexShader;
 
-    std::string frag =
-        "#version 460 core\n"
-        "out vec4 FragColor;\n"
+    std::string clusterGrid =
+        "const uint kClusterTilesX = " + std::to_string(LightClusterer::kTilesX) + "u;\n"
+        "const uint kClusterTilesY = " + std::to_string(LightClusterer::kTilesY) + "u;\n"
+        "const uint kClusterSlices = " + std::to_string(LightClusterer::kSlices) + "u;\n";
+
+    std::string frag = std::string("#version 460 core\n") + frameDataBlock + materialDataBlock + clusterGrid + clusteredLighting +
+        "layout(location = 0) out vec4 FragColor;\n"
+        "layout(location = 1) out uint ObjectID;\n"
         "in vec3 FragPos;\n"
         "in vec3 Normal;\n"
         "in vec2 TexCoord;\n"
+        "flat in uint vDrawID;\n"
         "uniform sampler2D texture1;\n"
         "uniform int hasTexture;\n"
         "uniform vec3 tintColor;\n"
-        "uniform vec3 lightDir;\n"
-        "uniform vec3 materialDiffuse;\n"
-        "uniform float opacity;\n"
         "void main() {\n"
         "    vec3 baseColor;\n"
         "    float alpha = 1.0;\n"
@@ -402,7 +559,9 @@ bool Shader::CreateNoTexture()
         "    float diff = max(dot(norm, light), 0.0);\n"
         "    vec3 ambient = 0.3 * baseColor;\n"
         "    vec3 diffuse = diff * baseColor;\n"
-        "    FragColor = vec4(ambient + diffuse, alpha * opacity);\n"
+        "    vec3 lights = ClusterLighting(FragPos, norm, baseColor);\n"
+        "    FragColor = vec4(ambient + diffuse + lights, alpha * opacity);\n"
+        "    ObjectID = vDrawID;\n"
         "}\n";
 
     return LoadFromSource(vert.c_str(), frag.c_str());
@@ -490,15 +649,12 @@ bool Shader::CreateWater()
         "    EmitV(m1,tm1);  EmitV(m2,tm2); EmitV(m3,tm3); EndPrimitive();\n"
         "}\n";
 
-    std::string frag =
-        "#version 460 core\n"
+    std::string frag = std::string("#version 460 core\n") + frameDataBlock +
         "out vec4 FragColor;\n"
         "in vec3 FragPos;\n"
         "in vec3 Normal;\n"
         "in vec2 TexCoord;\n"
         "in float v_Height;\n"
-        "uniform vec3 lightDir;\n"
-        "uniform vec3 viewPos;\n"
         "uniform float waveAmplitude;\n"
         "uniform float opacity;\n"
         "void main() {\n"
@@ -526,34 +682,6 @@ bool Shader::CreateWater()
     return LoadFromSource(vert.c_str(), frag.c_str(), geom.c_str());
 }
 
-bool Shader::CreatePickingShader()
-{
-    std::string vert = std::string(shaderHeader) + skinningDeclarations + skinningFunction +
-        "layout (location = 0) in vec3 position;\n"
-        "layout (location = 3) in ivec4 boneIDs;\n"
-        "layout (location = 4) in vec4 weights;\n"
-        "\n"
-        "void main()\n"
-        "{\n"
-        "    mat4 skinMat = GetSkinMatrix(boneIDs, weights);\n"
-        "    vec4 skinnedPos = skinMat * vec4(position, 1.0f);\n"
-        "\n"
-        "    gl_Position = projection * view * model * skinnedPos;\n"
-        "}\n";
-
-    std::string frag =
-        "#version 460 core\n"
-        "out vec4 FragColor;\n"
-        "uniform vec4 pickingColor;\n"
-        "\n"
-        "void main()\n"
-        "{\n"
-        "    FragColor = pickingColor;\n"
-        "}\n";
-
-    return LoadFromSource(vert.c_str(), frag.c_str());
-}
-
 bool Shader::CreateUIOverlay()
 {
     std::string vert =
@@ -581,17 +709,62 @@ bool Shader::CreateUIOverlay()
     return LoadFromSource(vert.c_str(), frag.c_str());
 }
 
+bool Shader::CreateParticleShader()
+{
+    // Camera facing quads, the corner offset is applied in view space
+    std::string vert = std::string(shaderHeader) +
+        "layout (location = 0) in vec2 corner;\n"
+        "layout (location = 1) in vec4 particlePosSize;\n"
+        "layout (location = 2) in vec4 particleColor;\n"
+        "layout (location = 3) in vec2 particleRotFrame;\n"
+        "\n"
+        "uniform mat4 model;\n"
+        "uniform vec2 atlasSize;\n"
+        "\n"
+        "out vec2 TexCoords;\n"
+        "out vec4 Color;\n"
+        "\n"
+        "void main() {\n"
+        "    float c = cos(particleRotFrame.x);\n"
+        "    float s = sin(particleRotFrame.x);\n"
+        "    vec2 offset = vec2(corner.x * c - corner.y * s, corner.x * s + corner.y * c) * particlePosSize.w;\n"
+        "    vec4 viewPos = view * model * vec4(particlePosSize.xyz, 1.0);\n"
+        "    viewPos.xy += offset;\n"
+        "    gl_Position = projection * viewPos;\n"
+        "\n"
+        "    // Sprite sheet frames go left to right, top to bottom\n"
+        "    float frame = particleRotFrame.y;\n"
+        "    float col = mod(frame, atlasSize.x);\n"
+        "    float row = floor(frame / atlasSize.x);\n"
+        "    TexCoords = vec2((col + corner.x + 0.5) / atlasSize.x, 1.0 - (row + 0.5 - corner.y) / atlasSize.y);\n"
+        "    Color = particleColor;\n"
+        "}\n";
+
+    std::string frag =
+        "#version 460 core\n"
+        "in vec2 TexCoords;\n"
+        "in vec4 Color;\n"
+        "out vec4 FragColor;\n"
+        "uniform sampler2D particleTexture;\n"
+        "uniform bool hasTexture;\n"
+        "void main() {\n"
+        "    FragColor = hasTexture ? Color * texture(particleTexture, TexCoords) : Color;\n"
+        "}\n";
+
+    return LoadFromSource(vert.c_str(), frag.c_str());
+}
+
 void Shader::SetInt(const std::string& name, int value) const
 {
-    glUniform1i(glGetUniformLocation(shaderProgram, name.c_str()), value);
+    glUniform1i(GetUniformLocation(name), value);
 }
 
 void Shader::SetVec4(const std::string& name, const glm::vec4& value) const
 {
-    glUniform4fv(glGetUniformLocation(shaderProgram, name.c_str()), 1, &value[0]);
+    glUniform4fv(GetUniformLocation(name), 1, &value[0]);
 }
 
 void Shader::SetBool(const std::string& name, bool value) const
 {
-    glUniform1i(glGetUniformLocation(shaderProgram, name.c_str()), (int)value);
+    glUniform1i(GetUniformLocation(name), (int)value);
 }
\ No newline at end of file
@@ -1,8 +1,62 @@
 #pragma once
 
 #include <string>
+#include <unordered_map>
 #include <glm/glm.hpp>
 
+// Uniform buffer binding points shared by the engine shaders
+enum UniformBlockBinding : unsigned int
+{
+    UBO_MATRICES = 0,      // view, projection
+    UBO_FRAME_DATA = 1,    // per camera: light, eye position, light clusters
+    UBO_MATERIAL_DATA = 2, // per material: diffuse, opacity
+};
+
+// std140 layouts of the FrameData and MaterialData blocks
+struct FrameUniformData
+{
+    glm::vec3 lightDir;
+    float padding0;
+    glm::vec3 viewPos;
+    float padding1;
+    glm::vec4 clusterScale; // tiles per pixel in x and y, slice scale and bias of log(depth)
+    glm::vec2 clusterDepth; // near and far planes
+    glm::vec2 padding2;
+};
+
+struct MaterialUniformData
+{
+    glm::vec3 materialDiffuse;
+    float opacity;
+};
+
+// Shader storage binding points (0 and 1 hold the skinning matrices)
+const unsigned int SSBO_INSTANCES = 2;
+const unsigned int SSBO_LIGHTS = 3;         // LightData of every visible light
+const unsigned int SSBO_LIGHT_GRID = 4;     // offset and count of each cluster
+const unsigned int SSBO_LIGHT_INDICES = 5;  // light indices of the clusters, back to back
+
+// std430 layout of one entry of the InstanceData buffer
+struct MeshInstanceData
+{
+    glm::mat4 model;
+    glm::mat4 normal; // upper 3x3 is the normal matrix
+};
+
+// std430 layout of one entry of the LightData buffer. Point lights keep the spot cosines
+// below -1, so the cone factor is always 1
+struct LightData
+{
+    glm::vec3 position;
+    float range;
+    glm::vec3 color;
+    float intensity;
+    glm::vec3 direction;
+    float spotCosOuter;
+    float spotCosInner;
+    float padding[3];
+};
+
 class Shader
 {
 public:
@@ -12,13 +66,15 @@ public:
     bool CreateSimpleColor();
     bool CreateSingleColor();
     bool CreateDepthVisualization();
+    bool CreateDepthPrepass();
+    bool CreateOverdraw();
     bool CreateNoTexture(); 
     bool CreateWater();
     bool CreateLinesShader(); 
     bool CreateNormalShader(); 
     bool CreateMeshShader(); 
-    bool CreatePickingShader(); 
     bool CreateUIOverlay();
+    bool CreateParticleShader();
     bool LoadFromSource(const char* vSource, const char* fSource, const char* gSource = nullptr);
 
     void Use() const;
@@ -26,6 +82,10 @@ public:
 
     unsigned int GetProgramID() const { return shaderProgram; }
 
+    // Location reflected at link time, -1 if the program has no such uniform
+    int GetUniformLocation(const std::string& name) const;
+
+    void SetVec2(const std::string& name, const glm::vec2& value) const;
     void SetVec3(const std::string& name, const glm::vec3& value) const;
     void SetFloat(const std::string& name, float value) const;
     void SetMat4(const std::string& name, const glm::mat4& mat) const;
@@ -36,10 +96,17 @@ public:
 
 private:
     unsigned int CompileShader(unsigned int type, const char* source);
+    void CacheUniformLocations();
 
     unsigned int shaderProgram;
+    std::unordered_map<std::string, int> uniformLocations;
 
     const char* shaderHeader;
     const char* skinningDeclarations;
     const char* skinningFunction;
+    const char* instancingDeclarations;
+    const char* frameDataBlock;
+    const char* materialDataBlock;
+    const char* meshVertexShader;
+    const char* clusteredLighting;
 };
\ No newline at end of file
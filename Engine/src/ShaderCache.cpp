@@ -0,0 +1,264 @@
+#include "ShaderCache.h"
+#include "Application.h"
+#include "LibraryManager.h"
+#include "Log.h"
+#include <SDL3/SDL.h>
+#include <glad/glad.h>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+
+// Bump when the file layout changes so stale binaries are ignored
+static const uint32_t kProgramFileMagic = 0x42505357; // "WSPB"
+static const uint32_t kProgramFileVersion = 1;
+
+// FNV-1a, stable across runs and platforms unlike std::hash
+static void HashBytes(uint64_t& hash, const void* data, size_t size)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+}
+
+static void HashString(uint64_t& hash, const char* text)
+{
+    if (!text) text = "";
+    HashBytes(hash, text, strlen(text) + 1);
+}
+
+static const uint64_t kHashSeed = 14695981039346656037ull;
+
+ShaderCache& ShaderCache::GetInstance()
+{
+    static ShaderCache instance;
+    return instance;
+}
+
+void ShaderCache::Init()
+{
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormats);
+
+    driverHash = kHashSeed;
+    HashString(driverHash, (const char*)glGetString(GL_VENDOR));
+    HashString(driverHash, (const char*)glGetString(GL_RENDERER));
+    HashString(driverHash, (const char*)glGetString(GL_VERSION));
+
+    enabled = binaryFormats > 0;
+    if (!enabled) LOG_CONSOLE("[ShaderCache] Driver exposes no program binary formats, shaders compile from source");
+}
+
+void ShaderCache::CleanUp()
+{
+    cancelWorker = true;
+    if (worker.joinable()) worker.join();
+
+    if (workerContext)
+    {
+        SDL_GL_DestroyContext(workerContext);
+        workerContext = nullptr;
+    }
+}
+
+uint64_t ShaderCache::MakeKey(const char* vSource, const char* fSource, const char* gSource) const
+{
+    uint64_t key = kHashSeed;
+    HashBytes(key, &kProgramFileVersion, sizeof(kProgramFileVersion));
+    HashBytes(key, &driverHash, sizeof(driverHash));
+    HashString(key, vSource);
+    HashString(key, fSource);
+    HashString(key, gSource);
+    return key;
+}
+
+std::string ShaderCache::GetBinaryPath(uint64_t key) const
+{
+    return LibraryManager::GetLibraryPathFromUID(key);
+}
+
+unsigned int ShaderCache::LoadProgram(uint64_t key)
+{
+    if (!enabled || !LibraryManager::IsInitialized()) return 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    uint32_t magic = 0, version = 0, format = 0, length = 0;
+    uint64_t fileKey = 0;
+    std::vector<char> binary;
+    {
+        std::lock_guard<std::mutex> lock(fileMutex);
+        std::ifstream file(GetBinaryPath(key), std::ios::binary);
+        if (!file.is_open()) return 0;
+
+        file.read(reinterpret_cast<char*>(&magic), sizeof(uint32_t));
+        file.read(reinterpret_cast<char*>(&version), sizeof(uint32_t));
+        file.read(reinterpret_cast<char*>(&fileKey), sizeof(uint64_t));
+        file.read(reinterpret_cast<char*>(&format), sizeof(uint32_t));
+        file.read(reinterpret_cast<char*>(&length), sizeof(uint32_t));
+        if (!file || magic != kProgramFileMagic || version != kProgramFileVersion || fileKey != key) return 0;
+
+        binary.resize(length);
+        file.read(binary.data(), length);
+        if (!file) return 0;
+    }
+
+    unsigned int program = glCreateProgram();
+    glProgramBinary(program, format, binary.data(), (GLsizei)length);
+
+    // Drivers reject binaries after an update even when the version string is unchanged
+    int linked = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked)
+    {
+        glDeleteProgram(program);
+        stats.rejected++;
+        return 0;
+    }
+
+    stats.hits++;
+    stats.loadTimeMs += std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    return program;
+}
+
+bool ShaderCache::SaveProgram(uint64_t key, unsigned int program)
+{
+    if (!enabled || !LibraryManager::IsInitialized()) return false;
+
+    int length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return false;
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+
+    std::lock_guard<std::mutex> lock(fileMutex);
+    std::ofstream file(GetBinaryPath(key), std::ios::binary);
+    if (!file.is_open()) return false;
+
+    uint32_t format32 = (uint32_t)format, length32 = (uint32_t)length;
+    file.write(reinterpret_cast<const char*>(&kProgramFileMagic), sizeof(uint32_t));
+    file.write(reinterpret_cast<const char*>(&kProgramFileVersion), sizeof(uint32_t));
+    file.write(reinterpret_cast<const char*>(&key), sizeof(uint64_t));
+    file.write(reinterpret_cast<const char*>(&format32), sizeof(uint32_t));
+    file.write(reinterpret_cast<const char*>(&length32), sizeof(uint32_t));
+    file.write(binary.data(), length);
+    return (bool)file;
+}
+
+void ShaderCache::PrecompileInBackground(std::vector<ShaderVariant> variants)
+{
+    if (!enabled || variants.empty() || worker.joinable()) return;
+
+    // The new context becomes current on creation, the main one is restored right away
+    SDL_Window* window = Application::GetInstance().window->GetWindow();
+    SDL_GLContext mainContext = SDL_GL_GetCurrentContext();
+
+    SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1);
+    workerContext = SDL_GL_CreateContext(window);
+    SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 0);
+    SDL_GL_MakeCurrent(window, mainContext);
+
+    if (!workerContext)
+    {
+        LOG_CONSOLE("[ShaderCache] WARNING: Could not create a shared context, shaders compile on first use: %s", SDL_GetError());
+        return;
+    }
+
+    pendingVariants = std::move(variants);
+    workerDone = false;
+    cancelWorker = false;
+    precompiled = 0;
+    precompileFailed = 0;
+    worker = std::thread(&ShaderCache::PrecompileVariants, this);
+}
+
+// Worker thread, must not log: the console is not thread safe
+void ShaderCache::PrecompileVariants()
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    SDL_Window* window = Application::GetInstance().window->GetWindow();
+    SDL_GL_MakeCurrent(window, workerContext);
+
+    for (const ShaderVariant& variant : pendingVariants)
+    {
+        if (cancelWorker) break;
+
+        uint64_t key = MakeKey(variant.vertex.c_str(), variant.fragment.c_str(),
+            variant.geometry.empty() ? nullptr : variant.geometry.c_str());
+        if (LibraryManager::FileExists(GetBinaryPath(key))) continue;
+
+        unsigned int program = LinkProgram(variant);
+        if (program != 0 && SaveProgram(key, program)) precompiled++;
+        else precompileFailed++;
+
+        if (program != 0) glDeleteProgram(program);
+    }
+
+    glFinish();
+    SDL_GL_MakeCurrent(window, nullptr);
+
+    precompileTimeMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    workerDone = true;
+}
+
+unsigned int ShaderCache::LinkProgram(const ShaderVariant& variant)
+{
+    const std::string* sources[3] = { &variant.vertex, &variant.fragment, &variant.geometry };
+    const GLenum types[3] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, GL_GEOMETRY_SHADER };
+
+    unsigned int program = glCreateProgram();
+    unsigned int shaders[3] = {};
+    bool compiled = true;
+
+    for (int i = 0; i < 3 && compiled; ++i)
+    {
+        if (sources[i]->empty()) continue;
+
+        const char* source = sources[i]->c_str();
+        shaders[i] = glCreateShader(types[i]);
+        glShaderSource(shaders[i], 1, &source, NULL);
+        glCompileShader(shaders[i]);
+
+        int success = 0;
+        glGetShaderiv(shaders[i], GL_COMPILE_STATUS, &success);
+        compiled = success != 0;
+        glAttachShader(program, shaders[i]);
+    }
+
+    int linked = 0;
+    if (compiled)
+    {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glLinkProgram(program);
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    }
+
+    for (unsigned int shader : shaders)
+    {
+        if (shader != 0) glDeleteShader(shader);
+    }
+
+    if (!linked)
+    {
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+void ShaderCache::Update()
+{
+    if (!worker.joinable() || !workerDone) return;
+
+    worker.join();
+    SDL_GL_DestroyContext(workerContext);
+    workerContext = nullptr;
+    pendingVariants.clear();
+
+    LOG_CONSOLE("[ShaderCache] Precompiled %d shader variants in the background in %.2f ms (%d failed, compiled on first use)",
+        precompiled.load(), precompileTimeMs, precompileFailed.load());
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <SDL3/SDL_video.h>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Sources of one program, as passed to Shader::LoadFromSource
+struct ShaderVariant
+{
+    std::string vertex;
+    std::string fragment;
+    std::string geometry; // empty when there is no geometry stage
+};
+
+// Linked program binaries stored in the Library, keyed by the stage sources and the
+// driver (vendor, renderer, version). Any mismatch or driver rejection falls back to
+// compiling from source, which refreshes the entry.
+class ShaderCache
+{
+public:
+    struct Stats
+    {
+        int hits = 0;
+        int compiled = 0;
+        int rejected = 0;       // binaries the driver refused to load
+        float loadTimeMs = 0.0f;
+        float compileTimeMs = 0.0f;
+    };
+
+    static ShaderCache& GetInstance();
+
+    // Needs the GL context, reads the driver identity
+    void Init();
+    void CleanUp();
+
+    bool IsEnabled() const { return enabled; }
+    void SetEnabled(bool enable) { enabled = enable && binaryFormats > 0; }
+
+    uint64_t MakeKey(const char* vSource, const char* fSource, const char* gSource) const;
+
+    // Linked program created from the cached binary, 0 on a miss
+    unsigned int LoadProgram(uint64_t key);
+    // The program must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+    bool SaveProgram(uint64_t key, unsigned int program);
+
+    void AddCompileTime(float ms) { stats.compiled++; stats.compileTimeMs += ms; }
+    const Stats& GetStats() const { return stats; }
+
+    // Compiles and stores the variants missing from the cache on a context shared
+    // with the main one, so later loads only hit the cache
+    void PrecompileInBackground(std::vector<ShaderVariant> variants);
+    // Reports and releases the background context once it is done, call every frame
+    void Update();
+
+private:
+    ShaderCache() = default;
+
+    ShaderCache(const ShaderCache&) = delete;
+    ShaderCache& operator=(const ShaderCache&) = delete;
+
+    void PrecompileVariants();
+    static unsigned int LinkProgram(const ShaderVariant& variant);
+    std::string GetBinaryPath(uint64_t key) const;
+
+    bool enabled = false;
+    int binaryFormats = 0;
+    uint64_t driverHash = 0;
+    Stats stats;
+
+    std::mutex fileMutex;
+
+    // Background precompile
+    SDL_GLContext workerContext = nullptr;
+    std::thread worker;
+    std::vector<ShaderVariant> pendingVariants;
+    std::atomic<bool> workerDone{ false };
+    std::atomic<bool> cancelWorker{ false };
+    std::atomic<int> precompiled{ 0 };
+    std::atomic<int> precompileFailed{ 0 };
+    float precompileTimeMs = 0.0f;
+};
@@ -0,0 +1,455 @@
+#include "StaticBatcher.h"
+#include "GameObject.h"
+#include "Transform.h"
+#include "ComponentMesh.h"
+#include "ComponentMaterial.h"
+#include "LibraryManager.h"
+#include "VertexFormat.h"
+#include "MetaFile.h"
+#include "Log.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <unordered_map>
+
+const float StaticBatcher::kChunkSize = 32.0f;
+const uint32_t StaticBatcher::kMaxBatchVertices = 262144;
+
+// Bump when the merge or the file layout changes so stale caches are rebuilt
+static const uint32_t kBatchFileMagic = 0x54425357; // "WSBT"
+static const uint32_t kBatchFileVersion = 2;
+
+// Recently used cache files, one per scene and static set, listed in the Library
+static const size_t kMaxCacheFiles = 8;
+static const char* kCacheIndexFile = "StaticBatches.json";
+
+// FNV-1a, stable across runs and platforms unlike std::hash
+static void HashBytes(uint64_t& hash, const void* data, size_t size)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+}
+
+template <typename T>
+static void HashValue(uint64_t& hash, const T& value)
+{
+    HashBytes(hash, &value, sizeof(T));
+}
+
+static const uint64_t kHashSeed = 14695981039346656037ull;
+
+StaticBatcher::~StaticBatcher()
+{
+    // The scene owns the sources, only the batch objects are ours
+    for (GameObject* batchObject : batchObjects)
+        delete batchObject;
+    batchObjects.clear();
+}
+
+void StaticBatcher::Build(GameObject* root)
+{
+    Clear(root);
+    stats = Stats();
+
+    if (!root) return;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::vector<Source> sources;
+    CollectSources(root, sources);
+    if (sources.empty()) return;
+
+    // Hierarchy order changes with editing, the sort keeps the output deterministic
+    std::sort(sources.begin(), sources.end(), [](const Source& a, const Source& b)
+        {
+            if (a.materialHash != b.materialHash) return a.materialHash < b.materialHash;
+            if (a.chunk.x != b.chunk.x) return a.chunk.x < b.chunk.x;
+            if (a.chunk.y != b.chunk.y) return a.chunk.y < b.chunk.y;
+            if (a.chunk.z != b.chunk.z) return a.chunk.z < b.chunk.z;
+            return a.uid < b.uid;
+        });
+
+    uint64_t hash = HashSources(sources);
+
+    std::vector<Batch> batches;
+    stats.fromCache = LoadBatches(hash, batches);
+    if (stats.fromCache)
+    {
+        TouchCacheFile(hash);
+    }
+    else
+    {
+        // Resource meshes may keep only their GPU copy, hold the vertices while merging
+        size_t sourceCount = sources.size();
+        sources.erase(std::remove_if(sources.begin(), sources.end(),
+            [](const Source& source) { return !source.mesh->AcquireCPUData(); }), sources.end());
+
+        MergeSources(sources, batches);
+
+        for (const Source& source : sources)
+            source.mesh->ReleaseCPUData();
+
+        // A cache missing some sources would hide them on the next load
+        if (sources.size() != sourceCount)
+        {
+            LOG_CONSOLE("[StaticBatcher] WARNING: %d static meshes could not be read and stay unbatched", (int)(sourceCount - sources.size()));
+        }
+        else if (SaveBatches(hash, batches))
+        {
+            TouchCacheFile(hash);
+        }
+        else
+        {
+            LOG_CONSOLE("[StaticBatcher] WARNING: Could not write batch cache to Library");
+        }
+    }
+
+    CreateBatchObjects(batches, sources);
+
+    auto end = std::chrono::high_resolution_clock::now();
+    stats.sourceMeshes = (int)sources.size();
+    stats.buildTimeMs = std::chrono::duration<float, std::milli>(end - start).count();
+
+    LOG_CONSOLE("[StaticBatcher] %d static meshes -> %d batches (%s, %.2f ms)", stats.sourceMeshes,
+        stats.batches, stats.fromCache ? "cached" : "built", stats.buildTimeMs);
+}
+
+void StaticBatcher::Clear(GameObject* root)
+{
+    for (GameObject* batchObject : batchObjects)
+        delete batchObject;
+    batchObjects.clear();
+
+    // Sources may have been destroyed meanwhile, so look them up again
+    if (root)
+    {
+        for (UID uid : batchedSources)
+        {
+            GameObject* source = root->FindChild(uid);
+            if (!source) continue;
+
+            ComponentMesh* mesh = static_cast<ComponentMesh*>(source->GetComponent(ComponentType::MESH));
+            if (mesh) mesh->SetStaticBatched(false);
+        }
+    }
+    batchedSources.clear();
+
+    stats = Stats();
+}
+
+void StaticBatcher::CollectSources(GameObject* gameObject, std::vector<Source>& sources) const
+{
+    if (!gameObject || !gameObject->IsActive()) return;
+
+    if (gameObject->IsStatic() && gameObject->transform)
+    {
+        ComponentMesh* mesh = static_cast<ComponentMesh*>(gameObject->GetComponent(ComponentType::MESH));
+        ComponentMaterial* material = mesh ? mesh->GetAttachedMaterial() : nullptr;
+
+        // Transparent and water materials need per-object sorting or animation, they stay separate
+        bool eligible = mesh && !mesh->HasSkinning() && mesh->HasMesh();
+        if (eligible && material && material->IsActive())
+        {
+            eligible = material->GetOpacity() >= 1.0f && material->GetMaterialType() == MaterialType::STANDARD;
+        }
+
+        if (eligible)
+        {
+            Source source;
+            source.mesh = mesh;
+            source.material = (material && material->IsActive()) ? material : nullptr;
+            source.uid = gameObject->GetUID();
+            source.materialHash = HashMaterial(source.material);
+            source.modelMatrix = gameObject->transform->GetGlobalMatrix();
+
+            AABB globalAABB = mesh->GetGlobalAABB();
+            glm::vec3 center = (globalAABB.min + globalAABB.max) * 0.5f;
+            source.chunk = glm::ivec3(glm::floor(center / kChunkSize));
+
+            sources.push_back(source);
+        }
+    }
+
+    for (GameObject* child : gameObject->GetChildren())
+    {
+        CollectSources(child, sources);
+    }
+}
+
+uint64_t StaticBatcher::HashMaterial(const ComponentMaterial* material)
+{
+    if (!material) return 0;
+
+    // Same fields the renderer compares when deciding if two materials draw alike
+    uint64_t hash = kHashSeed;
+    HashValue(hash, material->GetTextureUID());
+    HashValue(hash, material->GetShaderUID());
+    HashValue(hash, material->IsUsingCheckerboard());
+    HashValue(hash, material->GetMaterialType());
+    HashValue(hash, material->GetDiffuseColor());
+    HashValue(hash, material->GetOpacity());
+    return hash;
+}
+
+uint64_t StaticBatcher::HashSources(const std::vector<Source>& sources) const
+{
+    uint64_t hash = kHashSeed;
+    HashValue(hash, kBatchFileVersion);
+    HashValue(hash, kChunkSize);
+    HashValue(hash, kMaxBatchVertices);
+
+    for (const Source& source : sources)
+    {
+        const Mesh& mesh = source.mesh->GetMesh();
+
+        HashValue(hash, source.uid);
+        HashValue(hash, source.materialHash);
+        HashValue(hash, source.modelMatrix);
+        HashValue(hash, source.mesh->GetMeshUID());
+        HashValue(hash, (size_t)mesh.GetVertexCount());
+        HashValue(hash, (size_t)mesh.GetIndexCount());
+
+        // A reimport keeps the mesh UID, the Library file's time and size tell the revisions apart.
+        // Primitives and procedural meshes have no resource UID to stand for their contents.
+        // They always keep their CPU copy, resource meshes are only read on a cache miss
+        if (source.mesh->IsUsingResourceMesh())
+        {
+            std::string libraryPath = LibraryManager::GetLibraryPathFromUID(source.mesh->GetMeshUID());
+            std::error_code error;
+            HashValue(hash, MetaFileManager::GetFileTimestamp(libraryPath));
+            HashValue(hash, (uint64_t)fs::file_size(libraryPath, error));
+        }
+        else
+        {
+            HashBytes(hash, mesh.vertices.data(), mesh.vertices.size() * sizeof(Vertex));
+            HashBytes(hash, mesh.indices.data(), mesh.indices.size() * sizeof(unsigned int));
+        }
+    }
+
+    return hash;
+}
+
+void StaticBatcher::MergeSources(const std::vector<Source>& sources, std::vector<Batch>& batches) const
+{
+    size_t first = 0;
+    while (first < sources.size())
+    {
+        const Source& head = sources[first];
+
+        Batch batch;
+        batch.materialSource = head.material ? head.uid : 0;
+
+        size_t last = first;
+        while (last < sources.size() &&
+            sources[last].materialHash == head.materialHash && sources[last].chunk == head.chunk)
+        {
+            const Mesh& mesh = sources[last].mesh->GetMesh();
+            size_t vertexCount = batch.mesh.vertices.size();
+
+            if (vertexCount > 0 && vertexCount + mesh.GetVertexCount() > kMaxBatchVertices) break;
+
+            const glm::mat4& model = sources[last].modelMatrix;
+            glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(model)));
+
+            for (const Vertex& vertex : mesh.vertices)
+            {
+                Vertex merged = vertex;
+                merged.position = glm::vec3(model * glm::vec4(vertex.position, 1.0f));
+
+                glm::vec3 normal = normalMatrix * vertex.normal;
+                float length = glm::length(normal);
+                merged.normal = length > 0.0f ? normal / length : vertex.normal;
+
+                batch.mesh.vertices.push_back(merged);
+            }
+
+            for (unsigned int index : mesh.indices)
+            {
+                batch.mesh.indices.push_back(index + (unsigned int)vertexCount);
+            }
+
+            ++last;
+        }
+
+        batches.push_back(std::move(batch));
+        first = last;
+    }
+}
+
+bool StaticBatcher::SaveBatches(uint64_t hash, const std::vector<Batch>& batches) const
+{
+    if (!LibraryManager::IsInitialized()) return false;
+
+    std::ofstream file(LibraryManager::GetLibraryPathFromUID(hash), std::ios::binary);
+    if (!file.is_open()) return false;
+
+    unsigned int numBatches = static_cast<unsigned int>(batches.size());
+
+    file.write(reinterpret_cast<const char*>(&kBatchFileMagic), sizeof(uint32_t));
+    file.write(reinterpret_cast<const char*>(&kBatchFileVersion), sizeof(uint32_t));
+    file.write(reinterpret_cast<const char*>(&hash), sizeof(uint64_t));
+    file.write(reinterpret_cast<const char*>(&numBatches), sizeof(unsigned int));
+
+    for (const Batch& batch : batches)
+    {
+        unsigned int numVertices = static_cast<unsigned int>(batch.mesh.vertices.size());
+        unsigned int numIndices = static_cast<unsigned int>(batch.mesh.indices.size());
+
+        file.write(reinterpret_cast<const char*>(&batch.materialSource), sizeof(UID));
+        file.write(reinterpret_cast<const char*>(&numVertices), sizeof(unsigned int));
+        file.write(reinterpret_cast<const char*>(&numIndices), sizeof(unsigned int));
+
+        // Batches are static, only the compact stream is stored
+        std::vector<PackedVertex> packed(numVertices);
+        for (unsigned int i = 0; i < numVertices; ++i)
+            packed[i] = VertexFormat::Pack(batch.mesh.vertices[i]);
+
+        file.write(reinterpret_cast<const char*>(packed.data()), numVertices * sizeof(PackedVertex));
+        file.write(reinterpret_cast<const char*>(batch.mesh.indices.data()), numIndices * sizeof(unsigned int));
+    }
+
+    file.close();
+    return true;
+}
+
+bool StaticBatcher::LoadBatches(uint64_t hash, std::vector<Batch>& batches) const
+{
+    if (!LibraryManager::IsInitialized()) return false;
+
+    std::ifstream file(LibraryManager::GetLibraryPathFromUID(hash), std::ios::binary);
+    if (!file.is_open()) return false;
+
+    uint32_t magic = 0, version = 0;
+    uint64_t fileHash = 0;
+    unsigned int numBatches = 0;
+
+    file.read(reinterpret_cast<char*>(&magic), sizeof(uint32_t));
+    file.read(reinterpret_cast<char*>(&version), sizeof(uint32_t));
+    file.read(reinterpret_cast<char*>(&fileHash), sizeof(uint64_t));
+    file.read(reinterpret_cast<char*>(&numBatches), sizeof(unsigned int));
+
+    if (!file || magic != kBatchFileMagic || version != kBatchFileVersion || fileHash != hash) return false;
+
+    batches.resize(numBatches);
+    for (Batch& batch : batches)
+    {
+        unsigned int numVertices = 0, numIndices = 0;
+
+        file.read(reinterpret_cast<char*>(&batch.materialSource), sizeof(UID));
+        file.read(reinterpret_cast<char*>(&numVertices), sizeof(unsigned int));
+        file.read(reinterpret_cast<char*>(&numIndices), sizeof(unsigned int));
+
+        std::vector<PackedVertex> packed(numVertices);
+        batch.mesh.vertices.resize(numVertices);
+        batch.mesh.indices.resize(numIndices);
+        file.read(reinterpret_cast<char*>(packed.data()), numVertices * sizeof(PackedVertex));
+        file.read(reinterpret_cast<char*>(batch.mesh.indices.data()), numIndices * sizeof(unsigned int));
+
+        for (unsigned int i = 0; i < numVertices; ++i)
+            VertexFormat::Unpack(packed[i], nullptr, batch.mesh.vertices[i]);
+    }
+
+    if (!file)
+    {
+        LOG_CONSOLE("[StaticBatcher] WARNING: Batch cache is truncated, rebuilding");
+        batches.clear();
+        return false;
+    }
+
+    return true;
+}
+
+void StaticBatcher::TouchCacheFile(uint64_t hash) const
+{
+    if (!LibraryManager::IsInitialized()) return;
+
+    std::string indexPath = (fs::path(LibraryManager::GetLibraryRoot()) / kCacheIndexFile).string();
+
+    std::vector<uint64_t> recent;
+    std::ifstream indexIn(indexPath);
+    if (indexIn.is_open())
+    {
+        nlohmann::json index = nlohmann::json::parse(indexIn, nullptr, false);
+        if (index.is_array())
+        {
+            for (const nlohmann::json& entry : index)
+            {
+                if (entry.is_number_unsigned()) recent.push_back(entry.get<uint64_t>());
+            }
+        }
+        indexIn.close();
+    }
+
+    recent.erase(std::remove(recent.begin(), recent.end(), hash), recent.end());
+    recent.insert(recent.begin(), hash);
+
+    while (recent.size() > kMaxCacheFiles)
+    {
+        std::string path = LibraryManager::GetLibraryPathFromUID(recent.back());
+        recent.pop_back();
+
+        // Cache files share the Library with resources, only delete what is still a batch file
+        uint32_t magic = 0;
+        std::ifstream file(path, std::ios::binary);
+        file.read(reinterpret_cast<char*>(&magic), sizeof(uint32_t));
+        file.close();
+
+        std::error_code error;
+        if (magic == kBatchFileMagic) fs::remove(path, error);
+    }
+
+    std::ofstream indexOut(indexPath);
+    if (indexOut.is_open())
+    {
+        indexOut << nlohmann::json(recent).dump();
+    }
+}
+
+void StaticBatcher::CreateBatchObjects(const std::vector<Batch>& batches, const std::vector<Source>& sources)
+{
+    std::unordered_map<UID, const Source*> sourcesByUID;
+    for (const Source& source : sources)
+    {
+        sourcesByUID[source.uid] = &source;
+    }
+
+    for (size_t i = 0; i < batches.size(); ++i)
+    {
+        const Batch& batch = batches[i];
+        if (batch.mesh.vertices.empty() || batch.mesh.indices.empty()) continue;
+
+        // Batch objects live outside the hierarchy, so they are never saved or shown in the editor
+        GameObject* batchObject = new GameObject("StaticBatch_" + std::to_string(i));
+
+        // The material goes first so the mesh picks it up on creation
+        auto materialSource = sourcesByUID.find(batch.materialSource);
+        if (materialSource != sourcesByUID.end() && materialSource->second->material)
+        {
+            nlohmann::json materialObj;
+            materialSource->second->material->Serialize(materialObj);
+
+            ComponentMaterial* material = static_cast<ComponentMaterial*>(batchObject->CreateComponent(ComponentType::MATERIAL));
+            if (material) material->Deserialize(materialObj);
+        }
+
+        ComponentMesh* mesh = static_cast<ComponentMesh*>(batchObject->CreateComponent(ComponentType::MESH));
+        if (mesh) mesh->SetMesh(batch.mesh);
+
+        batchObjects.push_back(batchObject);
+        stats.vertices += (int)batch.mesh.vertices.size();
+    }
+
+    for (const Source& source : sources)
+    {
+        source.mesh->SetStaticBatched(true);
+        batchedSources.push_back(source.uid);
+    }
+
+    stats.batches = (int)batchObjects.size();
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Globals.h"
+#include "ResourceMesh.h"
+
+class GameObject;
+class ComponentMesh;
+class ComponentMaterial;
+
+// Merges meshes of GameObjects flagged static into world-space batches, one per material
+// and spatial chunk, so each chunk keeps its own AABB for culling.
+// The output only depends on the scene contents and is cached in the Library under a
+// hash of its inputs, so later runs (and game builds) load the merged geometry directly.
+// Only the most recently used cache files are kept.
+class StaticBatcher
+{
+public:
+    struct Stats
+    {
+        int sourceMeshes = 0;
+        int batches = 0;
+        int vertices = 0;
+        bool fromCache = false;
+        float buildTimeMs = 0.0f;
+    };
+
+    ~StaticBatcher();
+
+    // Batches every eligible static mesh under root. Replaces any previous batches
+    void Build(GameObject* root);
+
+    // Deletes the batch objects and lets the source meshes draw themselves again
+    void Clear(GameObject* root);
+
+    bool HasBatches() const { return !batchObjects.empty(); }
+    const Stats& GetStats() const { return stats; }
+
+    // World units per chunk side
+    static const float kChunkSize;
+    // Chunks bigger than this are split in several batches
+    static const uint32_t kMaxBatchVertices;
+
+private:
+    struct Source
+    {
+        ComponentMesh* mesh = nullptr;
+        ComponentMaterial* material = nullptr;
+        UID uid = 0;
+        uint64_t materialHash = 0;
+        glm::ivec3 chunk = glm::ivec3(0);
+        glm::mat4 modelMatrix = glm::mat4(1.0f);
+    };
+
+    struct Batch
+    {
+        UID materialSource = 0;
+        Mesh mesh;
+    };
+
+    void CollectSources(GameObject* gameObject, std::vector<Source>& sources) const;
+    uint64_t HashSources(const std::vector<Source>& sources) const;
+    void MergeSources(const std::vector<Source>& sources, std::vector<Batch>& batches) const;
+
+    bool SaveBatches(uint64_t hash, const std::vector<Batch>& batches) const;
+    bool LoadBatches(uint64_t hash, std::vector<Batch>& batches) const;
+    // Marks the cache file as most recently used and deletes the oldest ones past the limit
+    void TouchCacheFile(uint64_t hash) const;
+
+    void CreateBatchObjects(const std::vector<Batch>& batches, const std::vector<Source>& sources);
+
+    static uint64_t HashMaterial(const ComponentMaterial* material);
+
+private:
+    std::vector<GameObject*> batchObjects;
+    std::vector<UID> batchedSources;
+    Stats stats;
+};
@@ -7,6 +7,7 @@
 #include "Log.h"
 #include "TextureImporter.h"
 #include "LibraryManager.h"
+#include "GLState.h"
 
 #define CHECKERS_WIDTH 64
 #define CHECKERS_HEIGHT 64
@@ -18,7 +19,7 @@ Texture::Texture() : textureID(0), width(0), height(0), nrChannels(0)
 Texture::~Texture()
 {
     if (textureID != 0)
-        glDeleteTextures(1, &textureID);
+        GLState::DeleteTextures(1, &textureID);
 }
 
 void Texture::CreateCheckerboard()
@@ -40,7 +41,7 @@ void Texture::CreateCheckerboard()
     // Generate OpenGL texture
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
+    GLState::BindTexture(GL_TEXTURE_2D, textureID);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -50,7 +51,7 @@ void Texture::CreateCheckerboard()
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, CHECKERS_WIDTH, CHECKERS_HEIGHT,
         0, GL_RGBA, GL_UNSIGNED_BYTE, checkerImage);
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::BindTexture(GL_TEXTURE_2D, 0);
 
     width = CHECKERS_WIDTH;
     height = CHECKERS_HEIGHT;
@@ -117,10 +118,10 @@ bool FileExists(const std::string& path)
 
 void Texture::Bind()
 {
-    glBindTexture(GL_TEXTURE_2D, textureID);
+    GLState::BindTexture(GL_TEXTURE_2D, textureID);
 }
 
 void Texture::Unbind()
 {
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::BindTexture(GL_TEXTURE_2D, 0);
 }
\ No newline at end of file
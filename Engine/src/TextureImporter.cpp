@@ -9,9 +9,43 @@
 #include <filesystem>
 #include <algorithm>
 #include <iomanip>
+#include <chrono>
 
 bool TextureImporter::s_devilInitialized = false;
 
+// Bump when the file layout changes
+static const uint32_t kTextureFileMagic = 0x58455457; // "WTEX"
+static const uint32_t kTextureFileVersion = 1;
+
+// The uploads read pixels + offset for size bytes of every level, so the table read from disk
+// must describe levels that halve from the texture size, have the exact size of their format
+// and follow each other inside the data
+static bool IsValidLevelTable(const std::vector<TextureLevel>& levels, TextureFormat format,
+    unsigned int width, unsigned int height, uint64_t dataBytes) {
+    uint64_t offset = 0;
+    for (size_t i = 0; i < levels.size(); ++i) {
+        const TextureLevel& level = levels[i];
+        unsigned int expectedWidth = (i == 0) ? width : std::max(1u, levels[i - 1].width / 2);
+        unsigned int expectedHeight = (i == 0) ? height : std::max(1u, levels[i - 1].height / 2);
+
+        if (level.width == 0 || level.height == 0 || level.width != expectedWidth || level.height != expectedHeight) return false;
+        if (level.size != BlockCompression::GetLevelSize(format, level.width, level.height)) return false;
+        if (level.offset != offset) return false;
+
+        offset += level.size;
+    }
+    return offset <= dataBytes;
+}
+
+// Bytes from the read position to the end of the file, the position is kept
+static uint64_t GetBytesLeft(std::ifstream& file) {
+    std::streampos position = file.tellg();
+    file.seekg(0, std::ios::end);
+    std::streampos end = file.tellg();
+    file.seekg(position);
+    return (position >= 0 && end > position) ? static_cast<uint64_t>(end - position) : 0;
+}
+
 TextureImporter::TextureImporter() {}
 TextureImporter::~TextureImporter() {}
 
@@ -159,12 +193,77 @@ TextureData TextureImporter::ImportFromFile(const std::string& filepath,
     // Clean up DevIL resources
     ilDeleteImages(1, &imageID);
 
+    texture.levels.push_back({ texture.width, texture.height, 0, static_cast<unsigned int>(dataSize) });
+
     LOG_DEBUG("[TextureImporter] Texture imported successfully: %dx%d, %zu bytes",
         texture.width, texture.height, dataSize);
 
+    TextureFormat format = static_cast<TextureFormat>(std::clamp(settings.compression, 0, 4));
+    if ((settings.generateMipmaps || BlockCompression::IsCompressed(format)) &&
+        !BuildLevels(texture, settings.generateMipmaps, format)) {
+        LOG_CONSOLE("[TextureImporter] WARNING: Could not build mip levels for %s, keeping RGBA8", filepath.c_str());
+    }
+
     return texture;
 }
 
+bool TextureImporter::BuildLevels(TextureData& texture, bool generateMipmaps, TextureFormat format) {
+    if (!texture.IsValid() || texture.levels.size() != 1 || texture.format != TextureFormat::RGBA8) return false;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // RGBA8 chain, each level filtered from the previous one
+    std::vector<TextureLevel> sourceLevels = texture.levels;
+    std::vector<unsigned char> chain(texture.pixels, texture.pixels + texture.levels[0].size);
+
+    while (generateMipmaps && (sourceLevels.back().width > 1 || sourceLevels.back().height > 1)) {
+        const TextureLevel& previous = sourceLevels.back();
+        TextureLevel level;
+        level.width = std::max(1u, previous.width / 2);
+        level.height = std::max(1u, previous.height / 2);
+        level.offset = static_cast<unsigned int>(chain.size());
+        level.size = level.width * level.height * 4;
+
+        chain.resize(chain.size() + level.size);
+        BlockCompression::Downsample(chain.data() + previous.offset, previous.width, previous.height, chain.data() + level.offset);
+        sourceLevels.push_back(level);
+    }
+
+    std::vector<TextureLevel> levels = sourceLevels;
+    size_t dataSize = 0;
+    for (TextureLevel& level : levels) {
+        level.offset = static_cast<unsigned int>(dataSize);
+        level.size = static_cast<unsigned int>(BlockCompression::GetLevelSize(format, level.width, level.height));
+        dataSize += level.size;
+    }
+
+    unsigned char* pixels = nullptr;
+    try {
+        pixels = new unsigned char[dataSize];
+    }
+    catch (const std::bad_alloc&) {
+        LOG_DEBUG("[TextureImporter] ERROR: Failed to allocate %zu bytes", dataSize);
+        return false;
+    }
+
+    for (size_t i = 0; i < levels.size(); ++i) {
+        BlockCompression::Compress(chain.data() + sourceLevels[i].offset, levels[i].width, levels[i].height, format, pixels + levels[i].offset);
+    }
+
+    delete[] texture.pixels;
+    texture.pixels = pixels;
+    texture.levels = std::move(levels);
+    texture.format = format;
+    if (format == TextureFormat::BC1) texture.channels = 3;
+    else if (format == TextureFormat::BC5) texture.channels = 2;
+
+    float ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    LOG_DEBUG("[TextureImporter] Built %zu levels as %s in %.1f ms: %zu bytes (%zu as RGBA8)", texture.levels.size(),
+        BlockCompression::GetFormatName(format), ms, dataSize, chain.size());
+
+    return true;
+}
+
 bool TextureImporter::SaveToCustomFormat(const TextureData& texture, const UID& uid) {
     std::string fullPath = LibraryManager::GetLibraryPathFromUID(uid);
 
@@ -183,7 +282,7 @@ bool TextureImporter::SaveToCustomFormat(const TextureData& texture, const UID&
         return false;
     }
 
-    size_t expectedSize = static_cast<size_t>(texture.width) * static_cast<size_t>(texture.height) * 4;
+    size_t expectedSize = texture.GetDataSize();
     if (expectedSize == 0 || expectedSize > 100000000) {
         LOG_DEBUG("[TextureImporter] ERROR: Invalid data size: %zu bytes", expectedSize);
         return false;
@@ -195,16 +294,17 @@ bool TextureImporter::SaveToCustomFormat(const TextureData& texture, const UID&
         return false;
     }
 
-    TextureHeader header;
-    header.width = texture.width;
-    header.height = texture.height;
-    header.channels = 4;
-    header.format = GetOpenGLFormat(4);
-    header.dataSize = static_cast<unsigned int>(expectedSize);
-    header.hasAlpha = true;
-    header.compressed = false;
-
-    file.write(reinterpret_cast<const char*>(&header), sizeof(TextureHeader));
+    // Magic, version, size, channels, format and the level table, then every level
+    uint32_t format = static_cast<uint32_t>(texture.format);
+    uint32_t levelCount = static_cast<uint32_t>(texture.levels.size());
+    file.write(reinterpret_cast<const char*>(&kTextureFileMagic), sizeof(uint32_t));
+    file.write(reinterpret_cast<const char*>(&kTextureFileVersion), sizeof(uint32_t));
+    file.write(reinterpret_cast<const char*>(&texture.width), sizeof(unsigned int));
+    file.write(reinterpret_cast<const char*>(&texture.height), sizeof(unsigned int));
+    file.write(reinterpret_cast<const char*>(&texture.channels), sizeof(unsigned int));
+    file.write(reinterpret_cast<const char*>(&format), sizeof(uint32_t));
+    file.write(reinterpret_cast<const char*>(&levelCount), sizeof(uint32_t));
+    file.write(reinterpret_cast<const char*>(texture.levels.data()), levelCount * sizeof(TextureLevel));
 
     if (!file.good()) {
         LOG_DEBUG("[TextureImporter] ERROR: Failed to write header");
@@ -212,7 +312,7 @@ bool TextureImporter::SaveToCustomFormat(const TextureData& texture, const UID&
         return false;
     }
 
-    file.write(reinterpret_cast<const char*>(texture.pixels), header.dataSize);
+    file.write(reinterpret_cast<const char*>(texture.pixels), expectedSize);
 
     if (!file.good()) {
         LOG_DEBUG("[TextureImporter] ERROR: Failed to write pixel data");
@@ -225,7 +325,7 @@ bool TextureImporter::SaveToCustomFormat(const TextureData& texture, const UID&
     return true;
 }
 
-TextureData TextureImporter::LoadFromCustomFormat(const UID& uid) {
+TextureData TextureImporter::LoadFromCustomFormat(const UID& uid, unsigned int maxSize) {
     std::string fullPath = LibraryManager::GetLibraryPathFromUID(uid);
 
     TextureData texture;
@@ -236,6 +336,80 @@ TextureData TextureImporter::LoadFromCustomFormat(const UID& uid) {
         return texture;
     }
 
+    uint32_t magic = 0;
+    file.read(reinterpret_cast<char*>(&magic), sizeof(uint32_t));
+
+    if (magic == kTextureFileMagic) {
+        uint32_t version = 0, format = 0, levelCount = 0;
+        file.read(reinterpret_cast<char*>(&version), sizeof(uint32_t));
+
+        if (version > kTextureFileVersion) {
+            LOG_CONSOLE("[TextureImporter] ERROR: Texture file version %u is newer than supported (%u)", version, kTextureFileVersion);
+            return texture;
+        }
+
+        file.read(reinterpret_cast<char*>(&texture.width), sizeof(unsigned int));
+        file.read(reinterpret_cast<char*>(&texture.height), sizeof(unsigned int));
+        file.read(reinterpret_cast<char*>(&texture.channels), sizeof(unsigned int));
+        file.read(reinterpret_cast<char*>(&format), sizeof(uint32_t));
+        file.read(reinterpret_cast<char*>(&levelCount), sizeof(uint32_t));
+
+        if (!file.good() || levelCount == 0 || levelCount > 32 || format > static_cast<uint32_t>(TextureFormat::BC7)) {
+            LOG_DEBUG("[TextureImporter] ERROR: Invalid texture header in %s", fullPath.c_str());
+            texture.width = texture.height = texture.channels = 0;
+            return texture;
+        }
+
+        texture.format = static_cast<TextureFormat>(format);
+        texture.levels.resize(levelCount);
+        file.read(reinterpret_cast<char*>(texture.levels.data()), levelCount * sizeof(TextureLevel));
+
+        if (!file.good() || !IsValidLevelTable(texture.levels, texture.format, texture.width, texture.height, GetBytesLeft(file))) {
+            LOG_CONSOLE("[TextureImporter] ERROR: Corrupt or truncated level table in %s", fullPath.c_str());
+            texture.width = texture.height = texture.channels = 0;
+            texture.levels.clear();
+            return texture;
+        }
+
+        // Skip the levels above maxSize, the smallest one is always read
+        while (maxSize > 0 && texture.firstLevel + 1 < levelCount &&
+            std::max(texture.levels[texture.firstLevel].width, texture.levels[texture.firstLevel].height) > maxSize) {
+            texture.firstLevel++;
+        }
+        file.seekg(texture.levels[texture.firstLevel].offset, std::ios::cur);
+
+        size_t dataSize = texture.GetDataSize();
+        if (!file.good() || dataSize == 0 || dataSize > 100000000) {
+            LOG_DEBUG("[TextureImporter] ERROR: Invalid level table in %s", fullPath.c_str());
+            texture.width = texture.height = texture.channels = 0;
+            texture.levels.clear();
+            return texture;
+        }
+
+        try {
+            texture.pixels = new unsigned char[dataSize];
+        }
+        catch (const std::bad_alloc&) {
+            LOG_DEBUG("[TextureImporter] ERROR: Failed to allocate %zu bytes", dataSize);
+            return texture;
+        }
+
+        file.read(reinterpret_cast<char*>(texture.pixels), dataSize);
+
+        if (!file.good()) {
+            LOG_DEBUG("[TextureImporter] ERROR: Failed to read pixel data");
+            delete[] texture.pixels;
+            texture.pixels = nullptr;
+            return texture;
+        }
+
+        LOG_DEBUG("[TextureImporter] Loaded texture: %s (%ux%u, %s, levels %u-%u)", fullPath.c_str(), texture.width,
+            texture.height, BlockCompression::GetFormatName(texture.format), texture.firstLevel, levelCount - 1);
+        return texture;
+    }
+
+    // Older files are a bare TextureHeader and one RGBA level
+    file.seekg(0);
     TextureHeader header;
     file.read(reinterpret_cast<char*>(&header), sizeof(TextureHeader));
 
@@ -258,9 +432,17 @@ TextureData TextureImporter::LoadFromCustomFormat(const UID& uid) {
         return texture;
     }
 
+    // The upload reads a full RGB or RGBA image
+    if (header.dataSize < (uint64_t)header.width * header.height * (header.channels == 4 ? 4 : 3)) {
+        LOG_DEBUG("[TextureImporter] ERROR: Data size %u too small for %ux%u", header.dataSize, header.width, header.height);
+        file.close();
+        return texture;
+    }
+
     texture.width = header.width;
     texture.height = header.height;
     texture.channels = header.channels;
+    texture.levels.push_back({ header.width, header.height, 0, header.dataSize });
 
     try {
         texture.pixels = new unsigned char[header.dataSize];
@@ -289,6 +471,32 @@ TextureData TextureImporter::LoadFromCustomFormat(const UID& uid) {
     return texture;
 }
 
+bool TextureImporter::ReadLevel(const UID& uid, unsigned int level, std::vector<unsigned char>& data) {
+    std::ifstream file(LibraryManager::GetLibraryPathFromUID(uid), std::ios::binary);
+    if (!file.is_open()) return false;
+
+    uint32_t header[7] = {};
+    file.read(reinterpret_cast<char*>(header), sizeof(header));
+
+    // magic, version, width, height, channels, format, level count
+    uint32_t levelCount = header[6];
+    if (!file.good() || header[0] != kTextureFileMagic || header[1] > kTextureFileVersion ||
+        level >= levelCount || levelCount > 32 || header[5] > static_cast<uint32_t>(TextureFormat::BC7)) {
+        return false;
+    }
+
+    std::vector<TextureLevel> levels(levelCount);
+    file.read(reinterpret_cast<char*>(levels.data()), levelCount * sizeof(TextureLevel));
+    if (!file.good() || !IsValidLevelTable(levels, static_cast<TextureFormat>(header[5]), header[2], header[3], GetBytesLeft(file))) {
+        return false;
+    }
+    file.seekg(levels[level].offset, std::ios::cur);
+
+    data.resize(levels[level].size);
+    file.read(reinterpret_cast<char*>(data.data()), data.size());
+    return file.good();
+}
+
 std::string TextureImporter::GenerateTextureFilename(const std::string& originalPath) {
     std::filesystem::path path(originalPath);
 
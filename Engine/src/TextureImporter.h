@@ -1,13 +1,16 @@
 ﻿#pragma once
 
 #include "Globals.h"
+#include "BlockCompression.h"
 #include <string>
+#include <vector>
 #include <glm/glm.hpp>
 
 struct TextureData;
 struct ImportSettings; 
 
-// Header for custom texture format
+// Header of Library textures written before mip chains and block compression,
+// current files start with a magic and a level table instead
 struct TextureHeader {
     unsigned int width = 0;
     unsigned int height = 0;
@@ -18,12 +21,23 @@ struct TextureHeader {
     bool compressed = false;
 };
 
+// One mip level inside TextureData::pixels
+struct TextureLevel {
+    unsigned int width = 0;
+    unsigned int height = 0;
+    unsigned int offset = 0;
+    unsigned int size = 0;
+};
+
 // Runtime texture data
 struct TextureData {
     unsigned int width = 0;
     unsigned int height = 0;
     unsigned int channels = 0;
-    unsigned char* pixels = nullptr;
+    unsigned char* pixels = nullptr;            // levels from firstLevel on, largest first
+    TextureFormat format = TextureFormat::RGBA8;
+    std::vector<TextureLevel> levels;
+    unsigned int firstLevel = 0;                // larger levels were not read
 
     TextureData() = default;
     TextureData(const TextureData&) = delete;
@@ -34,6 +48,9 @@ struct TextureData {
         , height(other.height)
         , channels(other.channels)
         , pixels(other.pixels)
+        , format(other.format)
+        , levels(std::move(other.levels))
+        , firstLevel(other.firstLevel)
     {
         other.pixels = nullptr;
         other.width = 0;
@@ -50,6 +67,9 @@ struct TextureData {
             height = other.height;
             channels = other.channels;
             pixels = other.pixels;
+            format = other.format;
+            levels = std::move(other.levels);
+            firstLevel = other.firstLevel;
             other.pixels = nullptr;
             other.width = 0;
             other.height = 0;
@@ -68,6 +88,14 @@ struct TextureData {
     bool IsValid() const {
         return pixels != nullptr && width > 0 && height > 0;
     }
+
+    size_t GetDataSize() const {
+        return levels.empty() ? 0 : (size_t)levels.back().offset + levels.back().size - levels[firstLevel].offset;
+    }
+
+    const unsigned char* GetLevelData(size_t level) const {
+        return pixels + levels[level].offset - levels[firstLevel].offset;
+    }
 };
 
 class TextureImporter {
@@ -81,10 +109,16 @@ public:
     static TextureData ImportFromFile(const std::string& filepath);
 
     static bool SaveToCustomFormat(const TextureData& texture, const UID& uid);
-    static TextureData LoadFromCustomFormat(const UID& uid);
+    // maxSize > 0 leaves out the levels larger than it, the level table is always complete
+    static TextureData LoadFromCustomFormat(const UID& uid, unsigned int maxSize = 0);
+    // One level of a Library texture. Doesn't log, the texture streamer calls it from its thread
+    static bool ReadLevel(const UID& uid, unsigned int level, std::vector<unsigned char>& data);
     static std::string GenerateTextureFilename(const std::string& originalPath);
     static unsigned int GetOpenGLFormat(unsigned int channels);
 
+    // Replaces the single RGBA8 level with the CPU built mip chain, encoded in the given format
+    static bool BuildLevels(TextureData& texture, bool generateMipmaps, TextureFormat format);
+
 private:
     static void InitDevIL();
     static bool s_devilInitialized;
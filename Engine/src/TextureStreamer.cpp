@@ -0,0 +1,250 @@
+#include "TextureStreamer.h"
+#include "ResourceTexture.h"
+#include "TextureImporter.h"
+#include <algorithm>
+
+// Textures never drawn by a mesh (particles, UI) get their full size after this many frames
+static const uint64_t kUnusedGraceFrames = 120;
+// Bounds the reads in flight and the upload cost of a single frame
+static const int kMaxPendingRequests = 8;
+static const int kMaxUploadsPerFrame = 4;
+
+TextureStreamer& TextureStreamer::GetInstance()
+{
+    static TextureStreamer instance;
+    return instance;
+}
+
+void TextureStreamer::Init()
+{
+    if (running) return;
+
+    running = true;
+    worker = std::thread(&TextureStreamer::WorkerLoop, this);
+}
+
+void TextureStreamer::CleanUp()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+        requests.clear();
+    }
+    wakeCondition.notify_all();
+    if (worker.joinable()) worker.join();
+
+    completed.clear();
+    textures.clear();
+    reservedBytes = 0;
+}
+
+void TextureStreamer::Register(ResourceTexture* texture)
+{
+    StreamedTexture& streamed = textures[texture->GetUID()];
+    ReleaseReservation(streamed);
+    streamed = StreamedTexture();
+    streamed.texture = texture;
+    streamed.wantedLevel = texture->GetResidentLevel();
+    streamed.registeredFrame = frame;
+}
+
+void TextureStreamer::Unregister(ResourceTexture* texture)
+{
+    auto it = textures.find(texture->GetUID());
+    if (it != textures.end() && it->second.texture == texture)
+    {
+        ReleaseReservation(it->second);
+        textures.erase(it);
+    }
+}
+
+void TextureStreamer::ReleaseReservation(StreamedTexture& streamed)
+{
+    reservedBytes -= streamed.reservedBytes;
+    streamed.reservedBytes = 0;
+}
+
+void TextureStreamer::ReportUsage(UID uid, float screenSize)
+{
+    auto it = textures.find(uid);
+    if (it == textures.end()) return;
+
+    StreamedTexture& streamed = it->second;
+    streamed.screenSize = std::max(streamed.screenSize, screenSize);
+    streamed.lastUsedFrame = frame;
+}
+
+unsigned int TextureStreamer::ComputeWantedLevel(const ResourceTexture* texture, float screenSize) const
+{
+    // Smallest level that still has a texel per pixel, assuming the UVs span the texture once
+    unsigned int level = texture->GetLevelCount() - 1;
+    while (level > 0)
+    {
+        const TextureLevel& mip = texture->GetLevel(level);
+        if ((float)std::max(mip.width, mip.height) >= screenSize) break;
+        level--;
+    }
+    return level;
+}
+
+void TextureStreamer::WorkerLoop()
+{
+    while (true)
+    {
+        LevelRequest request;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeCondition.wait(lock, [this] { return !running || !requests.empty(); });
+            if (!running) return;
+
+            request = std::move(requests.front());
+            requests.pop_front();
+        }
+
+        request.loaded = TextureImporter::ReadLevel(request.uid, request.level, request.data);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        completed.push_back(std::move(request));
+    }
+}
+
+void TextureStreamer::UploadCompleted()
+{
+    std::vector<LevelRequest> finished;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        int count = std::min((int)completed.size(), kMaxUploadsPerFrame);
+        finished.assign(std::make_move_iterator(completed.begin()), std::make_move_iterator(completed.begin() + count));
+        completed.erase(completed.begin(), completed.begin() + count);
+    }
+
+    for (LevelRequest& request : finished)
+    {
+        // The texture may have been unloaded or lost levels while the read was in flight
+        auto it = textures.find(request.uid);
+        if (it == textures.end()) continue;
+
+        StreamedTexture& streamed = it->second;
+        streamed.pending = false;
+
+        // A queued upload keeps its reservation until the level is counted as resident
+        ResourceTexture* texture = streamed.texture;
+        if (request.loaded && request.level + 1 == texture->GetResidentLevel() && texture->UploadNextLevel(std::move(request.data)))
+            stats.loadedLevels++;
+        else
+            ReleaseReservation(streamed);
+    }
+
+    for (auto& pair : textures)
+    {
+        StreamedTexture& streamed = pair.second;
+        if (streamed.reservedBytes > 0 && !streamed.pending && !streamed.texture->IsUploading()) ReleaseReservation(streamed);
+    }
+}
+
+bool TextureStreamer::MakeRoom(size_t bytes, UID requester)
+{
+    // Levels already requested will land too, they take their share of the budget up front
+    while (ResourceTexture::GetTotalGPUBytes() + reservedBytes + bytes > budgetBytes)
+    {
+        // Textures not drawn this frame go first, then the ones holding more than they need
+        StreamedTexture* victim = nullptr;
+        for (auto& pair : textures)
+        {
+            StreamedTexture& candidate = pair.second;
+            const ResourceTexture* texture = candidate.texture;
+            if (pair.first == requester || candidate.pending || texture->IsUploading()) continue;
+            if (texture->GetResidentLevel() + 1 >= texture->GetLevelCount()) continue;
+
+            bool drawn = candidate.lastUsedFrame == frame;
+            if (drawn && texture->GetResidentLevel() >= candidate.wantedLevel) continue;
+
+            if (!victim || candidate.lastUsedFrame < victim->lastUsedFrame) victim = &candidate;
+        }
+
+        if (!victim) return false;
+
+        victim->texture->DropTopLevel();
+        stats.evictedLevels++;
+    }
+    return true;
+}
+
+void TextureStreamer::Update()
+{
+    UploadCompleted();
+
+    // Larger on screen first
+    std::vector<StreamedTexture*> wanting;
+    for (auto& pair : textures)
+    {
+        StreamedTexture& streamed = pair.second;
+        const ResourceTexture* texture = streamed.texture;
+
+        bool drawn = streamed.lastUsedFrame == frame && streamed.screenSize > 0.0f;
+        bool neverDrawn = streamed.lastUsedFrame == 0 && frame - streamed.registeredFrame > kUnusedGraceFrames;
+
+        if (drawn) streamed.wantedLevel = ComputeWantedLevel(texture, streamed.screenSize);
+        else if (neverDrawn) streamed.wantedLevel = 0;
+        else continue;
+
+        if (!streamed.pending && !texture->IsUploading() && texture->GetResidentLevel() > streamed.wantedLevel)
+            wanting.push_back(&streamed);
+    }
+
+    std::sort(wanting.begin(), wanting.end(), [](const StreamedTexture* a, const StreamedTexture* b) {
+        return a->screenSize > b->screenSize;
+    });
+
+    int pending = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending = (int)(requests.size() + completed.size());
+    }
+
+    stats.deferredRequests = 0;
+    for (StreamedTexture* streamed : wanting)
+    {
+        if (pending >= kMaxPendingRequests) break;
+
+        ResourceTexture* texture = streamed->texture;
+        unsigned int level = texture->GetResidentLevel() - 1;
+        size_t levelBytes = texture->GetLevel(level).size;
+
+        // Only drawn textures may push others out of the budget
+        bool drawn = streamed->screenSize > 0.0f;
+        bool fits = drawn ? MakeRoom(levelBytes, texture->GetUID())
+            : ResourceTexture::GetTotalGPUBytes() + reservedBytes + levelBytes <= budgetBytes;
+        if (!fits)
+        {
+            if (drawn) stats.deferredRequests++;
+            continue;
+        }
+
+        LevelRequest request;
+        request.uid = texture->GetUID();
+        request.level = level;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            requests.push_back(std::move(request));
+        }
+        wakeCondition.notify_one();
+
+        streamed->pending = true;
+        streamed->reservedBytes = levelBytes;
+        reservedBytes += levelBytes;
+        pending++;
+    }
+
+    // A lowered budget is enforced even without new requests
+    MakeRoom(0, 0);
+
+    for (auto& pair : textures) pair.second.screenSize = 0.0f;
+    frame++;
+
+    stats.residentBytes = ResourceTexture::GetTotalGPUBytes();
+    stats.budgetBytes = budgetBytes;
+    stats.streamedTextures = (int)textures.size();
+    stats.pendingRequests = pending;
+    stats.reservedBytes = reservedBytes;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "Globals.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class ResourceTexture;
+
+// Keeps the large mip levels of Library textures on the GPU only while something needs them.
+// Textures load with their levels up to kInitialSize, the renderer reports how large each one
+// is drawn on screen, and the missing levels are read on a background thread one at a time
+// and handed to the UploadManager.
+// Over the memory budget the least recently used textures give their top levels back.
+class TextureStreamer
+{
+public:
+    struct Stats
+    {
+        size_t residentBytes = 0;   // every loaded texture, streamed or not
+        size_t budgetBytes = 0;
+        int streamedTextures = 0;
+        int pendingRequests = 0;
+        size_t reservedBytes = 0;   // levels being read or uploaded, counted against the budget
+        int deferredRequests = 0;   // levels wanted last frame that didn't fit in the budget
+        int loadedLevels = 0;       // since startup
+        int evictedLevels = 0;      // since startup
+    };
+
+    // Largest level read when a texture loads
+    static const unsigned int kInitialSize = 64;
+
+    static TextureStreamer& GetInstance();
+
+    void Init();
+    void CleanUp();
+
+    // Applies to textures loaded afterwards
+    bool IsEnabled() const { return enabled; }
+    void SetEnabled(bool enable) { enabled = enable; }
+
+    size_t GetBudget() const { return budgetBytes; }
+    void SetBudget(size_t bytes) { budgetBytes = bytes; }
+
+    void Register(ResourceTexture* texture);
+    void Unregister(ResourceTexture* texture);
+
+    // Height in pixels the texture covers on screen for one draw, the largest one per frame wins
+    void ReportUsage(UID uid, float screenSize);
+
+    // Uploads finished reads, then requests and evicts levels. Once per frame, after rendering
+    void Update();
+
+    const Stats& GetStats() const { return stats; }
+
+private:
+    struct StreamedTexture
+    {
+        ResourceTexture* texture = nullptr;
+        float screenSize = 0.0f;        // this frame, 0 when not drawn
+        unsigned int wantedLevel = 0;
+        uint64_t lastUsedFrame = 0;
+        uint64_t registeredFrame = 0;
+        bool pending = false;
+        size_t reservedBytes = 0;       // level in flight, until it is counted as resident
+    };
+
+    struct LevelRequest
+    {
+        UID uid = 0;
+        unsigned int level = 0;
+        std::vector<unsigned char> data;
+        bool loaded = false;
+    };
+
+    TextureStreamer() = default;
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    void WorkerLoop();
+    void UploadCompleted();
+    unsigned int ComputeWantedLevel(const ResourceTexture* texture, float screenSize) const;
+    // Drops top levels, least recently used first, until bytes more fit in the budget
+    bool MakeRoom(size_t bytes, UID requester);
+    void ReleaseReservation(StreamedTexture& streamed);
+
+    bool enabled = true;
+    size_t budgetBytes = 512ull * 1024 * 1024;
+    uint64_t frame = 1;     // lastUsedFrame 0 means never drawn
+    size_t reservedBytes = 0;
+    Stats stats;
+
+    std::unordered_map<UID, StreamedTexture> textures;
+
+    // Background reads
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wakeCondition;
+    std::deque<LevelRequest> requests;
+    std::vector<LevelRequest> completed;
+    bool running = false;
+};
@@ -0,0 +1,279 @@
+#include "UploadManager.h"
+#include "Log.h"
+#include "GLState.h"
+#include <algorithm>
+#include <cstring>
+
+// Offsets of texture sources and buffer copies stay aligned for every format
+static const size_t kStagingAlignment = 256;
+
+UploadManager& UploadManager::GetInstance()
+{
+    static UploadManager instance;
+    return instance;
+}
+
+bool UploadManager::Init(size_t size)
+{
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glGenBuffers(1, &stagingBuffer);
+    glBindBuffer(GL_COPY_READ_BUFFER, stagingBuffer);
+    glBufferStorage(GL_COPY_READ_BUFFER, (GLsizeiptr)size, nullptr, flags);
+    stagingData = (unsigned char*)glMapBufferRange(GL_COPY_READ_BUFFER, 0, (GLsizeiptr)size, flags);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+    if (!stagingData)
+    {
+        LOG_CONSOLE("[UploadManager] WARNING: Could not map the staging buffer, uploads stay synchronous");
+        glDeleteBuffers(1, &stagingBuffer);
+        stagingBuffer = 0;
+        return false;
+    }
+
+    ringSize = size;
+    ringHead = 0;
+    ringUsed = 0;
+    stats.ringSize = size;
+    return true;
+}
+
+void UploadManager::CleanUp()
+{
+    for (Batch& batch : batches)
+    {
+        if (batch.fence) glDeleteSync(batch.fence);
+    }
+    batches.clear();
+    queue.clear();
+
+    if (stagingBuffer != 0)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, stagingBuffer);
+        glUnmapBuffer(GL_COPY_READ_BUFFER);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glDeleteBuffers(1, &stagingBuffer);
+    }
+
+    stagingBuffer = 0;
+    stagingData = nullptr;
+    ringSize = 0;
+}
+
+UploadManager::Ticket UploadManager::UploadTextureLevel(const void* owner, unsigned int texture, int level,
+    unsigned int width, unsigned int height, unsigned int glFormat, bool compressed,
+    std::vector<unsigned char> data, std::function<void()> onComplete)
+{
+    Upload upload;
+    upload.type = UploadType::TEXTURE_LEVEL;
+    upload.owner = owner;
+    upload.object = texture;
+    upload.level = level;
+    upload.width = width;
+    upload.height = height;
+    upload.glFormat = glFormat;
+    upload.compressed = compressed;
+    upload.data = std::move(data);
+    upload.onComplete = std::move(onComplete);
+    return Enqueue(std::move(upload));
+}
+
+UploadManager::Ticket UploadManager::UploadBuffer(unsigned int buffer, size_t offset, std::vector<unsigned char> data)
+{
+    Upload upload;
+    upload.type = UploadType::BUFFER;
+    upload.object = buffer;
+    upload.offset = offset;
+    upload.data = std::move(data);
+    return Enqueue(std::move(upload));
+}
+
+UploadManager::Ticket UploadManager::Enqueue(Upload&& upload)
+{
+    // Without the ring there is nothing to overlap with, the data goes now
+    if (!stagingData)
+    {
+        Issue(upload, upload.data.data(), false);
+        if (upload.onComplete) upload.onComplete();
+        return 0;
+    }
+
+    upload.ticket = nextTicket++;
+    stats.queuedBytes += upload.data.size();
+    queue.push_back(std::move(upload));
+    return queue.back().ticket;
+}
+
+void UploadManager::Cancel(const void* owner)
+{
+    if (owner == nullptr) return;
+
+    for (auto it = queue.begin(); it != queue.end();)
+    {
+        if (it->owner == owner)
+        {
+            stats.queuedBytes -= it->data.size();
+            it = queue.erase(it);
+        }
+        else ++it;
+    }
+
+    for (Batch& batch : batches)
+    {
+        for (auto& callback : batch.callbacks)
+        {
+            if (callback.first == owner) callback.second = nullptr;
+        }
+    }
+}
+
+void UploadManager::CancelBuffer(unsigned int buffer)
+{
+    if (buffer == 0) return;
+
+    for (auto it = queue.begin(); it != queue.end();)
+    {
+        if (it->type == UploadType::BUFFER && it->object == buffer)
+        {
+            stats.queuedBytes -= it->data.size();
+            it = queue.erase(it);
+        }
+        else ++it;
+    }
+}
+
+void UploadManager::Issue(const Upload& upload, const void* source, bool staged)
+{
+    if (upload.type == UploadType::TEXTURE_LEVEL)
+    {
+        if (staged) glBindBuffer(GL_PIXEL_UNPACK_BUFFER, GetInstance().stagingBuffer);
+        GLState::BindTexture(GL_TEXTURE_2D, upload.object);
+
+        if (upload.compressed)
+        {
+            glCompressedTexImage2D(GL_TEXTURE_2D, upload.level, upload.glFormat, upload.width, upload.height, 0,
+                (GLsizei)upload.data.size(), source);
+        }
+        else
+        {
+            glTexImage2D(GL_TEXTURE_2D, upload.level, upload.glFormat, upload.width, upload.height, 0,
+                upload.glFormat, GL_UNSIGNED_BYTE, source);
+        }
+
+        GLState::BindTexture(GL_TEXTURE_2D, 0);
+        if (staged) glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    else
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, upload.object);
+        if (staged)
+        {
+            glBindBuffer(GL_COPY_READ_BUFFER, GetInstance().stagingBuffer);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, (GLintptr)(size_t)source,
+                (GLintptr)upload.offset, (GLsizeiptr)upload.data.size());
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        }
+        else
+        {
+            glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)upload.offset, (GLsizeiptr)upload.data.size(), source);
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+}
+
+size_t UploadManager::Allocate(size_t size, size_t& ringBytes)
+{
+    size_t aligned = (size + kStagingAlignment - 1) & ~(kStagingAlignment - 1);
+
+    if (ringHead + aligned <= ringSize)
+    {
+        if (ringUsed + aligned > ringSize) return SIZE_MAX;
+
+        size_t offset = ringHead;
+        ringHead += aligned;
+        ringUsed += aligned;
+        ringBytes += aligned;
+        return offset;
+    }
+
+    // Wrap, the tail end of the ring is wasted until this batch retires
+    size_t padding = ringSize - ringHead;
+    if (ringUsed + padding + aligned > ringSize) return SIZE_MAX;
+
+    ringHead = aligned;
+    ringUsed += padding + aligned;
+    ringBytes += padding + aligned;
+    return 0;
+}
+
+void UploadManager::Update()
+{
+    // Batches retire in order, so every ticket up to the last one retired is complete
+    while (!batches.empty())
+    {
+        Batch& batch = batches.front();
+        GLenum status = glClientWaitSync(batch.fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) break;
+
+        glDeleteSync(batch.fence);
+        ringUsed -= batch.ringBytes;
+        completedTicket = batch.lastTicket;
+
+        std::vector<std::pair<const void*, std::function<void()>>> callbacks = std::move(batch.callbacks);
+        batches.pop_front();
+
+        for (auto& callback : callbacks)
+        {
+            if (callback.second) callback.second();
+        }
+    }
+
+    if (batches.empty())
+    {
+        ringHead = 0;
+        ringUsed = 0;
+    }
+
+    Batch batch;
+    size_t issuedBytes = 0;
+
+    while (!queue.empty())
+    {
+        Upload& upload = queue.front();
+        size_t size = upload.data.size();
+
+        // The first upload of a frame always goes, so one larger than the budget still progresses
+        if (issuedBytes > 0 && issuedBytes + size > frameBudget) break;
+
+        if (size > ringSize)
+        {
+            Issue(upload, upload.data.data(), false);
+            stats.directUploads++;
+        }
+        else
+        {
+            size_t offset = Allocate(size, batch.ringBytes);
+            if (offset == SIZE_MAX) break;
+
+            memcpy(stagingData + offset, upload.data.data(), size);
+            Issue(upload, (const void*)offset, true);
+        }
+
+        issuedBytes += size;
+        stats.queuedBytes -= size;
+        batch.lastTicket = upload.ticket;
+        batch.callbacks.emplace_back(upload.owner, std::move(upload.onComplete));
+        queue.pop_front();
+    }
+
+    if (batch.lastTicket != 0)
+    {
+        batch.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        batches.push_back(std::move(batch));
+    }
+
+    stats.queuedUploads = (int)queue.size();
+    stats.uploadedBytes = issuedBytes;
+    stats.batchesInFlight = (int)batches.size();
+    stats.ringUsed = ringUsed;
+}
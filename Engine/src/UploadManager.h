@@ -0,0 +1,107 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vector>
+
+// Moves texture levels and buffer contents to the GPU through a persistently mapped staging
+// ring. Uploads are queued with their data and issued over the next frames under a byte budget,
+// the copies of each frame are fenced and their tickets complete once the GPU has run them.
+// Before Init, or for data larger than the ring, uploads go straight from client memory.
+class UploadManager
+{
+public:
+    typedef uint64_t Ticket;    // 0 is always complete
+
+    struct Stats
+    {
+        int queuedUploads = 0;
+        size_t queuedBytes = 0;
+        size_t uploadedBytes = 0;   // last frame
+        int batchesInFlight = 0;
+        size_t ringUsed = 0;
+        size_t ringSize = 0;
+        int directUploads = 0;      // since startup, too large for the ring
+    };
+
+    static UploadManager& GetInstance();
+
+    bool Init(size_t ringSize);
+    void CleanUp();
+
+    size_t GetFrameBudget() const { return frameBudget; }
+    void SetFrameBudget(size_t bytes) { frameBudget = bytes; }
+
+    // Defines a texture level from data (glTexImage2D or glCompressedTexImage2D)
+    Ticket UploadTextureLevel(const void* owner, unsigned int texture, int level, unsigned int width, unsigned int height,
+        unsigned int glFormat, bool compressed, std::vector<unsigned char> data, std::function<void()> onComplete = nullptr);
+
+    // Fills part of a buffer whose storage already exists
+    Ticket UploadBuffer(unsigned int buffer, size_t offset, std::vector<unsigned char> data);
+
+    bool IsComplete(Ticket ticket) const { return ticket <= completedTicket; }
+
+    // Drops the queued uploads of an owner and the callbacks of the ones in flight
+    void Cancel(const void* owner);
+    // Drops the queued uploads into a buffer about to be deleted, its id may be reused
+    void CancelBuffer(unsigned int buffer);
+
+    // Retires finished batches, then issues queued uploads within the budget. Once per frame, before rendering
+    void Update();
+
+    const Stats& GetStats() const { return stats; }
+
+private:
+    enum class UploadType { TEXTURE_LEVEL, BUFFER };
+
+    struct Upload
+    {
+        UploadType type = UploadType::BUFFER;
+        const void* owner = nullptr;
+        Ticket ticket = 0;
+        unsigned int object = 0;        // texture or buffer
+        int level = 0;
+        unsigned int width = 0;
+        unsigned int height = 0;
+        unsigned int glFormat = 0;
+        bool compressed = false;
+        size_t offset = 0;              // destination offset for buffers
+        std::vector<unsigned char> data;
+        std::function<void()> onComplete;
+    };
+
+    struct Batch
+    {
+        GLsync fence = nullptr;
+        size_t ringBytes = 0;           // wrap padding included
+        Ticket lastTicket = 0;
+        std::vector<std::pair<const void*, std::function<void()>>> callbacks;
+    };
+
+    UploadManager() = default;
+
+    UploadManager(const UploadManager&) = delete;
+    UploadManager& operator=(const UploadManager&) = delete;
+
+    Ticket Enqueue(Upload&& upload);
+    // source is an offset in the staging buffer when it is bound, else a client pointer
+    static void Issue(const Upload& upload, const void* source, bool staged);
+    // Offset in the ring, or SIZE_MAX when it is full
+    size_t Allocate(size_t size, size_t& ringBytes);
+
+    unsigned int stagingBuffer = 0;
+    unsigned char* stagingData = nullptr;
+    size_t ringSize = 0;
+    size_t ringHead = 0;
+    size_t ringUsed = 0;
+
+    size_t frameBudget = 8 * 1024 * 1024;
+    Ticket nextTicket = 1;
+    Ticket completedTicket = 0;
+
+    std::deque<Upload> queue;
+    std::deque<Batch> batches;
+    Stats stats;
+};
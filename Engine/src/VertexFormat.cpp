@@ -0,0 +1,356 @@
+#include "VertexFormat.h"
+#include "ResourceMesh.h"
+#include "UploadManager.h"
+#include "GLState.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    VertexLayout defaultLayout = VertexLayout::COMPACT;
+    size_t uploadedBytes = 0;
+    size_t uploadedFullBytes = 0;
+
+    // PackedSkin stores bone indices in a byte
+    const size_t kMaxPackedBones = 256;
+
+    int32_t PackSnorm10(float value)
+    {
+        value = std::max(-1.0f, std::min(1.0f, value));
+        return (int32_t)std::lround(value * 511.0f);
+    }
+
+    float UnpackSnorm10(uint32_t bits)
+    {
+        int32_t value = (int32_t)(bits << 22) >> 22; // sign extend 10 bits
+        return std::max((float)value / 511.0f, -1.0f);
+    }
+
+    template <typename T>
+    std::vector<unsigned char> ToBytes(const std::vector<T>& values)
+    {
+        const unsigned char* data = (const unsigned char*)values.data();
+        return std::vector<unsigned char>(data, data + values.size() * sizeof(T));
+    }
+}
+
+VertexLayout VertexFormat::GetDefaultLayout()
+{
+    return defaultLayout;
+}
+
+void VertexFormat::SetDefaultLayout(VertexLayout layout)
+{
+    defaultLayout = layout;
+}
+
+VertexLayout VertexFormat::ChooseLayout(const Mesh& mesh)
+{
+    if (mesh.bones.size() > kMaxPackedBones) return VertexLayout::FULL;
+    return defaultLayout;
+}
+
+uint32_t VertexFormat::PackNormal(const glm::vec3& normal)
+{
+    uint32_t x = (uint32_t)PackSnorm10(normal.x) & 0x3FF;
+    uint32_t y = (uint32_t)PackSnorm10(normal.y) & 0x3FF;
+    uint32_t z = (uint32_t)PackSnorm10(normal.z) & 0x3FF;
+    return x | (y << 10) | (z << 20);
+}
+
+glm::vec3 VertexFormat::UnpackNormal(uint32_t packed)
+{
+    return glm::vec3(UnpackSnorm10(packed & 0x3FF), UnpackSnorm10((packed >> 10) & 0x3FF), UnpackSnorm10((packed >> 20) & 0x3FF));
+}
+
+uint16_t VertexFormat::FloatToHalf(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    uint32_t sign = (bits >> 16) & 0x8000;
+    int32_t exponent = (int32_t)((bits >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    if (((bits >> 23) & 0xFF) == 0xFF) return (uint16_t)(sign | 0x7C00 | (mantissa ? 0x200 : 0)); // inf, nan
+    if (exponent >= 31) return (uint16_t)(sign | 0x7C00);                                          // overflow
+    if (exponent <= 0)
+    {
+        // Denormal or zero
+        if (exponent < -10) return (uint16_t)sign;
+        mantissa |= 0x800000;
+        uint32_t shift = (uint32_t)(14 - exponent);
+        uint32_t half = mantissa >> shift;
+        if ((mantissa >> (shift - 1)) & 1) half++;
+        return (uint16_t)(sign | half);
+    }
+
+    uint32_t half = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);
+    if (mantissa & 0x1000) half++; // round, may carry into the exponent which is still correct
+    return (uint16_t)half;
+}
+
+float VertexFormat::HalfToFloat(uint16_t value)
+{
+    uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1F;
+    uint32_t mantissa = value & 0x3FF;
+    uint32_t bits;
+
+    if (exponent == 0)
+    {
+        if (mantissa == 0)
+        {
+            bits = sign;
+        }
+        else
+        {
+            // Denormal, renormalize
+            exponent = 127 - 15 + 1;
+            while ((mantissa & 0x400) == 0)
+            {
+                mantissa <<= 1;
+                exponent--;
+            }
+            bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+        }
+    }
+    else if (exponent == 31)
+    {
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    }
+    else
+    {
+        bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    }
+
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+PackedVertex VertexFormat::Pack(const Vertex& vertex)
+{
+    PackedVertex packed;
+    packed.position[0] = vertex.position.x;
+    packed.position[1] = vertex.position.y;
+    packed.position[2] = vertex.position.z;
+    packed.normal = PackNormal(vertex.normal);
+    packed.texCoords[0] = FloatToHalf(vertex.texCoords.x);
+    packed.texCoords[1] = FloatToHalf(vertex.texCoords.y);
+    return packed;
+}
+
+PackedSkin VertexFormat::PackSkin(const Vertex& vertex)
+{
+    PackedSkin skin;
+    for (int i = 0; i < 4; ++i)
+    {
+        bool used = vertex.boneIDs[i] >= 0 && vertex.boneIDs[i] < (int)kMaxPackedBones;
+        skin.boneIDs[i] = used ? (uint8_t)vertex.boneIDs[i] : 0;
+        skin.weights[i] = used ? (uint8_t)std::lround(std::max(0.0f, std::min(1.0f, vertex.weights[i])) * 255.0f) : 0;
+    }
+    return skin;
+}
+
+void VertexFormat::Unpack(const PackedVertex& packed, const PackedSkin* skin, Vertex& vertex)
+{
+    vertex.position = glm::vec3(packed.position[0], packed.position[1], packed.position[2]);
+    vertex.normal = UnpackNormal(packed.normal);
+    vertex.texCoords = glm::vec2(HalfToFloat(packed.texCoords[0]), HalfToFloat(packed.texCoords[1]));
+
+    for (int i = 0; i < 4; ++i)
+    {
+        bool used = skin && skin->weights[i] > 0;
+        vertex.boneIDs[i] = used ? skin->boneIDs[i] : -1;
+        vertex.weights[i] = used ? skin->weights[i] / 255.0f : 0.0f;
+    }
+}
+
+size_t VertexFormat::GetVertexSize(VertexLayout layout, bool skinned)
+{
+    if (layout == VertexLayout::FULL) return sizeof(Vertex);
+    return sizeof(PackedVertex) + (skinned ? sizeof(PackedSkin) : 0);
+}
+
+void VertexFormat::Upload(Mesh& mesh)
+{
+    // Ids copied along with the mesh data belong to someone else
+    mesh.VAO = mesh.VBO = mesh.skinVBO = mesh.EBO = 0;
+    mesh.depthVAO = mesh.positionVBO = 0;
+    mesh.gpuVertexBytes = 0;
+    mesh.uploadTicket = 0;
+
+    if (mesh.vertices.empty() || mesh.indices.empty()) return;
+
+    // Storage is allocated now and filled by the UploadManager over the next frames
+    UploadManager& uploads = UploadManager::GetInstance();
+
+    VertexLayout layout = ChooseLayout(mesh);
+    bool skinned = !mesh.bones.empty();
+
+    glGenVertexArrays(1, &mesh.VAO);
+    GLState::BindVertexArray(mesh.VAO);
+
+    glGenBuffers(1, &mesh.VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+
+    if (layout == VertexLayout::COMPACT)
+    {
+        std::vector<unsigned char> packed(mesh.vertices.size() * sizeof(PackedVertex));
+        PackedVertex* packedVertices = (PackedVertex*)packed.data();
+        for (size_t i = 0; i < mesh.vertices.size(); ++i)
+            packedVertices[i] = Pack(mesh.vertices[i]);
+
+        glBufferData(GL_ARRAY_BUFFER, packed.size(), nullptr, GL_STATIC_DRAW);
+        mesh.uploadTicket = uploads.UploadBuffer(mesh.VBO, 0, std::move(packed));
+
+        // Position
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, position));
+
+        // Normal
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, normal));
+
+        // TexCoords
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, texCoords));
+
+        if (skinned)
+        {
+            std::vector<unsigned char> skin(mesh.vertices.size() * sizeof(PackedSkin));
+            PackedSkin* packedSkin = (PackedSkin*)skin.data();
+            for (size_t i = 0; i < mesh.vertices.size(); ++i)
+                packedSkin[i] = PackSkin(mesh.vertices[i]);
+
+            glGenBuffers(1, &mesh.skinVBO);
+            glBindBuffer(GL_ARRAY_BUFFER, mesh.skinVBO);
+            glBufferData(GL_ARRAY_BUFFER, skin.size(), nullptr, GL_STATIC_DRAW);
+            mesh.uploadTicket = uploads.UploadBuffer(mesh.skinVBO, 0, std::move(skin));
+
+            // Bones
+            glEnableVertexAttribArray(3);
+            glVertexAttribIPointer(3, 4, GL_UNSIGNED_BYTE, sizeof(PackedSkin), (void*)offsetof(PackedSkin, boneIDs));
+
+            // Weights
+            glEnableVertexAttribArray(4);
+            glVertexAttribPointer(4, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PackedSkin), (void*)offsetof(PackedSkin, weights));
+        }
+    }
+    else
+    {
+        glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(Vertex), nullptr, GL_STATIC_DRAW);
+        mesh.uploadTicket = uploads.UploadBuffer(mesh.VBO, 0, ToBytes(mesh.vertices));
+
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
+
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoords));
+
+        glEnableVertexAttribArray(3);
+        glVertexAttribIPointer(3, 4, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, boneIDs));
+
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, weights));
+    }
+
+    // Positions alone for the depth pre-pass, skinned meshes are not pre-passed
+    if (!skinned)
+    {
+        std::vector<unsigned char> positions(mesh.vertices.size() * sizeof(glm::vec3));
+        glm::vec3* packedPositions = (glm::vec3*)positions.data();
+        for (size_t i = 0; i < mesh.vertices.size(); ++i)
+            packedPositions[i] = mesh.vertices[i].position;
+
+        glGenBuffers(1, &mesh.positionVBO);
+        glBindBuffer(GL_ARRAY_BUFFER, mesh.positionVBO);
+        glBufferData(GL_ARRAY_BUFFER, positions.size(), nullptr, GL_STATIC_DRAW);
+        mesh.uploadTicket = uploads.UploadBuffer(mesh.positionVBO, 0, std::move(positions));
+    }
+
+    // Index buffer, with the LODs after the full mesh
+    std::vector<unsigned int> gpuIndices = mesh.GetGPUIndices();
+    glGenBuffers(1, &mesh.EBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, gpuIndices.size() * sizeof(unsigned int), nullptr, GL_STATIC_DRAW);
+
+    // Uploads complete in order, the index buffer's ticket covers the whole mesh
+    mesh.uploadTicket = uploads.UploadBuffer(mesh.EBO, 0, ToBytes(gpuIndices));
+
+    GLState::BindVertexArray(0);
+
+    if (mesh.positionVBO != 0)
+    {
+        glGenVertexArrays(1, &mesh.depthVAO);
+        GLState::BindVertexArray(mesh.depthVAO);
+
+        glBindBuffer(GL_ARRAY_BUFFER, mesh.positionVBO);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO);
+
+        GLState::BindVertexArray(0);
+    }
+
+    // Kept so the mesh can still be drawn and culled once its CPU copy is dropped
+    mesh.gpuLayout = layout;
+    mesh.gpuVertexCount = (unsigned int)mesh.vertices.size();
+    for (int lod = 0; lod < kMaxMeshLODs; ++lod)
+        mesh.gpuIndexCounts[lod] = lod < mesh.GetLODCount() ? mesh.GetLODIndexCount(lod) : 0;
+
+    mesh.boundsMin = mesh.boundsMax = mesh.vertices[0].position;
+    for (const Vertex& vertex : mesh.vertices)
+    {
+        mesh.boundsMin = glm::min(mesh.boundsMin, vertex.position);
+        mesh.boundsMax = glm::max(mesh.boundsMax, vertex.position);
+    }
+
+    mesh.gpuVertexBytes = mesh.vertices.size() * GetVertexSize(layout, skinned);
+    if (mesh.positionVBO != 0) mesh.gpuVertexBytes += mesh.vertices.size() * sizeof(glm::vec3);
+    uploadedBytes += mesh.gpuVertexBytes;
+    uploadedFullBytes += mesh.vertices.size() * sizeof(Vertex);
+}
+
+void VertexFormat::Release(Mesh& mesh)
+{
+    UploadManager& uploads = UploadManager::GetInstance();
+    uploads.CancelBuffer(mesh.VBO);
+    uploads.CancelBuffer(mesh.skinVBO);
+    uploads.CancelBuffer(mesh.EBO);
+    uploads.CancelBuffer(mesh.positionVBO);
+
+    if (mesh.VAO != 0) GLState::DeleteVertexArrays(1, &mesh.VAO);
+    if (mesh.depthVAO != 0) GLState::DeleteVertexArrays(1, &mesh.depthVAO);
+    if (mesh.positionVBO != 0) glDeleteBuffers(1, &mesh.positionVBO);
+    if (mesh.VBO != 0) glDeleteBuffers(1, &mesh.VBO);
+    if (mesh.skinVBO != 0) glDeleteBuffers(1, &mesh.skinVBO);
+    if (mesh.EBO != 0) glDeleteBuffers(1, &mesh.EBO);
+
+    if (mesh.gpuVertexBytes > 0)
+    {
+        uploadedBytes -= std::min(uploadedBytes, mesh.gpuVertexBytes);
+        uploadedFullBytes -= std::min(uploadedFullBytes, (size_t)mesh.gpuVertexCount * sizeof(Vertex));
+    }
+
+    mesh.VAO = mesh.VBO = mesh.skinVBO = mesh.EBO = 0;
+    mesh.depthVAO = mesh.positionVBO = 0;
+    mesh.gpuVertexBytes = 0;
+    mesh.uploadTicket = 0;
+}
+
+size_t VertexFormat::GetUploadedBytes()
+{
+    return uploadedBytes;
+}
+
+size_t VertexFormat::GetUploadedFullBytes()
+{
+    return uploadedFullBytes;
+}
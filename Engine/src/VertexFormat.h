@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+struct Vertex;
+struct Mesh;
+
+// How a mesh's vertices are laid out on the GPU and in Library files.
+// The CPU side always keeps full Vertex data, since colliders, occlusion and batching read it.
+enum class VertexLayout : uint32_t
+{
+    FULL = 0,       // Vertex as is, 80 bytes with skinning data inline
+    COMPACT = 1     // PackedVertex (20 bytes) plus PackedSkin (8 bytes) for skinned meshes only
+};
+
+// Static stream. Every attribute is a format GL converts on fetch, so shaders still
+// declare vec3 aNormal and vec2 aTexCoords
+struct PackedVertex
+{
+    float position[3];
+    uint32_t normal;            // snorm 10:10:10:2
+    uint16_t texCoords[2];      // half floats
+};
+
+// Skinning stream, bound to the same attribute slots as the full layout
+struct PackedSkin
+{
+    uint8_t boneIDs[4];
+    uint8_t weights[4];         // unorm8, unused influences have weight 0
+};
+
+namespace VertexFormat
+{
+    // Layout used by meshes imported or uploaded from now on
+    VertexLayout GetDefaultLayout();
+    void SetDefaultLayout(VertexLayout layout);
+
+    // The default layout, unless the mesh has more bones than PackedSkin can index
+    VertexLayout ChooseLayout(const Mesh& mesh);
+
+    uint32_t PackNormal(const glm::vec3& normal);
+    glm::vec3 UnpackNormal(uint32_t packed);
+    uint16_t FloatToHalf(float value);
+    float HalfToFloat(uint16_t value);
+
+    PackedVertex Pack(const Vertex& vertex);
+    PackedSkin PackSkin(const Vertex& vertex);
+    // skin can be null for static meshes
+    void Unpack(const PackedVertex& packed, const PackedSkin* skin, Vertex& vertex);
+
+    // Bytes per vertex on the GPU, both streams included
+    size_t GetVertexSize(VertexLayout layout, bool skinned);
+
+    // Creates the VAO, vertex streams and index buffer (LODs included) of a mesh
+    void Upload(Mesh& mesh);
+    void Release(Mesh& mesh);
+
+    // Vertex stream bytes currently uploaded, and what they would take as full vertices
+    size_t GetUploadedBytes();
+    size_t GetUploadedFullBytes();
+}
@@ -0,0 +1,195 @@
+#include "Tests.h"
+#include "GLState.h"
+#include <string>
+#include <vector>
+
+// Every call that reaches the function table, as a line of text
+static std::vector<std::string> glCalls;
+
+template <typename... Args>
+static void Record(const char* format, Args... args)
+{
+    char buffer[128];
+    std::snprintf(buffer, sizeof(buffer), format, args...);
+    glCalls.push_back(buffer);
+}
+
+static GLFunctions MakeRecordingFunctions()
+{
+    GLFunctions functions;
+    functions.enable = [](GLenum cap) { Record("enable %x", cap); };
+    functions.disable = [](GLenum cap) { Record("disable %x", cap); };
+    functions.useProgram = [](GLuint id) { Record("useProgram %u", id); };
+    functions.activeTexture = [](GLenum unit) { Record("activeTexture %u", unit - GL_TEXTURE0); };
+    functions.bindTexture = [](GLenum target, GLuint texture) { Record("bindTexture %x %u", target, texture); };
+    functions.bindTextureUnit = [](GLuint unit, GLuint texture) { Record("bindTextureUnit %u %u", unit, texture); };
+    functions.bindTextures = [](GLuint first, GLsizei count, const GLuint* ids)
+        {
+            std::string line = "bindTextures " + std::to_string(first);
+            for (GLsizei i = 0; i < count; ++i) line += " " + std::to_string(ids[i]);
+            glCalls.push_back(line);
+        };
+    functions.bindVertexArray = [](GLuint vao) { Record("bindVertexArray %u", vao); };
+    functions.depthMask = [](GLboolean flag) { Record("depthMask %d", (int)flag); };
+    functions.depthFunc = [](GLenum func) { Record("depthFunc %x", func); };
+    functions.blendFunc = [](GLenum source, GLenum destination) { Record("blendFunc %x %x", source, destination); };
+    functions.cullFace = [](GLenum mode) { Record("cullFace %x", mode); };
+    functions.colorMask = [](GLboolean r, GLboolean g, GLboolean b, GLboolean a) { Record("colorMask %d%d%d%d", r, g, b, a); };
+    functions.stencilFunc = [](GLenum func, GLint ref, GLuint mask) { Record("stencilFunc %x %d %x", func, ref, mask); };
+    functions.stencilMask = [](GLuint mask) { Record("stencilMask %x", mask); };
+    functions.stencilOp = [](GLenum sfail, GLenum dpfail, GLenum dppass) { Record("stencilOp %x %x %x", sfail, dpfail, dppass); };
+    functions.polygonMode = [](GLenum face, GLenum mode) { Record("polygonMode %x %x", face, mode); };
+    functions.deleteTextures = [](GLsizei count, const GLuint* ids) { Record("deleteTextures %d", count); };
+    functions.deleteVertexArrays = [](GLsizei count, const GLuint* ids) { Record("deleteVertexArrays %d", count); };
+    return functions;
+}
+
+// Starts each case from unknown state with an empty log
+static void Reset()
+{
+    GLState::SetFunctions(MakeRecordingFunctions());
+    glCalls.clear();
+}
+
+static bool SameCalls(const std::vector<std::string>& expected)
+{
+    if (glCalls == expected) return true;
+
+    for (const std::string& call : glCalls) std::printf("    got: %s\n", call.c_str());
+    return false;
+}
+
+static void TestRedundantCallsAreSkipped()
+{
+    Reset();
+
+    GLState::Enable(GL_DEPTH_TEST);
+    GLState::Enable(GL_DEPTH_TEST);
+    GLState::Disable(GL_DEPTH_TEST);
+    GLState::Disable(GL_DEPTH_TEST);
+    GLState::UseProgram(5);
+    GLState::UseProgram(5);
+    GLState::UseProgram(6);
+    GLState::DepthMask(GL_FALSE);
+    GLState::DepthMask(GL_FALSE);
+    GLState::DepthMask(GL_TRUE);
+    GLState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GLState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GLState::BindVertexArray(3);
+    GLState::BindVertexArray(3);
+
+    TEST_CHECK(SameCalls({ "enable b71", "disable b71", "useProgram 5", "useProgram 6", "depthMask 0", "depthMask 1",
+        "blendFunc 302 303", "bindVertexArray 3" }));
+}
+
+// Capabilities the cache doesn't track always reach the driver
+static void TestUntrackedCapsPassThrough()
+{
+    Reset();
+
+    GLState::Enable(GL_PROGRAM_POINT_SIZE);
+    GLState::Enable(GL_PROGRAM_POINT_SIZE);
+    GLState::BindTexture(GL_TEXTURE_CUBE_MAP, 4);
+    GLState::BindTexture(GL_TEXTURE_CUBE_MAP, 4);
+
+    TEST_CHECK(SameCalls({ "enable 8642", "enable 8642", "bindTexture 8513 4", "bindTexture 8513 4" }));
+}
+
+static void TestInvalidateForgetsState()
+{
+    Reset();
+
+    GLState::UseProgram(5);
+    GLState::Enable(GL_BLEND);
+    GLState::ActiveTexture(GL_TEXTURE0 + 3);
+    GLState::Invalidate();
+    GLState::UseProgram(5);
+    GLState::Enable(GL_BLEND);
+
+    // Invalidate selects unit 0 again so texture binds stay tracked
+    TEST_CHECK(SameCalls({ "useProgram 5", "enable be2", "activeTexture 3", "activeTexture 0", "useProgram 5", "enable be2" }));
+
+    glCalls.clear();
+    GLState::DepthFunc(GL_LEQUAL);
+    GLState::BeginFrame();
+    GLState::DepthFunc(GL_LEQUAL);
+    TEST_CHECK(SameCalls({ "depthFunc 203", "activeTexture 0", "depthFunc 203" }));
+}
+
+static void TestBindTexturesSendsChangedSpan()
+{
+    Reset();
+
+    const GLuint first[4] = { 1, 2, 3, 4 };
+    GLState::BindTextures(0, 4, first);
+
+    // Only units 1 and 2 change
+    const GLuint second[4] = { 1, 9, 8, 4 };
+    GLState::BindTextures(0, 4, second);
+    GLState::BindTextures(0, 4, second);
+
+    // Single-unit binds see what the multi-bind set
+    GLState::BindTextureUnit(2, 8);
+    GLState::ActiveTexture(GL_TEXTURE0 + 3);
+    GLState::BindTexture(GL_TEXTURE_2D, 4);
+    GLState::BindTexture(GL_TEXTURE_2D, 5);
+
+    TEST_CHECK(SameCalls({ "bindTextures 0 1 2 3 4", "bindTextures 1 9 8", "activeTexture 3", "bindTexture de1 5" }));
+}
+
+// A deleted name can come back from glGen*, binding it again must reach the driver
+static void TestDeletesForceRebind()
+{
+    Reset();
+
+    GLState::BindTextureUnit(1, 9);
+    const GLuint texture = 9;
+    GLState::DeleteTextures(1, &texture);
+    GLState::BindTextureUnit(1, 9);
+
+    GLState::BindVertexArray(7);
+    const GLuint vao = 7;
+    GLState::DeleteVertexArrays(1, &vao);
+    GLState::BindVertexArray(7);
+
+    // Deleting a name that isn't bound keeps the cache
+    const GLuint other = 12;
+    GLState::DeleteTextures(1, &other);
+    GLState::BindTextureUnit(1, 9);
+
+    TEST_CHECK(SameCalls({ "bindTextureUnit 1 9", "deleteTextures 1", "bindTextureUnit 1 9", "bindVertexArray 7",
+        "deleteVertexArrays 1", "bindVertexArray 7", "deleteTextures 1" }));
+}
+
+static void TestStatsCountCallsAndSkips()
+{
+    Reset();
+
+    // BeginFrame's own unit select is the new frame's first call
+    GLState::BeginFrame();
+    GLState::UseProgram(1);
+    GLState::UseProgram(1);
+    GLState::Enable(GL_CULL_FACE);
+    GLState::Enable(GL_CULL_FACE);
+    GLState::Enable(GL_PROGRAM_POINT_SIZE);
+    GLState::StencilMask(0xFF);
+
+    const GLuint ids[4] = { 1, 2, 3, 4 };
+    GLState::BindTextures(0, 4, ids);
+    GLState::BindTextures(0, 4, ids);
+
+    GLState::BeginFrame();
+    const GLState::Stats& stats = GLState::GetStats();
+    TEST_CHECK(stats.calls == 6);
+    TEST_CHECK(stats.skipped == 6);
+}
+
+void RunGLStateTests()
+{
+    TestRedundantCallsAreSkipped();
+    TestUntrackedCapsPassThrough();
+    TestInvalidateForgetsState();
+    TestBindTexturesSendsChangedSpan();
+    TestDeletesForceRebind();
+    TestStatsCountCallsAndSkips();
+}
@@ -0,0 +1,77 @@
+#include "Tests.h"
+#include "IndirectCommandBuilder.h"
+
+static void TestRepeatsFoldIntoOneCommand()
+{
+    IndirectCommandBuilder builder;
+    builder.Clear(100);
+
+    TEST_CHECK(builder.AddDraw(0, 36, 0) == 0);
+    TEST_CHECK(builder.AddDraw(0, 36, 0) == 1);
+    TEST_CHECK(builder.AddDraw(0, 36, 0) == 2);
+
+    const std::vector<DrawElementsIndirectCommand>& commands = builder.GetCommands();
+    TEST_CHECK(commands.size() == 1);
+    TEST_CHECK(commands[0].count == 36);
+    TEST_CHECK(commands[0].instanceCount == 3);
+    TEST_CHECK(commands[0].baseInstance == 100);
+    TEST_CHECK(builder.GetInstanceCount() == 3);
+}
+
+static void TestOtherMeshesStartCommands()
+{
+    IndirectCommandBuilder builder;
+    builder.Clear(10);
+
+    builder.AddDraw(0, 36, 0);
+    builder.AddDraw(36, 12, 24);
+    builder.AddDraw(0, 36, 0);     // not next to its previous draw, no folding
+    builder.AddDraw(0, 36, 8);     // same indices, other vertices
+
+    const std::vector<DrawElementsIndirectCommand>& commands = builder.GetCommands();
+    TEST_CHECK(commands.size() == 4);
+    TEST_CHECK(commands[1].firstIndex == 36);
+    TEST_CHECK(commands[1].baseVertex == 24);
+    TEST_CHECK(commands[1].baseInstance == 11);
+    TEST_CHECK(commands[3].baseInstance == 13);
+
+    // A draw without BeginBatch opens the first batch
+    TEST_CHECK(builder.GetBatches().size() == 1);
+    TEST_CHECK(builder.GetBatches()[0].commandCount == 4);
+}
+
+static void TestBatchesSplitCommands()
+{
+    IndirectCommandBuilder builder;
+    builder.Clear(0);
+
+    builder.BeginBatch();
+    builder.AddDraw(0, 36, 0);
+    builder.AddDraw(0, 36, 0);
+    builder.BeginBatch();
+    builder.AddDraw(0, 36, 0);     // same mesh, but the state changed in between
+    builder.AddDraw(36, 6, 0);
+
+    const std::vector<IndirectBatch>& batches = builder.GetBatches();
+    TEST_CHECK(batches.size() == 2);
+    TEST_CHECK(batches[0].firstCommand == 0);
+    TEST_CHECK(batches[0].commandCount == 1);
+    TEST_CHECK(batches[0].instanceCount == 2);
+    TEST_CHECK(batches[1].firstCommand == 1);
+    TEST_CHECK(batches[1].commandCount == 2);
+    TEST_CHECK(batches[1].firstInstance == 2);
+    TEST_CHECK(batches[1].instanceCount == 2);
+
+    builder.Clear(5);
+    TEST_CHECK(builder.GetCommands().empty());
+    TEST_CHECK(builder.GetBatches().empty());
+    TEST_CHECK(builder.AddDraw(0, 3, 0) == 0);
+    TEST_CHECK(builder.GetCommands()[0].baseInstance == 5);
+}
+
+void RunIndirectCommandBuilderTests()
+{
+    TestRepeatsFoldIntoOneCommand();
+    TestOtherMeshesStartCommands();
+    TestBatchesSplitCommands();
+}
@@ -0,0 +1,142 @@
+#include "Tests.h"
+#include "LightClusterer.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+static const int kScreenWidth = 1600;
+static const int kScreenHeight = 900;
+static const float kNearPlane = 0.1f;
+static const float kFarPlane = 500.0f;
+
+static glm::mat4 MakeProjection()
+{
+    return glm::perspective(glm::radians(60.0f), (float)kScreenWidth / kScreenHeight, kNearPlane, kFarPlane);
+}
+
+// View space spheres spread over the frustum, some crossing its sides and the near plane
+static std::vector<glm::vec4> MakeLights(std::mt19937& rng, int count)
+{
+    std::uniform_real_distribution<float> centered(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    std::vector<glm::vec4> spheres(count);
+    for (glm::vec4& sphere : spheres)
+    {
+        sphere = glm::vec4(centered(rng) * 60.0f, centered(rng) * 30.0f, -unit(rng) * 150.0f, 1.0f + unit(rng) * 10.0f);
+    }
+    return spheres;
+}
+
+// A point inside a light's sphere has to find the light in its cluster, looked up the way the
+// fragment shader does: tile from the pixel, slice from the depth rebuilt out of the depth buffer
+static void TestSampledPointsFindTheirLights()
+{
+    glm::mat4 projection = MakeProjection();
+    LightClusterer clusterer;
+    clusterer.SetProjection(projection, kNearPlane, kFarPlane);
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> centered(-1.0f, 1.0f);
+
+    int checked = 0;
+    int missing = 0;
+    for (int count : { 1, 16, 64, 256, 1024 })
+    {
+        std::vector<glm::vec4> lights = MakeLights(rng, count);
+        clusterer.Build(lights);
+
+        const std::vector<LightCluster>& clusters = clusterer.GetClusters();
+        const std::vector<uint32_t>& indices = clusterer.GetLightIndices();
+        TEST_CHECK((int)clusters.size() == LightClusterer::kClusterCount);
+
+        for (int light = 0; light < count; ++light)
+        {
+            const glm::vec4& sphere = lights[light];
+            for (int sample = 0; sample < 200; ++sample)
+            {
+                glm::vec3 offset(centered(rng), centered(rng), centered(rng));
+                if (offset.x * offset.x + offset.y * offset.y + offset.z * offset.z > 1.0f) continue;
+
+                glm::vec4 point(sphere.x + offset.x * sphere.w, sphere.y + offset.y * sphere.w, sphere.z + offset.z * sphere.w, 1.0f);
+                glm::vec4 clip = projection * point;
+                if (clip.w <= 0.0f) continue;
+
+                glm::vec3 ndc(clip.x / clip.w, clip.y / clip.w, clip.z / clip.w);
+                if (std::abs(ndc.x) > 1.0f || std::abs(ndc.y) > 1.0f || std::abs(ndc.z) > 1.0f) continue;
+
+                float pixelX = (ndc.x * 0.5f + 0.5f) * kScreenWidth;
+                float pixelY = (ndc.y * 0.5f + 0.5f) * kScreenHeight;
+                float depth = 2.0f * kNearPlane * kFarPlane / (kFarPlane + kNearPlane - ndc.z * (kFarPlane - kNearPlane));
+
+                int tileX = std::min((int)(pixelX * LightClusterer::kTilesX / kScreenWidth), LightClusterer::kTilesX - 1);
+                int tileY = std::min((int)(pixelY * LightClusterer::kTilesY / kScreenHeight), LightClusterer::kTilesY - 1);
+                float slice = std::log(depth) * clusterer.GetSliceScale() + clusterer.GetSliceBias();
+                int sliceIndex = (int)std::clamp(slice, 0.0f, (float)(LightClusterer::kSlices - 1));
+
+                const LightCluster& cluster = clusters[(sliceIndex * LightClusterer::kTilesY + tileY) * LightClusterer::kTilesX + tileX];
+                auto first = indices.begin() + cluster.offset;
+                auto last = first + cluster.count;
+
+                checked++;
+                if (std::find(first, last, (uint32_t)light) == last) missing++;
+            }
+        }
+
+        // Each cluster lists its lights in light order
+        for (const LightCluster& cluster : clusters)
+        {
+            TEST_CHECK(std::is_sorted(indices.begin() + cluster.offset, indices.begin() + cluster.offset + cluster.count));
+        }
+    }
+
+    std::printf("[LightClusterer] %d sampled points, %d missing their light\n", checked, missing);
+    TEST_CHECK(checked > 0);
+    TEST_CHECK(missing == 0);
+}
+
+// Lights behind the camera or past the far plane touch no cluster
+static void TestLightsOutsideTheFrustum()
+{
+    LightClusterer clusterer;
+    clusterer.SetProjection(MakeProjection(), kNearPlane, kFarPlane);
+
+    std::vector<glm::vec4> lights = { glm::vec4(0.0f, 0.0f, 20.0f, 5.0f), glm::vec4(0.0f, 0.0f, -kFarPlane - 20.0f, 5.0f) };
+    clusterer.Build(lights);
+
+    TEST_CHECK(clusterer.GetLightIndices().empty());
+    TEST_CHECK(clusterer.GetOccupiedClusters() == 0);
+}
+
+static void BenchmarkBinning()
+{
+    LightClusterer clusterer;
+    clusterer.SetProjection(MakeProjection(), kNearPlane, kFarPlane);
+
+    std::mt19937 rng(42);
+    for (int count : { 64, 128, 256, 512, 1024 })
+    {
+        std::vector<glm::vec4> lights = MakeLights(rng, count);
+        clusterer.Build(lights); // warm up the buffers
+
+        const int runs = 20;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int run = 0; run < runs; ++run)
+        {
+            clusterer.Build(lights);
+        }
+        float ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / runs;
+
+        std::printf("[LightClusterer] %4d lights: %.3f ms, %zu indices, %d clusters used\n", count, ms,
+            clusterer.GetLightIndices().size(), clusterer.GetOccupiedClusters());
+    }
+}
+
+void RunLightClustererTests()
+{
+    TestSampledPointsFindTheirLights();
+    TestLightsOutsideTheFrustum();
+    BenchmarkBinning();
+}
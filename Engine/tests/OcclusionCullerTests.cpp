@@ -0,0 +1,147 @@
+#include "Tests.h"
+#include "OcclusionCuller.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <chrono>
+#include <random>
+
+// Unit cube, counter-clockwise faces looking outwards
+static const float kCubePositions[] = {
+    -0.5f, -0.5f, -0.5f,   0.5f, -0.5f, -0.5f,   0.5f, 0.5f, -0.5f,   -0.5f, 0.5f, -0.5f,
+    -0.5f, -0.5f,  0.5f,   0.5f, -0.5f,  0.5f,   0.5f, 0.5f,  0.5f,   -0.5f, 0.5f,  0.5f,
+};
+static const unsigned int kCubeIndices[] = {
+    4, 5, 6, 4, 6, 7,   1, 0, 3, 1, 3, 2,   0, 4, 7, 0, 7, 3,
+    5, 1, 2, 5, 2, 6,   7, 6, 2, 7, 2, 3,   0, 1, 5, 0, 5, 4,
+};
+
+// Camera at the origin looking down -Z
+static glm::mat4 MakeViewProjection()
+{
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), 2.0f, 0.1f, 100.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    return projection * view;
+}
+
+static void AddCube(OcclusionCuller& culler, const glm::vec3& position, const glm::vec3& size)
+{
+    glm::mat4 model = glm::scale(glm::translate(glm::mat4(1.0f), position), size);
+    culler.AddOccluder(model, kCubePositions, sizeof(float) * 3, 8, kCubeIndices, 36);
+}
+
+static AABB MakeBox(const glm::vec3& center, float halfSize)
+{
+    AABB box;
+    box.min = center - glm::vec3(halfSize);
+    box.max = center + glm::vec3(halfSize);
+    return box;
+}
+
+static void TestWallHidesWhatIsBehindIt()
+{
+    OcclusionCuller culler;
+    culler.BeginFrame(MakeViewProjection());
+
+    // Nothing rasterized yet, nothing can be hidden
+    TEST_CHECK(!culler.IsOccluded(MakeBox(glm::vec3(0.0f, 0.0f, -20.0f), 0.5f)));
+
+    // 20 x 20 wall, its front face at z = -9.5
+    AddCube(culler, glm::vec3(0.0f, 0.0f, -10.0f), glm::vec3(20.0f, 20.0f, 1.0f));
+    culler.RasterizeOccluders();
+
+    const OcclusionCuller::Stats& stats = culler.GetStats();
+    TEST_CHECK(stats.occluders == 1);
+    TEST_CHECK(stats.trianglesSubmitted == 12);
+    TEST_CHECK(stats.trianglesRasterized > 0 && stats.trianglesRasterized < 12);
+
+    // The middle of the depth buffer is covered, its corners are not
+    const float* depth = culler.GetDepthBuffer();
+    int width = culler.GetWidth();
+    int height = culler.GetHeight();
+    TEST_CHECK(depth[(height / 2) * width + width / 2] < 1.0f);
+    TEST_CHECK(depth[0] == 1.0f);
+
+    TEST_CHECK(culler.IsOccluded(MakeBox(glm::vec3(0.0f, 0.0f, -20.0f), 0.5f)));
+    TEST_CHECK(culler.IsOccluded(MakeBox(glm::vec3(10.0f, 5.0f, -40.0f), 2.0f)));
+
+    // In front of the wall, beside it, peeking past its edge and around the camera
+    TEST_CHECK(!culler.IsOccluded(MakeBox(glm::vec3(0.0f, 0.0f, -5.0f), 0.5f)));
+    TEST_CHECK(!culler.IsOccluded(MakeBox(glm::vec3(32.0f, 0.0f, -30.0f), 1.0f)));
+    TEST_CHECK(!culler.IsOccluded(MakeBox(glm::vec3(20.0f, 0.0f, -20.0f), 1.0f)));
+    TEST_CHECK(!culler.IsOccluded(MakeBox(glm::vec3(0.0f, 0.0f, 0.0f), 1.0f)));
+
+    TEST_CHECK(culler.GetStats().occludeesTested == 7);
+    TEST_CHECK(culler.GetStats().occludeesCulled == 2);
+}
+
+// Occluders facing away from the camera are not rasterized
+static void TestBackFacesAreSkipped()
+{
+    static const unsigned int flippedIndices[] = { 4, 6, 5, 4, 7, 6 };
+
+    OcclusionCuller culler;
+    culler.BeginFrame(MakeViewProjection());
+    glm::mat4 model = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -10.0f)), glm::vec3(20.0f));
+    culler.AddOccluder(model, kCubePositions, sizeof(float) * 3, 8, flippedIndices, 6);
+    culler.RasterizeOccluders();
+
+    TEST_CHECK(culler.GetStats().trianglesRasterized == 0);
+    TEST_CHECK(!culler.IsOccluded(MakeBox(glm::vec3(0.0f, 0.0f, -30.0f), 0.5f)));
+}
+
+static void BenchmarkOcclusion()
+{
+    std::mt19937 rng(99);
+    std::uniform_real_distribution<float> centered(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    std::vector<AABB> occludees(10000);
+    for (AABB& box : occludees)
+    {
+        box = MakeBox(glm::vec3(centered(rng) * 60.0f, centered(rng) * 20.0f, -15.0f - unit(rng) * 80.0f), 0.5f + unit(rng));
+    }
+
+    OcclusionCuller culler;
+    glm::mat4 viewProjection = MakeViewProjection();
+
+    for (int occluderCount : { 16, 64, 256 })
+    {
+        const int runs = 10;
+        float rasterizeMs = 0.0f;
+        float testMs = 0.0f;
+        int culled = 0;
+
+        for (int run = 0; run < runs; ++run)
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            culler.BeginFrame(viewProjection);
+            for (int i = 0; i < occluderCount; ++i)
+            {
+                float x = ((i % 16) - 7.5f) * 6.0f;
+                float y = ((i / 16) % 4 - 1.5f) * 4.0f;
+                AddCube(culler, glm::vec3(x, y, -12.0f - (i / 64) * 4.0f), glm::vec3(4.0f, 3.0f, 1.0f));
+            }
+            culler.RasterizeOccluders();
+            auto rasterized = std::chrono::high_resolution_clock::now();
+
+            culled = 0;
+            for (const AABB& box : occludees)
+            {
+                if (culler.IsOccluded(box)) culled++;
+            }
+            auto tested = std::chrono::high_resolution_clock::now();
+
+            rasterizeMs += std::chrono::duration<float, std::milli>(rasterized - start).count();
+            testMs += std::chrono::duration<float, std::milli>(tested - rasterized).count();
+        }
+
+        std::printf("[OcclusionCuller] %3d occluders: rasterize %.3f ms, %zu boxes tested in %.3f ms, %d culled\n",
+            occluderCount, rasterizeMs / runs, occludees.size(), testMs / runs, culled);
+    }
+}
+
+void RunOcclusionCullerTests()
+{
+    TestWallHidesWhatIsBehindIt();
+    TestBackFacesAreSkipped();
+    BenchmarkOcclusion();
+}
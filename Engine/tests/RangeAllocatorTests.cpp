@@ -0,0 +1,145 @@
+#include "Tests.h"
+#include "RangeAllocator.h"
+#include <random>
+#include <vector>
+
+static void TestAllocateAndFill()
+{
+    RangeAllocator allocator(100);
+
+    TEST_CHECK(allocator.Allocate(0) == RangeAllocator::kInvalidOffset);
+    TEST_CHECK(allocator.Allocate(40) == 0);
+    TEST_CHECK(allocator.Allocate(60) == 40);
+    TEST_CHECK(allocator.GetUsed() == 100);
+    TEST_CHECK(allocator.GetFreeBlockCount() == 0);
+    TEST_CHECK(allocator.Allocate(1) == RangeAllocator::kInvalidOffset);
+}
+
+static void TestFreeMergesNeighbours()
+{
+    RangeAllocator allocator(30);
+    uint32_t a = allocator.Allocate(10);
+    uint32_t b = allocator.Allocate(10);
+    uint32_t c = allocator.Allocate(10);
+
+    allocator.Free(a, 10);
+    allocator.Free(c, 10);
+    TEST_CHECK(allocator.GetFreeBlockCount() == 2);
+    TEST_CHECK(allocator.GetLargestFreeBlock() == 10);
+
+    // Joins the block before and the one after
+    allocator.Free(b, 10);
+    TEST_CHECK(allocator.GetFreeBlockCount() == 1);
+    TEST_CHECK(allocator.GetLargestFreeBlock() == 30);
+    TEST_CHECK(allocator.GetUsed() == 0);
+}
+
+static void TestFirstFit()
+{
+    RangeAllocator allocator(100);
+    uint32_t a = allocator.Allocate(10);
+    allocator.Allocate(10);
+    allocator.Free(a, 10);
+
+    // The hole at the start fits, the tail is left alone
+    TEST_CHECK(allocator.Allocate(5) == 0);
+    TEST_CHECK(allocator.Allocate(5) == 5);
+    TEST_CHECK(allocator.Allocate(5) == 20);
+}
+
+static void TestGrow()
+{
+    RangeAllocator allocator(30);
+    allocator.Allocate(20);
+
+    // The new space joins the free tail
+    allocator.Grow(50);
+    TEST_CHECK(allocator.GetCapacity() == 50);
+    TEST_CHECK(allocator.GetFreeBlockCount() == 1);
+    TEST_CHECK(allocator.Allocate(30) == 20);
+
+    allocator.Grow(40);
+    TEST_CHECK(allocator.GetCapacity() == 50);
+
+    allocator.Grow(60);
+    TEST_CHECK(allocator.Allocate(10) == 50);
+}
+
+// Random allocations and frees checked against a map of which elements are taken
+static void TestRandomAllocFree()
+{
+    const uint32_t capacity = 4096;
+    RangeAllocator allocator(capacity);
+    std::vector<bool> taken(capacity, false);
+
+    struct Range
+    {
+        uint32_t offset;
+        uint32_t count;
+    };
+    std::vector<Range> live;
+
+    std::mt19937 rng(1234);
+    uint32_t used = 0;
+    int failedAllocations = 0;
+
+    for (int step = 0; step < 20000; ++step)
+    {
+        bool allocate = live.empty() || rng() % 100 < 55;
+        if (allocate)
+        {
+            uint32_t count = 1 + rng() % 64;
+            uint32_t offset = allocator.Allocate(count);
+            if (offset == RangeAllocator::kInvalidOffset)
+            {
+                // Only allowed when no free block is large enough
+                TEST_CHECK(allocator.GetLargestFreeBlock() < count);
+                failedAllocations++;
+                continue;
+            }
+
+            TEST_CHECK(offset + count <= capacity);
+            bool overlaps = false;
+            for (uint32_t i = offset; i < offset + count && i < capacity; ++i)
+            {
+                overlaps |= taken[i];
+                taken[i] = true;
+            }
+            TEST_CHECK(!overlaps);
+
+            live.push_back({ offset, count });
+            used += count;
+        }
+        else
+        {
+            size_t index = rng() % live.size();
+            Range range = live[index];
+            live[index] = live.back();
+            live.pop_back();
+
+            allocator.Free(range.offset, range.count);
+            for (uint32_t i = range.offset; i < range.offset + range.count; ++i) taken[i] = false;
+            used -= range.count;
+        }
+
+        TEST_CHECK(allocator.GetUsed() == used);
+        if (testFailures > 0) return;
+    }
+
+    for (const Range& range : live) allocator.Free(range.offset, range.count);
+
+    // Everything merged back into one block
+    TEST_CHECK(allocator.GetUsed() == 0);
+    TEST_CHECK(allocator.GetFreeBlockCount() == 1);
+    TEST_CHECK(allocator.GetLargestFreeBlock() == capacity);
+    std::printf("[RangeAllocator] 20000 random steps, %d allocations did not fit\n", failedAllocations);
+}
+
+void RunRangeAllocatorTests()
+{
+    TestAllocateAndFill();
+    TestFreeMergesNeighbours();
+    TestFirstFit();
+    TestGrow();
+    TestRandomAllocFree();
+}
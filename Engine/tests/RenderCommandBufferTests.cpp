@@ -0,0 +1,267 @@
+#include "Tests.h"
+#include "RenderCommandBuffer.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// Writes every backend call down as a line of text, so a replay can be compared without a context
+class RecordingBackend : public RenderBackend
+{
+public:
+    // Instances land at this slot, as if earlier buffers had taken the ones before
+    explicit RecordingBackend(uint32_t instanceSlot = 1000) : instanceSlot(instanceSlot) {}
+
+    uint32_t UploadInstances(const MeshInstanceData* instances, size_t count) override
+    {
+        std::string line = "UploadInstances";
+        for (size_t i = 0; i < count; ++i) line += Format(" %g", instances[i].model[3][0]);
+        calls.push_back(line);
+        return instanceSlot;
+    }
+
+    void UploadIndirectCommands(const DrawElementsIndirectCommand* commands, const uint8_t* lods, size_t count) override
+    {
+        std::string line = "UploadIndirectCommands";
+        for (size_t i = 0; i < count; ++i)
+        {
+            line += Format(" (%u %u %u %d %u lod %u)", commands[i].count, commands[i].instanceCount, commands[i].firstIndex,
+                commands[i].baseVertex, commands[i].baseInstance, lods[i]);
+        }
+        calls.push_back(line);
+    }
+
+    void UpdateMaterial(uint32_t slot, const MaterialUniformData& material) override
+    {
+        calls.push_back(Format("UpdateMaterial %u (%g %g %g %g)", slot, material.materialDiffuse.x, material.materialDiffuse.y,
+            material.materialDiffuse.z, material.opacity));
+    }
+
+    void SetStencil(int ref, unsigned int writeMask) override { calls.push_back(Format("SetStencil %d %u", ref, writeMask)); }
+    void BindMaterial(unsigned int texture, int slot) override { calls.push_back(Format("BindMaterial %u %d", texture, slot)); }
+    void SetDrawID(uint32_t drawID) override { calls.push_back(Format("SetDrawID %u", drawID)); }
+
+    void SetModel(const glm::mat4& model) override
+    {
+        calls.push_back(Format("SetModel %g %g %g", model[3][0], model[3][1], model[3][2]));
+    }
+
+    void SetSkinning(unsigned int globalSSBO, unsigned int offsetSSBO, const glm::mat4& meshInverse,
+        const glm::mat4* bones, uint32_t boneCount) override
+    {
+        std::string line = Format("SetSkinning %u %u %g bones", globalSSBO, offsetSSBO, meshInverse[3][0]);
+        for (uint32_t i = 0; i < boneCount; ++i) line += Format(" %g", bones[i][3][0]);
+        calls.push_back(line);
+    }
+
+    void Draw(unsigned int vao, uint32_t indexCount, uint32_t firstIndex, bool skinned, int lod) override
+    {
+        calls.push_back(Format("Draw %u %u %u %d lod %d", vao, indexCount, firstIndex, skinned ? 1 : 0, lod));
+    }
+
+    void DrawInstanced(unsigned int vao, uint32_t indexCount, uint32_t firstIndex, uint32_t instanceBase, uint32_t instanceCount,
+        int lod) override
+    {
+        calls.push_back(Format("DrawInstanced %u %u %u %u %u lod %d", vao, indexCount, firstIndex, instanceBase, instanceCount, lod));
+    }
+
+    void DrawIndirect(uint32_t firstCommand, uint32_t commandCount, uint32_t instanceBase) override
+    {
+        calls.push_back(Format("DrawIndirect %u %u %u", firstCommand, commandCount, instanceBase));
+    }
+
+    void BeginList(uint32_t uniformSet) override { calls.push_back(Format("BeginList %u", uniformSet)); }
+    void EndList() override { calls.push_back("EndList"); }
+    void BeginTimer(const char* name) override { calls.push_back(Format("BeginTimer %s", name)); }
+    void EndTimer() override { calls.push_back("EndTimer"); }
+
+    void RunPass(const std::function<void()>& pass) override
+    {
+        calls.push_back("RunPass");
+        pass();
+    }
+
+    std::vector<std::string> calls;
+
+private:
+    uint32_t instanceSlot;
+
+    template <typename... Args>
+    static std::string Format(const char* format, Args... args)
+    {
+        char buffer[256];
+        std::snprintf(buffer, sizeof(buffer), format, args...);
+        return buffer;
+    }
+};
+
+static glm::mat4 MakeTranslation(float x, float y, float z)
+{
+    glm::mat4 matrix(1.0f);
+    matrix[3] = glm::vec4(x, y, z, 1.0f);
+    return matrix;
+}
+
+static bool SameCalls(const std::vector<std::string>& calls, const std::vector<std::string>& expected)
+{
+    if (calls == expected) return true;
+
+    for (size_t i = 0; i < std::max(calls.size(), expected.size()); ++i)
+    {
+        std::printf("  %-50s | %s\n", i < calls.size() ? calls[i].c_str() : "-", i < expected.size() ? expected[i].c_str() : "-");
+    }
+    return false;
+}
+
+// A recorded stream replays in order with its values, the uploads coming first
+static void TestRecordAndReplay()
+{
+    RenderCommandBuffer commands;
+
+    MaterialUniformData red = { glm::vec3(1.0f, 0.0f, 0.0f), 1.0f };
+    MaterialUniformData glass = { glm::vec3(0.5f, 0.5f, 1.0f), 0.25f };
+
+    commands.BindMaterial(0, nullptr);
+    commands.SetStencil(1, 0xFF);
+    commands.BindMaterial(7, &red, 4);
+    commands.SetDrawID(3);
+    commands.SetModel(MakeTranslation(1.0f, 2.0f, 3.0f));
+    commands.Draw(10, 36, 0, false, 0);
+
+    // The palette is copied, the bones can move once it is recorded
+    std::vector<glm::mat4> bones = { MakeTranslation(7.0f, 0.0f, 0.0f), MakeTranslation(8.0f, 0.0f, 0.0f) };
+    commands.SetSkinning(20, 21, MakeTranslation(-4.0f, 0.0f, 0.0f), bones);
+    bones[0] = MakeTranslation(0.0f, 0.0f, 0.0f);
+    commands.SetModel(MakeTranslation(5.0f, 0.0f, 0.0f));
+    commands.Draw(11, 60, 12, true, 1);
+
+    // Later changes to the source values don't reach a recorded bind
+    red.opacity = 0.0f;
+    commands.SetStencil(0, 0x00);
+    commands.BindMaterial(8, &glass, 9);
+    uint32_t base = commands.AddInstance(MakeTranslation(30.0f, 0.0f, 0.0f), glm::mat4(1.0f));
+    for (int i = 1; i < 4; ++i) commands.AddInstance(MakeTranslation(30.0f + i, 0.0f, 0.0f), glm::mat4(1.0f));
+    TEST_CHECK(base == 0);
+    commands.DrawInstanced(12, 6, 0, base, 4, 2);
+
+    // Base instances are relative to the buffer too
+    commands.AddInstance(MakeTranslation(40.0f, 0.0f, 0.0f), glm::mat4(1.0f));
+    commands.AddInstance(MakeTranslation(41.0f, 0.0f, 0.0f), glm::mat4(1.0f));
+    commands.AddInstance(MakeTranslation(42.0f, 0.0f, 0.0f), glm::mat4(1.0f));
+    std::vector<DrawElementsIndirectCommand> indirect = { { 36, 2, 0, 0, 4 }, { 6, 1, 36, 24, 6 } };
+    TEST_CHECK(commands.AddIndirectCommands(indirect, { 0, 3 }) == 0);
+    commands.DrawIndirect(0, 2, 4);
+
+    TEST_CHECK(commands.GetCommandCount() == 13);
+    TEST_CHECK(commands.GetInstanceCount() == 7);
+
+    RecordingBackend backend;
+    commands.Execute(backend);
+
+    std::vector<std::string> expected = {
+        "UploadInstances 30 31 32 33 40 41 42",
+        "UploadIndirectCommands (36 2 0 0 1004 lod 0) (6 1 36 24 1006 lod 3)",
+        "UpdateMaterial 4 (1 0 0 1)",
+        "UpdateMaterial 9 (0.5 0.5 1 0.25)",
+        "BindMaterial 0 -1",
+        "SetStencil 1 255",
+        "BindMaterial 7 4",
+        "SetDrawID 3",
+        "SetModel 1 2 3",
+        "Draw 10 36 0 0 lod 0",
+        "SetSkinning 20 21 -4 bones 7 8",
+        "SetModel 5 0 0",
+        "Draw 11 60 12 1 lod 1",
+        "SetStencil 0 0",
+        "BindMaterial 8 9",
+        "DrawInstanced 12 6 0 1000 4 lod 2",
+        "DrawIndirect 0 2 1004",
+    };
+    TEST_CHECK(SameCalls(backend.calls, expected));
+
+    // Replaying doesn't consume the buffer
+    RecordingBackend again;
+    commands.Execute(again);
+    TEST_CHECK(again.calls == backend.calls);
+
+    commands.Clear();
+    TEST_CHECK(commands.IsEmpty());
+
+    RecordingBackend cleared;
+    commands.Execute(cleared);
+    TEST_CHECK(cleared.calls.empty());
+}
+
+// Without materials, instances nor indirect commands nothing is uploaded
+static void TestNoUploadsWhenUnused()
+{
+    RenderCommandBuffer commands;
+    commands.BindMaterial(0, nullptr);
+    commands.Draw(1, 3, 0, false, 0);
+
+    RecordingBackend backend;
+    commands.Execute(backend);
+    TEST_CHECK(SameCalls(backend.calls, { "BindMaterial 0 -1", "Draw 1 3 0 0 lod 0" }));
+}
+
+// Indirect commands of several lists share one upload, each list's ranges start past the last
+static void TestIndirectCommandsAppend()
+{
+    RenderCommandBuffer commands;
+    commands.AddInstance(glm::mat4(1.0f), glm::mat4(1.0f));
+    commands.AddInstance(glm::mat4(1.0f), glm::mat4(1.0f));
+
+    std::vector<DrawElementsIndirectCommand> opaque = { { 3, 1, 0, 0, 0 } };
+    std::vector<DrawElementsIndirectCommand> late = { { 6, 1, 3, 0, 1 } };
+    uint32_t first = commands.AddIndirectCommands(opaque, { 1 });
+    uint32_t second = commands.AddIndirectCommands(late, { 2 });
+    TEST_CHECK(first == 0);
+    TEST_CHECK(second == 1);
+    commands.DrawIndirect(first, 1, 0);
+    commands.DrawIndirect(second, 1, 1);
+
+    RecordingBackend backend(16);
+    commands.Execute(backend);
+    TEST_CHECK(SameCalls(backend.calls, { "UploadInstances 0 0", "UploadIndirectCommands (3 1 0 0 16 lod 1) (6 1 3 0 17 lod 2)",
+        "DrawIndirect 0 1 16", "DrawIndirect 1 1 17" }));
+}
+
+// Passes run between the draws they were recorded with, holding the values they captured
+static void TestPassesRunInOrder()
+{
+    RenderCommandBuffer commands;
+    std::vector<std::string> log;
+
+    int clearColor = 3;
+    commands.RunPass([&log, clearColor]() { log.push_back("clear " + std::to_string(clearColor)); });
+    clearColor = 4;
+
+    commands.BeginTimer("Opaque");
+    commands.BeginList(2);
+    commands.Draw(1, 3, 0, false, 0);
+    commands.EndList();
+    commands.RunPass([&log]() { log.push_back("resolve"); });
+    commands.EndTimer();
+    TEST_CHECK(commands.GetCommandCount() == 7);
+
+    RecordingBackend backend;
+    commands.Execute(backend);
+    TEST_CHECK(SameCalls(backend.calls, { "RunPass", "BeginTimer Opaque", "BeginList 2", "Draw 1 3 0 0 lod 0", "EndList",
+        "RunPass", "EndTimer" }));
+    TEST_CHECK(SameCalls(log, { "clear 3", "resolve" }));
+
+    // Clearing drops the passes with what they hold
+    commands.Clear();
+    log.clear();
+    RecordingBackend cleared;
+    commands.Execute(cleared);
+    TEST_CHECK(cleared.calls.empty());
+    TEST_CHECK(log.empty());
+}
+
+void RunRenderCommandBufferTests()
+{
+    TestRecordAndReplay();
+    TestNoUploadsWhenUnused();
+    TestIndirectCommandsAppend();
+    TestPassesRunInOrder();
+}
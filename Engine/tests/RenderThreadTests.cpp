@@ -0,0 +1,141 @@
+#include "Tests.h"
+#include "RenderThread.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Context hooks and jobs append here, from the worker and from the test thread
+static std::mutex eventMutex;
+static std::vector<std::string> events;
+
+static void Event(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(eventMutex);
+    events.push_back(name);
+}
+
+static bool SameEvents(const std::vector<std::string>& expected)
+{
+    std::lock_guard<std::mutex> lock(eventMutex);
+    if (events == expected) return true;
+
+    for (const std::string& event : events) std::printf("    got: %s\n", event.c_str());
+    return false;
+}
+
+static void Reset()
+{
+    std::lock_guard<std::mutex> lock(eventMutex);
+    events.clear();
+}
+
+static bool Acquire()
+{
+    Event("acquire");
+    return true;
+}
+
+static void Release()
+{
+    Event("release");
+}
+
+// The start frame and each later frame take the context once and give it back in EndFrame
+static void TestFramesHoldTheContext()
+{
+    Reset();
+    RenderThread thread(Acquire, Release);
+    TEST_CHECK(thread.Start());
+    TEST_CHECK(thread.IsRunning());
+
+    std::thread::id caller = std::this_thread::get_id();
+    std::atomic<bool> onWorker{ true };
+    for (int i = 0; i < 3; ++i)
+    {
+        thread.Submit([i, caller, &onWorker]() {
+            if (std::this_thread::get_id() == caller) onWorker = false;
+            Event("job " + std::to_string(i));
+        });
+    }
+    thread.EndFrame();
+    Event("frame ended");
+
+    // A frame without jobs doesn't take the context
+    thread.EndFrame();
+    thread.Stop();
+
+    TEST_CHECK(onWorker);
+    TEST_CHECK(!thread.IsRunning());
+    TEST_CHECK(SameEvents({ "acquire", "release", "acquire", "job 0", "job 1", "job 2", "release", "frame ended" }));
+}
+
+static void TestWaitForReturnsAfterTheJob()
+{
+    Reset();
+    RenderThread thread(Acquire, Release);
+    TEST_CHECK(thread.Start());
+
+    std::atomic<bool> first{ false };
+    std::atomic<bool> second{ false };
+    uint64_t ticket = thread.Submit([&first]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        first = true;
+    });
+    thread.Submit([&second]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        second = true;
+    });
+
+    thread.WaitFor(ticket);
+    TEST_CHECK(first);
+
+    // A ticket from an earlier frame is already done
+    thread.EndFrame();
+    TEST_CHECK(second);
+    thread.WaitFor(ticket);
+    thread.Stop();
+}
+
+// The caller keeps the inline replay when the worker can't take the context
+static void TestFailedAcquireStops()
+{
+    Reset();
+    RenderThread thread([]() { Event("acquire"); return false; }, Release);
+    TEST_CHECK(!thread.Start());
+    TEST_CHECK(thread.HasFailed());
+    TEST_CHECK(!thread.IsRunning());
+    TEST_CHECK(SameEvents({ "acquire" }));
+}
+
+// Stop runs what was queued, then gives the context back before the worker exits
+static void TestStopRunsQueuedJobs()
+{
+    Reset();
+    RenderThread thread(Acquire, Release);
+    TEST_CHECK(thread.Start());
+
+    thread.Submit([]() { Event("job"); });
+    thread.Stop();
+
+    TEST_CHECK(SameEvents({ "acquire", "release", "acquire", "job", "release" }));
+
+    // Tickets keep counting after a restart
+    Reset();
+    TEST_CHECK(thread.Start());
+    uint64_t ticket = thread.Submit([]() { Event("job"); });
+    thread.WaitFor(ticket);
+    thread.EndFrame();
+    thread.Stop();
+    TEST_CHECK(SameEvents({ "acquire", "release", "acquire", "job", "release" }));
+}
+
+void RunRenderThreadTests()
+{
+    TestFramesHoldTheContext();
+    TestWaitForReturnsAfterTheJob();
+    TestFailedAcquireStops();
+    TestStopRunsQueuedJobs();
+}
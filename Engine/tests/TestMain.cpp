@@ -0,0 +1,24 @@
+#include "Tests.h"
+
+int testFailures = 0;
+
+// Runs the CPU side render helpers without a window or a GL context
+int main()
+{
+    RunOcclusionCullerTests();
+    RunRangeAllocatorTests();
+    RunIndirectCommandBuilderTests();
+    RunLightClustererTests();
+    RunRenderCommandBufferTests();
+    RunGLStateTests();
+    RunRenderThreadTests();
+
+    if (testFailures > 0)
+    {
+        std::printf("%d checks failed\n", testFailures);
+        return 1;
+    }
+
+    std::printf("All checks passed\n");
+    return 0;
+}
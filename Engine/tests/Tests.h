@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdio>
+
+// Checks for the headless test runner. A failed check is printed and fails the run, timings are
+// only printed.
+extern int testFailures;
+
+#define TEST_CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            testFailures++; \
+        } \
+    } while (0)
+
+void RunOcclusionCullerTests();
+void RunRangeAllocatorTests();
+void RunIndirectCommandBuilderTests();
+void RunLightClustererTests();
+void RunRenderCommandBufferTests();
+void RunGLStateTests();
+void RunRenderThreadTests();